@@ -0,0 +1,108 @@
+/**
+ *  @file       batched_reader.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_BATCHED_READER_H
+#define KITSUNEMIMI_CPU_BATCHED_READER_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+// standalone utility for own sampling-loops, which read many small files and msr-registers in
+// each tick. The samplers of this library don't use it and keep their own open files.
+class BatchedReader
+{
+public:
+    BatchedReader();
+    ~BatchedReader();
+    BatchedReader(const BatchedReader &) = delete;
+    BatchedReader &operator=(const BatchedReader &) = delete;
+
+    // register reads before initializing
+    bool addFile(uint64_t &readId,
+                 const std::string &filePath,
+                 const uint64_t maxSize,
+                 ErrorContainer &error);
+    bool addMsr(uint64_t &readId,
+                const uint64_t threadId,
+                const uint32_t offset,
+                ErrorContainer &error);
+
+    bool initReader(const bool useIoUring, ErrorContainer &error);
+    bool isUsingIoUring() const;
+
+    // one sampling-tick
+    bool readAll(ErrorContainer &error);
+
+    // results of the last tick
+    bool getNumber(int64_t &result, const uint64_t readId) const;
+    bool getMsrValue(uint64_t &result, const uint64_t readId) const;
+    const char* getContent(const uint64_t readId) const;
+    int64_t getResult(const uint64_t readId) const;
+
+private:
+    struct ReadRequest
+    {
+        // position of the file-descriptor in m_fds, which is also the id of the registered file
+        uint64_t fdPos = 0;
+        uint64_t fileOffset = 0;
+        uint64_t bufferOffset = 0;
+        uint64_t size = 0;
+        bool isMsr = false;
+        // number of read bytes or negative error-number of the last tick
+        int64_t result = 0;
+    };
+
+    struct IoUring
+    {
+        int fd = -1;
+        uint64_t numberOfEntries = 0;
+
+        void* sqRing = nullptr;
+        uint64_t sqRingSize = 0;
+        void* cqRing = nullptr;
+        uint64_t cqRingSize = 0;
+        void* sqes = nullptr;
+        uint64_t sqesSize = 0;
+
+        uint32_t* sqTail = nullptr;
+        uint32_t* sqMask = nullptr;
+        uint32_t* sqArray = nullptr;
+        uint32_t* cqHead = nullptr;
+        uint32_t* cqTail = nullptr;
+        uint32_t* cqMask = nullptr;
+        void* cqes = nullptr;
+    };
+
+    bool m_isInit = false;
+    bool m_useIoUring = false;
+
+    std::vector<int> m_fds;
+    std::map<uint64_t, uint64_t> m_msrFdPositions;
+    std::vector<ReadRequest> m_requests;
+
+    // one preallocated buffer for the results of all reads, which is registered at io_uring
+    std::vector<uint64_t> m_buffer;
+
+    IoUring m_ring;
+
+    bool initIoUring(ErrorContainer &error);
+    void closeIoUring();
+    bool readWithIoUring(ErrorContainer &error);
+    bool readWithPreadv(ErrorContainer &error);
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_BATCHED_READER_H
@@ -0,0 +1,43 @@
+/**
+ *  @file       cgroup.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_CGROUP_H
+#define KITSUNEMIMI_CPU_CGROUP_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+enum CgroupVersion
+{
+    NO_CGROUP = 0,
+    CGROUP_V1 = 1,
+    CGROUP_V2 = 2,
+};
+
+CgroupVersion getCgroupVersion();
+bool getCgroupPath(std::string &result, const std::string &controller, ErrorContainer &error);
+bool getCgroupPaths(std::vector<std::string> &result,
+                    const std::string &controller,
+                    ErrorContainer &error);
+
+// limits of the cgroup of the current process
+bool getCgroupMemoryLimit(uint64_t &result, ErrorContainer &error);
+bool getCgroupMemoryUsage(uint64_t &result, ErrorContainer &error);
+bool getCgroupMemoryInactiveFile(uint64_t &result, ErrorContainer &error);
+bool getCgroupCpuLimit(double &result, ErrorContainer &error);
+bool getCgroupCpuThreads(uint64_t &result, ErrorContainer &error);
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_CGROUP_H
@@ -0,0 +1,69 @@
+/**
+ *  @file       core_latency.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_CORE_LATENCY_H
+#define KITSUNEMIMI_CPU_CORE_LATENCY_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <libKitsunemimiCpu/cpu_set.h>
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+struct CoreLatencyMatrix
+{
+    std::string cpuModel = "";
+    std::vector<uint64_t> threadIds;
+
+    // one-way latency in nanoseconds, row-major with threadIds.size() x threadIds.size() entries
+    std::vector<double> latencies;
+
+    double get(const uint64_t posA, const uint64_t posB) const
+    {
+        return latencies[posA * threadIds.size() + posB];
+    }
+
+    const std::string toString()
+    {
+        std::string content = "";
+        for(uint64_t a = 0; a < threadIds.size(); a++)
+        {
+            content += std::to_string(threadIds[a]) + ":";
+            for(uint64_t b = 0; b < threadIds.size(); b++) {
+                content += " " + std::to_string(static_cast<uint64_t>(get(a, b)));
+            }
+            content += "\n";
+        }
+        return content;
+    }
+};
+
+bool measureCoreLatency(CoreLatencyMatrix &result,
+                        const CpuSet &threads,
+                        const uint64_t numberOfRoundTrips,
+                        ErrorContainer &error);
+bool getCoreLatency(CoreLatencyMatrix &result,
+                    const CpuSet &threads,
+                    const std::string &cacheDirectory,
+                    ErrorContainer &error);
+
+bool getCommunicationDistance(double &result,
+                              const CoreLatencyMatrix &matrix,
+                              const uint64_t threadIdA,
+                              const uint64_t threadIdB);
+void getCommunicationGroups(std::vector<CpuSet> &result,
+                            const CoreLatencyMatrix &matrix,
+                            const double maxLatency);
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_CORE_LATENCY_H
@@ -12,24 +12,90 @@
 #include <stdint.h>
 #include <string>
 #include <fstream>
+#include <map>
 #include <stdlib.h>
+#include <vector>
 
+#include <libKitsunemimiCpu/cpu_set.h>
 #include <libKitsunemimiCommon/logger.h>
 
 namespace Kitsunemimi
 {
 
+enum CpuCoreClass
+{
+    UNKNOWN_CORE_CLASS = 0,
+    PERFORMANCE_CORE_CLASS = 1,
+    EFFICIENCY_CORE_CLASS = 2,
+};
+
+// modes of the cpu-times in the order of /proc/stat:
+//     user, nice, system, idle, iowait, irq, softirq, steal
+const uint64_t numberOfCpuTimeModes = 8;
+
+struct CpuThreadTimes
+{
+    // cumulative ticks of each mode
+    uint64_t ticks[numberOfCpuTimeModes] = {0, 0, 0, 0, 0, 0, 0, 0};
+    // false, if the thread was not listed, because it is offline
+    bool isValid = false;
+
+    uint64_t getBusy() const;
+    uint64_t getTotal() const;
+};
+
 // topological
 bool getNumberOfCpuPackages(uint64_t &result, ErrorContainer &error);
 bool getNumberOfCpuThreads(uint64_t &result, ErrorContainer &error);
+bool getNumberOfUsableCpuThreads(uint64_t &result, ErrorContainer &error);
 bool getCpuPackageId(uint64_t &result, const uint64_t threadId, ErrorContainer &error);
 bool getCpuCoreId(uint64_t &result, const uint64_t threadId, ErrorContainer &error);
 bool getCpuSiblingId(uint64_t &result, const uint64_t threadId, ErrorContainer &error);
+bool getCpuThreadsOfPackage(CpuSet &result, const uint64_t packageId, ErrorContainer &error);
+bool getCpuPackageId(std::vector<uint64_t> &result, const CpuSet &threads, ErrorContainer &error);
+bool getCpuCoreId(std::vector<uint64_t> &result, const CpuSet &threads, ErrorContainer &error);
+
+// hybrid-cores
+bool isHybridCpu(ErrorContainer &error);
+bool getCpuCoreClass(CpuCoreClass &result, const uint64_t threadId, ErrorContainer &error);
+bool getCpuThreadsOfCoreClass(CpuSet &result,
+                              const CpuCoreClass coreClass,
+                              ErrorContainer &error);
+bool getMaximumSpeedOfCoreClass(uint64_t &result,
+                                const CpuCoreClass coreClass,
+                                ErrorContainer &error);
+bool bindThreadToCoreClass(const CpuCoreClass coreClass, ErrorContainer &error);
+
+// hotplug
+bool getPossibleCpuThreads(CpuSet &result, ErrorContainer &error);
+bool getPresentCpuThreads(CpuSet &result, ErrorContainer &error);
+bool getOnlineCpuThreads(CpuSet &result, ErrorContainer &error);
+bool getOfflineCpuThreads(CpuSet &result, ErrorContainer &error);
+bool isCpuThreadOnline(const uint64_t threadId, ErrorContainer &error);
+bool setCpuThreadOnline(const uint64_t threadId, const bool newState, ErrorContainer &error);
 
 // hyperthreading
 bool isHyperthreadingEnabled(ErrorContainer &error);
 bool isHyperthreadingSupported(ErrorContainer &error);
 bool changeHyperthreadingState(const bool newState, ErrorContainer &error);
+bool getCpuSiblingThreads(CpuSet &result, const uint64_t threadId, ErrorContainer &error);
+bool disableCoreSiblings(CpuSet &offlinedThreads, const CpuSet &threads, ErrorContainer &error);
+bool restoreCoreSiblings(const CpuSet &offlinedThreads, ErrorContainer &error);
+
+// affinity
+bool getThreadAffinity(CpuSet &result, ErrorContainer &error);
+bool setThreadAffinity(const CpuSet &threads, ErrorContainer &error);
+
+// isolation
+bool parseKernelCpuList(CpuSet &result,
+                        const std::vector<std::string> &entries,
+                        const uint64_t lastId);
+bool getIsolatedCpuThreads(CpuSet &result, ErrorContainer &error);
+bool getNohzFullCpuThreads(CpuSet &result, ErrorContainer &error);
+bool getRcuNocbsCpuThreads(CpuSet &result, ErrorContainer &error);
+bool checkPollerPlacement(const CpuSet &pollerThreads, ErrorContainer &error);
+bool bindPollerThread(const uint64_t threadId, ErrorContainer &error);
+void releasePollerThread(const uint64_t threadId);
 
 // speed
 bool getMinimumSpeed(uint64_t &result, const uint64_t threadId, ErrorContainer &error);
@@ -43,9 +109,30 @@ bool setMinimumSpeed(const uint64_t threadId, uint64_t newSpeed, ErrorContainer
 bool setMaximumSpeed(const uint64_t threadId, uint64_t newSpeed, ErrorContainer &error);
 bool resetSpeed(const uint64_t threadId, ErrorContainer &error);
 
+bool getMinimumSpeed(std::vector<uint64_t> &result, const CpuSet &threads, ErrorContainer &error);
+bool getMaximumSpeed(std::vector<uint64_t> &result, const CpuSet &threads, ErrorContainer &error);
+bool getCurrentSpeed(std::vector<uint64_t> &result, const CpuSet &threads, ErrorContainer &error);
+bool getCurrentMinimumSpeed(std::vector<uint64_t> &result,
+                            const CpuSet &threads,
+                            ErrorContainer &error);
+bool getCurrentMaximumSpeed(std::vector<uint64_t> &result,
+                            const CpuSet &threads,
+                            ErrorContainer &error);
+
+bool setMinimumSpeed(const CpuSet &threads, uint64_t newSpeed, ErrorContainer &error);
+bool setMaximumSpeed(const CpuSet &threads, uint64_t newSpeed, ErrorContainer &error);
+bool resetSpeed(const CpuSet &threads, ErrorContainer &error);
+
+// cpu-times
+bool getCpuThreadTimes(std::vector<CpuThreadTimes> &result, ErrorContainer &error);
+bool parseCpuThreadTimes(std::vector<CpuThreadTimes> &result, const char* content);
+
 // temperature
 bool getPkgTemperatureIds(std::vector<uint64_t> &ids, ErrorContainer &error);
 double getPkgTemperature(const uint64_t pkgFileId, ErrorContainer &error);
+bool getPkgTemperature(std::vector<double> &result, const CpuSet &threads, ErrorContainer &error);
+bool getPkgTemperatureFiles(std::map<uint64_t, std::string> &result, ErrorContainer &error);
+bool readPkgTemperature(double &result, const std::string &filePath, ErrorContainer &error);
 
 } // namespace Kitsunemimi
 
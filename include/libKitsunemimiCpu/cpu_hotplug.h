@@ -0,0 +1,48 @@
+/**
+ *  @file       cpu_hotplug.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_CPU_HOTPLUG_H
+#define KITSUNEMIMI_CPU_CPU_HOTPLUG_H
+
+#include <stdint.h>
+
+#include <libKitsunemimiCpu/cpu_set.h>
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+class CpuHotplugObserver
+{
+public:
+    CpuHotplugObserver();
+    ~CpuHotplugObserver();
+    CpuHotplugObserver(const CpuHotplugObserver &) = delete;
+    CpuHotplugObserver &operator=(const CpuHotplugObserver &) = delete;
+
+    bool initObserver(ErrorContainer &error);
+    bool waitForChange(bool &changed,
+                       CpuSet &onlineThreads,
+                       const uint32_t timeoutMs,
+                       ErrorContainer &error);
+    bool checkForChange(bool &changed, CpuSet &onlineThreads, ErrorContainer &error);
+
+    int getFileDescriptor() const;
+    const CpuSet getOnlineThreads() const;
+
+private:
+    bool m_isInit = false;
+    int m_fd = -1;
+    CpuSet m_onlineThreads;
+
+    void drainEvents();
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_CPU_HOTPLUG_H
@@ -0,0 +1,112 @@
+/**
+ *  @file       cpu_set.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_CPU_SET_H
+#define KITSUNEMIMI_CPU_CPU_SET_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <sched.h>
+
+namespace Kitsunemimi
+{
+
+class CpuSet
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator(const std::vector<uint64_t>* bits, const uint64_t word)
+        {
+            m_bits = bits;
+            m_word = word;
+            m_current = word < bits->size() ? (*bits)[word] : 0;
+            skipEmptyWords();
+        }
+
+        uint64_t operator*() const
+        {
+            return m_word * 64 + __builtin_ctzll(m_current);
+        }
+
+        Iterator& operator++()
+        {
+            // clear lowest set bit
+            m_current &= m_current - 1;
+            skipEmptyWords();
+            return *this;
+        }
+
+        bool operator!=(const Iterator &other) const
+        {
+            return m_word != other.m_word || m_current != other.m_current;
+        }
+
+    private:
+        const std::vector<uint64_t>* m_bits = nullptr;
+        uint64_t m_word = 0;
+        uint64_t m_current = 0;
+
+        void skipEmptyWords()
+        {
+            while(m_current == 0
+                  && m_word < m_bits->size())
+            {
+                m_word++;
+                m_current = m_word < m_bits->size() ? (*m_bits)[m_word] : 0;
+            }
+        }
+    };
+
+    CpuSet();
+
+    bool parse(const std::string &cpuList);
+    const std::string toString() const;
+
+    void add(const uint64_t threadId);
+    void remove(const uint64_t threadId);
+    bool contains(const uint64_t threadId) const;
+    void clear();
+
+    uint64_t count() const;
+    bool isEmpty() const;
+    uint64_t getFirst() const;
+    uint64_t getLast() const;
+    const std::vector<uint64_t> getThreadIds() const;
+
+    Iterator begin() const;
+    Iterator end() const;
+
+    // conversion from and to cpu_set_t, allocated with CPU_ALLOC
+    uint64_t getCpuSetTSize() const;
+    void toCpuSetT(cpu_set_t* cpuSet, const uint64_t setSize) const;
+    void fromCpuSetT(const cpu_set_t* cpuSet, const uint64_t setSize);
+
+    // set-operations
+    bool intersects(const CpuSet &other) const;
+    CpuSet& operator|=(const CpuSet &other);
+    CpuSet& operator&=(const CpuSet &other);
+    CpuSet& operator-=(const CpuSet &other);
+    CpuSet operator|(const CpuSet &other) const;
+    CpuSet operator&(const CpuSet &other) const;
+    CpuSet operator-(const CpuSet &other) const;
+
+    bool operator==(const CpuSet &other) const;
+    bool operator!=(const CpuSet &other) const;
+
+private:
+    std::vector<uint64_t> m_bits;
+
+    void shrink();
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_CPU_SET_H
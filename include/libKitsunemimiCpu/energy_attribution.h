@@ -0,0 +1,135 @@
+/**
+ *  @file       energy_attribution.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_ENERGY_ATTRIBUTION_H
+#define KITSUNEMIMI_CPU_ENERGY_ATTRIBUTION_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <sys/types.h>
+
+#include <libKitsunemimiCpu/rapl.h>
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+struct EnergyConsumerInfo
+{
+    uint64_t consumerId = 0;
+    std::string name = "";
+    bool isActive = true;
+
+    // total values since the consumer was added
+    double busyTime = 0.0;
+    double pkgEnergy = 0.0;
+    double dramEnergy = 0.0;
+
+    // values of the last update-interval
+    double lastBusyTime = 0.0;
+    double lastPkgEnergy = 0.0;
+    double lastDramEnergy = 0.0;
+
+    const std::string toString()
+    {
+        std::string content = "";
+        content += "name:       " + name + "\n";
+        content += "busy-time:  " + std::to_string(busyTime)   + " s\n";
+        content += "pkgEnergy:  " + std::to_string(pkgEnergy)  + " Ws\n";
+        content += "dramEnergy: " + std::to_string(dramEnergy) + " Ws\n";
+        return content;
+    }
+};
+
+class EnergyAttribution
+{
+public:
+    EnergyAttribution();
+    ~EnergyAttribution();
+    EnergyAttribution(const EnergyAttribution &) = delete;
+    EnergyAttribution &operator=(const EnergyAttribution &) = delete;
+
+    bool initAttribution(ErrorContainer &error);
+
+    bool addProcess(uint64_t &consumerId, const pid_t pid, ErrorContainer &error);
+    bool addCgroup(uint64_t &consumerId, const std::string &cgroupPath, ErrorContainer &error);
+    bool removeConsumer(const uint64_t consumerId);
+
+    bool update(ErrorContainer &error);
+
+    bool getConsumer(EnergyConsumerInfo &result, const uint64_t consumerId) const;
+    const std::vector<EnergyConsumerInfo> getConsumers() const;
+    double getUnattributedPkgEnergy() const;
+
+private:
+    enum ConsumerType
+    {
+        PROCESS_CONSUMER = 0,
+        CGROUP_V1_CONSUMER = 1,
+        CGROUP_V2_CONSUMER = 2,
+    };
+
+    struct TaskSample
+    {
+        // cumulative busy-time in seconds
+        double total = 0.0;
+        // cpu-thread, where the task was running the last time
+        int64_t lastThreadId = -1;
+    };
+
+    struct ConsumerSample
+    {
+        // cumulative busy-time in seconds
+        double total = 0.0;
+        // cumulative busy-time in seconds per package, if the source provides per-cpu values
+        std::vector<double> perPackage;
+        // cpu-thread, where the process was running the last time
+        int64_t lastThreadId = -1;
+        // number of tasks of a process, to detect created or exited tasks
+        uint64_t numberOfTasks = 0;
+        // samples of the single tasks of a process, where the key is the task-id
+        std::map<uint64_t, TaskSample> tasks;
+    };
+
+    struct Consumer
+    {
+        EnergyConsumerInfo info;
+        ConsumerType type = PROCESS_CONSUMER;
+        pid_t pid = 0;
+        int fd = -1;
+        // opened stat-files of the tasks of a process, where the key is the task-id
+        std::map<uint64_t, int> taskFds;
+        ConsumerSample lastSample;
+    };
+
+    bool m_isInit = false;
+    uint64_t m_nextId = 0;
+    double m_unattributedPkgEnergy = 0.0;
+
+    std::vector<Rapl> m_rapls;
+    std::vector<uint64_t> m_packageOfThread;
+    std::vector<double> m_lastPackageBusy;
+    std::map<uint64_t, Consumer> m_consumers;
+
+    bool readPackageBusy(std::vector<double> &result, ErrorContainer &error);
+    bool readConsumer(ConsumerSample &result, Consumer &consumer);
+    bool readProcessTasks(std::map<uint64_t, TaskSample> &result,
+                          Consumer &consumer,
+                          const bool rescan);
+    double splitProcessBusy(std::vector<double> &result,
+                            const ConsumerSample &sample,
+                            const ConsumerSample &lastSample);
+    bool registerConsumer(uint64_t &consumerId, Consumer &consumer, ErrorContainer &error);
+    void closeConsumer(Consumer &consumer);
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_ENERGY_ATTRIBUTION_H
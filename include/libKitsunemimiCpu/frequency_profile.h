@@ -0,0 +1,89 @@
+/**
+ *  @file       frequency_profile.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_FREQUENCY_PROFILE_H
+#define KITSUNEMIMI_CPU_FREQUENCY_PROFILE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <libKitsunemimiCpu/cpu_set.h>
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+struct FrequencyRamp
+{
+    // effective speed in kHz before the change and after the ramp
+    uint64_t startSpeed = 0;
+    uint64_t sustainedSpeed = 0;
+
+    // time in microseconds until 90 percent of the sustained speed was reached
+    double latency = 0.0;
+
+    // effective speed in kHz over the time in microseconds since the change
+    std::vector<double> traceTimes;
+    std::vector<uint64_t> traceSpeeds;
+};
+
+struct FrequencyProfile
+{
+    std::vector<uint64_t> threadIds;
+
+    // speed in kHz, which the tsc and the mperf-counter are running with
+    uint64_t nominalSpeed = 0;
+
+    // sustained effective speed in kHz under load, if only the thread itself or all threads of
+    // the profile are loaded at the same time
+    std::vector<uint64_t> singleCoreSpeeds;
+    std::vector<uint64_t> allCoreSpeeds;
+
+    // ramp-latency in microseconds after raising the minimum-speed and after a wake from idle
+    std::vector<double> rampLatencies;
+    std::vector<double> wakeLatencies;
+
+    const std::string toString()
+    {
+        std::string content = "nominal speed: " + std::to_string(nominalSpeed) + " kHz\n";
+        for(uint64_t i = 0; i < threadIds.size(); i++)
+        {
+            content += "thread " + std::to_string(threadIds[i]) + ":"
+                       + " single-core: " + std::to_string(singleCoreSpeeds[i]) + " kHz"
+                       + " all-core: " + std::to_string(allCoreSpeeds[i]) + " kHz"
+                       + " ramp: " + std::to_string(rampLatencies[i]) + " us"
+                       + " wake: " + std::to_string(wakeLatencies[i]) + " us\n";
+        }
+        return content;
+    }
+};
+
+// single measurements
+bool measureSustainedSpeed(std::vector<uint64_t> &result,
+                           const CpuSet &threads,
+                           const uint64_t durationMs,
+                           ErrorContainer &error);
+bool measureRampLatency(FrequencyRamp &result, const uint64_t threadId, ErrorContainer &error);
+bool measureWakeLatency(FrequencyRamp &result, const uint64_t threadId, ErrorContainer &error);
+
+// profile of the machine
+bool createFrequencyProfile(FrequencyProfile &result,
+                            const CpuSet &threads,
+                            const uint64_t durationMs,
+                            ErrorContainer &error);
+bool saveFrequencyProfile(const FrequencyProfile &profile,
+                          const std::string &filePath,
+                          ErrorContainer &error);
+bool loadFrequencyProfile(FrequencyProfile &result,
+                          const std::string &filePath,
+                          ErrorContainer &error);
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_FREQUENCY_PROFILE_H
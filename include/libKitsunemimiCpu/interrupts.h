@@ -0,0 +1,87 @@
+/**
+ *  @file       interrupts.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_INTERRUPTS_H
+#define KITSUNEMIMI_CPU_INTERRUPTS_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <libKitsunemimiCpu/cpu_set.h>
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+struct InterruptInfo
+{
+    // number of the irq or name of the architecture-specific interrupt, like "LOC"
+    std::string name = "";
+    bool isDeviceIrq = false;
+    uint64_t irq = 0;
+
+    // interrupt-controller and names of the registered handlers
+    std::string chip = "";
+    std::string actions = "";
+
+    // number of interrupts for each cpu-thread, where the position is the thread-id
+    std::vector<uint64_t> counts;
+
+    uint64_t getTotal() const
+    {
+        uint64_t total = 0;
+        for(const uint64_t count : counts) {
+            total += count;
+        }
+        return total;
+    }
+};
+
+// statistics
+bool parseInterruptLine(InterruptInfo &result,
+                        const std::string &line,
+                        const std::vector<uint64_t> &columnIds);
+bool getInterrupts(std::vector<InterruptInfo> &result, ErrorContainer &error);
+
+class InterruptSampler
+{
+public:
+    InterruptSampler();
+
+    bool initSampler(ErrorContainer &error);
+    bool calculateDiff(std::vector<InterruptInfo> &result, ErrorContainer &error);
+
+private:
+    bool m_isInit = false;
+    std::vector<InterruptInfo> m_lastState;
+};
+
+// irqs of devices
+bool getInterruptsOfDevice(std::vector<uint64_t> &result,
+                           const std::string &devicePath,
+                           ErrorContainer &error);
+bool getInterruptsOfNetworkInterface(std::vector<uint64_t> &result,
+                                     const std::string &interfaceName,
+                                     ErrorContainer &error);
+
+// affinity
+bool getInterruptAffinity(CpuSet &result, const uint64_t irq, ErrorContainer &error);
+bool setInterruptAffinity(const uint64_t irq, const CpuSet &threads, ErrorContainer &error);
+
+// policies
+bool moveInterruptsAway(std::vector<uint64_t> &failedIrqs,
+                        const CpuSet &protectedThreads,
+                        ErrorContainer &error);
+bool spreadNetworkInterrupts(const std::string &interfaceName,
+                             const CpuSet &excludedThreads,
+                             ErrorContainer &error);
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_INTERRUPTS_H
@@ -17,8 +17,13 @@ namespace Kitsunemimi
 
 uint64_t getTotalMemory();
 uint64_t getFreeMemory();
+uint64_t getAvailableMemory();
 uint64_t getPageSize();
 
+// limited by the cgroup of the current process
+uint64_t getContainerTotalMemory();
+uint64_t getContainerFreeMemory();
+
 } // namespace Kitsunemimi
 
 #endif // KITSUNEMIMI_CPU_MEMORY_H
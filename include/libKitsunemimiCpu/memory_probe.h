@@ -0,0 +1,78 @@
+/**
+ *  @file       memory_probe.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_MEMORY_PROBE_H
+#define KITSUNEMIMI_CPU_MEMORY_PROBE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <libKitsunemimiCpu/cpu_set.h>
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+struct MemoryProbeResult
+{
+    uint64_t cpuNode = 0;
+    uint64_t memoryNode = 0;
+
+    // bandwidth in bytes per second
+    double readBandwidth = 0.0;
+    double writeBandwidth = 0.0;
+    double copyBandwidth = 0.0;
+
+    // latency of a dependent load in nanoseconds
+    double latency = 0.0;
+
+    const std::string toString()
+    {
+        const double gb = 1000.0 * 1000.0 * 1000.0;
+        std::string content = "";
+        content += "cpu-node " + std::to_string(cpuNode)
+                   + " -> memory-node " + std::to_string(memoryNode) + "\n";
+        content += "read:    " + std::to_string(readBandwidth / gb) + " GB/s\n";
+        content += "write:   " + std::to_string(writeBandwidth / gb) + " GB/s\n";
+        content += "copy:    " + std::to_string(copyBandwidth / gb) + " GB/s\n";
+        content += "latency: " + std::to_string(latency) + " ns\n";
+        return content;
+    }
+};
+
+struct MemoryProbeMatrix
+{
+    std::vector<uint64_t> nodeIds;
+
+    // row-major with nodeIds.size() x nodeIds.size() entries, where the row is the cpu-node
+    std::vector<MemoryProbeResult> results;
+
+    const MemoryProbeResult& get(const uint64_t cpuNodePos, const uint64_t memoryNodePos) const
+    {
+        return results[cpuNodePos * nodeIds.size() + memoryNodePos];
+    }
+};
+
+// numa-topology
+bool getNumaNodes(std::vector<uint64_t> &result, ErrorContainer &error);
+bool getCpuThreadsOfNode(CpuSet &result, const uint64_t nodeId, ErrorContainer &error);
+
+// probes
+bool probeMemory(MemoryProbeResult &result,
+                 const CpuSet &threads,
+                 const uint64_t memoryNode,
+                 const uint64_t bufferSize,
+                 ErrorContainer &error);
+bool probeMemoryMatrix(MemoryProbeMatrix &result,
+                       const uint64_t bufferSize,
+                       ErrorContainer &error);
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_MEMORY_PROBE_H
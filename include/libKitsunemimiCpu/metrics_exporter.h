@@ -0,0 +1,111 @@
+/**
+ *  @file       metrics_exporter.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_METRICS_EXPORTER_H
+#define KITSUNEMIMI_CPU_METRICS_EXPORTER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libKitsunemimiCpu/cpu.h>
+#include <libKitsunemimiCpu/rapl.h>
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+class MetricsExporter
+{
+public:
+    MetricsExporter();
+    ~MetricsExporter();
+
+    bool initExporter(const uint64_t cacheTimeMs, ErrorContainer &error);
+    bool getMetrics(std::string &result, ErrorContainer &error);
+
+    // embedded http-listener on localhost
+    bool startServer(const uint16_t port, ErrorContainer &error);
+    void stopServer();
+    uint16_t getServerPort() const;
+
+private:
+    struct ThreadSource
+    {
+        uint64_t threadId = 0;
+        uint64_t packageId = 0;
+        int speedFd = -1;
+    };
+
+    struct PackageSource
+    {
+        uint64_t packageId = 0;
+        Rapl rapl;
+        // cumulative energy in joule since the exporter was initialized
+        RaplDiff total;
+
+        PackageSource(const uint64_t threadId) : rapl(threadId) {}
+    };
+
+    struct TemperatureSource
+    {
+        uint64_t packageId = 0;
+        int temperatureFd = -1;
+    };
+
+    struct ZoneSource
+    {
+        uint64_t zoneId = 0;
+        int temperatureFd = -1;
+    };
+
+    bool m_isInit = false;
+    std::mutex m_lock;
+
+    // rendered metrics, which are reused until the cache-time is over
+    std::string m_buffer;
+    uint64_t m_cacheTime = 0;
+    uint64_t m_lastRender = 0;
+    bool m_isRendered = false;
+
+    // already opened sources, so a refresh doesn't have to open any file
+    std::vector<ThreadSource> m_threads;
+    std::vector<PackageSource> m_packages;
+    std::vector<TemperatureSource> m_temperatures;
+    std::vector<ZoneSource> m_zones;
+    int m_statFd = -1;
+    std::vector<CpuThreadTimes> m_cpuTimes;
+    int m_memInfoFd = -1;
+    std::vector<char> m_readBuffer;
+
+    // http-listener
+    int m_serverFd = -1;
+    uint16_t m_serverPort = 0;
+    std::thread m_serverThread;
+    std::atomic<bool> m_stopServer;
+
+    // sampler, which reads the energy-counters often enough to detect each wrap of them
+    std::thread m_energyThread;
+    std::atomic<bool> m_stopEnergy;
+
+    void accumulateEnergy();
+    void sampleEnergy();
+    void renderMetrics();
+    void appendHeader(const char* name, const char* type, const char* unit, const char* help);
+    void appendValue(const char* name, const char* labels, const double value);
+    void renderCpuTimes();
+    void renderMemory();
+    void serveClients();
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_METRICS_EXPORTER_H
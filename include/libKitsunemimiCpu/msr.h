@@ -0,0 +1,36 @@
+/**
+ *  @file       msr.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_MSR_H
+#define KITSUNEMIMI_CPU_MSR_H
+
+#include <stdint.h>
+
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+// access with an already opened msr-file
+int openMsr(const uint64_t threadId, const bool writable, ErrorContainer &error);
+bool readMsrFd(uint64_t &result, const int fd, const uint32_t offset, ErrorContainer &error);
+bool writeMsrFd(const int fd, const uint32_t offset, const uint64_t value, ErrorContainer &error);
+
+// single access, which opens and closes the msr-file
+bool readMsr(uint64_t &result,
+             const uint64_t threadId,
+             const uint32_t offset,
+             ErrorContainer &error);
+bool writeMsr(const uint64_t threadId,
+              const uint32_t offset,
+              const uint64_t value,
+              ErrorContainer &error);
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_MSR_H
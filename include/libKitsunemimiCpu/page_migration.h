@@ -0,0 +1,79 @@
+/**
+ *  @file       page_migration.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_PAGE_MIGRATION_H
+#define KITSUNEMIMI_CPU_PAGE_MIGRATION_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <libKitsunemimiCpu/cpu_set.h>
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+struct PageMigrationResult
+{
+    uint64_t numberOfPages = 0;
+    uint64_t movedPages = 0;
+
+    // pages, which were already on the target-node before
+    uint64_t alreadyOnNodePages = 0;
+
+    // pages, which were never touched, so there is nothing to move
+    uint64_t notPresentPages = 0;
+
+    // pages, which could not be moved, together with the error-number of the kernel
+    std::vector<uint64_t> failedAddresses;
+    std::vector<int> failedErrors;
+
+    const std::string toString()
+    {
+        std::string content = "";
+        content += "pages:       " + std::to_string(numberOfPages) + "\n";
+        content += "moved:       " + std::to_string(movedPages) + "\n";
+        content += "already:     " + std::to_string(alreadyOnNodePages) + "\n";
+        content += "not present: " + std::to_string(notPresentPages) + "\n";
+        content += "failed:      " + std::to_string(failedAddresses.size()) + "\n";
+        return content;
+    }
+};
+
+// location and migration of pages
+bool getPageNodes(std::vector<int> &result,
+                  const void* address,
+                  const uint64_t size,
+                  ErrorContainer &error);
+bool migrateRange(PageMigrationResult &result,
+                  const void* address,
+                  const uint64_t size,
+                  const uint64_t nodeId,
+                  ErrorContainer &error);
+bool bindRangeToNode(const void* address,
+                     const uint64_t size,
+                     const uint64_t nodeId,
+                     ErrorContainer &error);
+
+// prefault and lock in parallel
+bool prefaultRange(void* address,
+                   const uint64_t size,
+                   const CpuSet &threads,
+                   ErrorContainer &error);
+bool lockRange(void* address,
+               const uint64_t size,
+               const CpuSet &threads,
+               ErrorContainer &error);
+bool unlockRange(void* address,
+                 const uint64_t size,
+                 ErrorContainer &error);
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_PAGE_MIGRATION_H
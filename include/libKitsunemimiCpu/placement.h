@@ -0,0 +1,110 @@
+/**
+ *  @file       placement.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_PLACEMENT_H
+#define KITSUNEMIMI_CPU_PLACEMENT_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <libKitsunemimiCpu/cpu.h>
+#include <libKitsunemimiCpu/rapl.h>
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+enum PlacementPolicy
+{
+    // spread workers over all packages and physical cores, siblings are used last
+    MAX_THROUGHPUT_POLICY = 0,
+    // pack workers onto as few packages as possible, so the other packages can idle or turbo
+    MIN_ENERGY_POLICY = 1,
+    // prefer cool packages and balance the workers based on the package-temperature
+    THERMAL_BALANCE_POLICY = 2,
+};
+
+struct CpuThreadState
+{
+    uint64_t threadId = 0;
+    uint64_t packageId = 0;
+    uint64_t coreId = 0;
+    uint64_t currentSpeed = 0;
+    uint64_t maximumSpeed = 0;
+    double load = 0.0;
+};
+
+struct CpuPackageState
+{
+    uint64_t packageId = 0;
+    double temperature = 0.0;
+    double power = 0.0;
+    double load = 0.0;
+    bool hasPower = false;
+    bool hasTemperature = false;
+    std::vector<uint64_t> threadIds;
+};
+
+struct PlacementPlan
+{
+    PlacementPolicy policy = MAX_THROUGHPUT_POLICY;
+
+    // position in the list is the id of the worker, value is the id of the cpu-thread
+    std::vector<uint64_t> threadIds;
+
+    const std::string toString()
+    {
+        std::string content = "";
+        for(uint64_t i = 0; i < threadIds.size(); i++) {
+            content += "worker " + std::to_string(i) + " -> thread " + std::to_string(threadIds[i]) + "\n";
+        }
+        return content;
+    }
+};
+
+class PlacementAdvisor
+{
+public:
+    PlacementAdvisor();
+
+    bool initAdvisor(ErrorContainer &error);
+    bool updateState(ErrorContainer &error);
+    bool createPlan(PlacementPlan &result,
+                    const uint64_t numberOfWorkers,
+                    const PlacementPolicy policy,
+                    ErrorContainer &error);
+
+    const std::vector<CpuThreadState> getThreadStates() const;
+    const std::vector<CpuPackageState> getPackageStates() const;
+
+private:
+    bool m_isInit = false;
+
+    std::vector<CpuThreadState> m_threads;
+    std::vector<CpuPackageState> m_packages;
+    std::vector<Rapl> m_rapls;
+    // temperature-file of each package, where the key is the package-id
+    std::map<uint64_t, std::string> m_temperatureFiles;
+    std::vector<CpuThreadTimes> m_lastTimes;
+
+    const std::vector<std::vector<uint64_t>> getSortedCores(const uint64_t packagePos) const;
+
+    void createMaxThroughputPlan(PlacementPlan &result, const uint64_t numberOfWorkers);
+    void createMinEnergyPlan(PlacementPlan &result, const uint64_t numberOfWorkers);
+    void createThermalBalancePlan(PlacementPlan &result, const uint64_t numberOfWorkers);
+};
+
+bool applyPlacement(const PlacementPlan &plan,
+                    const uint64_t workerId,
+                    ErrorContainer &error);
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_PLACEMENT_H
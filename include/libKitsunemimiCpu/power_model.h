@@ -0,0 +1,96 @@
+/**
+ *  @file       power_model.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_POWER_MODEL_H
+#define KITSUNEMIMI_CPU_POWER_MODEL_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <libKitsunemimiCpu/cpu.h>
+#include <libKitsunemimiCpu/cpu_set.h>
+#include <libKitsunemimiCpu/rapl.h>
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+// features of the model for each package:
+//     constant, sum of utilization, sum of utilization * frequency,
+//     sum of utilization * frequency^3, temperature
+// where the utilization of a thread is between 0 and 1 and the frequency is in GHz
+const uint64_t numberOfPowerFeatures = 5;
+
+struct PowerModelCoefficients
+{
+    double pkg[numberOfPowerFeatures] = {0.0, 0.0, 0.0, 0.0, 0.0};
+    double pp0[numberOfPowerFeatures] = {0.0, 0.0, 0.0, 0.0, 0.0};
+    double dram[numberOfPowerFeatures] = {0.0, 0.0, 0.0, 0.0, 0.0};
+};
+
+class PowerModel
+{
+public:
+    PowerModel();
+
+    bool initModel(ErrorContainer &error);
+    bool isCalibrated() const;
+
+    // calibration on a host with rapl
+    bool addCalibrationSample(ErrorContainer &error);
+    bool fitModel(ErrorContainer &error);
+    bool saveModel(const std::string &filePath, ErrorContainer &error) const;
+    bool loadModel(const std::string &filePath, ErrorContainer &error);
+
+    // estimation
+    bool calculateDiff(std::vector<RaplDiff> &result, ErrorContainer &error);
+
+private:
+    struct CalibrationSample
+    {
+        double features[numberOfPowerFeatures];
+        // measured average power in watt of pkg, pp0 and dram
+        double power[3];
+    };
+
+    bool m_isInit = false;
+    bool m_isCalibrated = false;
+
+    CpuSet m_threads;
+    std::vector<uint64_t> m_packageOfThread;
+    uint64_t m_numberOfPackages = 0;
+    std::vector<uint64_t> m_packageIds;
+    std::vector<Rapl> m_rapls;
+    // temperature-file of each package, where the key is the package-id
+    std::map<uint64_t, std::string> m_temperatureFiles;
+
+    // last state of the cumulative cpu-times of each thread
+    std::vector<CpuThreadTimes> m_lastTimes;
+    uint64_t m_lastTimeStamp = 0;
+
+    // used for frequency in GHz and temperature in celsius, if they can not be read
+    double m_referenceFrequency = 1.0;
+    double m_referenceTemperature = 50.0;
+    double m_frequencySum = 0.0;
+    double m_temperatureSum = 0.0;
+    uint64_t m_frequencyCount = 0;
+    uint64_t m_temperatureCount = 0;
+
+    std::vector<std::vector<CalibrationSample>> m_samples;
+    std::vector<PowerModelCoefficients> m_coefficients;
+
+    bool collectFeatures(std::vector<CalibrationSample> &result,
+                         double &interval,
+                         ErrorContainer &error);
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_POWER_MODEL_H
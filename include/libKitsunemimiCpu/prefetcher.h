@@ -0,0 +1,70 @@
+/**
+ *  @file       prefetcher.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_PREFETCHER_H
+#define KITSUNEMIMI_CPU_PREFETCHER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <libKitsunemimiCpu/cpu_set.h>
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+// values are the bit-positions in MSR_MISC_FEATURE_CONTROL
+enum Prefetcher
+{
+    L2_STREAMER_PREFETCHER = 0,
+    L2_ADJACENT_LINE_PREFETCHER = 1,
+    L1_DCU_PREFETCHER = 2,
+    L1_IP_PREFETCHER = 3,
+};
+
+struct PrefetcherState
+{
+    uint64_t threadId = 0;
+
+    bool l2Streamer = true;
+    bool l2AdjacentLine = true;
+    bool l1Dcu = true;
+    bool l1Ip = true;
+
+    const std::string toString()
+    {
+        std::string content = "";
+        content += "cpu-thread " + std::to_string(threadId) + ":\n";
+        content += "l2 streamer:      " + std::string(l2Streamer ? "on" : "off") + "\n";
+        content += "l2 adjacent-line: " + std::string(l2AdjacentLine ? "on" : "off") + "\n";
+        content += "l1 dcu:           " + std::string(l1Dcu ? "on" : "off") + "\n";
+        content += "l1 ip:            " + std::string(l1Ip ? "on" : "off") + "\n";
+        return content;
+    }
+};
+
+bool getPrefetcherState(PrefetcherState &result, const uint64_t threadId, ErrorContainer &error);
+bool setPrefetcherState(const PrefetcherState &state, ErrorContainer &error);
+bool setPrefetcherEnabled(const uint64_t threadId,
+                          const Prefetcher prefetcher,
+                          const bool enable,
+                          ErrorContainer &error);
+
+bool getPrefetcherState(std::vector<PrefetcherState> &result,
+                        const CpuSet &threads,
+                        ErrorContainer &error);
+bool setPrefetcherEnabled(const CpuSet &threads,
+                          const Prefetcher prefetcher,
+                          const bool enable,
+                          ErrorContainer &error);
+bool restorePrefetcherState(const std::vector<PrefetcherState> &state, ErrorContainer &error);
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_PREFETCHER_H
@@ -0,0 +1,152 @@
+/**
+ *  @file       pressure.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_PRESSURE_H
+#define KITSUNEMIMI_CPU_PRESSURE_H
+
+#include <stdint.h>
+#include <string>
+
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+enum PressureResource
+{
+    CPU_PRESSURE = 0,
+    MEMORY_PRESSURE = 1,
+    IO_PRESSURE = 2,
+};
+
+enum PressureType
+{
+    // at least one task is stalled
+    SOME_PRESSURE = 0,
+    // all non-idle tasks are stalled at the same time
+    FULL_PRESSURE = 1,
+};
+
+struct PressureValues
+{
+    // share of stalled time in percent over the last 10, 60 and 300 seconds
+    double avg10 = 0.0;
+    double avg60 = 0.0;
+    double avg300 = 0.0;
+
+    // absolute stalled time in microseconds
+    uint64_t total = 0;
+};
+
+struct PressureInfo
+{
+    PressureValues some;
+    PressureValues full;
+
+    const std::string toString()
+    {
+        std::string content = "";
+        content += "some: avg10=" + std::to_string(some.avg10)
+                   + " avg60=" + std::to_string(some.avg60)
+                   + " avg300=" + std::to_string(some.avg300)
+                   + " total=" + std::to_string(some.total) + " us\n";
+        content += "full: avg10=" + std::to_string(full.avg10)
+                   + " avg60=" + std::to_string(full.avg60)
+                   + " avg300=" + std::to_string(full.avg300)
+                   + " total=" + std::to_string(full.total) + " us\n";
+        return content;
+    }
+};
+
+struct VmStatInfo
+{
+    uint64_t pgMajFault = 0;
+    uint64_t pgScan = 0;
+    uint64_t pgSteal = 0;
+    uint64_t compactStall = 0;
+    uint64_t compactFail = 0;
+    uint64_t compactSuccess = 0;
+    uint64_t oomKill = 0;
+
+    // length of the interval in seconds, only set for diffs
+    double time = 0.0;
+
+    const std::string toString()
+    {
+        std::string content = "";
+        content += "pgmajfault:      " + std::to_string(pgMajFault) + "\n";
+        content += "pgscan:          " + std::to_string(pgScan) + "\n";
+        content += "pgsteal:         " + std::to_string(pgSteal) + "\n";
+        content += "compact_stall:   " + std::to_string(compactStall) + "\n";
+        content += "compact_fail:    " + std::to_string(compactFail) + "\n";
+        content += "compact_success: " + std::to_string(compactSuccess) + "\n";
+        content += "oom_kill:        " + std::to_string(oomKill) + "\n";
+        return content;
+    }
+};
+
+// pressure stall information
+bool parsePressureLine(PressureInfo &result, const std::string &line);
+bool getPressure(PressureInfo &result, const PressureResource resource, ErrorContainer &error);
+bool getCgroupPressure(PressureInfo &result,
+                       const PressureResource resource,
+                       ErrorContainer &error);
+
+// memory-management counters
+bool getVmStat(VmStatInfo &result, ErrorContainer &error);
+
+class VmStatSampler
+{
+public:
+    VmStatSampler();
+
+    bool initSampler(ErrorContainer &error);
+    bool calculateDiff(VmStatInfo &result, ErrorContainer &error);
+
+private:
+    bool m_isInit = false;
+    VmStatInfo m_lastState;
+    uint64_t m_lastTimeStamp = 0;
+};
+
+class PressureTrigger
+{
+public:
+    PressureTrigger();
+    ~PressureTrigger();
+    PressureTrigger(const PressureTrigger &) = delete;
+    PressureTrigger &operator=(const PressureTrigger &) = delete;
+
+    bool initTrigger(const PressureResource resource,
+                     const PressureType type,
+                     const uint64_t stallUs,
+                     const uint64_t windowUs,
+                     ErrorContainer &error);
+    bool initCgroupTrigger(const PressureResource resource,
+                           const PressureType type,
+                           const uint64_t stallUs,
+                           const uint64_t windowUs,
+                           ErrorContainer &error);
+
+    bool waitForEvent(const uint32_t timeoutMs, ErrorContainer &error);
+    int getFileDescriptor() const;
+
+private:
+    bool m_isInit = false;
+    int m_fd = -1;
+
+    bool registerTrigger(const std::string &filePath,
+                         const PressureType type,
+                         const uint64_t stallUs,
+                         const uint64_t windowUs,
+                         ErrorContainer &error);
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_PRESSURE_H
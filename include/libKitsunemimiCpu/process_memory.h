@@ -0,0 +1,103 @@
+/**
+ *  @file       process_memory.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_PROCESS_MEMORY_H
+#define KITSUNEMIMI_CPU_PROCESS_MEMORY_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+struct ProcessMemoryInfo
+{
+    // all values in bytes
+    uint64_t rss = 0;
+    uint64_t rssPeak = 0;
+    uint64_t rssAnon = 0;
+    uint64_t rssFile = 0;
+    uint64_t pss = 0;
+    uint64_t swap = 0;
+    uint64_t swapPss = 0;
+    uint64_t anonHugePages = 0;
+    uint64_t hugetlbPages = 0;
+    uint64_t locked = 0;
+
+    const std::string toString()
+    {
+        const double mib = 1024.0 * 1024.0;
+        std::string content = "";
+        content += "rss:             " + std::to_string(rss / mib) + " MiB\n";
+        content += "rss-peak:        " + std::to_string(rssPeak / mib) + " MiB\n";
+        content += "rss-anon:        " + std::to_string(rssAnon / mib) + " MiB\n";
+        content += "rss-file:        " + std::to_string(rssFile / mib) + " MiB\n";
+        content += "pss:             " + std::to_string(pss / mib) + " MiB\n";
+        content += "swap:            " + std::to_string(swap / mib) + " MiB\n";
+        content += "swap-pss:        " + std::to_string(swapPss / mib) + " MiB\n";
+        content += "anon-huge-pages: " + std::to_string(anonHugePages / mib) + " MiB\n";
+        content += "hugetlb-pages:   " + std::to_string(hugetlbPages / mib) + " MiB\n";
+        content += "locked:          " + std::to_string(locked / mib) + " MiB\n";
+        return content;
+    }
+};
+
+struct NodeMemoryDistribution
+{
+    // resident bytes for each numa-node, where the position is the id of the node
+    std::vector<uint64_t> bytes;
+
+    // part of the bytes, which are backed by hugetlb-pages
+    std::vector<uint64_t> hugeBytes;
+
+    void add(const uint64_t nodeId, const uint64_t size, const bool isHuge)
+    {
+        if(nodeId >= bytes.size())
+        {
+            bytes.resize(nodeId + 1, 0);
+            hugeBytes.resize(nodeId + 1, 0);
+        }
+        bytes[nodeId] += size;
+        if(isHuge) {
+            hugeBytes[nodeId] += size;
+        }
+    }
+
+    const std::string toString()
+    {
+        const double mib = 1024.0 * 1024.0;
+        std::string content = "";
+        for(uint64_t i = 0; i < bytes.size(); i++)
+        {
+            content += "node " + std::to_string(i) + ": "
+                       + std::to_string(bytes[i] / mib) + " MiB (huge: "
+                       + std::to_string(hugeBytes[i] / mib) + " MiB)\n";
+        }
+        return content;
+    }
+};
+
+bool getProcessMemory(ProcessMemoryInfo &result, const pid_t pid, ErrorContainer &error);
+bool getProcessNodeDistribution(NodeMemoryDistribution &result,
+                                const pid_t pid,
+                                ErrorContainer &error);
+
+// only for the current process
+bool getRangeMemory(ProcessMemoryInfo &result,
+                    NodeMemoryDistribution &distribution,
+                    const void* address,
+                    const uint64_t size,
+                    ErrorContainer &error);
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_PROCESS_MEMORY_H
@@ -20,20 +20,30 @@
 namespace Kitsunemimi
 {
 
+enum CpuVendor
+{
+    UNKNOWN_CPU_VENDOR = 0,
+    INTEL_CPU_VENDOR = 1,
+    AMD_CPU_VENDOR = 2,
+};
+
 struct RaplDiff
 {
     // info: pp0 = cores
     //       pp1 = graphics
+    //       core = single physical core of the thread (AMD only)
 
     double pkgDiff = 0;
     double pp0Diff = 0;
     double pp1Diff = 0;
     double dramDiff = 0;
+    double coreDiff = 0;
 
     double pkgAvg = 0.0;
     double pp0Avg = 0.0;
     double pp1Avg = 0.0;
     double dramAvg = 0.0;
+    double coreAvg = 0.0;
 
     double time = 0.0;
 
@@ -44,11 +54,13 @@ struct RaplDiff
         content += "pp0Diff:  " + std::to_string(pp0Diff)  + " Ws\n";
         content += "pp1Diff:  " + std::to_string(pp1Diff)  + " Ws\n";
         content += "dramDiff: " + std::to_string(dramDiff) + " Ws\n";
+        content += "coreDiff: " + std::to_string(coreDiff) + " Ws\n";
         content +=  "---\n";
         content += "pkgAvg:  " + std::to_string(pkgAvg)  + " W\n";
         content += "pp0Avg:  " + std::to_string(pp0Avg)  + " W\n";
         content += "pp1Avg:  " + std::to_string(pp1Avg)  + " W\n";
         content += "dramAvg: " + std::to_string(dramAvg) + " W\n";
+        content += "coreAvg: " + std::to_string(coreAvg) + " W\n";
         return content;
     }
 };
@@ -62,7 +74,11 @@ struct RaplInfo
     double minimum_power = 0.0;
     double maximum_power = 0.0;
     double time_window = 0.0;
+    CpuVendor vendor = UNKNOWN_CPU_VENDOR;
+    bool supportPP0 = false;
     bool supportPP1 = false;
+    bool supportDram = false;
+    bool supportCore = false;
 
     const std::string toString()
     {
@@ -79,6 +95,14 @@ class Rapl
 {
 public:
     Rapl(const uint64_t threadId);
+    ~Rapl();
+
+    // the msr-file is owned by the instance, so it can only be moved
+    Rapl(const Rapl &) = delete;
+    Rapl &operator=(const Rapl &) = delete;
+    Rapl(Rapl &&other) noexcept;
+    Rapl &operator=(Rapl &&other) noexcept;
+
     bool initRapl(ErrorContainer &error);
     bool isActive() const;
 
@@ -92,19 +116,25 @@ private:
         uint64_t pp0 = 0;
         uint64_t pp1 = 0;
         uint64_t dram = 0;
-        std::chrono::high_resolution_clock::time_point timeStamp;
+        uint64_t core = 0;
+        // monotonic timestamp in nanoseconds of the tsc-clock
+        uint64_t timeStamp = 0;
     };
 
     uint64_t m_threadId = 0;
-    int m_fd;
+    int m_fd = -1;
     bool m_isInit = false;
 
     RaplState m_lastState;
     RaplInfo m_info;
 
+    CpuVendor checkVendor();
     bool checkPP1();
+    void initIntel();
+    bool initAmd(ErrorContainer &error);
+    double calcEnergy(const uint64_t current, const uint64_t last) const;
     bool openMSR(ErrorContainer &error);
-    uint64_t readMSR(const int32_t offset);
+    uint64_t readMSR(const uint32_t offset);
 };
 
 } // namespace Kitsunemimi
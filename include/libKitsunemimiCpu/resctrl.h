@@ -0,0 +1,137 @@
+/**
+ *  @file       resctrl.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_RESCTRL_H
+#define KITSUNEMIMI_CPU_RESCTRL_H
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+#include <libKitsunemimiCpu/cpu_set.h>
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+struct ResctrlInfo
+{
+    // cache-allocation for the L3-cache
+    bool supportL3 = false;
+    uint64_t cbmMask = 0;
+    uint64_t minCbmBits = 0;
+    uint64_t numberOfL3Closids = 0;
+
+    // memory-bandwidth-allocation
+    bool supportMba = false;
+    uint64_t minBandwidth = 0;
+    uint64_t bandwidthGranularity = 0;
+    uint64_t numberOfMbaClosids = 0;
+
+    // monitoring of cache-occupancy and memory-bandwidth
+    bool supportMonitoring = false;
+    uint64_t numberOfRmids = 0;
+    std::vector<std::string> monitoringFeatures;
+};
+
+struct ResctrlSchemata
+{
+    // capacity-bitmask of the L3-cache for each cache-domain
+    std::map<uint64_t, uint64_t> l3Masks;
+
+    // memory-bandwidth in percent for each cache-domain
+    std::map<uint64_t, uint64_t> mbaPercent;
+};
+
+struct ResctrlMonitorValues
+{
+    uint64_t domainId = 0;
+
+    // occupancy of the L3-cache in bytes
+    uint64_t llcOccupancy = 0;
+
+    // memory-traffic in bytes, which are deltas, if read by a ResctrlSampler
+    uint64_t mbmTotalBytes = 0;
+    uint64_t mbmLocalBytes = 0;
+};
+
+class Resctrl
+{
+public:
+    Resctrl(const std::string &rootPath);
+
+    static bool mountResctrl(const std::string &rootPath, ErrorContainer &error);
+
+    bool initResctrl(ErrorContainer &error);
+    ResctrlInfo getInfo() const;
+
+    // resource-groups, where an empty name is the default-group
+    bool getGroups(std::vector<std::string> &result, ErrorContainer &error);
+    bool createGroup(const std::string &groupName, ErrorContainer &error);
+    bool removeGroup(const std::string &groupName, ErrorContainer &error);
+
+    // allocation
+    bool getSchemata(ResctrlSchemata &result,
+                     const std::string &groupName,
+                     ErrorContainer &error);
+    bool setL3Mask(const std::string &groupName,
+                   const uint64_t domainId,
+                   const uint64_t mask,
+                   ErrorContainer &error);
+    bool setMemoryBandwidth(const std::string &groupName,
+                            const uint64_t domainId,
+                            const uint64_t percent,
+                            ErrorContainer &error);
+
+    // assignment
+    bool assignTask(const std::string &groupName, const pid_t pid, ErrorContainer &error);
+    bool assignCpuThreads(const std::string &groupName,
+                          const CpuSet &threads,
+                          ErrorContainer &error);
+
+    // monitoring
+    bool getMonitorValues(std::vector<ResctrlMonitorValues> &result,
+                          const std::string &groupName,
+                          ErrorContainer &error);
+
+private:
+    std::string m_rootPath = "";
+    bool m_isInit = false;
+    ResctrlInfo m_info;
+
+    const std::string getGroupPath(const std::string &groupName) const;
+    bool readSchemataLines(std::map<std::string, std::map<uint64_t, std::string>> &result,
+                           const std::string &groupName,
+                           ErrorContainer &error);
+    bool updateSchemata(const std::string &groupName,
+                        const std::string &resource,
+                        const uint64_t domainId,
+                        const std::string &value,
+                        ErrorContainer &error);
+};
+
+class ResctrlSampler
+{
+public:
+    ResctrlSampler();
+
+    bool initSampler(Resctrl* resctrl, const std::string &groupName, ErrorContainer &error);
+    bool calculateDiff(std::vector<ResctrlMonitorValues> &result, ErrorContainer &error);
+
+private:
+    bool m_isInit = false;
+    Resctrl* m_resctrl = nullptr;
+    std::string m_groupName = "";
+    std::vector<ResctrlMonitorValues> m_lastState;
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_RESCTRL_H
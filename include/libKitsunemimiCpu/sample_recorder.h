@@ -0,0 +1,165 @@
+/**
+ *  @file       sample_recorder.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_SAMPLE_RECORDER_H
+#define KITSUNEMIMI_CPU_SAMPLE_RECORDER_H
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+enum SampleSource
+{
+    SYSTEM_SAMPLE_SOURCE = 0,
+    PACKAGE_SAMPLE_SOURCE = 1,
+    CORE_SAMPLE_SOURCE = 2,
+    THREAD_SAMPLE_SOURCE = 3,
+};
+
+// description of a single column of a sample-file, which is stored in the header of the file
+struct SampleColumn
+{
+    char name[48];
+    char unit[16];
+    uint32_t source = SYSTEM_SAMPLE_SOURCE;
+    uint32_t padding = 0;
+    // id of the package, core or thread, where the value comes from
+    uint64_t sourceId = 0;
+};
+
+// fixed header at the begin of a sample-file, which is followed by the columns and the blocks
+struct SampleFileHeader
+{
+    char magic[8];
+    uint32_t version = 0;
+    uint32_t headerSize = 0;
+    uint64_t numberOfColumns = 0;
+
+    // topology of the host, where the file was recorded
+    uint64_t numberOfPackages = 0;
+    uint64_t numberOfThreads = 0;
+
+    // wall-clock-time and monotonic timestamp in nanoseconds at the start of the recording, to
+    // convert the monotonic timestamps of the samples into wall-clock-time
+    uint64_t startRealTime = 0;
+    uint64_t startTimeStamp = 0;
+
+    // only updated after a block was completely written, so readers of a file, which is still
+    // written, and files of a crashed recorder only see complete blocks
+    uint64_t numberOfBlocks = 0;
+    uint64_t numberOfSamples = 0;
+    uint64_t dataEnd = 0;
+};
+
+// header of each block of samples, which is followed by the offsets of the compressed streams
+// and the streams itself: first the timestamps and then one stream for each column
+struct SampleBlockHeader
+{
+    uint64_t blockSize = 0;
+    uint64_t numberOfSamples = 0;
+    uint64_t firstTimeStamp = 0;
+    uint64_t lastTimeStamp = 0;
+};
+
+class SampleRecorder
+{
+public:
+    SampleRecorder();
+    ~SampleRecorder();
+    SampleRecorder(const SampleRecorder &) = delete;
+    SampleRecorder &operator=(const SampleRecorder &) = delete;
+
+    bool addColumn(const std::string &name,
+                   const std::string &unit,
+                   const SampleSource source,
+                   const uint64_t sourceId,
+                   ErrorContainer &error);
+    bool initRecorder(const std::string &filePath, ErrorContainer &error);
+
+    bool appendSample(const uint64_t timeStamp,
+                      const std::vector<double> &values,
+                      ErrorContainer &error);
+    bool flush(ErrorContainer &error);
+    bool closeRecorder(ErrorContainer &error);
+
+    uint64_t getNumberOfColumns() const;
+    uint64_t getFileSize() const;
+
+private:
+    bool m_isInit = false;
+    int m_fd = -1;
+    uint8_t* m_data = nullptr;
+    uint64_t m_mappedSize = 0;
+
+    std::vector<SampleColumn> m_columns;
+
+    // compressed streams of the current block, which are preallocated for the worst case
+    std::vector<std::vector<uint64_t>> m_streams;
+    std::vector<uint64_t> m_streamBits;
+    std::vector<uint64_t> m_lastBits;
+    std::vector<uint8_t> m_lastLeading;
+    std::vector<uint8_t> m_lastTrailing;
+    uint64_t m_blockSamples = 0;
+    uint64_t m_firstTimeStamp = 0;
+    uint64_t m_lastTimeStamp = 0;
+    int64_t m_lastDelta = 0;
+
+    SampleFileHeader* getHeader() const;
+    bool resizeFile(const uint64_t minimumSize, ErrorContainer &error);
+    bool writeBlock(ErrorContainer &error);
+};
+
+class SampleReader
+{
+public:
+    SampleReader();
+    ~SampleReader();
+    SampleReader(const SampleReader &) = delete;
+    SampleReader &operator=(const SampleReader &) = delete;
+
+    bool initReader(const std::string &filePath, ErrorContainer &error);
+
+    const SampleFileHeader* getHeader() const;
+    const std::vector<SampleColumn> getColumns() const;
+    uint64_t getNumberOfSamples() const;
+    uint64_t getFirstTimeStamp() const;
+    uint64_t getLastTimeStamp() const;
+
+    bool forEachSample(const uint64_t beginTimeStamp,
+                       const uint64_t endTimeStamp,
+                       const std::function<void(const uint64_t,
+                                                const std::vector<double>&)> &function,
+                       ErrorContainer &error) const;
+    bool readColumn(std::vector<uint64_t> &timeStamps,
+                    std::vector<double> &values,
+                    const uint64_t columnId,
+                    const uint64_t beginTimeStamp,
+                    const uint64_t endTimeStamp,
+                    ErrorContainer &error) const;
+
+private:
+    bool m_isInit = false;
+    const uint8_t* m_data = nullptr;
+    uint64_t m_mappedSize = 0;
+
+    // offsets of all blocks within the file, to skip blocks outside of a requested range
+    std::vector<uint64_t> m_blockOffsets;
+
+    const SampleBlockHeader* getBlock(const uint64_t blockId) const;
+    uint64_t findFirstBlock(const uint64_t beginTimeStamp) const;
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_SAMPLE_RECORDER_H
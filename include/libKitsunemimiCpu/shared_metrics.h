@@ -0,0 +1,142 @@
+/**
+ *  @file       shared_metrics.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_SHARED_METRICS_H
+#define KITSUNEMIMI_CPU_SHARED_METRICS_H
+
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libKitsunemimiCpu/cpu_set.h>
+#include <libKitsunemimiCpu/rapl.h>
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+// all structs of the shared segment only contain 8-byte-values, so they can be copied word by
+// word while protected by the sequence-counter
+
+struct SharedSystemMetrics
+{
+    // monotonic timestamp in nanoseconds of the tsc-clock and number of updates
+    uint64_t timeStamp = 0;
+    uint64_t numberOfUpdates = 0;
+    // length of the last update-interval in seconds
+    double interval = 0.0;
+
+    uint64_t totalMemory = 0;
+    uint64_t availableMemory = 0;
+};
+
+struct SharedPackageMetrics
+{
+    uint64_t packageId = 0;
+    uint64_t supportRapl = 0;
+    uint64_t supportTemperature = 0;
+
+    // cumulative energy in joule since the publisher was started
+    double pkgEnergy = 0.0;
+    double pp0Energy = 0.0;
+    double pp1Energy = 0.0;
+    double dramEnergy = 0.0;
+
+    // average power in watt of the last update-interval
+    double pkgPower = 0.0;
+    double pp0Power = 0.0;
+    double pp1Power = 0.0;
+    double dramPower = 0.0;
+
+    // temperature in celsius
+    double temperature = 0.0;
+};
+
+struct SharedThreadMetrics
+{
+    uint64_t threadId = 0;
+    uint64_t packageId = 0;
+    // current speed in kHz
+    uint64_t speed = 0;
+};
+
+struct SharedMetricsSnapshot
+{
+    SharedSystemMetrics system;
+    std::vector<SharedPackageMetrics> packages;
+    std::vector<SharedThreadMetrics> threads;
+};
+
+class SharedMetricsPublisher
+{
+public:
+    SharedMetricsPublisher();
+    ~SharedMetricsPublisher();
+    SharedMetricsPublisher(const SharedMetricsPublisher &) = delete;
+    SharedMetricsPublisher &operator=(const SharedMetricsPublisher &) = delete;
+
+    bool initPublisher(const std::string &name, ErrorContainer &error);
+    bool publish(ErrorContainer &error);
+
+    bool startPublishing(const uint64_t intervalMs, ErrorContainer &error);
+    void stopPublishing();
+
+private:
+    bool m_isInit = false;
+    std::string m_name = "";
+    uint8_t* m_segment = nullptr;
+    uint64_t m_segmentSize = 0;
+    // locked lock-file, which marks this publisher as running
+    int m_lockFd = -1;
+
+    CpuSet m_threads;
+    std::vector<Rapl> m_rapls;
+    // temperature-file of each package, where the key is the package-id
+    std::map<uint64_t, std::string> m_temperatureFiles;
+
+    // the sequence-counter only allows a single writer, so publish is serialized
+    std::mutex m_publishLock;
+    SharedMetricsSnapshot m_snapshot;
+    uint64_t m_lastTimeStamp = 0;
+
+    std::thread m_publishThread;
+    std::atomic<bool> m_stopPublishing;
+};
+
+class SharedMetricsReader
+{
+public:
+    SharedMetricsReader();
+    ~SharedMetricsReader();
+    SharedMetricsReader(const SharedMetricsReader &) = delete;
+    SharedMetricsReader &operator=(const SharedMetricsReader &) = delete;
+
+    bool initReader(const std::string &name, ErrorContainer &error);
+    bool readSnapshot(SharedMetricsSnapshot &result, ErrorContainer &error);
+
+private:
+    bool m_isInit = false;
+    std::string m_name = "";
+    const uint8_t* m_segment = nullptr;
+    uint64_t m_segmentSize = 0;
+    // inode of the mapped segment to detect a new segment of a restarted publisher
+    uint64_t m_segmentInode = 0;
+    // lock-file, which is locked by the running publisher
+    int m_lockFd = -1;
+
+    bool mapSegment(ErrorContainer &error);
+    bool checkPublisher(ErrorContainer &error);
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_SHARED_METRICS_H
@@ -0,0 +1,124 @@
+/**
+ *  @file       tsc_clock.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_TSC_CLOCK_H
+#define KITSUNEMIMI_CPU_TSC_CLOCK_H
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace Kitsunemimi
+{
+
+class TscClock
+{
+public:
+    static TscClock* getInstance();
+
+    bool isInvariant() const;
+    bool isConstant() const;
+    double getTicksPerNanoSec() const;
+
+    /**
+     * @brief read the time-stamp-counter without waiting for previous instructions
+     */
+    static inline uint64_t readTicks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * @brief read the time-stamp-counter after all previous instructions are finished
+     *
+     * @param cpuId reference for the content of IA32_TSC_AUX, which is the id of the cpu-thread
+     *              under linux
+     */
+    static inline uint64_t readTicksOrdered(uint32_t &cpuId)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned int aux = 0;
+        const uint64_t ticks = __rdtscp(&aux);
+        cpuId = aux & 0xfff;
+        return ticks;
+#else
+        cpuId = 0;
+        return 0;
+#endif
+    }
+
+    /**
+     * @brief convert a number of ticks into nanoseconds
+     */
+    inline uint64_t toNanoSec(const uint64_t ticks) const
+    {
+#if defined(__SIZEOF_INT128__)
+        return static_cast<uint64_t>((static_cast<unsigned __int128>(ticks) * m_nsPerTick) >> 32);
+#else
+        return static_cast<uint64_t>(static_cast<double>(ticks) / m_ticksPerNs);
+#endif
+    }
+
+    /**
+     * @brief convert nanoseconds into a number of ticks
+     */
+    inline uint64_t toTicks(const uint64_t nanoSec) const
+    {
+        return static_cast<uint64_t>(static_cast<double>(nanoSec) * m_ticksPerNs);
+    }
+
+    /**
+     * @brief get monotonic timestamp in nanoseconds, which has the same base like
+     *        CLOCK_MONOTONIC_RAW. Without invariant tsc the clock itself is used.
+     */
+    inline uint64_t getTimestamp() const
+    {
+        if(m_isInvariant)
+        {
+            // the tsc of another core can be slightly behind the one of the calibrating core, so
+            // the difference is clamped instead of wrapping around
+            const uint64_t ticks = readTicks();
+            if(ticks <= m_baseTicks) {
+                return m_baseNs;
+            }
+            return m_baseNs + toNanoSec(ticks - m_baseTicks);
+        }
+
+        struct timespec time;
+        clock_gettime(CLOCK_MONOTONIC_RAW, &time);
+        return static_cast<uint64_t>(time.tv_sec) * 1000000000ULL
+               + static_cast<uint64_t>(time.tv_nsec);
+    }
+
+private:
+    TscClock();
+
+    bool m_isInvariant = false;
+    bool m_isConstant = false;
+    double m_ticksPerNs = 0.0;
+
+    // nanoseconds per tick as fixed-point-value with 32 fractional bits
+    uint64_t m_nsPerTick = 0;
+
+    uint64_t m_baseTicks = 0;
+    uint64_t m_baseNs = 0;
+
+    void checkFeatures();
+    void calibrate();
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_TSC_CLOCK_H
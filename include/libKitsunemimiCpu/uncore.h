@@ -0,0 +1,64 @@
+/**
+ *  @file       uncore.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_UNCORE_H
+#define KITSUNEMIMI_CPU_UNCORE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <libKitsunemimiCommon/logger.h>
+
+namespace Kitsunemimi
+{
+
+struct UncoreFrequency
+{
+    uint64_t packageId = 0;
+    uint64_t dieId = 0;
+
+    // all values in kHz
+    uint64_t minimum = 0;
+    uint64_t maximum = 0;
+    uint64_t initialMinimum = 0;
+    uint64_t initialMaximum = 0;
+    uint64_t current = 0;
+
+    // directory in sysfs or empty, if the values come from the msr
+    std::string sysfsPath = "";
+
+    const std::string toString()
+    {
+        std::string content = "";
+        content += "package " + std::to_string(packageId)
+                   + " die " + std::to_string(dieId) + ":\n";
+        content += "minimum:         " + std::to_string(minimum) + " kHz\n";
+        content += "maximum:         " + std::to_string(maximum) + " kHz\n";
+        content += "initial minimum: " + std::to_string(initialMinimum) + " kHz\n";
+        content += "initial maximum: " + std::to_string(initialMaximum) + " kHz\n";
+        content += "current:         " + std::to_string(current) + " kHz\n";
+        return content;
+    }
+};
+
+bool getUncoreFrequencies(std::vector<UncoreFrequency> &result, ErrorContainer &error);
+bool setUncoreFrequency(const uint64_t packageId,
+                        const uint64_t minimum,
+                        const uint64_t maximum,
+                        ErrorContainer &error);
+bool setUncoreFrequency(const std::vector<uint64_t> &packageIds,
+                        const uint64_t minimum,
+                        const uint64_t maximum,
+                        ErrorContainer &error);
+bool restoreUncoreFrequencies(const std::vector<UncoreFrequency> &state, ErrorContainer &error);
+bool resetUncoreFrequencies(ErrorContainer &error);
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_UNCORE_H
@@ -0,0 +1,571 @@
+/**
+ *  @file       batched_reader.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/batched_reader.h>
+#include <libKitsunemimiCpu/msr.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define KITSUNEMIMI_CPU_IO_URING 1
+#endif
+
+namespace Kitsunemimi
+{
+
+// maximum size of the submission-queue. Larger batches are submitted in multiple steps.
+const uint64_t maxRingEntries = 4096;
+
+/**
+ * @brief constructor
+ */
+BatchedReader::BatchedReader() {}
+
+/**
+ * @brief destructor
+ */
+BatchedReader::~BatchedReader()
+{
+    closeIoUring();
+
+    for(const int fd : m_fds) {
+        close(fd);
+    }
+}
+
+/**
+ * @brief register a read of a text-file, like a file of the sysfs, which is read from the
+ *        beginning in each tick. The file is opened only once.
+ *
+ * @param readId reference for the id of the read, to get its result
+ * @param filePath path to the file
+ * @param maxSize maximum number of bytes to read
+ * @param error reference for error-output
+ *
+ * @return false, if already initialized or the file can not be opened, else true
+ */
+bool
+BatchedReader::addFile(uint64_t &readId,
+                       const std::string &filePath,
+                       const uint64_t maxSize,
+                       ErrorContainer &error)
+{
+    if(m_isInit)
+    {
+        error.addMeesage("Failed to add file '"
+                         + filePath
+                         + "', because batched-reader is already initialized");
+        return false;
+    }
+
+    const int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        error.addMeesage("can not open file to read content: '" + filePath + "'");
+        return false;
+    }
+
+    ReadRequest request;
+    request.fdPos = m_fds.size();
+    request.size = maxSize;
+    m_fds.push_back(fd);
+
+    readId = m_requests.size();
+    m_requests.push_back(request);
+
+    return true;
+}
+
+/**
+ * @brief register a read of a model-specific register. The msr-file of each cpu-thread is
+ *        opened only once for all its registers.
+ *
+ * @param readId reference for the id of the read, to get its result
+ * @param threadId id of the cpu-thread
+ * @param offset address of the register
+ * @param error reference for error-output
+ *
+ * @return false, if already initialized or the msr-file can not be opened, else true
+ */
+bool
+BatchedReader::addMsr(uint64_t &readId,
+                      const uint64_t threadId,
+                      const uint32_t offset,
+                      ErrorContainer &error)
+{
+    if(m_isInit)
+    {
+        error.addMeesage("Failed to add msr of thread '"
+                         + std::to_string(threadId)
+                         + "', because batched-reader is already initialized");
+        return false;
+    }
+
+    if(m_msrFdPositions.find(threadId) == m_msrFdPositions.end())
+    {
+        const int fd = openMsr(threadId, false, error);
+        if(fd < 0) {
+            return false;
+        }
+        m_msrFdPositions.emplace(threadId, m_fds.size());
+        m_fds.push_back(fd);
+    }
+
+    // the file-offset of the msr-file is the address of the register
+    ReadRequest request;
+    request.fdPos = m_msrFdPositions[threadId];
+    request.fileOffset = offset;
+    request.size = sizeof(uint64_t);
+    request.isMsr = true;
+
+    readId = m_requests.size();
+    m_requests.push_back(request);
+
+    return true;
+}
+
+/**
+ * @brief allocate the buffer for all results and set up io_uring with the registered files
+ *        and the buffer. If io_uring is not available, like on old kernels or when blocked by
+ *        seccomp, the reads fall back to preadv.
+ *
+ * @param useIoUring false to always use preadv
+ * @param error reference for error-output
+ *
+ * @return false, if there are no reads, else true
+ */
+bool
+BatchedReader::initReader(const bool useIoUring,
+                          ErrorContainer &error)
+{
+    // check if already initialized
+    if(m_isInit)
+    {
+        LOG_WARNING("this batched-reader was already successfully initialized");
+        return true;
+    }
+
+    if(m_requests.size() == 0)
+    {
+        error.addMeesage("Failed to initialize batched-reader, because there are no reads");
+        error.addSolution("add reads with addFile or addMsr before initializing the reader");
+        return false;
+    }
+
+    // each text-result gets one more byte for the null-termination and all results are aligned
+    uint64_t bufferSize = 0;
+    for(ReadRequest &request : m_requests)
+    {
+        request.bufferOffset = bufferSize;
+        const uint64_t slotSize = request.isMsr ? request.size : request.size + 1;
+        bufferSize += (slotSize + 7) & ~static_cast<uint64_t>(7);
+    }
+    m_buffer.assign(bufferSize / sizeof(uint64_t), 0);
+
+    if(useIoUring)
+    {
+        ErrorContainer ringError;
+        m_useIoUring = initIoUring(ringError);
+        if(m_useIoUring == false)
+        {
+            closeIoUring();
+            LOG_WARNING("io_uring is not available, so the batched-reader falls back to preadv");
+        }
+    }
+
+    m_isInit = true;
+
+    return true;
+}
+
+/**
+ * @brief check if the reads are done with io_uring
+ */
+bool
+BatchedReader::isUsingIoUring() const
+{
+    return m_useIoUring;
+}
+
+/**
+ * @brief create the rings, map them and register files and buffer
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if io_uring is not available, else true
+ */
+bool
+BatchedReader::initIoUring(ErrorContainer &error)
+{
+#ifdef KITSUNEMIMI_CPU_IO_URING
+    uint64_t entries = 1;
+    while(entries < std::min(static_cast<uint64_t>(m_requests.size()), maxRingEntries)) {
+        entries *= 2;
+    }
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    m_ring.fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if(m_ring.fd < 0)
+    {
+        error.addMeesage("Failed to create io_uring: " + std::string(strerror(errno)));
+        return false;
+    }
+    m_ring.numberOfEntries = params.sq_entries;
+
+    // map rings, where newer kernels provide both rings with a single mapping
+    m_ring.sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    m_ring.cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if(singleMmap)
+    {
+        m_ring.sqRingSize = std::max(m_ring.sqRingSize, m_ring.cqRingSize);
+        m_ring.cqRingSize = 0;
+    }
+
+    m_ring.sqRing = mmap(nullptr,
+                         m_ring.sqRingSize,
+                         PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE,
+                         m_ring.fd,
+                         IORING_OFF_SQ_RING);
+    if(m_ring.sqRing == MAP_FAILED)
+    {
+        m_ring.sqRing = nullptr;
+        error.addMeesage("Failed to map submission-queue: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    if(singleMmap)
+    {
+        m_ring.cqRing = m_ring.sqRing;
+    }
+    else
+    {
+        m_ring.cqRing = mmap(nullptr,
+                             m_ring.cqRingSize,
+                             PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE,
+                             m_ring.fd,
+                             IORING_OFF_CQ_RING);
+        if(m_ring.cqRing == MAP_FAILED)
+        {
+            m_ring.cqRing = nullptr;
+            error.addMeesage("Failed to map completion-queue: " + std::string(strerror(errno)));
+            return false;
+        }
+    }
+
+    m_ring.sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    m_ring.sqes = mmap(nullptr,
+                       m_ring.sqesSize,
+                       PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE,
+                       m_ring.fd,
+                       IORING_OFF_SQES);
+    if(m_ring.sqes == MAP_FAILED)
+    {
+        m_ring.sqes = nullptr;
+        error.addMeesage("Failed to map submission-entries: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    uint8_t* sqRing = static_cast<uint8_t*>(m_ring.sqRing);
+    uint8_t* cqRing = static_cast<uint8_t*>(m_ring.cqRing);
+    m_ring.sqTail = reinterpret_cast<uint32_t*>(sqRing + params.sq_off.tail);
+    m_ring.sqMask = reinterpret_cast<uint32_t*>(sqRing + params.sq_off.ring_mask);
+    m_ring.sqArray = reinterpret_cast<uint32_t*>(sqRing + params.sq_off.array);
+    m_ring.cqHead = reinterpret_cast<uint32_t*>(cqRing + params.cq_off.head);
+    m_ring.cqTail = reinterpret_cast<uint32_t*>(cqRing + params.cq_off.tail);
+    m_ring.cqMask = reinterpret_cast<uint32_t*>(cqRing + params.cq_off.ring_mask);
+    m_ring.cqes = cqRing + params.cq_off.cqes;
+
+    // registered files and buffer avoid the lookup of the file-descriptors and the mapping of
+    // the buffer for each read
+    struct iovec bufferVec;
+    bufferVec.iov_base = m_buffer.data();
+    bufferVec.iov_len = m_buffer.size() * sizeof(uint64_t);
+    if(syscall(__NR_io_uring_register,
+               m_ring.fd,
+               IORING_REGISTER_FILES,
+               m_fds.data(),
+               m_fds.size()) != 0
+            || syscall(__NR_io_uring_register,
+                       m_ring.fd,
+                       IORING_REGISTER_BUFFERS,
+                       &bufferVec,
+                       1) != 0)
+    {
+        error.addMeesage("Failed to register files and buffer at io_uring: "
+                         + std::string(strerror(errno)));
+        error.addSolution("check the limit for locked memory with 'ulimit -l'");
+        return false;
+    }
+
+    return true;
+#else
+    error.addMeesage("Failed to create io_uring, because it was not available while building");
+    return false;
+#endif
+}
+
+/**
+ * @brief unmap the rings and close the io_uring
+ */
+void
+BatchedReader::closeIoUring()
+{
+    if(m_ring.sqes != nullptr) {
+        munmap(m_ring.sqes, m_ring.sqesSize);
+    }
+    if(m_ring.cqRing != nullptr
+            && m_ring.cqRing != m_ring.sqRing)
+    {
+        munmap(m_ring.cqRing, m_ring.cqRingSize);
+    }
+    if(m_ring.sqRing != nullptr) {
+        munmap(m_ring.sqRing, m_ring.sqRingSize);
+    }
+    if(m_ring.fd >= 0) {
+        close(m_ring.fd);
+    }
+
+    m_ring = IoUring();
+}
+
+/**
+ * @brief submit all reads as one batch and wait for their completion, which only needs one
+ *        syscall for up to 4096 reads
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if submitting failed, else true
+ */
+bool
+BatchedReader::readWithIoUring(ErrorContainer &error)
+{
+#ifdef KITSUNEMIMI_CPU_IO_URING
+    struct io_uring_sqe* sqes = static_cast<struct io_uring_sqe*>(m_ring.sqes);
+    const struct io_uring_cqe* cqes = static_cast<const struct io_uring_cqe*>(m_ring.cqes);
+    uint8_t* buffer = reinterpret_cast<uint8_t*>(m_buffer.data());
+    const uint32_t sqMask = *m_ring.sqMask;
+    const uint32_t cqMask = *m_ring.cqMask;
+
+    for(uint64_t start = 0; start < m_requests.size(); start += m_ring.numberOfEntries)
+    {
+        const uint64_t count = std::min(m_ring.numberOfEntries, m_requests.size() - start);
+
+        // fill submission-queue
+        const uint32_t tail = *m_ring.sqTail;
+        for(uint64_t i = 0; i < count; i++)
+        {
+            const ReadRequest &request = m_requests[start + i];
+            const uint32_t index = (tail + static_cast<uint32_t>(i)) & sqMask;
+            struct io_uring_sqe* sqe = &sqes[index];
+            memset(sqe, 0, sizeof(struct io_uring_sqe));
+            sqe->opcode = IORING_OP_READ_FIXED;
+            sqe->flags = IOSQE_FIXED_FILE;
+            sqe->fd = static_cast<int32_t>(request.fdPos);
+            sqe->off = request.fileOffset;
+            sqe->addr = reinterpret_cast<uint64_t>(buffer + request.bufferOffset);
+            sqe->len = static_cast<uint32_t>(request.size);
+            sqe->buf_index = 0;
+            sqe->user_data = start + i;
+            m_ring.sqArray[index] = index;
+        }
+        __atomic_store_n(m_ring.sqTail, tail + static_cast<uint32_t>(count), __ATOMIC_RELEASE);
+
+        // submit and wait for completions, until all reads of the batch are completed
+        uint64_t toSubmit = count;
+        uint64_t completed = 0;
+        while(completed < count)
+        {
+            const long ret = syscall(__NR_io_uring_enter,
+                                     m_ring.fd,
+                                     toSubmit,
+                                     count - completed,
+                                     IORING_ENTER_GETEVENTS,
+                                     nullptr,
+                                     0);
+            if(ret < 0)
+            {
+                if(errno == EINTR) {
+                    continue;
+                }
+                error.addMeesage("Failed to submit reads to io_uring: "
+                                 + std::string(strerror(errno)));
+                return false;
+            }
+            toSubmit -= std::min(toSubmit, static_cast<uint64_t>(ret));
+
+            uint32_t head = *m_ring.cqHead;
+            const uint32_t cqTail = __atomic_load_n(m_ring.cqTail, __ATOMIC_ACQUIRE);
+            while(head != cqTail)
+            {
+                const struct io_uring_cqe* cqe = &cqes[head & cqMask];
+                m_requests[cqe->user_data].result = cqe->res;
+                head++;
+                completed++;
+            }
+            __atomic_store_n(m_ring.cqHead, head, __ATOMIC_RELEASE);
+        }
+    }
+
+    return true;
+#else
+    error.addMeesage("Failed to read with io_uring, because it was not available while building");
+    return false;
+#endif
+}
+
+/**
+ * @brief read all registered files one after another with preadv
+ *
+ * @return always true, because errors are stored in the result of each read
+ */
+bool
+BatchedReader::readWithPreadv(ErrorContainer &)
+{
+    uint8_t* buffer = reinterpret_cast<uint8_t*>(m_buffer.data());
+    for(ReadRequest &request : m_requests)
+    {
+        struct iovec vec;
+        vec.iov_base = buffer + request.bufferOffset;
+        vec.iov_len = request.size;
+        const ssize_t ret = preadv(m_fds[request.fdPos],
+                                   &vec,
+                                   1,
+                                   static_cast<off_t>(request.fileOffset));
+        request.result = ret < 0 ? -errno : ret;
+    }
+
+    return true;
+}
+
+/**
+ * @brief read all registered files and registers of a single sampling-tick into the
+ *        preallocated buffer
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized or the batch can not be submitted, else true. Errors of
+ *         single reads are available with getResult.
+ */
+bool
+BatchedReader::readAll(ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to read, because batched-reader is not initialized");
+        return false;
+    }
+
+    bool success = false;
+    if(m_useIoUring) {
+        success = readWithIoUring(error);
+    } else {
+        success = readWithPreadv(error);
+    }
+    if(success == false) {
+        return false;
+    }
+
+    // terminate text-results, so they can be parsed directly
+    char* buffer = reinterpret_cast<char*>(m_buffer.data());
+    for(const ReadRequest &request : m_requests)
+    {
+        if(request.isMsr == false)
+        {
+            const int64_t length = std::max(request.result, static_cast<int64_t>(0));
+            buffer[request.bufferOffset + static_cast<uint64_t>(length)] = '\0';
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief get result of a read of a text-file, which contains a number, like the current speed
+ *
+ * @return false, if read failed or is not a read of a text-file, else true
+ */
+bool
+BatchedReader::getNumber(int64_t &result,
+                         const uint64_t readId) const
+{
+    const char* content = getContent(readId);
+    if(content == nullptr) {
+        return false;
+    }
+
+    char* end = nullptr;
+    result = strtoll(content, &end, 10);
+    return end != content;
+}
+
+/**
+ * @brief get result of a read of a model-specific register
+ *
+ * @return false, if read failed or is not a read of a register, else true
+ */
+bool
+BatchedReader::getMsrValue(uint64_t &result,
+                           const uint64_t readId) const
+{
+    if(readId >= m_requests.size()
+            || m_requests[readId].isMsr == false
+            || m_requests[readId].result != sizeof(uint64_t))
+    {
+        return false;
+    }
+
+    result = m_buffer[m_requests[readId].bufferOffset / sizeof(uint64_t)];
+    return true;
+}
+
+/**
+ * @brief get null-terminated content of a read of a text-file
+ *
+ * @return nullptr, if read failed or is not a read of a text-file, else pointer into the buffer
+ */
+const char*
+BatchedReader::getContent(const uint64_t readId) const
+{
+    if(readId >= m_requests.size()
+            || m_requests[readId].isMsr
+            || m_requests[readId].result <= 0)
+    {
+        return nullptr;
+    }
+
+    return reinterpret_cast<const char*>(m_buffer.data()) + m_requests[readId].bufferOffset;
+}
+
+/**
+ * @brief get number of read bytes or the negative error-number of a read of the last tick
+ */
+int64_t
+BatchedReader::getResult(const uint64_t readId) const
+{
+    if(readId >= m_requests.size()) {
+        return -EINVAL;
+    }
+
+    return m_requests[readId].result;
+}
+
+} // namespace Kitsunemimi
@@ -0,0 +1,387 @@
+/**
+ *  @file       cgroup.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/cgroup.h>
+#include <libKitsunemimiCpu/cpu_set.h>
+
+#include <libKitsunemimiCommon/methods/string_methods.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
+namespace Kitsunemimi
+{
+
+const std::string cgroupMountPath = "/sys/fs/cgroup";
+
+/**
+ * @brief read first line of a cgroup-file
+ *
+ * @param result reference for the content
+ * @param filePath path of the file
+ *
+ * @return false, if file can not be read, else true
+ */
+bool
+readCgroupFile(std::string &result,
+               const std::string &filePath)
+{
+    std::ifstream inFile(filePath);
+    if(inFile.is_open() == false) {
+        return false;
+    }
+
+    std::getline(inFile, result);
+    Kitsunemimi::trim(result);
+
+    return result != "";
+}
+
+/**
+ * @brief check which cgroup-version is mounted on the system
+ *
+ * @return NO_CGROUP, if no cgroup was found, else the version of the cgroup
+ */
+CgroupVersion
+getCgroupVersion()
+{
+    if(std::filesystem::exists(cgroupMountPath + "/cgroup.controllers")) {
+        return CGROUP_V2;
+    }
+    if(std::filesystem::exists(cgroupMountPath + "/memory")
+            || std::filesystem::exists(cgroupMountPath + "/cpu"))
+    {
+        return CGROUP_V1;
+    }
+
+    return NO_CGROUP;
+}
+
+/**
+ * @brief get directory of the cgroup of the current process
+ *
+ * @param result reference for the resulting absolute path
+ * @param controller name of the controller for cgroup v1 (for example "memory" or "cpu").
+ *                   For cgroup v2 this value is ignored.
+ * @param error reference for error-output
+ *
+ * @return false, if no cgroup was found, else true
+ */
+bool
+getCgroupPath(std::string &result,
+              const std::string &controller,
+              ErrorContainer &error)
+{
+    const CgroupVersion version = getCgroupVersion();
+    if(version == NO_CGROUP)
+    {
+        error.addMeesage("No cgroup found in '" + cgroupMountPath + "'");
+        return false;
+    }
+
+    const std::string filePath = "/proc/self/cgroup";
+    std::ifstream inFile(filePath);
+    if(inFile.is_open() == false)
+    {
+        error.addMeesage("can not open file to read content: '" + filePath + "'");
+        return false;
+    }
+
+    // lines have the form "<id>:<controller-list>:<path>"
+    std::string line;
+    while(std::getline(inFile, line))
+    {
+        const size_t first = line.find(':');
+        const size_t second = line.find(':', first + 1);
+        if(first == std::string::npos || second == std::string::npos) {
+            continue;
+        }
+
+        const std::string controllers = line.substr(first + 1, second - first - 1);
+        const std::string path = line.substr(second + 1);
+        std::string mountPath = "";
+
+        if(version == CGROUP_V2)
+        {
+            if(controllers != "") {
+                continue;
+            }
+            mountPath = cgroupMountPath;
+        }
+        else
+        {
+            std::vector<std::string> controllerList;
+            Kitsunemimi::splitStringByDelimiter(controllerList, controllers, ',');
+            if(std::find(controllerList.begin(), controllerList.end(), controller)
+                    == controllerList.end())
+            {
+                continue;
+            }
+            mountPath = cgroupMountPath + "/" + controller;
+        }
+
+        // inside of a container without cgroup-namespace the path of the host is shown, but
+        // only the cgroup of the container is mounted
+        result = mountPath + path;
+        if(std::filesystem::exists(result) == false) {
+            result = mountPath;
+        }
+
+        return true;
+    }
+
+    error.addMeesage("No cgroup found for controller '" + controller + "'");
+    return false;
+}
+
+/**
+ * @brief get directory of the cgroup of the current process and all of its parent-directories,
+ *        because the limits of the parents are also valid for the child
+ *
+ * @param result reference for the resulting absolute paths, beginning with the own cgroup
+ * @param controller name of the controller for cgroup v1
+ * @param error reference for error-output
+ *
+ * @return false, if no cgroup was found, else true
+ */
+bool
+getCgroupPaths(std::vector<std::string> &result,
+               const std::string &controller,
+               ErrorContainer &error)
+{
+    std::string path = "";
+    if(getCgroupPath(path, controller, error) == false) {
+        return false;
+    }
+
+    result.clear();
+    std::filesystem::path current(path);
+    while(true)
+    {
+        result.push_back(current.string());
+        if(current.string().size() <= cgroupMountPath.size()
+                || current.has_parent_path() == false)
+        {
+            break;
+        }
+        current = current.parent_path();
+    }
+
+    return true;
+}
+
+/**
+ * @brief get memory-limit of the cgroup of the current process
+ *
+ * @param result reference for the limit in bytes, which is UINT64_MAX, if no limit is set
+ * @param error reference for error-output
+ *
+ * @return false, if no cgroup was found, else true
+ */
+bool
+getCgroupMemoryLimit(uint64_t &result,
+                     ErrorContainer &error)
+{
+    std::vector<std::string> paths;
+    if(getCgroupPaths(paths, "memory", error) == false) {
+        return false;
+    }
+
+    const std::string fileName = getCgroupVersion() == CGROUP_V2 ? "/memory.max"
+                                                                 : "/memory.limit_in_bytes";
+    result = UINT64_MAX;
+    for(const std::string &path : paths)
+    {
+        std::string content = "";
+        if(readCgroupFile(content, path + fileName) == false
+                || content == "max")
+        {
+            continue;
+        }
+
+        result = std::min(result, static_cast<uint64_t>(std::stoull(content)));
+    }
+
+    return true;
+}
+
+/**
+ * @brief get current memory-usage of the cgroup of the current process
+ *
+ * @param result reference for the usage in bytes
+ * @param error reference for error-output
+ *
+ * @return false, if no cgroup was found, else true
+ */
+bool
+getCgroupMemoryUsage(uint64_t &result,
+                     ErrorContainer &error)
+{
+    std::string path = "";
+    if(getCgroupPath(path, "memory", error) == false) {
+        return false;
+    }
+
+    const std::string filePath = getCgroupVersion() == CGROUP_V2 ? path + "/memory.current"
+                                                                 : path + "/memory.usage_in_bytes";
+    std::string content = "";
+    if(readCgroupFile(content, filePath) == false)
+    {
+        error.addMeesage("Failed to read memory-usage of the cgroup from '" + filePath + "'");
+        return false;
+    }
+
+    result = std::stoull(content);
+    return true;
+}
+
+/**
+ * @brief get amount of inactive file-backed memory of the cgroup of the current process, which
+ *        is included in the memory-usage, but can be reclaimed by the kernel before the limit
+ *        is reached
+ *
+ * @param result reference for the inactive file-memory in bytes
+ * @param error reference for error-output
+ *
+ * @return false, if no cgroup was found or the memory-stats can not be read, else true
+ */
+bool
+getCgroupMemoryInactiveFile(uint64_t &result,
+                            ErrorContainer &error)
+{
+    std::string path = "";
+    if(getCgroupPath(path, "memory", error) == false) {
+        return false;
+    }
+
+    // cgroup v1 contains the value for the cgroup with all of its children as separate key
+    const std::string searchKey = getCgroupVersion() == CGROUP_V2 ? "inactive_file"
+                                                                  : "total_inactive_file";
+    const std::string filePath = path + "/memory.stat";
+    std::ifstream inFile(filePath);
+    std::string key = "";
+    std::string value = "";
+    while(inFile >> key >> value)
+    {
+        if(key != searchKey) {
+            continue;
+        }
+
+        char* end = nullptr;
+        result = strtoull(value.c_str(), &end, 10);
+        if(end == value.c_str()
+                || *end != '\0')
+        {
+            break;
+        }
+
+        return true;
+    }
+
+    error.addMeesage("Failed to read inactive file-memory of the cgroup from '"
+                     + filePath + "'");
+    return false;
+}
+
+/**
+ * @brief get cpu-bandwidth-limit of the cgroup of the current process
+ *
+ * @param result reference for the limit in number of cpu-threads, which is 0.0,
+ *               if no limit is set
+ * @param error reference for error-output
+ *
+ * @return false, if no cgroup was found, else true
+ */
+bool
+getCgroupCpuLimit(double &result,
+                  ErrorContainer &error)
+{
+    const CgroupVersion version = getCgroupVersion();
+    std::vector<std::string> paths;
+    if(getCgroupPaths(paths, "cpu", error) == false) {
+        return false;
+    }
+
+    result = 0.0;
+    for(const std::string &path : paths)
+    {
+        std::string quota = "";
+        std::string period = "";
+        if(version == CGROUP_V2)
+        {
+            // cpu.max has the form "<quota> <period>" or "max <period>"
+            std::string content = "";
+            if(readCgroupFile(content, path + "/cpu.max") == false) {
+                continue;
+            }
+            std::istringstream stream(content);
+            stream >> quota >> period;
+        }
+        else
+        {
+            if(readCgroupFile(quota, path + "/cpu.cfs_quota_us") == false
+                    || readCgroupFile(period, path + "/cpu.cfs_period_us") == false)
+            {
+                continue;
+            }
+        }
+
+        if(quota == "max"
+                || quota == "-1"
+                || period == "")
+        {
+            continue;
+        }
+
+        const double limit = std::stod(quota) / std::stod(period);
+        if(result == 0.0 || limit < result) {
+            result = limit;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief get number of cpu-threads in the cpuset of the cgroup of the current process
+ *
+ * @param result reference for the result
+ * @param error reference for error-output
+ *
+ * @return false, if no cpuset was found, else true
+ */
+bool
+getCgroupCpuThreads(uint64_t &result,
+                    ErrorContainer &error)
+{
+    std::string path = "";
+    if(getCgroupPath(path, "cpuset", error) == false) {
+        return false;
+    }
+
+    const std::string filePath = getCgroupVersion() == CGROUP_V2
+                                 ? path + "/cpuset.cpus.effective"
+                                 : path + "/cpuset.effective_cpus";
+    std::string content = "";
+    CpuSet cpuSet;
+    if(readCgroupFile(content, filePath) == false
+            || cpuSet.parse(content) == false
+            || cpuSet.isEmpty())
+    {
+        error.addMeesage("Failed to read cpuset of the cgroup from '" + filePath + "'");
+        return false;
+    }
+
+    result = cpuSet.count();
+    return true;
+}
+
+} // namespace Kitsunemimi
@@ -0,0 +1,457 @@
+/**
+ *  @file       core_latency.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/core_latency.h>
+#include <libKitsunemimiCpu/cpu.h>
+
+#include <libKitsunemimiCommon/methods/string_methods.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief cache-line, which is send between the two threads
+ */
+struct alignas(64) PingPongLine
+{
+    std::atomic<uint64_t> value;
+    std::atomic<bool> failed;
+    uint8_t padding[64 - sizeof(std::atomic<uint64_t>) - sizeof(std::atomic<bool>)];
+};
+
+/**
+ * @brief bind the calling thread to a single cpu-thread
+ */
+bool
+bindToSingleThread(const uint64_t threadId)
+{
+    ErrorContainer error;
+    CpuSet target;
+    target.add(threadId);
+    return setThreadAffinity(target, error);
+}
+
+/**
+ * @brief measure the one-way latency between two cpu-threads by moving a cache-line between them
+ *
+ * @param result reference for the latency in nanoseconds
+ * @param threadIdA id of the first cpu-thread
+ * @param threadIdB id of the second cpu-thread
+ * @param numberOfRoundTrips number of round-trips to measure
+ *
+ * @return false, if one of the threads can not be bound to its cpu-thread, else true
+ */
+bool
+measurePairLatency(double &result,
+                   const uint64_t threadIdA,
+                   const uint64_t threadIdB,
+                   const uint64_t numberOfRoundTrips)
+{
+    PingPongLine line;
+    line.value.store(0);
+    line.failed.store(false);
+
+    // a few round-trips are done before the measuring, to bring both threads in a stable state
+    const uint64_t warmup = numberOfRoundTrips / 10 + 1;
+    const uint64_t total = warmup + numberOfRoundTrips;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+
+    // responder answers each odd value with the next even value
+    std::thread responder([&]()
+    {
+        if(bindToSingleThread(threadIdB) == false)
+        {
+            line.failed.store(true);
+            return;
+        }
+
+        for(uint64_t i = 0; i < total; i++)
+        {
+            const uint64_t expected = 2 * i + 1;
+            while(line.value.load(std::memory_order_acquire) != expected)
+            {
+                if(line.failed.load(std::memory_order_relaxed)) {
+                    return;
+                }
+            }
+            line.value.store(expected + 1, std::memory_order_release);
+        }
+    });
+
+    // initiator sends odd values and wait for the answer
+    std::thread initiator([&]()
+    {
+        if(bindToSingleThread(threadIdA) == false)
+        {
+            line.failed.store(true);
+            return;
+        }
+
+        for(uint64_t i = 0; i < total; i++)
+        {
+            if(i == warmup) {
+                start = std::chrono::steady_clock::now();
+            }
+
+            line.value.store(2 * i + 1, std::memory_order_release);
+            while(line.value.load(std::memory_order_acquire) != 2 * i + 2)
+            {
+                if(line.failed.load(std::memory_order_relaxed)) {
+                    return;
+                }
+            }
+        }
+
+        end = std::chrono::steady_clock::now();
+    });
+
+    initiator.join();
+    responder.join();
+
+    if(line.failed.load()) {
+        return false;
+    }
+
+    const double nanoSec = std::chrono::duration<double, std::nano>(end - start).count();
+    result = nanoSec / static_cast<double>(2 * numberOfRoundTrips);
+
+    return true;
+}
+
+/**
+ * @brief measure the latency between all pairs of a set of cpu-threads
+ *
+ * @param result reference for the resulting matrix
+ * @param threads cpu-threads to measure
+ * @param numberOfRoundTrips number of round-trips for each pair (at least 1)
+ * @param error reference for error-output
+ *
+ * @return false, if the number of round-trips is 0 or any pair can not be measured, else true
+ */
+bool
+measureCoreLatency(CoreLatencyMatrix &result,
+                   const CpuSet &threads,
+                   const uint64_t numberOfRoundTrips,
+                   ErrorContainer &error)
+{
+    if(threads.count() < 2)
+    {
+        error.addMeesage("Failed to measure core-latency, because at least two cpu-threads "
+                         "are necessary");
+        return false;
+    }
+
+    if(numberOfRoundTrips == 0)
+    {
+        error.addMeesage("Failed to measure core-latency, because the number of round-trips "
+                         "is 0");
+        return false;
+    }
+
+    result.threadIds = threads.getThreadIds();
+    const uint64_t size = result.threadIds.size();
+    result.latencies.assign(size * size, 0.0);
+
+    for(uint64_t a = 0; a < size; a++)
+    {
+        for(uint64_t b = a + 1; b < size; b++)
+        {
+            double latency = 0.0;
+            if(measurePairLatency(latency,
+                                  result.threadIds[a],
+                                  result.threadIds[b],
+                                  numberOfRoundTrips) == false)
+            {
+                error.addMeesage("Failed to measure core-latency between cpu-threads '"
+                                 + std::to_string(result.threadIds[a])
+                                 + "' and '"
+                                 + std::to_string(result.threadIds[b])
+                                 + "'");
+                error.addSolution("Check if both cpu-threads are online and allowed by the "
+                                  "affinity-mask of the process");
+                return false;
+            }
+
+            result.latencies[a * size + b] = latency;
+            result.latencies[b * size + a] = latency;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief get model-name of the cpu, which is used as key for the cache-file
+ *
+ * @return model-name or "unknown", if not found
+ */
+const std::string
+getCpuModelName()
+{
+    std::ifstream inFile("/proc/cpuinfo");
+    std::string line;
+    while(std::getline(inFile, line))
+    {
+        if(line.compare(0, 10, "model name") != 0) {
+            continue;
+        }
+
+        const size_t pos = line.find(':');
+        if(pos == std::string::npos) {
+            continue;
+        }
+
+        std::string name = line.substr(pos + 1);
+        Kitsunemimi::trim(name);
+        return name;
+    }
+
+    return "unknown";
+}
+
+/**
+ * @brief get path of the cache-file for a cpu-model and a set of measured cpu-threads, so
+ *        measurements of different sets don't overwrite each other
+ */
+const std::string
+getCoreLatencyCachePath(const std::string &cacheDirectory,
+                        const std::string &cpuModel,
+                        const CpuSet &threads)
+{
+    std::string fileName = "core_latency_";
+    for(const char c : cpuModel) {
+        fileName += isalnum(c) ? c : '_';
+    }
+
+    // fragmented cpu-lists can be longer than the limit of file-names, so they are replaced
+    // by their FNV-1a hash
+    std::string cpuList = threads.toString();
+    if(cpuList.size() > 64)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for(const char c : cpuList)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 1099511628211ULL;
+        }
+
+        char hashString[17];
+        snprintf(hashString, sizeof(hashString), "%016lx", static_cast<unsigned long>(hash));
+        cpuList = hashString;
+    }
+
+    fileName += "_";
+    for(const char c : cpuList) {
+        fileName += isalnum(c) ? c : '_';
+    }
+
+    return cacheDirectory + "/" + fileName + ".txt";
+}
+
+/**
+ * @brief read matrix from a cache-file
+ *
+ * @return false, if file doesn't exist or doesn't match the cpu-model and threads, else true
+ */
+bool
+readCoreLatencyCache(CoreLatencyMatrix &result,
+                     const std::string &filePath,
+                     const std::string &cpuModel,
+                     const CpuSet &threads)
+{
+    std::ifstream inFile(filePath);
+    if(inFile.is_open() == false) {
+        return false;
+    }
+
+    // first line is the cpu-model and the second line the cpu-list of the measured threads
+    std::string model = "";
+    std::string cpuList = "";
+    std::getline(inFile, model);
+    std::getline(inFile, cpuList);
+
+    CpuSet cachedThreads;
+    if(model != cpuModel
+            || cachedThreads.parse(cpuList) == false
+            || cachedThreads != threads)
+    {
+        return false;
+    }
+
+    result.cpuModel = model;
+    result.threadIds = threads.getThreadIds();
+    const uint64_t size = result.threadIds.size();
+    result.latencies.assign(size * size, 0.0);
+    for(uint64_t i = 0; i < size * size; i++)
+    {
+        inFile >> result.latencies[i];
+        if(inFile.fail()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief write matrix into a cache-file
+ */
+bool
+writeCoreLatencyCache(const CoreLatencyMatrix &matrix,
+                      const std::string &filePath,
+                      const CpuSet &threads)
+{
+    std::ofstream outFile(filePath, std::ios_base::trunc);
+    if(outFile.is_open() == false) {
+        return false;
+    }
+
+    outFile << matrix.cpuModel << "\n" << threads.toString() << "\n";
+    const uint64_t size = matrix.threadIds.size();
+    for(uint64_t a = 0; a < size; a++)
+    {
+        for(uint64_t b = 0; b < size; b++) {
+            outFile << matrix.get(a, b) << (b + 1 == size ? "\n" : " ");
+        }
+    }
+
+    return outFile.good();
+}
+
+/**
+ * @brief get latency-matrix from the cache-file of the cpu-model or measure and cache it,
+ *        if there is no matching cache-file
+ *
+ * @param result reference for the resulting matrix
+ * @param threads cpu-threads to measure
+ * @param cacheDirectory directory for the cache-files
+ * @param error reference for error-output
+ *
+ * @return false, if measuring failed, else true
+ */
+bool
+getCoreLatency(CoreLatencyMatrix &result,
+               const CpuSet &threads,
+               const std::string &cacheDirectory,
+               ErrorContainer &error)
+{
+    const std::string cpuModel = getCpuModelName();
+    const std::string filePath = getCoreLatencyCachePath(cacheDirectory, cpuModel, threads);
+
+    if(readCoreLatencyCache(result, filePath, cpuModel, threads)) {
+        return true;
+    }
+
+    const uint64_t numberOfRoundTrips = 10000;
+    if(measureCoreLatency(result, threads, numberOfRoundTrips, error) == false) {
+        return false;
+    }
+    result.cpuModel = cpuModel;
+
+    // the cache is only an optimization, so a failed write is not an error
+    if(writeCoreLatencyCache(result, filePath, threads) == false) {
+        LOG_WARNING("Failed to write core-latency into cache-file '" + filePath + "'");
+    }
+
+    return true;
+}
+
+/**
+ * @brief get communication-distance between two cpu-threads
+ *
+ * @param result reference for the latency in nanoseconds
+ * @param matrix measured latency-matrix
+ * @param threadIdA id of the first cpu-thread
+ * @param threadIdB id of the second cpu-thread
+ *
+ * @return false, if one of the threads is not part of the matrix, else true
+ */
+bool
+getCommunicationDistance(double &result,
+                         const CoreLatencyMatrix &matrix,
+                         const uint64_t threadIdA,
+                         const uint64_t threadIdB)
+{
+    int64_t posA = -1;
+    int64_t posB = -1;
+    for(uint64_t i = 0; i < matrix.threadIds.size(); i++)
+    {
+        if(matrix.threadIds[i] == threadIdA) {
+            posA = i;
+        }
+        if(matrix.threadIds[i] == threadIdB) {
+            posB = i;
+        }
+    }
+
+    if(posA < 0 || posB < 0) {
+        return false;
+    }
+
+    result = matrix.get(posA, posB);
+    return true;
+}
+
+/**
+ * @brief group cpu-threads, which can communicate cheap with each other, for example the threads
+ *        of the same CCX. Two threads are in the same group, if they are connected by a chain of
+ *        pairs with a latency below the given maximum.
+ *
+ * @param result reference for the resulting groups
+ * @param matrix measured latency-matrix
+ * @param maxLatency maximum latency in nanoseconds within a group
+ */
+void
+getCommunicationGroups(std::vector<CpuSet> &result,
+                       const CoreLatencyMatrix &matrix,
+                       const double maxLatency)
+{
+    result.clear();
+
+    const uint64_t size = matrix.threadIds.size();
+    std::vector<bool> assigned(size, false);
+    for(uint64_t start = 0; start < size; start++)
+    {
+        if(assigned[start]) {
+            continue;
+        }
+
+        // depth-first-search over all pairs below the maximum latency
+        CpuSet group;
+        std::vector<uint64_t> stack = {start};
+        assigned[start] = true;
+        while(stack.size() > 0)
+        {
+            const uint64_t current = stack.back();
+            stack.pop_back();
+            group.add(matrix.threadIds[current]);
+
+            for(uint64_t other = 0; other < size; other++)
+            {
+                if(assigned[other] == false
+                        && matrix.get(current, other) <= maxLatency)
+                {
+                    assigned[other] = true;
+                    stack.push_back(other);
+                }
+            }
+        }
+
+        result.push_back(group);
+    }
+}
+
+} // namespace Kitsunemimi
@@ -7,13 +7,28 @@
  */
 
 #include <libKitsunemimiCpu/cpu.h>
+#include <libKitsunemimiCpu/cgroup.h>
 
 #include <libKitsunemimiCommon/methods/string_methods.h>
 #include <libKitsunemimiCommon/methods/file_methods.h>
 
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+
 namespace Kitsunemimi
 {
 
+// highest cpu-thread-id, which is accepted from /proc/stat, same limit like for cpu-lists
+const uint64_t maxStatCpuThreadId = 65535;
+
 /**
  * @brief generic function to get file-content of a requested file
  *
@@ -50,7 +65,7 @@ getInfo(const std::string &filePath,
 }
 
 /**
- * @brief get max-value of a range-info-output
+ * @brief get number of entries of a range-info-output, like "0-3,8-11"
  *
  * @param result reference for result-output
  * @param info string with the info to parse
@@ -61,21 +76,48 @@ bool
 getRangeInfo(uint64_t &result,
              const std::string &info)
 {
-    // handle case of only one core
-    if(info == "0")
+    CpuSet cpuSet;
+    if(cpuSet.parse(info) == false
+            || cpuSet.isEmpty())
     {
-        result = 1;
-        return true;
+        return false;
+    }
+
+    result = cpuSet.count();
+    return true;
+}
+
+/**
+ * @brief read a file, which contains a cpu-list
+ *
+ * @param result reference for result-output
+ * @param filePath path to the file
+ * @param error reference for error-output
+ *
+ * @return false, if file can not be read or is broken, else true
+ */
+bool
+getCpuListInfo(CpuSet &result,
+               const std::string &filePath,
+               ErrorContainer &error)
+{
+    // getInfo can not be used here, because an empty file is valid in this case
+    std::ifstream inFile(filePath);
+    if(inFile.is_open() == false)
+    {
+        error.addMeesage("can not open file to read content: '" + filePath + "'");
+        error.addSolution("check if the file  '" + filePath + "' exist on your system");
+        return false;
     }
 
-    // process content
-    std::vector<std::string> numberRange;
-    Kitsunemimi::splitStringByDelimiter(numberRange, info, '-');
-    if(numberRange.size() < 2) {
+    std::string content = "";
+    std::getline(inFile, content);
+    if(result.parse(content) == false)
+    {
+        error.addMeesage("Failed to parse cpu-list '" + content + "' of file '" + filePath + "'");
         return false;
     }
 
-    result = std::stoi(numberRange.at(1)) + 1;
     return true;
 }
 
@@ -104,9 +146,14 @@ writeToFile(const std::string &filePath,
         return false;
     }
 
-    // update file
+    // update file. The kernel rejects invalid values or states only while flushing
     outputFile << value;
     outputFile.flush();
+    if(outputFile.fail())
+    {
+        error.addMeesage("Failed to write value '" + value + "' into file '" + filePath + "'");
+        return false;
+    }
     outputFile.close();
 
     return true;
@@ -174,7 +221,9 @@ getNumberOfCpuPackages(uint64_t &result,
 }
 
 /**
- * @brief get total number of cpu-threads of all cpu-sockets of the system
+ * @brief get number of online cpu-threads of all cpu-sockets of the system. The ids of the
+ *        cpu-threads are not necessarily continuous, so getOnlineCpuThreads has to be used to
+ *        iterate over them.
  *
  * @param result reference for result-output
  * @param error reference for error-output
@@ -186,7 +235,7 @@ getNumberOfCpuThreads(uint64_t &result,
                       ErrorContainer &error)
 {
     // get info from requested file
-    const std::string filePath = "/sys/devices/system/cpu/possible";
+    const std::string filePath = "/sys/devices/system/cpu/online";
     const std::string info = getInfo(filePath, error);
     if(info == "")
     {
@@ -209,6 +258,172 @@ getNumberOfCpuThreads(uint64_t &result,
     return true;
 }
 
+/**
+ * @brief get number of cpu-threads, which can really be used by the current process. This
+ *        respects the affinity-mask of the process and the cpuset and cpu-bandwidth-limit of its
+ *        cgroup, so inside of a container not the number of threads of the host is returned.
+ *
+ * @param result reference for result-output
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getNumberOfUsableCpuThreads(uint64_t &result,
+                            ErrorContainer &error)
+{
+    // affinity-mask of the process, which has to be dynamic sized for more than 1024 threads
+    CpuSet affinity;
+    if(getThreadAffinity(affinity, error) == false)
+    {
+        error.addMeesage("Failed to get number of usable cpu-threads, "
+                         "because the affinity-mask of the process can not be read");
+        return false;
+    }
+    uint64_t usable = affinity.count();
+
+    // cgroup-limits are optional, because not every system use cgroups
+    ErrorContainer cgroupError;
+    uint64_t cpusetThreads = 0;
+    if(getCgroupCpuThreads(cpusetThreads, cgroupError)) {
+        usable = std::min(usable, cpusetThreads);
+    }
+
+    double cpuLimit = 0.0;
+    if(getCgroupCpuLimit(cpuLimit, cgroupError)
+            && cpuLimit > 0.0)
+    {
+        usable = std::min(usable, static_cast<uint64_t>(std::ceil(cpuLimit)));
+    }
+
+    result = usable;
+    return true;
+}
+
+/**
+ * @brief get all cpu-threads, which can ever be available on the system
+ *
+ * @param result reference for result-output
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getPossibleCpuThreads(CpuSet &result,
+                      ErrorContainer &error)
+{
+    return getCpuListInfo(result, "/sys/devices/system/cpu/possible", error);
+}
+
+/**
+ * @brief get all cpu-threads, which are physically present in the system
+ *
+ * @param result reference for result-output
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getPresentCpuThreads(CpuSet &result,
+                     ErrorContainer &error)
+{
+    return getCpuListInfo(result, "/sys/devices/system/cpu/present", error);
+}
+
+/**
+ * @brief get all cpu-threads, which are currently online and can be used
+ *
+ * @param result reference for result-output
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getOnlineCpuThreads(CpuSet &result,
+                    ErrorContainer &error)
+{
+    return getCpuListInfo(result, "/sys/devices/system/cpu/online", error);
+}
+
+/**
+ * @brief get all cpu-threads, which are currently offline
+ *
+ * @param result reference for result-output
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getOfflineCpuThreads(CpuSet &result,
+                     ErrorContainer &error)
+{
+    return getCpuListInfo(result, "/sys/devices/system/cpu/offline", error);
+}
+
+/**
+ * @brief check if a specific cpu-thread is online
+ *
+ * @param threadId id of the thread to check
+ * @param error reference for error-output
+ *
+ * @return true, if online, else false
+ */
+bool
+isCpuThreadOnline(const uint64_t threadId,
+                  ErrorContainer &error)
+{
+    CpuSet online;
+    if(getOnlineCpuThreads(online, error) == false)
+    {
+        error.addMeesage("Failed to check if cpu-thread with id '"
+                         + std::to_string(threadId)
+                         + "' is online");
+        return false;
+    }
+
+    return online.contains(threadId);
+}
+
+/**
+ * @brief bring a cpu-thread online or offline
+ *
+ * @param threadId id of the thread to change
+ * @param newState true to bring the thread online and false to bring it offline
+ * @param error reference for error-output
+ *
+ * @return false, if no permission to update files or thread can not be hotplugged, else true
+ */
+bool
+setCpuThreadOnline(const uint64_t threadId,
+                   const bool newState,
+                   ErrorContainer &error)
+{
+    // check if already in the requested state
+    CpuSet online;
+    if(getOnlineCpuThreads(online, error) == false) {
+        return false;
+    }
+    if(online.contains(threadId) == newState) {
+        return true;
+    }
+
+    // cpu0 has in most cases no online-file, because it can not be set offline
+    const std::string filePath = "/sys/devices/system/cpu/cpu"
+                                 + std::to_string(threadId)
+                                 + "/online";
+    if(writeToFile(filePath, newState ? "1" : "0", error) == false)
+    {
+        error.addMeesage("Failed to set cpu-thread with id '"
+                         + std::to_string(threadId)
+                         + "' "
+                         + (newState ? "online" : "offline"));
+        error.addSolution("Check if the cpu-thread supports hotplug");
+        return false;
+    }
+
+    return true;
+}
+
 /**
  * @brief check if hyperthreading is enabled on the system
  *
@@ -399,7 +614,7 @@ getCpuSiblingId(uint64_t &result,
                 ErrorContainer &error)
 {
     // if hyperthreading is not enabled, there are no siblings possible
-    if(isHyperthreadingEnabled(error))
+    if(isHyperthreadingEnabled(error) == false)
     {
         error.addMeesage("Failed to get sibling-id of the cpu-thread with id: '"
                          + std::to_string(threadId)
@@ -413,9 +628,9 @@ getCpuSiblingId(uint64_t &result,
                                  + std::to_string(threadId)
                                  + "/topology/thread_siblings_list";
 
-    // get info from requested file
-    const std::string info = getInfo(filePath, error);
-    if(info == "")
+    // get info from requested file, which can be a list like "1,5" or a range like "0-1"
+    CpuSet siblings;
+    if(getCpuListInfo(siblings, filePath, error) == false)
     {
         error.addMeesage("Failed to get sibling-id of the cpu-thread with id: '"
                          + std::to_string(threadId)
@@ -423,25 +638,151 @@ getCpuSiblingId(uint64_t &result,
         return false;
     }
 
-    // process content
-    std::vector<std::string> siblings;
-    Kitsunemimi::splitStringByDelimiter(siblings, info, ',');
-    if(siblings.size() < 2)
+    // filter correct result from the output
+    siblings.remove(threadId);
+    if(siblings.isEmpty())
     {
         error.addMeesage("Failed to get sibling-id of the cpu-thread with id: '"
                              + std::to_string(threadId) + "'");
-        error.addSolution("Check if file '" + filePath + "' has contains a comma-separated"
-                          " list of thread-ids");
+        error.addSolution("Check if file '" + filePath + "' has contains a list of thread-ids");
         return false;
     }
 
-    // filter correct result from the output
-    const uint64_t second = std::stoi(siblings.at(1));
-    if(second == threadId) {
-        return std::stoi(siblings.at(0));
+    result = siblings.getThreadIds().at(0);
+    return true;
+}
+
+/**
+ * @brief get all cpu-threads of the physical core of a cpu-thread
+ *
+ * @param result reference for result-output, which includes the thread itself
+ * @param threadId id of an online cpu-thread
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getCpuSiblingThreads(CpuSet &result,
+                     const uint64_t threadId,
+                     ErrorContainer &error)
+{
+    const std::string filePath = "/sys/devices/system/cpu/cpu"
+                                 + std::to_string(threadId)
+                                 + "/topology/thread_siblings_list";
+    if(getCpuListInfo(result, filePath, error) == false)
+    {
+        error.addMeesage("Failed to get siblings of the cpu-thread with id: '"
+                         + std::to_string(threadId)
+                         + "'");
+        error.addSolution("Check if the cpu-thread is online");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief disable hyperthreading only for the physical cores of a set of cpu-threads, by setting
+ *        all other threads of these cores offline. So latency-critical threads get the whole
+ *        core, while the rest of the system keeps hyperthreading.
+ *
+ * @param offlinedThreads reference for the cpu-threads, which were set offline by this call,
+ *                        to restore them later with restoreCoreSiblings
+ * @param threads cpu-threads, which should stay online. Only one thread of each core is allowed.
+ * @param error reference for error-output
+ *
+ * @return false, if multiple threads of the same core are given or any sibling can not be set
+ *         offline, else true. Siblings, which were already set offline before the failure, are
+ *         still returned in offlinedThreads.
+ */
+bool
+disableCoreSiblings(CpuSet &offlinedThreads,
+                    const CpuSet &threads,
+                    ErrorContainer &error)
+{
+    offlinedThreads.clear();
+
+    // collect all siblings before changing anything, because the topology-files of offline
+    // threads don't exist anymore
+    CpuSet toOffline;
+    for(const uint64_t threadId : threads)
+    {
+        CpuSet siblings;
+        if(getCpuSiblingThreads(siblings, threadId, error) == false) {
+            return false;
+        }
+        siblings.remove(threadId);
+
+        // a requested thread must never be set offline as sibling of another requested thread
+        if(siblings.intersects(threads))
+        {
+            error.addMeesage("Failed to disable siblings of cores of cpu-threads '"
+                             + threads.toString()
+                             + "', because cpu-thread '"
+                             + std::to_string(threadId)
+                             + "' shares its core with other requested cpu-threads");
+            error.addSolution("give only one cpu-thread of each physical core");
+            return false;
+        }
+        toOffline |= siblings;
+    }
+
+    for(const uint64_t threadId : toOffline)
+    {
+        if(isCpuThreadOnline(threadId, error) == false) {
+            continue;
+        }
+        if(setCpuThreadOnline(threadId, false, error) == false)
+        {
+            error.addMeesage("Failed to disable siblings of cores of cpu-threads '"
+                             + threads.toString()
+                             + "'");
+            return false;
+        }
+
+        // only threads, which are really offline, are allowed to be restored later
+        CpuSet online;
+        if(getOnlineCpuThreads(online, error) == false) {
+            return false;
+        }
+        if(online.contains(threadId))
+        {
+            error.addMeesage("Failed to disable siblings of cores of cpu-threads '"
+                             + threads.toString()
+                             + "', because cpu-thread '"
+                             + std::to_string(threadId)
+                             + "' is still online");
+            return false;
+        }
+        offlinedThreads.add(threadId);
+    }
+
+    return true;
+}
+
+/**
+ * @brief set cpu-threads online again, which were set offline by disableCoreSiblings
+ *
+ * @param offlinedThreads cpu-threads, which were set offline
+ * @param error reference for error-output
+ *
+ * @return false, if any thread can not be set online, else true
+ */
+bool
+restoreCoreSiblings(const CpuSet &offlinedThreads,
+                    ErrorContainer &error)
+{
+    bool result = true;
+    for(const uint64_t threadId : offlinedThreads) {
+        result &= setCpuThreadOnline(threadId, true, error);
+    }
+
+    if(result == false)
+    {
+        error.addMeesage("Failed to restore siblings '" + offlinedThreads.toString() + "'");
+        return false;
     }
 
-    result = second;
     return true;
 }
 
@@ -811,4 +1152,1535 @@ getPkgTemperature(const uint64_t pkgFileId,
     return (double)temp / 1000.0;
 }
 
+/**
+ * @brief get the files with the temperature of each cpu-package. The coretemp-sensors of the
+ *        hwmon-interface are labeled with the physical package-id. Thermal-zones and other
+ *        sensors have no relation to a package, so they are only used, if there is only one
+ *        package.
+ *
+ * @param result reference for the resulting file-paths, where the key is the package-id
+ * @param error reference for error-output
+ *
+ * @return false, if no sensor was found for any package, else true
+ */
+bool
+getPkgTemperatureFiles(std::map<uint64_t, std::string> &result,
+                       ErrorContainer &error)
+{
+    result.clear();
+
+    // coretemp provides files like temp1_label with content "Package id 0" and temp1_input
+    std::string singlePackageFile = "";
+    std::error_code errorCode;
+    const std::string labelPrefix = "Package id ";
+    for(const auto &hwmon : std::filesystem::directory_iterator("/sys/class/hwmon", errorCode))
+    {
+        const std::string hwmonPath = hwmon.path().string();
+        ErrorContainer hwmonError;
+        const std::string name = getInfo(hwmonPath + "/name", hwmonError);
+        if(name == "k10temp"
+                && singlePackageFile == "")
+        {
+            singlePackageFile = hwmonPath + "/temp1_input";
+        }
+        if(name != "coretemp") {
+            continue;
+        }
+
+        for(const auto &entry : std::filesystem::directory_iterator(hwmonPath, errorCode))
+        {
+            const std::string fileName = entry.path().filename().string();
+            const size_t suffixPos = fileName.rfind("_label");
+            if(fileName.compare(0, 4, "temp") != 0
+                    || suffixPos == std::string::npos
+                    || suffixPos + 6 != fileName.size())
+            {
+                continue;
+            }
+
+            const std::string label = getInfo(entry.path().string(), hwmonError);
+            if(label.compare(0, labelPrefix.size(), labelPrefix) != 0) {
+                continue;
+            }
+
+            const uint64_t packageId = strtoull(label.c_str() + labelPrefix.size(), NULL, 10);
+            result[packageId] = hwmonPath + "/" + fileName.substr(0, suffixPos) + "_input";
+        }
+    }
+
+    if(result.size() > 0) {
+        return true;
+    }
+
+    // fallback to the thermal-zone, which can only be assigned, if there is only one package
+    ErrorContainer zoneError;
+    std::vector<uint64_t> zoneIds;
+    if(singlePackageFile == ""
+            && getPkgTemperatureIds(zoneIds, zoneError))
+    {
+        singlePackageFile = "/sys/class/thermal/thermal_zone"
+                            + std::to_string(zoneIds.at(0))
+                            + "/temp";
+    }
+
+    CpuSet onlineThreads;
+    std::vector<uint64_t> packageIds;
+    if(singlePackageFile != ""
+            && getOnlineCpuThreads(onlineThreads, error)
+            && getCpuPackageId(packageIds, onlineThreads, error)
+            && packageIds.size() > 0
+            && std::count(packageIds.begin(), packageIds.end(), packageIds[0])
+               == static_cast<int64_t>(packageIds.size()))
+    {
+        result[packageIds[0]] = singlePackageFile;
+        return true;
+    }
+
+    error.addMeesage("No temperature-sensor found, which can be assigned to a cpu-package");
+    error.addSolution("load the coretemp-kernel-module with \"modprobe coretemp\"");
+    return false;
+}
+
+/**
+ * @brief read temperature of a cpu-package
+ *
+ * @param result reference for the temperature in celsius
+ * @param filePath one of the files, which where selected by the function getPkgTemperatureFiles
+ * @param error reference for error-output
+ *
+ * @return false, if the file can not be read, else true
+ */
+bool
+readPkgTemperature(double &result,
+                   const std::string &filePath,
+                   ErrorContainer &error)
+{
+    const std::string content = getInfo(filePath, error);
+    if(content == "")
+    {
+        error.addMeesage("Failed to read temperature from file '" + filePath + "'");
+        return false;
+    }
+
+    result = static_cast<double>(strtol(content.c_str(), NULL, 10)) / 1000.0;
+    return true;
+}
+
+/**
+ * @brief get busy-time of a cpu-thread. The steal-time is the time, where the hypervisor was
+ *        running another guest, so it is neither busy nor idle for this thread and left out of
+ *        busy- and total-time.
+ *
+ * @return sum of the ticks of user, nice, system, irq and softirq
+ */
+uint64_t
+CpuThreadTimes::getBusy() const
+{
+    return ticks[0] + ticks[1] + ticks[2] + ticks[5] + ticks[6];
+}
+
+/**
+ * @brief get total-time of a cpu-thread, which is the busy-time plus idle and iowait
+ *
+ * @return sum of the ticks of all modes except of steal
+ */
+uint64_t
+CpuThreadTimes::getTotal() const
+{
+    return getBusy() + ticks[3] + ticks[4];
+}
+
+/**
+ * @brief parse the cpu-times of all cpu-threads from the content of /proc/stat
+ *
+ * @param result reference for the resulting times, where the position is the thread-id. The
+ *               memory of the vector is reused, if it is large enough.
+ * @param content null-terminated content of /proc/stat
+ *
+ * @return false, if no cpu-thread was found, else true
+ */
+bool
+parseCpuThreadTimes(std::vector<CpuThreadTimes> &result,
+                    const char* content)
+{
+    for(CpuThreadTimes &times : result) {
+        times = CpuThreadTimes();
+    }
+
+    bool found = false;
+    const char* line = content;
+    while(line != nullptr
+          && *line != '\0')
+    {
+        // only lines of the form "cpu<id> ..." are relevant
+        if(strncmp(line, "cpu", 3) == 0
+                && isdigit(line[3]))
+        {
+            char* pos = nullptr;
+            const uint64_t threadId = strtoull(line + 3, &pos, 10);
+            if(threadId <= maxStatCpuThreadId)
+            {
+                if(result.size() <= threadId) {
+                    result.resize(threadId + 1);
+                }
+
+                CpuThreadTimes &times = result[threadId];
+                for(uint64_t mode = 0; mode < numberOfCpuTimeModes; mode++) {
+                    times.ticks[mode] = strtoull(pos, &pos, 10);
+                }
+                times.isValid = true;
+                found = true;
+            }
+        }
+
+        line = strchr(line, '\n');
+        if(line != nullptr) {
+            line++;
+        }
+    }
+
+    return found;
+}
+
+/**
+ * @brief read the cpu-times of all cpu-threads from /proc/stat
+ *
+ * @param result reference for the resulting times, where the position is the thread-id
+ * @param error reference for error-output
+ *
+ * @return false, if file can not be read or contains no cpu-thread, else true
+ */
+bool
+getCpuThreadTimes(std::vector<CpuThreadTimes> &result,
+                  ErrorContainer &error)
+{
+    const std::string filePath = "/proc/stat";
+    const std::string content = getInfo(filePath, error);
+    if(parseCpuThreadTimes(result, content.c_str()) == false)
+    {
+        error.addMeesage("Failed to read cpu-times from file '" + filePath + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief collect ids of the topology of multiple cpu-threads. Threads, which are listed in the
+ *        same sibling-file, have the same id, so the id-file is only read once for all of them.
+ *
+ * @param result reference for the resulting ids in the same order as the threads in the set
+ * @param threads set of cpu-threads to check
+ * @param idFile name of the id-file in the topology-directory
+ * @param siblingFile name of the file in the topology-directory with all threads of the same id
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getTopologyIds(std::vector<uint64_t> &result,
+               const CpuSet &threads,
+               const std::string &idFile,
+               const std::string &siblingFile,
+               ErrorContainer &error)
+{
+    std::map<uint64_t, uint64_t> ids;
+    for(const uint64_t threadId : threads)
+    {
+        if(ids.find(threadId) != ids.end()) {
+            continue;
+        }
+
+        const std::string basePath = "/sys/devices/system/cpu/cpu"
+                                     + std::to_string(threadId)
+                                     + "/topology/";
+
+        // get info from requested file
+        const std::string info = getInfo(basePath + idFile, error);
+        if(info == "")
+        {
+            error.addMeesage("Failed to get topology-id of the cpu-thread with id: '"
+                             + std::to_string(threadId)
+                             + "'");
+            return false;
+        }
+        const uint64_t id = std::stoi(info);
+        ids.emplace(threadId, id);
+
+        // the sibling-file is optional, because older kernel do not provide all of them
+        ErrorContainer siblingError;
+        CpuSet siblings;
+        if(getCpuListInfo(siblings, basePath + siblingFile, siblingError))
+        {
+            for(const uint64_t siblingId : siblings) {
+                ids.emplace(siblingId, id);
+            }
+        }
+    }
+
+    result.clear();
+    result.reserve(threads.count());
+    for(const uint64_t threadId : threads) {
+        result.push_back(ids[threadId]);
+    }
+
+    return true;
+}
+
+/**
+ * @brief get package-ids of multiple cpu-threads
+ *
+ * @param result reference for the resulting ids in the same order as the threads in the set
+ * @param threads set of cpu-threads to check
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getCpuPackageId(std::vector<uint64_t> &result,
+                const CpuSet &threads,
+                ErrorContainer &error)
+{
+    if(getTopologyIds(result, threads, "physical_package_id", "core_siblings_list", error) == false)
+    {
+        error.addMeesage("Failed to get package-ids of cpu-threads '" + threads.toString() + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get ids of the physical cores of multiple cpu-threads
+ *
+ * @param result reference for the resulting ids in the same order as the threads in the set
+ * @param threads set of cpu-threads to check
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getCpuCoreId(std::vector<uint64_t> &result,
+             const CpuSet &threads,
+             ErrorContainer &error)
+{
+    if(getTopologyIds(result, threads, "core_id", "thread_siblings_list", error) == false)
+    {
+        error.addMeesage("Failed to get core-ids of cpu-threads '" + threads.toString() + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get all online cpu-threads, which belong to a specific cpu-package
+ *
+ * @param result reference for result-output
+ * @param packageId id of the package
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getCpuThreadsOfPackage(CpuSet &result,
+                       const uint64_t packageId,
+                       ErrorContainer &error)
+{
+    CpuSet online;
+    std::vector<uint64_t> packageIds;
+    if(getOnlineCpuThreads(online, error) == false
+            || getCpuPackageId(packageIds, online, error) == false)
+    {
+        error.addMeesage("Failed to get cpu-threads of package '"
+                         + std::to_string(packageId)
+                         + "'");
+        return false;
+    }
+
+    result.clear();
+    uint64_t pos = 0;
+    for(const uint64_t threadId : online)
+    {
+        if(packageIds[pos] == packageId) {
+            result.add(threadId);
+        }
+        pos++;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get cpu-threads, to which the calling thread is allowed to be scheduled
+ *
+ * @param result reference for result-output
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getThreadAffinity(CpuSet &result,
+                  ErrorContainer &error)
+{
+    // the size of the set has to be increased for systems with more than 1024 cpu-threads
+    uint64_t numberOfThreads = CPU_SETSIZE;
+    while(true)
+    {
+        cpu_set_t* cpuSet = CPU_ALLOC(numberOfThreads);
+        const uint64_t setSize = CPU_ALLOC_SIZE(numberOfThreads);
+        const int ret = pthread_getaffinity_np(pthread_self(), setSize, cpuSet);
+        if(ret == 0) {
+            result.fromCpuSetT(cpuSet, setSize);
+        }
+        CPU_FREE(cpuSet);
+
+        if(ret == 0) {
+            return true;
+        }
+        if(ret != EINVAL || numberOfThreads >= 1024 * 1024)
+        {
+            error.addMeesage("Failed to get affinity of the current thread");
+            return false;
+        }
+
+        numberOfThreads *= 2;
+    }
+
+    return true;
+}
+
+/**
+ * @brief bind the calling thread to a set of cpu-threads
+ *
+ * @param threads set of cpu-threads, where the thread is allowed to be scheduled
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+setThreadAffinity(const CpuSet &threads,
+                  ErrorContainer &error)
+{
+    if(threads.isEmpty())
+    {
+        error.addMeesage("Failed to set affinity of the current thread, because set is empty");
+        return false;
+    }
+
+    const uint64_t numberOfThreads = threads.getLast() + 1;
+    cpu_set_t* cpuSet = CPU_ALLOC(numberOfThreads);
+    const uint64_t setSize = CPU_ALLOC_SIZE(numberOfThreads);
+    threads.toCpuSetT(cpuSet, setSize);
+    const int ret = pthread_setaffinity_np(pthread_self(), setSize, cpuSet);
+    CPU_FREE(cpuSet);
+
+    if(ret != 0)
+    {
+        error.addMeesage("Failed to bind the current thread to cpu-threads '"
+                         + threads.toString()
+                         + "'");
+        error.addSolution("Check if all cpu-threads of the set are online");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief group cpu-threads by their cpufreq-policy. All threads of a policy share the same
+ *        speed-values, so each policy-file has to be read or written only once.
+ *
+ * @param result reference for the resulting map with the policy-directory as key
+ * @param threads set of cpu-threads to group
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getSpeedPolicies(std::map<std::string, CpuSet> &result,
+                 const CpuSet &threads,
+                 ErrorContainer &error)
+{
+    result.clear();
+    for(const uint64_t threadId : threads)
+    {
+        // cpufreq-directory of a thread is a symlink to the directory of its policy
+        const std::string path = "/sys/devices/system/cpu/cpu"
+                                 + std::to_string(threadId)
+                                 + "/cpufreq";
+        std::error_code ec;
+        const std::filesystem::path policyPath = std::filesystem::canonical(path, ec);
+        if(ec)
+        {
+            error.addMeesage("Failed to get cpufreq-policy of the cpu-thread with id: '"
+                             + std::to_string(threadId)
+                             + "'");
+            error.addSolution("check if the directory '" + path + "' exist on your system");
+            return false;
+        }
+
+        result[policyPath.string()].add(threadId);
+    }
+
+    return true;
+}
+
+/**
+ * @brief get speed-value of a file for multiple cpu-threads
+ *
+ * @param result reference for the resulting values in the same order as the threads in the set
+ * @param threads set of cpu-threads to request
+ * @param fileName name of the file in cpufreq-directory to read
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getSpeed(std::vector<uint64_t> &result,
+         const CpuSet &threads,
+         const std::string &fileName,
+         ErrorContainer &error)
+{
+    std::map<std::string, CpuSet> policies;
+    if(getSpeedPolicies(policies, threads, error) == false) {
+        return false;
+    }
+
+    std::map<uint64_t, uint64_t> values;
+    for(const auto &[policyPath, policyThreads] : policies)
+    {
+        const std::string info = getInfo(policyPath + "/" + fileName, error);
+        if(info == "") {
+            return false;
+        }
+
+        const uint64_t value = std::stol(info);
+        for(const uint64_t threadId : policyThreads) {
+            values.emplace(threadId, value);
+        }
+    }
+
+    result.clear();
+    result.reserve(threads.count());
+    for(const uint64_t threadId : threads) {
+        result.push_back(values[threadId]);
+    }
+
+    return true;
+}
+
+/**
+ * @brief get absolute minimum value of multiple cpu-threads
+ *
+ * @param result reference for the resulting values in the same order as the threads in the set
+ * @param threads set of cpu-threads to check
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getMinimumSpeed(std::vector<uint64_t> &result,
+                const CpuSet &threads,
+                ErrorContainer &error)
+{
+    if(getSpeed(result, threads, "cpuinfo_min_freq", error) == false)
+    {
+        error.addMeesage("Failed to the minimum speed of threads '" + threads.toString() + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get absolute maximum value of multiple cpu-threads
+ *
+ * @param result reference for the resulting values in the same order as the threads in the set
+ * @param threads set of cpu-threads to check
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getMaximumSpeed(std::vector<uint64_t> &result,
+                const CpuSet &threads,
+                ErrorContainer &error)
+{
+    if(getSpeed(result, threads, "cpuinfo_max_freq", error) == false)
+    {
+        error.addMeesage("Failed to the maximum speed of threads '" + threads.toString() + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get current speed of multiple cpu-threads
+ *
+ * @param result reference for the resulting values in the same order as the threads in the set
+ * @param threads set of cpu-threads to check
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getCurrentSpeed(std::vector<uint64_t> &result,
+                const CpuSet &threads,
+                ErrorContainer &error)
+{
+    if(getSpeed(result, threads, "scaling_cur_freq", error) == false)
+    {
+        error.addMeesage("Failed to the current speed of threads '" + threads.toString() + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get current set minimum speed of multiple cpu-threads
+ *
+ * @param result reference for the resulting values in the same order as the threads in the set
+ * @param threads set of cpu-threads to check
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getCurrentMinimumSpeed(std::vector<uint64_t> &result,
+                       const CpuSet &threads,
+                       ErrorContainer &error)
+{
+    if(getSpeed(result, threads, "scaling_min_freq", error) == false)
+    {
+        error.addMeesage("Failed to the current minimum speed of threads '"
+                         + threads.toString()
+                         + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get current set maximum speed of multiple cpu-threads
+ *
+ * @param result reference for the resulting values in the same order as the threads in the set
+ * @param threads set of cpu-threads to check
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getCurrentMaximumSpeed(std::vector<uint64_t> &result,
+                       const CpuSet &threads,
+                       ErrorContainer &error)
+{
+    if(getSpeed(result, threads, "scaling_max_freq", error) == false)
+    {
+        error.addMeesage("Failed to the current maximum speed of threads '"
+                         + threads.toString()
+                         + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief write a speed-value for multiple cpu-threads, where the value is limited by the
+ *        absolute minimum and maximum of each policy
+ *
+ * @param threads set of cpu-threads to change
+ * @param newSpeed new speed-value
+ * @param fileName target file-name to update
+ * @param error reference for error-output
+ *
+ * @return false, if no permission to update files, else true
+ */
+bool
+setSpeed(const CpuSet &threads,
+         const uint64_t newSpeed,
+         const std::string &fileName,
+         ErrorContainer &error)
+{
+    std::map<std::string, CpuSet> policies;
+    if(getSpeedPolicies(policies, threads, error) == false) {
+        return false;
+    }
+
+    for(const auto &[policyPath, policyThreads] : policies)
+    {
+        const std::string minInfo = getInfo(policyPath + "/cpuinfo_min_freq", error);
+        const std::string maxInfo = getInfo(policyPath + "/cpuinfo_max_freq", error);
+        if(minInfo == ""
+                || maxInfo == "")
+        {
+            return false;
+        }
+
+        // fix borders
+        uint64_t speed = newSpeed;
+        speed = std::max(speed, static_cast<uint64_t>(std::stol(minInfo)));
+        speed = std::min(speed, static_cast<uint64_t>(std::stol(maxInfo)));
+
+        if(writeToFile(policyPath + "/" + fileName, std::to_string(speed), error) == false) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief set minimum speed value of multiple cpu-threads
+ *
+ * @param threads set of cpu-threads to change
+ * @param newSpeed new minimum speed-value to set in Hz
+ * @param error reference for error-output
+ *
+ * @return false, if no permission to update files, else true
+ */
+bool
+setMinimumSpeed(const CpuSet &threads,
+                uint64_t newSpeed,
+                ErrorContainer &error)
+{
+    if(setSpeed(threads, newSpeed, "scaling_min_freq", error) == false)
+    {
+        error.addMeesage("Failed to set new minimum speed for threads '"
+                         + threads.toString()
+                         + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief set maximum speed value of multiple cpu-threads
+ *
+ * @param threads set of cpu-threads to change
+ * @param newSpeed new maximum speed-value to set in Hz
+ * @param error reference for error-output
+ *
+ * @return false, if no permission to update files, else true
+ */
+bool
+setMaximumSpeed(const CpuSet &threads,
+                uint64_t newSpeed,
+                ErrorContainer &error)
+{
+    if(setSpeed(threads, newSpeed, "scaling_max_freq", error) == false)
+    {
+        error.addMeesage("Failed to set new maximum speed for threads '"
+                         + threads.toString()
+                         + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief reset speed values of multiple cpu-threads to basic values
+ *
+ * @param threads set of cpu-threads to reset
+ * @param error reference for error-output
+ *
+ * @return false, if no permission to update files, else true
+ */
+bool
+resetSpeed(const CpuSet &threads,
+           ErrorContainer &error)
+{
+    // values are limited by the borders of each policy, so the highest and lowest possible
+    // value result in the absolute maximum and minimum
+    if(setMaximumSpeed(threads, UINT64_MAX, error) == false) {
+        return false;
+    }
+    if(setMinimumSpeed(threads, 0, error) == false) {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get package-temperature of multiple cpu-threads, where each temperature-file is only
+ *        read once for all threads of the same package
+ *
+ * @param result reference for the resulting temperatures in celsius in the same order as the
+ *               threads in the set
+ * @param threads set of cpu-threads to check
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getPkgTemperature(std::vector<double> &result,
+                  const CpuSet &threads,
+                  ErrorContainer &error)
+{
+    std::map<uint64_t, std::string> files;
+    std::vector<uint64_t> packageIds;
+    if(getPkgTemperatureFiles(files, error) == false
+            || getCpuPackageId(packageIds, threads, error) == false)
+    {
+        error.addMeesage("Failed to get temperature of threads '" + threads.toString() + "'");
+        return false;
+    }
+
+    std::map<uint64_t, double> temperatures;
+    for(const uint64_t packageId : packageIds)
+    {
+        if(temperatures.find(packageId) != temperatures.end()) {
+            continue;
+        }
+
+        const auto it = files.find(packageId);
+        double temperature = 0.0;
+        if(it == files.end()
+                || readPkgTemperature(temperature, it->second, error) == false)
+        {
+            error.addMeesage("Failed to get temperature of package '"
+                             + std::to_string(packageId)
+                             + "'");
+            return false;
+        }
+        temperatures.emplace(packageId, temperature);
+    }
+
+    result.clear();
+    result.reserve(packageIds.size());
+    for(const uint64_t packageId : packageIds) {
+        result.push_back(temperatures[packageId]);
+    }
+
+    return true;
+}
+
+/**
+ * @brief classify cpu-threads by cpuid-leaf 0x1a, which has to be executed on each cpu-thread.
+ *        This is only used, if the kernel doesn't provide the information in the sysfs. The
+ *        cpuid is executed by a short-lived helper-thread, so the affinity of the calling thread
+ *        is never changed. Only cpu-threads of the affinity of the calling thread can be
+ *        classified, because the helper-thread can not be bound to any other threads.
+ *
+ * @param performance reference for the performance-threads
+ * @param efficiency reference for the efficiency-threads
+ * @param online all online cpu-threads
+ * @param error reference for error-output
+ *
+ * @return false, if the helper-thread can not be bound to an allowed cpu-thread, else true.
+ *         If the cpu is not hybrid, both sets stay empty.
+ */
+bool
+getCoreClassesByCpuid(CpuSet &performance,
+                      CpuSet &efficiency,
+                      const CpuSet &online,
+                      ErrorContainer &error)
+{
+    uint32_t eax = 0;
+    uint32_t ebx = 0;
+    uint32_t ecx = 0;
+    uint32_t edx = 0;
+
+    // check if leaf 0x1a exist and the hybrid-flag (leaf 7, edx bit 15) is set
+    __asm__("cpuid;" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "0"(0));
+    if(eax < 0x1a) {
+        return true;
+    }
+    __asm__("cpuid;" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "0"(7), "2"(0));
+    if(((edx >> 15) & 1) == 0) {
+        return true;
+    }
+
+    // the helper-thread inherits the affinity of the calling thread and can only be bound to
+    // cpu-threads of this affinity
+    CpuSet allowed;
+    if(getThreadAffinity(allowed, error) == false)
+    {
+        error.addMeesage("Failed to classify cpu-threads by cpuid");
+        return false;
+    }
+    allowed &= online;
+
+    bool success = true;
+    std::thread helper([&]()
+    {
+        for(const uint64_t threadId : allowed)
+        {
+            CpuSet target;
+            target.add(threadId);
+            if(setThreadAffinity(target, error) == false)
+            {
+                success = false;
+                return;
+            }
+
+            // core-type in bits 31-24: 0x20 = Atom, 0x40 = Core
+            uint32_t leafEax = 0;
+            uint32_t leafEbx = 0;
+            uint32_t leafEcx = 0;
+            uint32_t leafEdx = 0;
+            __asm__("cpuid;"
+                    : "=a"(leafEax), "=b"(leafEbx), "=c"(leafEcx), "=d"(leafEdx)
+                    : "0"(0x1a), "2"(0));
+            const uint32_t coreType = (leafEax >> 24) & 0xff;
+            if(coreType == 0x20) {
+                efficiency.add(threadId);
+            } else {
+                performance.add(threadId);
+            }
+        }
+    });
+    helper.join();
+
+    if(success == false)
+    {
+        performance.clear();
+        efficiency.clear();
+        error.addMeesage("Failed to classify cpu-threads by cpuid");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief classify all online cpu-threads into performance- and efficiency-threads. The
+ *        information is taken from the pmu-devices of hybrid Intel cpus, the cpu-capacity of
+ *        ARM big.LITTLE systems or from cpuid, in this order. If the cpu is not hybrid, all
+ *        threads are performance-threads. Cpuid can only classify the cpu-threads of the
+ *        affinity of the calling thread, so other threads are in none of both sets in this case.
+ *
+ * @param performance reference for the performance-threads
+ * @param efficiency reference for the efficiency-threads
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getCoreClasses(CpuSet &performance,
+               CpuSet &efficiency,
+               ErrorContainer &error)
+{
+    performance.clear();
+    efficiency.clear();
+
+    CpuSet online;
+    if(getOnlineCpuThreads(online, error) == false) {
+        return false;
+    }
+
+    // hybrid Intel cpus have a separate pmu-device for each core-type
+    ErrorContainer optionalError;
+    if(std::filesystem::exists("/sys/devices/cpu_core/cpus")
+            && getCpuListInfo(performance, "/sys/devices/cpu_core/cpus", optionalError)
+            && getCpuListInfo(efficiency, "/sys/devices/cpu_atom/cpus", optionalError))
+    {
+        performance &= online;
+        efficiency &= online;
+        return true;
+    }
+    performance.clear();
+    efficiency.clear();
+
+    // capacity is scaled to 1024 for the fastest thread of the system
+    std::map<uint64_t, uint64_t> capacities;
+    uint64_t maxCapacity = 0;
+    for(const uint64_t threadId : online)
+    {
+        const std::string filePath = "/sys/devices/system/cpu/cpu"
+                                     + std::to_string(threadId)
+                                     + "/cpu_capacity";
+        if(std::filesystem::exists(filePath) == false) {
+            break;
+        }
+        const std::string info = getInfo(filePath, optionalError);
+        if(info == "") {
+            break;
+        }
+        const uint64_t capacity = std::stoull(info);
+        capacities.emplace(threadId, capacity);
+        maxCapacity = std::max(maxCapacity, capacity);
+    }
+    if(capacities.size() == online.count())
+    {
+        for(const auto &[threadId, capacity] : capacities)
+        {
+            if(capacity == maxCapacity) {
+                performance.add(threadId);
+            } else {
+                efficiency.add(threadId);
+            }
+        }
+        return true;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    if(getCoreClassesByCpuid(performance, efficiency, online, error) == false)
+    {
+        error.addMeesage("Failed to get core-classes of the cpu-threads");
+        return false;
+    }
+    if(performance.isEmpty() == false
+            || efficiency.isEmpty() == false)
+    {
+        return true;
+    }
+#endif
+
+    // no hybrid cpu
+    performance = online;
+    return true;
+}
+
+/**
+ * @brief check if the cpu has different types of cores
+ *
+ * @param error reference for error-output
+ *
+ * @return true, if the system has performance- and efficiency-threads, else false
+ */
+bool
+isHybridCpu(ErrorContainer &error)
+{
+    CpuSet performance;
+    CpuSet efficiency;
+    if(getCoreClasses(performance, efficiency, error) == false)
+    {
+        error.addMeesage("Failed to check if cpu is hybrid");
+        return false;
+    }
+
+    return performance.isEmpty() == false
+           && efficiency.isEmpty() == false;
+}
+
+/**
+ * @brief get the class of the core of a cpu-thread
+ *
+ * @param result reference for result-output
+ * @param threadId id of the thread to check
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getCpuCoreClass(CpuCoreClass &result,
+                const uint64_t threadId,
+                ErrorContainer &error)
+{
+    CpuSet performance;
+    CpuSet efficiency;
+    if(getCoreClasses(performance, efficiency, error) == false)
+    {
+        error.addMeesage("Failed to get core-class of the cpu-thread with id: '"
+                         + std::to_string(threadId)
+                         + "'");
+        return false;
+    }
+
+    result = UNKNOWN_CORE_CLASS;
+    if(performance.contains(threadId)) {
+        result = PERFORMANCE_CORE_CLASS;
+    }
+    if(efficiency.contains(threadId)) {
+        result = EFFICIENCY_CORE_CLASS;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get all online cpu-threads of a specific core-class
+ *
+ * @param result reference for result-output
+ * @param coreClass requested core-class
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getCpuThreadsOfCoreClass(CpuSet &result,
+                         const CpuCoreClass coreClass,
+                         ErrorContainer &error)
+{
+    CpuSet performance;
+    CpuSet efficiency;
+    if(getCoreClasses(performance, efficiency, error) == false)
+    {
+        error.addMeesage("Failed to get cpu-threads of core-class");
+        return false;
+    }
+
+    result.clear();
+    if(coreClass == PERFORMANCE_CORE_CLASS) {
+        result = performance;
+    }
+    if(coreClass == EFFICIENCY_CORE_CLASS) {
+        result = efficiency;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get the highest maximum speed of all cpu-threads of a core-class
+ *
+ * @param result reference for result-output
+ * @param coreClass requested core-class
+ * @param error reference for error-output
+ *
+ * @return false, if the system has no threads of the class or speed can not be read, else true
+ */
+bool
+getMaximumSpeedOfCoreClass(uint64_t &result,
+                           const CpuCoreClass coreClass,
+                           ErrorContainer &error)
+{
+    CpuSet threads;
+    if(getCpuThreadsOfCoreClass(threads, coreClass, error) == false) {
+        return false;
+    }
+    if(threads.isEmpty())
+    {
+        error.addMeesage("Failed to get maximum speed of core-class, "
+                         "because no cpu-threads of this class exist");
+        return false;
+    }
+
+    std::vector<uint64_t> speeds;
+    if(getMaximumSpeed(speeds, threads, error) == false) {
+        return false;
+    }
+
+    result = *std::max_element(speeds.begin(), speeds.end());
+    return true;
+}
+
+/**
+ * @brief bind the calling thread to all cpu-threads of a core-class
+ *
+ * @param coreClass requested core-class
+ * @param error reference for error-output
+ *
+ * @return false, if the system has no threads of the class or binding failed, else true
+ */
+bool
+bindThreadToCoreClass(const CpuCoreClass coreClass,
+                      ErrorContainer &error)
+{
+    CpuSet threads;
+    if(getCpuThreadsOfCoreClass(threads, coreClass, error) == false) {
+        return false;
+    }
+    if(threads.isEmpty())
+    {
+        error.addMeesage("Failed to bind thread to core-class, "
+                         "because no cpu-threads of this class exist");
+        return false;
+    }
+
+    return setThreadAffinity(threads, error);
+}
+
+/**
+ * @brief get value of a parameter of the kernel command-line
+ *
+ * @param result reference for the value, which is empty for parameters without value
+ * @param name name of the parameter, like "isolcpus"
+ *
+ * @return false, if the parameter is not set, else true
+ */
+bool
+getKernelParameter(std::string &result,
+                   const std::string &name)
+{
+    std::ifstream inFile("/proc/cmdline");
+    std::string parameter;
+    while(inFile >> parameter)
+    {
+        if(parameter == name)
+        {
+            result = "";
+            return true;
+        }
+        if(parameter.compare(0, name.size() + 1, name + "=") == 0)
+        {
+            result = parameter.substr(name.size() + 1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief parse a cpu-list in the format of the kernel-command-line, which additionally to the
+ *        format of the sysfs allows "N" for the last cpu-thread and strides like "0-15:2/4",
+ *        where the first 2 of each group of 4 cpu-threads are used
+ *
+ * @param result reference for result-output
+ * @param entries comma-separated entries of the cpu-list
+ * @param lastId id of the last possible cpu-thread
+ *
+ * @return false, if the cpu-list is broken, else true
+ */
+bool
+parseKernelCpuList(CpuSet &result,
+                   const std::vector<std::string> &entries,
+                   const uint64_t lastId)
+{
+    auto parseId = [lastId](uint64_t &id, const std::string &value)
+    {
+        if(value == "N")
+        {
+            id = lastId;
+            return true;
+        }
+
+        char* end = nullptr;
+        id = strtoull(value.c_str(), &end, 10);
+        return value != "" && *end == '\0';
+    };
+
+    for(const std::string &entry : entries)
+    {
+        std::string range = entry;
+        uint64_t used = 1;
+        uint64_t groupSize = 1;
+
+        // stride-suffix ":<used>/<group-size>"
+        const size_t colonPos = entry.find(':');
+        if(colonPos != std::string::npos)
+        {
+            range = entry.substr(0, colonPos);
+            const std::string stride = entry.substr(colonPos + 1);
+            const size_t slashPos = stride.find('/');
+            if(slashPos == std::string::npos
+                    || parseId(used, stride.substr(0, slashPos)) == false
+                    || parseId(groupSize, stride.substr(slashPos + 1)) == false
+                    || used == 0
+                    || used > groupSize)
+            {
+                return false;
+            }
+        }
+
+        uint64_t begin = 0;
+        uint64_t last = 0;
+        const size_t dashPos = range.find('-');
+        if(dashPos == std::string::npos)
+        {
+            if(parseId(begin, range) == false) {
+                return false;
+            }
+            last = begin;
+        }
+        else if(parseId(begin, range.substr(0, dashPos)) == false
+                || parseId(last, range.substr(dashPos + 1)) == false)
+        {
+            return false;
+        }
+
+        if(last < begin) {
+            return false;
+        }
+
+        // like the kernel, cpu-threads beyond the possible ones are ignored
+        for(uint64_t id = begin; id <= std::min(last, lastId); id++)
+        {
+            if((id - begin) % groupSize < used) {
+                result.add(id);
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief get cpu-threads of a kernel-parameter with a cpu-list, like "isolcpus=nohz,domain,2-5",
+ *        where leading flags are skipped
+ *
+ * @param result reference for result-output
+ * @param name name of the parameter
+ * @param error reference for error-output
+ *
+ * @return false, if the cpu-list is broken, else true
+ */
+bool
+getKernelParameterCpuList(CpuSet &result,
+                          const std::string &name,
+                          ErrorContainer &error)
+{
+    result.clear();
+    std::string value = "";
+    if(getKernelParameter(value, name) == false
+            || value == "")
+    {
+        return true;
+    }
+
+    CpuSet possible;
+    if(getPossibleCpuThreads(possible, error) == false
+            || possible.isEmpty())
+    {
+        error.addMeesage("Failed to get possible cpu-threads for kernel-parameter '" + name + "'");
+        return false;
+    }
+
+    if(value == "all")
+    {
+        result = possible;
+        return true;
+    }
+
+    // skip flags, which are all entries before the first entry starting with a digit or with
+    // "N" for the last cpu-thread
+    std::vector<std::string> parts;
+    Kitsunemimi::splitStringByDelimiter(parts, value, ',');
+    std::vector<std::string> cpuList;
+    for(const std::string &part : parts)
+    {
+        if(cpuList.size() == 0
+                && (part.size() == 0 || (isdigit(part[0]) == false && part[0] != 'N')))
+        {
+            continue;
+        }
+        cpuList.push_back(part);
+    }
+
+    if(parseKernelCpuList(result, cpuList, possible.getThreadIds().back()) == false)
+    {
+        result.clear();
+        error.addMeesage("Failed to parse cpu-list of kernel-parameter '" + name + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get cpu-threads, which are isolated from the scheduler by the kernel-parameter
+ *        isolcpus or by an isolated cpuset-partition
+ *
+ * @param result reference for result-output
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getIsolatedCpuThreads(CpuSet &result,
+                      ErrorContainer &error)
+{
+    // the sysfs-file only contains the threads with domain-isolation, so the kernel
+    // command-line is checked too for isolations like "isolcpus=nohz,2-5"
+    if(getCpuListInfo(result, "/sys/devices/system/cpu/isolated", error) == false) {
+        return false;
+    }
+
+    CpuSet parameter;
+    if(getKernelParameterCpuList(parameter, "isolcpus", error) == false) {
+        return false;
+    }
+    result |= parameter;
+
+    return true;
+}
+
+/**
+ * @brief get cpu-threads, which run without scheduler-tick, while only one task is running
+ *
+ * @param result reference for result-output
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getNohzFullCpuThreads(CpuSet &result,
+                      ErrorContainer &error)
+{
+    // the file contains "(null)", if nohz_full is not set, and doesn't exist without
+    // CONFIG_NO_HZ_FULL
+    std::ifstream inFile("/sys/devices/system/cpu/nohz_full");
+    std::string content = "";
+    if(inFile.is_open()
+            && std::getline(inFile, content)
+            && result.parse(content))
+    {
+        return true;
+    }
+
+    return getKernelParameterCpuList(result, "nohz_full", error);
+}
+
+/**
+ * @brief get cpu-threads, where rcu-callbacks are offloaded to other cpu-threads
+ *
+ * @param result reference for result-output
+ * @param error reference for error-output
+ *
+ * @return true, if successful, else false
+ */
+bool
+getRcuNocbsCpuThreads(CpuSet &result,
+                      ErrorContainer &error)
+{
+    if(getKernelParameterCpuList(result, "rcu_nocbs", error) == false) {
+        return false;
+    }
+
+    // nohz_full implies rcu_nocbs
+    CpuSet nohzFull;
+    if(getNohzFullCpuThreads(nohzFull, error) == false) {
+        return false;
+    }
+    result |= nohzFull;
+
+    return true;
+}
+
+/**
+ * @brief check if cpu-threads are suitable for busy-polling threads, so each thread is isolated
+ *        or nohz_full and no two pollers share a physical core
+ *
+ * @param pollerThreads cpu-threads of all pollers
+ * @param error reference for error-output, which gets one message for each problem
+ *
+ * @return false, if the placement has any problem, else true
+ */
+bool
+checkPollerPlacement(const CpuSet &pollerThreads,
+                     ErrorContainer &error)
+{
+    CpuSet isolated;
+    CpuSet nohzFull;
+    if(getIsolatedCpuThreads(isolated, error) == false
+            || getNohzFullCpuThreads(nohzFull, error) == false)
+    {
+        return false;
+    }
+
+    bool result = true;
+    const CpuSet notIsolated = pollerThreads - (isolated | nohzFull);
+    if(notIsolated.isEmpty() == false)
+    {
+        error.addMeesage("Pollers on cpu-threads '"
+                         + notIsolated.toString()
+                         + "' are not isolated from the scheduler");
+        error.addSolution("add the cpu-threads to the kernel-parameters isolcpus or nohz_full");
+        result = false;
+    }
+
+    // pollers on hyperthreads of the same core slow down each other
+    std::vector<uint64_t> packageIds;
+    std::vector<uint64_t> coreIds;
+    if(getCpuPackageId(packageIds, pollerThreads, error) == false
+            || getCpuCoreId(coreIds, pollerThreads, error) == false)
+    {
+        return false;
+    }
+    const std::vector<uint64_t> threadIds = pollerThreads.getThreadIds();
+    for(uint64_t a = 0; a < threadIds.size(); a++)
+    {
+        for(uint64_t b = a + 1; b < threadIds.size(); b++)
+        {
+            if(packageIds[a] == packageIds[b]
+                    && coreIds[a] == coreIds[b])
+            {
+                error.addMeesage("Pollers on cpu-threads '"
+                                 + std::to_string(threadIds[a])
+                                 + "' and '"
+                                 + std::to_string(threadIds[b])
+                                 + "' are siblings of the same physical core");
+                error.addSolution("use only one cpu-thread of each core for pollers");
+                result = false;
+            }
+        }
+    }
+
+    return result;
+}
+
+// cpu-threads, which are used by pollers of this process, with the number of pollers on each
+static std::mutex registeredPollerLock;
+static std::map<uint64_t, uint32_t> registeredPollerThreads;
+
+/**
+ * @brief bind the calling thread as busy-polling thread to a single cpu-thread and warn, if the
+ *        placement of all pollers of the process is not suitable
+ *
+ * @param threadId id of the cpu-thread
+ * @param error reference for error-output
+ *
+ * @return false, if binding failed, else true. A bad placement only creates a warning.
+ */
+bool
+bindPollerThread(const uint64_t threadId,
+                 ErrorContainer &error)
+{
+    CpuSet target;
+    target.add(threadId);
+    if(setThreadAffinity(target, error) == false) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(registeredPollerLock);
+    const uint32_t numberOfPollers = ++registeredPollerThreads[threadId];
+
+    ErrorContainer placementError;
+    bool goodPlacement = true;
+    if(numberOfPollers > 1)
+    {
+        placementError.addMeesage("Cpu-thread '"
+                                  + std::to_string(threadId)
+                                  + "' is used by "
+                                  + std::to_string(numberOfPollers)
+                                  + " pollers");
+        placementError.addSolution("use a separate cpu-thread for each poller");
+        goodPlacement = false;
+    }
+
+    CpuSet pollerThreads;
+    for(const auto &[id, count] : registeredPollerThreads) {
+        pollerThreads.add(id);
+    }
+    if(checkPollerPlacement(pollerThreads, placementError) == false) {
+        goodPlacement = false;
+    }
+
+    if(goodPlacement == false) {
+        LOG_WARNING("bad placement of pollers: " + placementError.toString());
+    }
+
+    return true;
+}
+
+/**
+ * @brief unregister a poller from a cpu-thread, after its polling-thread was stopped. The
+ *        cpu-thread stays registered, as long as other pollers are still bound to it.
+ *
+ * @param threadId id of the cpu-thread
+ */
+void
+releasePollerThread(const uint64_t threadId)
+{
+    std::lock_guard<std::mutex> guard(registeredPollerLock);
+    auto it = registeredPollerThreads.find(threadId);
+    if(it == registeredPollerThreads.end()) {
+        return;
+    }
+
+    it->second--;
+    if(it->second == 0) {
+        registeredPollerThreads.erase(it);
+    }
+}
+
 } // namespace Kitsunemimi
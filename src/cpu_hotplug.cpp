@@ -0,0 +1,221 @@
+/**
+ *  @file       cpu_hotplug.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/cpu_hotplug.h>
+#include <libKitsunemimiCpu/cpu.h>
+
+#include <algorithm>
+#include <chrono>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief constructor
+ */
+CpuHotplugObserver::CpuHotplugObserver() {}
+
+/**
+ * @brief destructor
+ */
+CpuHotplugObserver::~CpuHotplugObserver()
+{
+    if(m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+/**
+ * @brief read the initial online-state and subscribe to the uevents of the kernel. If the
+ *        netlink-socket is not available, for example inside of some containers, the observer
+ *        falls back to polling of the online-file.
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if online-state can not be read, else true
+ */
+bool
+CpuHotplugObserver::initObserver(ErrorContainer &error)
+{
+    // check if already initialized
+    if(m_isInit)
+    {
+        LOG_WARNING("this hotplug-observer was already successfully initialized");
+        return true;
+    }
+
+    if(getOnlineCpuThreads(m_onlineThreads, error) == false)
+    {
+        error.addMeesage("Failed to initialize hotplug-observer");
+        return false;
+    }
+
+    // subscribe to kernel-uevents
+    m_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if(m_fd >= 0)
+    {
+        struct sockaddr_nl addr = {};
+        addr.nl_family = AF_NETLINK;
+        addr.nl_pid = 0;
+        addr.nl_groups = 1;
+        if(bind(m_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0)
+        {
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    if(m_fd < 0) {
+        LOG_WARNING("netlink-socket for cpu-hotplug not available, fallback to polling");
+    }
+
+    m_isInit = true;
+
+    return true;
+}
+
+/**
+ * @brief read and drop all pending events of the netlink-socket
+ */
+void
+CpuHotplugObserver::drainEvents()
+{
+    char buffer[4096];
+    while(recv(m_fd, buffer, sizeof(buffer), MSG_DONTWAIT) > 0) {}
+}
+
+/**
+ * @brief check without blocking, if the online-state of any cpu-thread has changed
+ *
+ * @param changed reference for the result, which is true, if the online-state has changed
+ *                since the last check
+ * @param onlineThreads reference for the new set of online cpu-threads
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized or online-state can not be read, else true
+ */
+bool
+CpuHotplugObserver::checkForChange(bool &changed,
+                                   CpuSet &onlineThreads,
+                                   ErrorContainer &error)
+{
+    changed = false;
+
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to check for hotplug-change, because observer is not initialized");
+        return false;
+    }
+
+    if(m_fd >= 0) {
+        drainEvents();
+    }
+
+    CpuSet current;
+    if(getOnlineCpuThreads(current, error) == false)
+    {
+        error.addMeesage("Failed to check for hotplug-change");
+        return false;
+    }
+
+    onlineThreads = current;
+    if(current == m_onlineThreads) {
+        return true;
+    }
+
+    m_onlineThreads = current;
+    changed = true;
+
+    return true;
+}
+
+/**
+ * @brief block until the online-state of any cpu-thread has changed or the timeout was reached
+ *
+ * @param changed reference for the result, which is true, if the online-state has changed
+ *                and false, if the timeout was reached
+ * @param onlineThreads reference for the new set of online cpu-threads
+ * @param timeoutMs timeout in milliseconds
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized or online-state can not be read, else true
+ */
+bool
+CpuHotplugObserver::waitForChange(bool &changed,
+                                  CpuSet &onlineThreads,
+                                  const uint32_t timeoutMs,
+                                  ErrorContainer &error)
+{
+    // interval for the fallback without netlink-socket
+    const std::chrono::milliseconds pollInterval(100);
+
+    // poll and usleep can return early or late, so the remaining time is always taken from
+    // the deadline instead of summing up the intervals
+    const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now()
+                                                           + std::chrono::milliseconds(timeoutMs);
+
+    while(true)
+    {
+        if(checkForChange(changed, onlineThreads, error) == false) {
+            return false;
+        }
+        if(changed) {
+            return true;
+        }
+
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if(now >= deadline) {
+            return true;
+        }
+
+        const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - now);
+        const uint32_t interval = std::min(pollInterval, remaining).count();
+        if(m_fd >= 0)
+        {
+            // uevents of other subsystems wake up too, so the state is checked again after
+            // each event
+            struct pollfd pfd = {};
+            pfd.fd = m_fd;
+            pfd.events = POLLIN;
+            poll(&pfd, 1, interval);
+        }
+        else
+        {
+            usleep(interval * 1000);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief get file-descriptor of the netlink-socket to integrate the observer into an own
+ *        poll-loop. After the descriptor becomes readable, checkForChange has to be called.
+ *
+ * @return -1, if polling-fallback is used, else the file-descriptor
+ */
+int
+CpuHotplugObserver::getFileDescriptor() const
+{
+    return m_fd;
+}
+
+/**
+ * @brief get online cpu-threads of the last check
+ */
+const CpuSet
+CpuHotplugObserver::getOnlineThreads() const
+{
+    return m_onlineThreads;
+}
+
+} // namespace Kitsunemimi
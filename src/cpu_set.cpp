@@ -0,0 +1,449 @@
+/**
+ *  @file       cpu_set.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/cpu_set.h>
+
+#include <libKitsunemimiCommon/methods/string_methods.h>
+
+#include <algorithm>
+#include <cctype>
+#include <stdlib.h>
+
+namespace Kitsunemimi
+{
+
+// highest accepted id while parsing, which is far above the NR_CPUS-limit of the kernel, but
+// prevents a huge allocation for broken lists like "0-4294967295"
+const uint64_t maxParsedCpuThreadId = 65535;
+
+/**
+ * @brief constructor
+ */
+CpuSet::CpuSet() {}
+
+/**
+ * @brief parse a single id of a cpu-list, which must consist only of decimal digits
+ *
+ * @param result reference for the parsed id
+ * @param text text to parse
+ *
+ * @return false, if text is empty, not a number or the id is above 65535, else true
+ */
+bool
+parseCpuThreadId(uint64_t &result,
+                 const std::string &text)
+{
+    // strtoull would also accept whitespace and signs
+    if(text == ""
+            || std::all_of(text.begin(), text.end(), ::isdigit) == false)
+    {
+        return false;
+    }
+
+    char* end = nullptr;
+    result = strtoull(text.c_str(), &end, 10);
+    return *end == '\0'
+           && result <= maxParsedCpuThreadId;
+}
+
+/**
+ * @brief parse a cpu-list of the kernel, like "0", "0-3" or "0-3,8-11,16"
+ *
+ * @param cpuList cpu-list to parse
+ *
+ * @return false, if the list is invalid or contains an id above 65535, else true
+ */
+bool
+CpuSet::parse(const std::string &cpuList)
+{
+    clear();
+
+    std::string content = cpuList;
+    Kitsunemimi::trim(content);
+
+    // an empty list is valid, for example the content of the offline-file
+    if(content == "") {
+        return true;
+    }
+
+    // split by hand, because empty parts, like in "1-" or "0,", have to be rejected
+    uint64_t partStart = 0;
+    while(partStart <= content.size())
+    {
+        uint64_t partEnd = content.find(',', partStart);
+        if(partEnd == std::string::npos) {
+            partEnd = content.size();
+        }
+        const std::string part = content.substr(partStart, partEnd - partStart);
+        partStart = partEnd + 1;
+
+        uint64_t begin = 0;
+        uint64_t last = 0;
+        const size_t dashPos = part.find('-');
+        if(dashPos == std::string::npos)
+        {
+            if(parseCpuThreadId(begin, part) == false)
+            {
+                clear();
+                return false;
+            }
+            last = begin;
+        }
+        else
+        {
+            if(parseCpuThreadId(begin, part.substr(0, dashPos)) == false
+                    || parseCpuThreadId(last, part.substr(dashPos + 1)) == false
+                    || last < begin)
+            {
+                clear();
+                return false;
+            }
+        }
+
+        for(uint64_t id = begin; id <= last; id++) {
+            add(id);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief convert set into cpu-list-format of the kernel, like "0-3,8-11"
+ */
+const std::string
+CpuSet::toString() const
+{
+    std::string result = "";
+    const std::vector<uint64_t> ids = getThreadIds();
+
+    uint64_t pos = 0;
+    while(pos < ids.size())
+    {
+        // find end of the continuous range
+        uint64_t end = pos;
+        while(end + 1 < ids.size()
+              && ids[end + 1] == ids[end] + 1)
+        {
+            end++;
+        }
+
+        if(result != "") {
+            result += ",";
+        }
+        result += std::to_string(ids[pos]);
+        if(end != pos) {
+            result += "-" + std::to_string(ids[end]);
+        }
+
+        pos = end + 1;
+    }
+
+    return result;
+}
+
+/**
+ * @brief add a cpu-thread to the set
+ */
+void
+CpuSet::add(const uint64_t threadId)
+{
+    const uint64_t word = threadId / 64;
+    if(word >= m_bits.size()) {
+        m_bits.resize(word + 1, 0);
+    }
+    m_bits[word] |= 1ULL << (threadId % 64);
+}
+
+/**
+ * @brief remove a cpu-thread from the set
+ */
+void
+CpuSet::remove(const uint64_t threadId)
+{
+    const uint64_t word = threadId / 64;
+    if(word >= m_bits.size()) {
+        return;
+    }
+    m_bits[word] &= ~(1ULL << (threadId % 64));
+    shrink();
+}
+
+/**
+ * @brief check if a cpu-thread is part of the set
+ */
+bool
+CpuSet::contains(const uint64_t threadId) const
+{
+    const uint64_t word = threadId / 64;
+    if(word >= m_bits.size()) {
+        return false;
+    }
+    return (m_bits[word] >> (threadId % 64)) & 1ULL;
+}
+
+/**
+ * @brief remove all cpu-threads from the set
+ */
+void
+CpuSet::clear()
+{
+    m_bits.clear();
+}
+
+/**
+ * @brief get number of cpu-threads in the set
+ */
+uint64_t
+CpuSet::count() const
+{
+    uint64_t result = 0;
+    for(const uint64_t word : m_bits) {
+        result += __builtin_popcountll(word);
+    }
+    return result;
+}
+
+/**
+ * @brief check if set is empty
+ */
+bool
+CpuSet::isEmpty() const
+{
+    return m_bits.size() == 0;
+}
+
+/**
+ * @brief get id of the lowest cpu-thread of the set, which is only valid, if the set is not empty
+ */
+uint64_t
+CpuSet::getFirst() const
+{
+    return *begin();
+}
+
+/**
+ * @brief get id of the highest cpu-thread of the set, which is only valid, if the set is not empty
+ */
+uint64_t
+CpuSet::getLast() const
+{
+    if(m_bits.size() == 0) {
+        return 0;
+    }
+
+    // the last word is never empty, because of the shrink-function
+    return (m_bits.size() - 1) * 64 + 63 - __builtin_clzll(m_bits.back());
+}
+
+/**
+ * @brief get ids of all cpu-threads of the set in ascending order
+ */
+const std::vector<uint64_t>
+CpuSet::getThreadIds() const
+{
+    std::vector<uint64_t> result;
+    result.reserve(count());
+    for(const uint64_t threadId : *this) {
+        result.push_back(threadId);
+    }
+    return result;
+}
+
+/**
+ * @brief get iterator to the lowest cpu-thread of the set
+ */
+CpuSet::Iterator
+CpuSet::begin() const
+{
+    return Iterator(&m_bits, 0);
+}
+
+/**
+ * @brief get iterator behind the highest cpu-thread of the set
+ */
+CpuSet::Iterator
+CpuSet::end() const
+{
+    return Iterator(&m_bits, m_bits.size());
+}
+
+/**
+ * @brief get size in bytes, which is necessary for a cpu_set_t to hold all cpu-threads of the set
+ */
+uint64_t
+CpuSet::getCpuSetTSize() const
+{
+    return CPU_ALLOC_SIZE(m_bits.size() * 64);
+}
+
+/**
+ * @brief write set into a cpu_set_t
+ *
+ * @param cpuSet target-set, which was allocated with CPU_ALLOC
+ * @param setSize size of the target-set in bytes, as returned by CPU_ALLOC_SIZE
+ */
+void
+CpuSet::toCpuSetT(cpu_set_t* cpuSet,
+                  const uint64_t setSize) const
+{
+    CPU_ZERO_S(setSize, cpuSet);
+    for(const uint64_t threadId : *this)
+    {
+        if(threadId >= setSize * 8) {
+            break;
+        }
+        CPU_SET_S(threadId, setSize, cpuSet);
+    }
+}
+
+/**
+ * @brief read set from a cpu_set_t
+ *
+ * @param cpuSet source-set
+ * @param setSize size of the source-set in bytes
+ */
+void
+CpuSet::fromCpuSetT(const cpu_set_t* cpuSet,
+                    const uint64_t setSize)
+{
+    clear();
+    for(uint64_t threadId = 0; threadId < setSize * 8; threadId++)
+    {
+        if(CPU_ISSET_S(threadId, setSize, cpuSet)) {
+            add(threadId);
+        }
+    }
+}
+
+/**
+ * @brief check if at least one cpu-thread is part of both sets
+ */
+bool
+CpuSet::intersects(const CpuSet &other) const
+{
+    const uint64_t size = std::min(m_bits.size(), other.m_bits.size());
+    for(uint64_t i = 0; i < size; i++)
+    {
+        if((m_bits[i] & other.m_bits[i]) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief add all cpu-threads of another set
+ */
+CpuSet&
+CpuSet::operator|=(const CpuSet &other)
+{
+    if(other.m_bits.size() > m_bits.size()) {
+        m_bits.resize(other.m_bits.size(), 0);
+    }
+    for(uint64_t i = 0; i < other.m_bits.size(); i++) {
+        m_bits[i] |= other.m_bits[i];
+    }
+    return *this;
+}
+
+/**
+ * @brief keep only cpu-threads, which are also part of another set
+ */
+CpuSet&
+CpuSet::operator&=(const CpuSet &other)
+{
+    if(other.m_bits.size() < m_bits.size()) {
+        m_bits.resize(other.m_bits.size());
+    }
+    for(uint64_t i = 0; i < m_bits.size(); i++) {
+        m_bits[i] &= other.m_bits[i];
+    }
+    shrink();
+    return *this;
+}
+
+/**
+ * @brief remove all cpu-threads of another set
+ */
+CpuSet&
+CpuSet::operator-=(const CpuSet &other)
+{
+    const uint64_t size = std::min(m_bits.size(), other.m_bits.size());
+    for(uint64_t i = 0; i < size; i++) {
+        m_bits[i] &= ~other.m_bits[i];
+    }
+    shrink();
+    return *this;
+}
+
+/**
+ * @brief union of two sets
+ */
+CpuSet
+CpuSet::operator|(const CpuSet &other) const
+{
+    CpuSet result = *this;
+    result |= other;
+    return result;
+}
+
+/**
+ * @brief intersection of two sets
+ */
+CpuSet
+CpuSet::operator&(const CpuSet &other) const
+{
+    CpuSet result = *this;
+    result &= other;
+    return result;
+}
+
+/**
+ * @brief difference of two sets
+ */
+CpuSet
+CpuSet::operator-(const CpuSet &other) const
+{
+    CpuSet result = *this;
+    result -= other;
+    return result;
+}
+
+/**
+ * @brief compare two sets
+ */
+bool
+CpuSet::operator==(const CpuSet &other) const
+{
+    return m_bits == other.m_bits;
+}
+
+/**
+ * @brief compare two sets
+ */
+bool
+CpuSet::operator!=(const CpuSet &other) const
+{
+    return m_bits != other.m_bits;
+}
+
+/**
+ * @brief remove empty words at the end, so equal sets have always the same internal size
+ */
+void
+CpuSet::shrink()
+{
+    while(m_bits.size() > 0
+          && m_bits.back() == 0)
+    {
+        m_bits.pop_back();
+    }
+}
+
+} // namespace Kitsunemimi
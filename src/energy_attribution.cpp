@@ -0,0 +1,749 @@
+/**
+ *  @file       energy_attribution.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/energy_attribution.h>
+#include <libKitsunemimiCpu/cpu.h>
+
+#include <sstream>
+#include <fstream>
+#include <filesystem>
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief read the complete content of an already opened file from the beginning
+ *
+ * @param content reference for the resulting content
+ * @param fd file-descriptor to read from
+ *
+ * @return false, if read failed, else true
+ */
+bool
+readOpenFile(std::string &content,
+             const int fd)
+{
+    char buffer[4096];
+    uint64_t offset = 0;
+    content.clear();
+
+    while(true)
+    {
+        const ssize_t ret = pread(fd, buffer, sizeof(buffer), offset);
+        if(ret < 0) {
+            return false;
+        }
+        if(ret == 0) {
+            break;
+        }
+        content.append(buffer, ret);
+        offset += ret;
+    }
+
+    return content.size() > 0;
+}
+
+/**
+ * @brief parse a complete field of a stat-file as unsigned decimal number
+ *
+ * @param result reference for the resulting number
+ * @param field field to parse
+ *
+ * @return false, if the field is not a number, else true
+ */
+bool
+parseStatField(uint64_t &result,
+               const std::string &field)
+{
+    char* end = nullptr;
+    result = strtoull(field.c_str(), &end, 10);
+    return end != field.c_str()
+           && *end == '\0';
+}
+
+/**
+ * @brief parse the busy-time and the last used cpu-thread from the content of the stat-file of
+ *        a process or of a single task
+ *
+ * @param total reference for the busy-time in seconds
+ * @param lastThreadId reference for the cpu-thread, where the process was running the last time
+ * @param numberOfTasks reference for the number of tasks of the process
+ * @param content content of the stat-file
+ *
+ * @return false, if content is invalid, else true
+ */
+bool
+parseProcessStat(double &total,
+                 int64_t &lastThreadId,
+                 uint64_t &numberOfTasks,
+                 const std::string &content)
+{
+    // the name of the process can contain spaces, so parsing starts after its end
+    const size_t nameEnd = content.rfind(')');
+    if(nameEnd == std::string::npos) {
+        return false;
+    }
+
+    // first field after the name is field 3 of the stat-file
+    std::istringstream stream(content.substr(nameEnd + 1));
+    std::string field;
+    uint64_t fieldNumber = 3;
+    uint64_t ticks = 0;
+    uint64_t value = 0;
+    while(stream >> field)
+    {
+        // utime and stime
+        if(fieldNumber == 14 || fieldNumber == 15)
+        {
+            if(parseStatField(value, field) == false) {
+                return false;
+            }
+            ticks += value;
+        }
+        // num_threads
+        if(fieldNumber == 20)
+        {
+            if(parseStatField(numberOfTasks, field) == false) {
+                return false;
+            }
+        }
+        // last used cpu-thread
+        if(fieldNumber == 39)
+        {
+            if(parseStatField(value, field) == false) {
+                return false;
+            }
+            lastThreadId = static_cast<int64_t>(value);
+            break;
+        }
+        fieldNumber++;
+    }
+
+    // content ended before the last used cpu-thread
+    if(fieldNumber != 39) {
+        return false;
+    }
+
+    total = static_cast<double>(ticks) / static_cast<double>(sysconf(_SC_CLK_TCK));
+    return true;
+}
+
+/**
+ * @brief constructor
+ */
+EnergyAttribution::EnergyAttribution() {}
+
+/**
+ * @brief destructor
+ */
+EnergyAttribution::~EnergyAttribution()
+{
+    for(auto &[id, consumer] : m_consumers) {
+        closeConsumer(consumer);
+    }
+}
+
+/**
+ * @brief initialize rapl for all packages and the mapping of cpu-threads to packages
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if topology can not be read or rapl is not available, else true
+ */
+bool
+EnergyAttribution::initAttribution(ErrorContainer &error)
+{
+    // check if already initialized
+    if(m_isInit)
+    {
+        LOG_WARNING("this energy-attribution was already successfully initialized");
+        return true;
+    }
+
+    CpuSet onlineThreads;
+    if(getOnlineCpuThreads(onlineThreads, error) == false
+            || onlineThreads.isEmpty())
+    {
+        error.addMeesage("Failed to initialize energy-attribution");
+        return false;
+    }
+
+    // map cpu-threads to package-positions and create one rapl-instance for each package
+    std::map<uint64_t, uint64_t> packagePositions;
+    m_packageOfThread.resize(onlineThreads.getLast() + 1, 0);
+    for(const uint64_t threadId : onlineThreads)
+    {
+        uint64_t packageId = 0;
+        ErrorContainer threadError;
+        if(getCpuPackageId(packageId, threadId, threadError) == false) {
+            continue;
+        }
+
+        if(packagePositions.find(packageId) == packagePositions.end())
+        {
+            packagePositions.emplace(packageId, m_rapls.size());
+
+            // rapl owns the open msr-file, so it is created in place and never copied
+            m_rapls.emplace_back(threadId);
+            if(m_rapls.back().initRapl(error) == false)
+            {
+                m_rapls.clear();
+                error.addMeesage("Failed to initialize energy-attribution, because rapl is not "
+                                 "available for package '" + std::to_string(packageId) + "'");
+                return false;
+            }
+        }
+
+        m_packageOfThread[threadId] = packagePositions[packageId];
+    }
+
+    // create initial state
+    if(readPackageBusy(m_lastPackageBusy, error) == false)
+    {
+        error.addMeesage("Failed to initialize energy-attribution");
+        return false;
+    }
+
+    m_isInit = true;
+
+    return true;
+}
+
+/**
+ * @brief read the cumulative busy-time in seconds of all packages from /proc/stat
+ *
+ * @param result reference for the resulting busy-times, where the position is the package
+ * @param error reference for error-output
+ *
+ * @return false, if file can not be read, else true
+ */
+bool
+EnergyAttribution::readPackageBusy(std::vector<double> &result,
+                                   ErrorContainer &error)
+{
+    std::vector<CpuThreadTimes> times;
+    if(getCpuThreadTimes(times, error) == false) {
+        return false;
+    }
+
+    const double ticksPerSec = static_cast<double>(sysconf(_SC_CLK_TCK));
+    result.assign(m_rapls.size(), 0.0);
+    for(uint64_t threadId = 0; threadId < times.size(); threadId++)
+    {
+        if(times[threadId].isValid == false
+                || threadId >= m_packageOfThread.size())
+        {
+            continue;
+        }
+
+        const double busy = static_cast<double>(times[threadId].getBusy());
+        result[m_packageOfThread[threadId]] += busy / ticksPerSec;
+    }
+
+    return true;
+}
+
+/**
+ * @brief read the current busy-time of a consumer from its already opened file
+ *
+ * @param result reference for the resulting sample
+ * @param consumer consumer to read
+ *
+ * @return false, if the file can not be read anymore, else true
+ */
+bool
+EnergyAttribution::readConsumer(ConsumerSample &result,
+                                Consumer &consumer)
+{
+    std::string content;
+    if(readOpenFile(content, consumer.fd) == false) {
+        return false;
+    }
+
+    switch(consumer.type)
+    {
+        case PROCESS_CONSUMER:
+        {
+            if(parseProcessStat(result.total,
+                                result.lastThreadId,
+                                result.numberOfTasks,
+                                content) == false)
+            {
+                return false;
+            }
+
+            // the task-directory is only scanned again, if tasks were created or exited
+            const bool rescan = result.numberOfTasks != consumer.lastSample.numberOfTasks
+                                || consumer.taskFds.empty();
+            if(readProcessTasks(result.tasks, consumer, rescan) == false) {
+                readProcessTasks(result.tasks, consumer, true);
+            }
+            return true;
+        }
+        case CGROUP_V1_CONSUMER:
+        {
+            // cpuacct.usage_percpu contains the usage in nanoseconds for each cpu-thread
+            std::istringstream stream(content);
+            uint64_t nanoSec = 0;
+            uint64_t threadId = 0;
+            result.perPackage.assign(m_rapls.size(), 0.0);
+            while(stream >> nanoSec)
+            {
+                const double sec = static_cast<double>(nanoSec) / 1000000000.0;
+                if(threadId < m_packageOfThread.size()) {
+                    result.perPackage[m_packageOfThread[threadId]] += sec;
+                }
+                result.total += sec;
+                threadId++;
+            }
+            return true;
+        }
+        case CGROUP_V2_CONSUMER:
+        {
+            // cpu.stat contains the total usage in microseconds as "usage_usec <value>"
+            std::istringstream stream(content);
+            std::string key;
+            uint64_t value = 0;
+            while(stream >> key >> value)
+            {
+                if(key == "usage_usec")
+                {
+                    result.total = static_cast<double>(value) / 1000000.0;
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief read busy-time and last used cpu-thread of all tasks of a process. The stat-files of
+ *        the tasks stay opened between the updates, like the stat-file of the process itself.
+ *
+ * @param result reference for the resulting samples, where the key is the task-id
+ * @param consumer process-consumer with the opened stat-files of its tasks
+ * @param rescan true to scan the task-directory of the process for new and exited tasks
+ *
+ * @return false, if a task has exited since the last scan, else true
+ */
+bool
+EnergyAttribution::readProcessTasks(std::map<uint64_t, TaskSample> &result,
+                                    Consumer &consumer,
+                                    const bool rescan)
+{
+    result.clear();
+
+    if(rescan)
+    {
+        std::map<uint64_t, int> taskFds;
+        std::error_code errorCode;
+        const std::string taskPath = "/proc/" + std::to_string(consumer.pid) + "/task";
+        for(const auto &entry : std::filesystem::directory_iterator(taskPath, errorCode))
+        {
+            const std::string taskName = entry.path().filename().string();
+            uint64_t taskId = 0;
+            if(parseStatField(taskId, taskName) == false) {
+                continue;
+            }
+
+            // keep the files of already known tasks
+            const auto it = consumer.taskFds.find(taskId);
+            if(it != consumer.taskFds.end())
+            {
+                taskFds.emplace(taskId, it->second);
+                consumer.taskFds.erase(it);
+                continue;
+            }
+
+            const std::string filePath = entry.path().string() + "/stat";
+            const int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+            if(fd >= 0) {
+                taskFds.emplace(taskId, fd);
+            }
+        }
+
+        // close the files of exited tasks
+        for(const auto &[taskId, fd] : consumer.taskFds) {
+            close(fd);
+        }
+        consumer.taskFds = taskFds;
+    }
+
+    bool allTasksAlive = true;
+    auto it = consumer.taskFds.begin();
+    while(it != consumer.taskFds.end())
+    {
+        std::string content;
+        TaskSample task;
+        uint64_t numberOfTasks = 0;
+        if(readOpenFile(content, it->second)
+                && parseProcessStat(task.total, task.lastThreadId, numberOfTasks, content))
+        {
+            result.emplace(it->first, task);
+            it++;
+            continue;
+        }
+
+        // the stat-file of an exited task can not be read anymore
+        close(it->second);
+        it = consumer.taskFds.erase(it);
+        allTasksAlive = false;
+    }
+
+    return allTasksAlive;
+}
+
+/**
+ * @brief close all opened files of a consumer
+ *
+ * @param consumer consumer to close
+ */
+void
+EnergyAttribution::closeConsumer(Consumer &consumer)
+{
+    if(consumer.fd >= 0)
+    {
+        close(consumer.fd);
+        consumer.fd = -1;
+    }
+
+    for(const auto &[taskId, fd] : consumer.taskFds) {
+        close(fd);
+    }
+    consumer.taskFds.clear();
+}
+
+/**
+ * @brief split the busy-time of a process within the interval on the packages, where each task
+ *        is charged to the package of the cpu-thread, where it was running the last time
+ *
+ * @param result reference for the busy-time in seconds per package
+ * @param sample current sample of the process
+ * @param lastSample sample of the last update
+ *
+ * @return busy-time in seconds, which could be assigned to a package
+ */
+double
+EnergyAttribution::splitProcessBusy(std::vector<double> &result,
+                                    const ConsumerSample &sample,
+                                    const ConsumerSample &lastSample)
+{
+    double assigned = 0.0;
+    for(const auto &[taskId, task] : sample.tasks)
+    {
+        if(task.lastThreadId < 0
+                || static_cast<uint64_t>(task.lastThreadId) >= m_packageOfThread.size())
+        {
+            continue;
+        }
+
+        // tasks, which were created within the interval, have no last sample
+        double lastTotal = 0.0;
+        const auto lastIt = lastSample.tasks.find(taskId);
+        if(lastIt != lastSample.tasks.end()) {
+            lastTotal = lastIt->second.total;
+        }
+
+        const double taskDiff = std::max(0.0, task.total - lastTotal);
+        result[m_packageOfThread[task.lastThreadId]] += taskDiff;
+        assigned += taskDiff;
+    }
+
+    return assigned;
+}
+
+/**
+ * @brief read initial sample of a new consumer and register it
+ *
+ * @param consumerId reference for the id of the new consumer
+ * @param consumer new consumer with already opened file
+ * @param error reference for error-output
+ *
+ * @return false, if initial read failed, else true
+ */
+bool
+EnergyAttribution::registerConsumer(uint64_t &consumerId,
+                                    Consumer &consumer,
+                                    ErrorContainer &error)
+{
+    if(readConsumer(consumer.lastSample, consumer) == false)
+    {
+        error.addMeesage("Failed to read initial busy-time of consumer '"
+                         + consumer.info.name
+                         + "'");
+        closeConsumer(consumer);
+        return false;
+    }
+
+    consumerId = m_nextId;
+    m_nextId++;
+    consumer.info.consumerId = consumerId;
+    m_consumers.emplace(consumerId, consumer);
+
+    return true;
+}
+
+/**
+ * @brief add a process as new consumer
+ *
+ * @param consumerId reference for the id of the new consumer
+ * @param pid id of the process
+ * @param error reference for error-output
+ *
+ * @return false, if stat-file of the process can not be opened, else true
+ */
+bool
+EnergyAttribution::addProcess(uint64_t &consumerId,
+                              const pid_t pid,
+                              ErrorContainer &error)
+{
+    const std::string filePath = "/proc/" + std::to_string(pid) + "/stat";
+
+    Consumer consumer;
+    consumer.type = PROCESS_CONSUMER;
+    consumer.pid = pid;
+    consumer.info.name = "pid-" + std::to_string(pid);
+    consumer.fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(consumer.fd < 0)
+    {
+        error.addMeesage("Failed to add process with id '"
+                         + std::to_string(pid)
+                         + "' to the energy-attribution, because file '"
+                         + filePath
+                         + "' can not be opened");
+        error.addSolution("Check if the process still exist");
+        return false;
+    }
+
+    return registerConsumer(consumerId, consumer, error);
+}
+
+/**
+ * @brief add a cgroup as new consumer
+ *
+ * @param consumerId reference for the id of the new consumer
+ * @param cgroupPath absolute path of the cgroup-directory. For cgroup v1 this is the directory
+ *                   within the cpuacct-hierarchy.
+ * @param error reference for error-output
+ *
+ * @return false, if cgroup has no cpu-accounting, else true
+ */
+bool
+EnergyAttribution::addCgroup(uint64_t &consumerId,
+                             const std::string &cgroupPath,
+                             ErrorContainer &error)
+{
+    Consumer consumer;
+    consumer.info.name = cgroupPath;
+
+    // cgroup v1 provides per-cpu-values, so prefer it, if available
+    std::string filePath = cgroupPath + "/cpuacct.usage_percpu";
+    consumer.type = CGROUP_V1_CONSUMER;
+    if(std::filesystem::exists(filePath) == false)
+    {
+        filePath = cgroupPath + "/cpu.stat";
+        consumer.type = CGROUP_V2_CONSUMER;
+    }
+
+    consumer.fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if(consumer.fd < 0)
+    {
+        error.addMeesage("Failed to add cgroup '"
+                         + cgroupPath
+                         + "' to the energy-attribution, because no cpu-accounting was found");
+        error.addSolution("Check if the cpu- or cpuacct-controller is enabled for the cgroup");
+        return false;
+    }
+
+    return registerConsumer(consumerId, consumer, error);
+}
+
+/**
+ * @brief remove a consumer from the attribution
+ *
+ * @param consumerId id of the consumer to remove
+ *
+ * @return false, if id was not found, else true
+ */
+bool
+EnergyAttribution::removeConsumer(const uint64_t consumerId)
+{
+    auto it = m_consumers.find(consumerId);
+    if(it == m_consumers.end()) {
+        return false;
+    }
+
+    closeConsumer(it->second);
+    m_consumers.erase(it);
+
+    return true;
+}
+
+/**
+ * @brief read new energy-values and busy-times and apportion the energy of the interval since
+ *        the last update to all registered consumers
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized or reading failed, else true
+ */
+bool
+EnergyAttribution::update(ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to update energy-attribution, because it is not initialized");
+        return false;
+    }
+
+    const uint64_t numberOfPackages = m_rapls.size();
+
+    // get energy of all packages
+    std::vector<RaplDiff> energy;
+    for(Rapl &rapl : m_rapls) {
+        energy.push_back(rapl.calculateDiff());
+    }
+
+    // get busy-time of all packages
+    std::vector<double> packageBusy;
+    if(readPackageBusy(packageBusy, error) == false)
+    {
+        error.addMeesage("Failed to update energy-attribution");
+        return false;
+    }
+
+    std::vector<double> busyDiff(numberOfPackages, 0.0);
+    double totalBusyDiff = 0.0;
+    double totalPkgEnergy = 0.0;
+    for(uint64_t p = 0; p < numberOfPackages; p++)
+    {
+        busyDiff[p] = packageBusy[p] - m_lastPackageBusy[p];
+        totalBusyDiff += busyDiff[p];
+        totalPkgEnergy += energy[p].pkgDiff;
+    }
+    m_lastPackageBusy = packageBusy;
+
+    double attributedPkgEnergy = 0.0;
+    for(auto &[id, consumer] : m_consumers)
+    {
+        EnergyConsumerInfo &info = consumer.info;
+        info.lastBusyTime = 0.0;
+        info.lastPkgEnergy = 0.0;
+        info.lastDramEnergy = 0.0;
+        if(info.isActive == false) {
+            continue;
+        }
+
+        // process has exited or cgroup was removed
+        ConsumerSample sample;
+        if(readConsumer(sample, consumer) == false)
+        {
+            info.isActive = false;
+            closeConsumer(consumer);
+            continue;
+        }
+
+        // split busy-time of the interval on the packages
+        const double consumerDiff = sample.total - consumer.lastSample.total;
+        std::vector<double> consumerBusy(numberOfPackages, 0.0);
+        if(sample.perPackage.size() == numberOfPackages)
+        {
+            for(uint64_t p = 0; p < numberOfPackages; p++) {
+                consumerBusy[p] = sample.perPackage[p] - consumer.lastSample.perPackage[p];
+            }
+        }
+        else if(sample.lastThreadId >= 0
+                && static_cast<uint64_t>(sample.lastThreadId) < m_packageOfThread.size())
+        {
+            // the time of tasks, which exited within the interval, is only contained in the
+            // total of the process, so it is charged to the last cpu-thread of the process
+            const double taskBusy = splitProcessBusy(consumerBusy, sample, consumer.lastSample);
+            if(consumerDiff > taskBusy) {
+                consumerBusy[m_packageOfThread[sample.lastThreadId]] += consumerDiff - taskBusy;
+            }
+        }
+        else if(totalBusyDiff > 0.0)
+        {
+            for(uint64_t p = 0; p < numberOfPackages; p++) {
+                consumerBusy[p] = consumerDiff * (busyDiff[p] / totalBusyDiff);
+            }
+        }
+        consumer.lastSample = sample;
+
+        // apportion energy by the share of the busy-time of each package
+        for(uint64_t p = 0; p < numberOfPackages; p++)
+        {
+            if(busyDiff[p] <= 0.0) {
+                continue;
+            }
+
+            const double share = std::min(1.0, consumerBusy[p] / busyDiff[p]);
+            info.lastPkgEnergy += share * energy[p].pkgDiff;
+            info.lastDramEnergy += share * energy[p].dramDiff;
+        }
+
+        info.lastBusyTime = consumerDiff;
+        info.busyTime += info.lastBusyTime;
+        info.pkgEnergy += info.lastPkgEnergy;
+        info.dramEnergy += info.lastDramEnergy;
+        attributedPkgEnergy += info.lastPkgEnergy;
+    }
+
+    m_unattributedPkgEnergy += std::max(0.0, totalPkgEnergy - attributedPkgEnergy);
+
+    return true;
+}
+
+/**
+ * @brief get info of a specific consumer
+ *
+ * @param result reference for the result
+ * @param consumerId id of the requested consumer
+ *
+ * @return false, if id was not found, else true
+ */
+bool
+EnergyAttribution::getConsumer(EnergyConsumerInfo &result,
+                               const uint64_t consumerId) const
+{
+    const auto it = m_consumers.find(consumerId);
+    if(it == m_consumers.end()) {
+        return false;
+    }
+
+    result = it->second.info;
+    return true;
+}
+
+/**
+ * @brief get info of all registered consumers
+ */
+const std::vector<EnergyConsumerInfo>
+EnergyAttribution::getConsumers() const
+{
+    std::vector<EnergyConsumerInfo> result;
+    for(const auto &[id, consumer] : m_consumers) {
+        result.push_back(consumer.info);
+    }
+    return result;
+}
+
+/**
+ * @brief get energy of the packages in Ws, which was consumed by idle-time or by processes,
+ *        which are not registered
+ */
+double
+EnergyAttribution::getUnattributedPkgEnergy() const
+{
+    return m_unattributedPkgEnergy;
+}
+
+} // namespace Kitsunemimi
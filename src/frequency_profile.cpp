@@ -0,0 +1,603 @@
+/**
+ *  @file       frequency_profile.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/frequency_profile.h>
+#include <libKitsunemimiCpu/cpu.h>
+#include <libKitsunemimiCpu/msr.h>
+#include <libKitsunemimiCpu/tsc_clock.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <thread>
+
+#include <unistd.h>
+
+namespace Kitsunemimi
+{
+
+// counters, which increase with the actual and with the nominal speed, while the thread is
+// not idle
+const uint32_t mperfOffset = 0xE7;
+const uint32_t aperfOffset = 0xE8;
+
+// length of a single window of a ramp-trace and the maximum time of a trace
+const uint64_t rampWindowUs = 10;
+const uint64_t rampTimeoutUs = 100000;
+
+// time under load before measuring and time in idle before a wake-up
+const uint64_t settleTimeUs = 50000;
+const uint64_t idleTimeUs = 50000;
+
+const std::string frequencyProfileFileHeader = "kitsunemimi-frequency-profile 1";
+
+/**
+ * @brief get speed in kHz, which the tsc and the mperf-counter are running with
+ */
+uint64_t
+getNominalSpeed()
+{
+    return static_cast<uint64_t>(TscClock::getInstance()->getTicksPerNanoSec() * 1000000.0);
+}
+
+/**
+ * @brief busy-wait for a number of tsc-ticks, which keeps the thread under full load
+ */
+void
+spinForTicks(const uint64_t ticks)
+{
+    const uint64_t end = TscClock::readTicks() + ticks;
+    while(TscClock::readTicks() < end) {}
+}
+
+/**
+ * @brief read aperf- and mperf-counter of a cpu-thread
+ */
+bool
+readAperfMperf(uint64_t &aperf,
+               uint64_t &mperf,
+               const int fd,
+               ErrorContainer &error)
+{
+    return readMsrFd(aperf, fd, aperfOffset, error)
+           && readMsrFd(mperf, fd, mperfOffset, error);
+}
+
+/**
+ * @brief calculate effective speed in kHz from the difference of aperf and mperf
+ */
+uint64_t
+calcEffectiveSpeed(const uint64_t aperfDiff,
+                   const uint64_t mperfDiff)
+{
+    if(mperfDiff == 0) {
+        return 0;
+    }
+
+    const double ratio = static_cast<double>(aperfDiff) / static_cast<double>(mperfDiff);
+    return static_cast<uint64_t>(ratio * static_cast<double>(getNominalSpeed()));
+}
+
+/**
+ * @brief record the effective speed of the current thread in windows of a few microseconds under
+ *        full load and evaluate the ramp
+ *
+ * @param result reference for the trace and the evaluated ramp
+ * @param fd msr-file of the current thread
+ * @param startTicks tsc-value of the change, which triggered the ramp
+ * @param error reference for error-output
+ *
+ * @return false, if the counters can not be read, else true
+ */
+bool
+traceFrequencyRamp(FrequencyRamp &result,
+                   const int fd,
+                   const uint64_t startTicks,
+                   ErrorContainer &error)
+{
+    const TscClock* clock = TscClock::getInstance();
+    const uint64_t windowTicks = clock->toTicks(rampWindowUs * 1000);
+    const uint64_t endTicks = startTicks + clock->toTicks(rampTimeoutUs * 1000);
+
+    // preallocate, so the trace is not disturbed by allocations
+    const uint64_t maxWindows = rampTimeoutUs / rampWindowUs + 1;
+    result.traceTimes.clear();
+    result.traceSpeeds.clear();
+    result.traceTimes.reserve(maxWindows);
+    result.traceSpeeds.reserve(maxWindows);
+
+    uint64_t lastAperf = 0;
+    uint64_t lastMperf = 0;
+    if(readAperfMperf(lastAperf, lastMperf, fd, error) == false) {
+        return false;
+    }
+
+    uint64_t now = TscClock::readTicks();
+    while(now < endTicks
+          && result.traceTimes.size() < maxWindows)
+    {
+        spinForTicks(windowTicks);
+
+        uint64_t aperf = 0;
+        uint64_t mperf = 0;
+        if(readAperfMperf(aperf, mperf, fd, error) == false) {
+            return false;
+        }
+        now = TscClock::readTicks();
+
+        const double timeUs = static_cast<double>(clock->toNanoSec(now - startTicks)) / 1000.0;
+        result.traceTimes.push_back(timeUs);
+        result.traceSpeeds.push_back(calcEffectiveSpeed(aperf - lastAperf, mperf - lastMperf));
+        lastAperf = aperf;
+        lastMperf = mperf;
+    }
+
+    // the sustained speed is the average of the last 10 percent of the trace
+    const uint64_t numberOfWindows = result.traceSpeeds.size();
+    if(numberOfWindows == 0) {
+        return false;
+    }
+    const uint64_t tailSize = std::max(numberOfWindows / 10, static_cast<uint64_t>(1));
+    double sum = 0.0;
+    for(uint64_t i = numberOfWindows - tailSize; i < numberOfWindows; i++) {
+        sum += static_cast<double>(result.traceSpeeds[i]);
+    }
+    result.sustainedSpeed = static_cast<uint64_t>(sum / static_cast<double>(tailSize));
+
+    result.latency = result.traceTimes.back();
+    for(uint64_t i = 0; i < numberOfWindows; i++)
+    {
+        if(static_cast<double>(result.traceSpeeds[i])
+                >= 0.9 * static_cast<double>(result.sustainedSpeed))
+        {
+            result.latency = result.traceTimes[i];
+            break;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief measure the sustained effective speed of cpu-threads, while all of them are under full
+ *        load at the same time
+ *
+ * @param result reference for the speed in kHz of each thread in the order of the thread-ids
+ * @param threads cpu-threads to load and measure
+ * @param durationMs duration of the load, where the first half is used to reach a stable state
+ * @param error reference for error-output
+ *
+ * @return false, if the msr can not be read, else true
+ */
+bool
+measureSustainedSpeed(std::vector<uint64_t> &result,
+                      const CpuSet &threads,
+                      const uint64_t durationMs,
+                      ErrorContainer &error)
+{
+    const std::vector<uint64_t> threadIds = threads.getThreadIds();
+    std::vector<int> fds;
+    for(const uint64_t threadId : threadIds)
+    {
+        const int fd = openMsr(threadId, false, error);
+        if(fd < 0)
+        {
+            for(const int openFd : fds) {
+                close(openFd);
+            }
+            error.addMeesage("Failed to measure sustained speed of threads '"
+                             + threads.toString()
+                             + "'");
+            return false;
+        }
+        fds.push_back(fd);
+    }
+
+    const uint64_t halfTicks = TscClock::getInstance()->toTicks(durationMs * 1000000 / 2);
+    result.assign(threadIds.size(), 0);
+    std::atomic<bool> success(true);
+
+    std::vector<std::thread> workers;
+    for(uint64_t i = 0; i < threadIds.size(); i++)
+    {
+        workers.emplace_back([&, i]()
+        {
+            ErrorContainer workerError;
+            CpuSet target;
+            target.add(threadIds[i]);
+            if(setThreadAffinity(target, workerError) == false)
+            {
+                success.store(false);
+                return;
+            }
+
+            spinForTicks(halfTicks);
+
+            uint64_t aperfBefore = 0;
+            uint64_t mperfBefore = 0;
+            uint64_t aperfAfter = 0;
+            uint64_t mperfAfter = 0;
+            if(readAperfMperf(aperfBefore, mperfBefore, fds[i], workerError) == false)
+            {
+                success.store(false);
+                return;
+            }
+            spinForTicks(halfTicks);
+            if(readAperfMperf(aperfAfter, mperfAfter, fds[i], workerError) == false)
+            {
+                success.store(false);
+                return;
+            }
+
+            result[i] = calcEffectiveSpeed(aperfAfter - aperfBefore, mperfAfter - mperfBefore);
+        });
+    }
+
+    for(std::thread &worker : workers) {
+        worker.join();
+    }
+    for(const int fd : fds) {
+        close(fd);
+    }
+
+    if(success.load() == false)
+    {
+        error.addMeesage("Failed to measure sustained speed of threads '"
+                         + threads.toString()
+                         + "', because a thread can not be bound or the msr can not be read");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief measure how long a cpu-thread under full load needs to ramp up, after the speed was
+ *        limited to the minimum and then the minimum-speed was raised to the maximum. The
+ *        speed-limits are restored afterwards.
+ *
+ * @param result reference for the ramp
+ * @param threadId id of the cpu-thread
+ * @param error reference for error-output
+ *
+ * @return false, if cpufreq or the msr is not available or the old speed-limits can not be
+ *         restored, else true
+ */
+bool
+measureRampLatency(FrequencyRamp &result,
+                   const uint64_t threadId,
+                   ErrorContainer &error)
+{
+    uint64_t minSpeed = 0;
+    uint64_t maxSpeed = 0;
+    uint64_t oldMinSpeed = 0;
+    uint64_t oldMaxSpeed = 0;
+    if(getMinimumSpeed(minSpeed, threadId, error) == false
+            || getMaximumSpeed(maxSpeed, threadId, error) == false
+            || getCurrentMinimumSpeed(oldMinSpeed, threadId, error) == false
+            || getCurrentMaximumSpeed(oldMaxSpeed, threadId, error) == false)
+    {
+        error.addMeesage("Failed to measure ramp-latency of thread '"
+                         + std::to_string(threadId)
+                         + "', because its speed can not be read");
+        return false;
+    }
+
+    const int fd = openMsr(threadId, false, error);
+    if(fd < 0)
+    {
+        error.addMeesage("Failed to measure ramp-latency of thread '"
+                         + std::to_string(threadId)
+                         + "'");
+        return false;
+    }
+
+    // the measurement runs on the measured thread itself, so the change and the trace use the
+    // same tsc without any cross-thread-communication
+    bool success = false;
+    std::thread worker([&]()
+    {
+        CpuSet target;
+        target.add(threadId);
+        if(setThreadAffinity(target, error) == false) {
+            return;
+        }
+
+        // limit to minimum-speed and wait for a stable state
+        if(setMinimumSpeed(threadId, minSpeed, error) == false
+                || setMaximumSpeed(threadId, minSpeed, error) == false)
+        {
+            return;
+        }
+        const TscClock* clock = TscClock::getInstance();
+        spinForTicks(clock->toTicks(settleTimeUs * 1000));
+
+        uint64_t aperfBefore = 0;
+        uint64_t mperfBefore = 0;
+        uint64_t aperfAfter = 0;
+        uint64_t mperfAfter = 0;
+        if(readAperfMperf(aperfBefore, mperfBefore, fd, error) == false) {
+            return;
+        }
+        spinForTicks(clock->toTicks(1000000));
+        if(readAperfMperf(aperfAfter, mperfAfter, fd, error) == false) {
+            return;
+        }
+        result.startSpeed = calcEffectiveSpeed(aperfAfter - aperfBefore,
+                                               mperfAfter - mperfBefore);
+
+        // raise the limits and trace the ramp
+        const uint64_t startTicks = TscClock::readTicks();
+        if(setMaximumSpeed(threadId, maxSpeed, error) == false
+                || setMinimumSpeed(threadId, maxSpeed, error) == false)
+        {
+            return;
+        }
+        success = traceFrequencyRamp(result, fd, startTicks, error);
+    });
+    worker.join();
+    close(fd);
+
+    // the kernel rejects a minimum above the current maximum and the other way round, so the
+    // order of the restore depends on the limits, which were left by the worker
+    uint64_t currentMaxSpeed = 0;
+    bool restored = getCurrentMaximumSpeed(currentMaxSpeed, threadId, error);
+    if(restored)
+    {
+        if(oldMinSpeed > currentMaxSpeed)
+        {
+            restored = setMaximumSpeed(threadId, oldMaxSpeed, error)
+                       && setMinimumSpeed(threadId, oldMinSpeed, error);
+        }
+        else
+        {
+            restored = setMinimumSpeed(threadId, oldMinSpeed, error)
+                       && setMaximumSpeed(threadId, oldMaxSpeed, error);
+        }
+    }
+
+    if(restored == false)
+    {
+        error.addMeesage("Failed to restore speed-limits of thread '"
+                         + std::to_string(threadId)
+                         + "' after measuring the ramp-latency");
+        error.addSolution("reset the speed of the thread with resetSpeed");
+        return false;
+    }
+
+    if(success == false)
+    {
+        error.addMeesage("Failed to measure ramp-latency of thread '"
+                         + std::to_string(threadId)
+                         + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief measure how long a cpu-thread needs to ramp up, after it was idle for 50ms and
+ *        then is under full load
+ *
+ * @param result reference for the ramp, where the start-speed is the speed of the first window
+ *               after the wake-up
+ * @param threadId id of the cpu-thread
+ * @param error reference for error-output
+ *
+ * @return false, if the msr is not available, else true
+ */
+bool
+measureWakeLatency(FrequencyRamp &result,
+                   const uint64_t threadId,
+                   ErrorContainer &error)
+{
+    const int fd = openMsr(threadId, false, error);
+    if(fd < 0)
+    {
+        error.addMeesage("Failed to measure wake-latency of thread '"
+                         + std::to_string(threadId)
+                         + "'");
+        return false;
+    }
+
+    bool success = false;
+    std::thread worker([&]()
+    {
+        CpuSet target;
+        target.add(threadId);
+        if(setThreadAffinity(target, error) == false) {
+            return;
+        }
+
+        // the sleep gives the thread the chance to enter a deep idle-state
+        std::this_thread::sleep_for(std::chrono::microseconds(idleTimeUs));
+        const uint64_t startTicks = TscClock::readTicks();
+        success = traceFrequencyRamp(result, fd, startTicks, error);
+        if(success) {
+            result.startSpeed = result.traceSpeeds.front();
+        }
+    });
+    worker.join();
+    close(fd);
+
+    if(success == false)
+    {
+        error.addMeesage("Failed to measure wake-latency of thread '"
+                         + std::to_string(threadId)
+                         + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief characterize the speed of cpu-threads under single-core- and all-core-load and their
+ *        ramp-latencies. Ramp-latencies, which can not be measured, because cpufreq is not
+ *        available, are set to -1.
+ *
+ * @param result reference for the resulting profile
+ * @param threads cpu-threads to characterize
+ * @param durationMs duration of the load for each sustained speed
+ * @param error reference for error-output
+ *
+ * @return false, if the msr can not be read, else true
+ */
+bool
+createFrequencyProfile(FrequencyProfile &result,
+                       const CpuSet &threads,
+                       const uint64_t durationMs,
+                       ErrorContainer &error)
+{
+    result = FrequencyProfile();
+    result.threadIds = threads.getThreadIds();
+    result.nominalSpeed = getNominalSpeed();
+
+    // all-core
+    if(measureSustainedSpeed(result.allCoreSpeeds, threads, durationMs, error) == false)
+    {
+        error.addMeesage("Failed to create frequency-profile");
+        return false;
+    }
+
+    for(const uint64_t threadId : result.threadIds)
+    {
+        // single-core
+        CpuSet single;
+        single.add(threadId);
+        std::vector<uint64_t> speeds;
+        if(measureSustainedSpeed(speeds, single, durationMs, error) == false)
+        {
+            error.addMeesage("Failed to create frequency-profile");
+            return false;
+        }
+        result.singleCoreSpeeds.push_back(speeds[0]);
+
+        // ramps
+        FrequencyRamp ramp;
+        ErrorContainer rampError;
+        if(measureRampLatency(ramp, threadId, rampError)) {
+            result.rampLatencies.push_back(ramp.latency);
+        } else {
+            result.rampLatencies.push_back(-1.0);
+        }
+
+        if(measureWakeLatency(ramp, threadId, error) == false)
+        {
+            error.addMeesage("Failed to create frequency-profile");
+            return false;
+        }
+        result.wakeLatencies.push_back(ramp.latency);
+    }
+
+    return true;
+}
+
+/**
+ * @brief write a frequency-profile into a file
+ *
+ * @param profile profile to write
+ * @param filePath path to the file
+ * @param error reference for error-output
+ *
+ * @return false, if file can not be written, else true
+ */
+bool
+saveFrequencyProfile(const FrequencyProfile &profile,
+                     const std::string &filePath,
+                     ErrorContainer &error)
+{
+    std::ofstream outFile(filePath, std::ios_base::trunc);
+    if(outFile.is_open() == false)
+    {
+        error.addMeesage("can not open file to write content: '" + filePath + "'");
+        return false;
+    }
+
+    // first line is the header, second line the nominal speed and number of threads and then one
+    // line for each thread with: thread-id single-core all-core ramp-latency wake-latency
+    outFile.precision(std::numeric_limits<double>::max_digits10);
+    outFile << frequencyProfileFileHeader << "\n";
+    outFile << profile.nominalSpeed << " " << profile.threadIds.size() << "\n";
+    for(uint64_t i = 0; i < profile.threadIds.size(); i++)
+    {
+        outFile << profile.threadIds[i] << " "
+                << profile.singleCoreSpeeds[i] << " "
+                << profile.allCoreSpeeds[i] << " "
+                << profile.rampLatencies[i] << " "
+                << profile.wakeLatencies[i] << "\n";
+    }
+
+    if(outFile.good() == false)
+    {
+        error.addMeesage("Failed to write frequency-profile into file '" + filePath + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief read a frequency-profile from a file, which was written by saveFrequencyProfile
+ *
+ * @param result reference for the resulting profile
+ * @param filePath path to the file
+ * @param error reference for error-output
+ *
+ * @return false, if file doesn't exist or is invalid, else true
+ */
+bool
+loadFrequencyProfile(FrequencyProfile &result,
+                     const std::string &filePath,
+                     ErrorContainer &error)
+{
+    std::ifstream inFile(filePath);
+    if(inFile.is_open() == false)
+    {
+        error.addMeesage("can not open file to read content: '" + filePath + "'");
+        return false;
+    }
+
+    std::string header = "";
+    std::getline(inFile, header);
+    FrequencyProfile profile;
+    uint64_t numberOfThreads = 0;
+    inFile >> profile.nominalSpeed >> numberOfThreads;
+
+    for(uint64_t i = 0; i < numberOfThreads && inFile.good(); i++)
+    {
+        uint64_t threadId = 0;
+        uint64_t singleCoreSpeed = 0;
+        uint64_t allCoreSpeed = 0;
+        double rampLatency = 0.0;
+        double wakeLatency = 0.0;
+        inFile >> threadId >> singleCoreSpeed >> allCoreSpeed >> rampLatency >> wakeLatency;
+
+        profile.threadIds.push_back(threadId);
+        profile.singleCoreSpeeds.push_back(singleCoreSpeed);
+        profile.allCoreSpeeds.push_back(allCoreSpeed);
+        profile.rampLatencies.push_back(rampLatency);
+        profile.wakeLatencies.push_back(wakeLatency);
+    }
+
+    if(header != frequencyProfileFileHeader
+            || inFile.fail())
+    {
+        error.addMeesage("File '" + filePath + "' is not a valid frequency-profile");
+        return false;
+    }
+
+    result = profile;
+
+    return true;
+}
+
+} // namespace Kitsunemimi
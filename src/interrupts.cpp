@@ -0,0 +1,552 @@
+/**
+ *  @file       interrupts.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/interrupts.h>
+#include <libKitsunemimiCpu/cpu.h>
+#include <libKitsunemimiCpu/memory_probe.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief parse a line of the interrupts-file, like
+ *        " 43:  1673  0  PCI-MSIX-0000:00:05.0   1-edge      virtio4-rx"
+ *
+ * @param result reference for result-output
+ * @param line line to parse
+ * @param columnIds ids of the cpu-threads of the count-columns
+ *
+ * @return false, if the line has no name, else true
+ */
+bool
+parseInterruptLine(InterruptInfo &result,
+                   const std::string &line,
+                   const std::vector<uint64_t> &columnIds)
+{
+    std::istringstream lineStream(line);
+    std::string name;
+    lineStream >> name;
+    if(name.size() < 2
+            || name.back() != ':')
+    {
+        return false;
+    }
+    result.name = name.substr(0, name.size() - 1);
+    result.isDeviceIrq = std::all_of(result.name.begin(), result.name.end(), ::isdigit);
+    if(result.isDeviceIrq) {
+        result.irq = std::stoull(result.name);
+    }
+
+    // some lines, like "ERR", have only a single value instead of one for each cpu-thread
+    const uint64_t maxId = columnIds.size() > 0 ? columnIds.back() : 0;
+    result.counts.assign(maxId + 1, 0);
+    std::string token;
+    std::vector<std::string> rest;
+    uint64_t column = 0;
+    while(lineStream >> token)
+    {
+        if(rest.size() == 0
+                && column < columnIds.size()
+                && std::all_of(token.begin(), token.end(), ::isdigit))
+        {
+            result.counts[columnIds[column]] = std::stoull(token);
+            column++;
+            continue;
+        }
+        rest.push_back(token);
+    }
+
+    // device-irqs have the form "<chip> [<hwirq>-<type>] <actions>", the other interrupts only
+    // have a description
+    uint64_t actionStart = 0;
+    if(result.isDeviceIrq
+            && rest.size() > 0)
+    {
+        result.chip = rest[0];
+        actionStart = 1;
+        if(rest.size() > 2
+                && rest[1].find('-') != std::string::npos)
+        {
+            actionStart = 2;
+        }
+    }
+    for(uint64_t i = actionStart; i < rest.size(); i++)
+    {
+        if(result.actions.size() > 0) {
+            result.actions += " ";
+        }
+        result.actions += rest[i];
+    }
+
+    return true;
+}
+
+/**
+ * @brief get all interrupts and their counts for each cpu-thread
+ *
+ * @param result reference for result-output
+ * @param error reference for error-output
+ *
+ * @return false, if the interrupts-file can not be read, else true
+ */
+bool
+getInterrupts(std::vector<InterruptInfo> &result,
+              ErrorContainer &error)
+{
+    const std::string filePath = "/proc/interrupts";
+    std::ifstream inFile(filePath);
+    if(inFile.is_open() == false)
+    {
+        error.addMeesage("can not open file to read content: '" + filePath + "'");
+        return false;
+    }
+
+    // header has one column for each online cpu-thread, like "CPU0 CPU1 CPU3"
+    std::string line;
+    std::getline(inFile, line);
+    std::vector<uint64_t> columnIds;
+    std::istringstream header(line);
+    std::string column;
+    while(header >> column)
+    {
+        if(column.compare(0, 3, "CPU") == 0) {
+            columnIds.push_back(std::stoull(column.substr(3)));
+        }
+    }
+
+    result.clear();
+    while(std::getline(inFile, line))
+    {
+        InterruptInfo info;
+        if(parseInterruptLine(info, line, columnIds)) {
+            result.push_back(info);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief constructor
+ */
+InterruptSampler::InterruptSampler() {}
+
+/**
+ * @brief read initial state of the interrupt-counters
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if the counters can not be read, else true
+ */
+bool
+InterruptSampler::initSampler(ErrorContainer &error)
+{
+    // check if already initialized
+    if(m_isInit)
+    {
+        LOG_WARNING("this interrupt-sampler was already successfully initialized");
+        return true;
+    }
+
+    if(getInterrupts(m_lastState, error) == false)
+    {
+        error.addMeesage("Failed to initialize interrupt-sampler");
+        return false;
+    }
+    m_isInit = true;
+
+    return true;
+}
+
+/**
+ * @brief get the number of interrupts for each cpu-thread since the last call
+ *
+ * @param result reference for the interrupts with the increase of their counters
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized or counters can not be read, else true
+ */
+bool
+InterruptSampler::calculateDiff(std::vector<InterruptInfo> &result,
+                                ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to calculate interrupt-diff, because sampler is not "
+                         "initialized");
+        return false;
+    }
+
+    std::vector<InterruptInfo> current;
+    if(getInterrupts(current, error) == false) {
+        return false;
+    }
+
+    // irqs can be added or removed and cpu-threads can go online or offline in the meantime
+    std::map<std::string, const InterruptInfo*> lastByName;
+    for(const InterruptInfo &info : m_lastState) {
+        lastByName[info.name] = &info;
+    }
+
+    result = current;
+    for(InterruptInfo &info : result)
+    {
+        const auto it = lastByName.find(info.name);
+        if(it == lastByName.end()) {
+            continue;
+        }
+
+        const std::vector<uint64_t> &lastCounts = it->second->counts;
+        for(uint64_t i = 0; i < info.counts.size() && i < lastCounts.size(); i++) {
+            info.counts[i] -= std::min(info.counts[i], lastCounts[i]);
+        }
+    }
+
+    m_lastState = current;
+
+    return true;
+}
+
+/**
+ * @brief get the sysfs-directory of a device, which owns the irqs. Some devices, like
+ *        virtio-devices, are only children of the pci-device with the irqs.
+ *
+ * @param devicePath path to the device in sysfs
+ *
+ * @return path of the device itself or its parent
+ */
+const std::string
+getIrqOwnerPath(const std::string &devicePath)
+{
+    std::error_code ec;
+    const std::filesystem::path device = std::filesystem::canonical(devicePath, ec);
+    if(ec) {
+        return devicePath;
+    }
+
+    if(std::filesystem::exists(device / "msi_irqs")
+            || std::filesystem::exists(device / "irq"))
+    {
+        return device.string();
+    }
+
+    return device.parent_path().string();
+}
+
+/**
+ * @brief get all irqs of a device
+ *
+ * @param result reference for the resulting irq-numbers
+ * @param devicePath path to the device in sysfs, like "/sys/class/net/eth0/device"
+ * @param error reference for error-output
+ *
+ * @return false, if no irqs were found, else true
+ */
+bool
+getInterruptsOfDevice(std::vector<uint64_t> &result,
+                      const std::string &devicePath,
+                      ErrorContainer &error)
+{
+    result.clear();
+    const std::string ownerPath = getIrqOwnerPath(devicePath);
+
+    // msi- and msi-x-devices have one entry for each vector
+    std::error_code ec;
+    for(const auto &entry : std::filesystem::directory_iterator(ownerPath + "/msi_irqs", ec))
+    {
+        const std::string name = entry.path().filename().string();
+        if(std::all_of(name.begin(), name.end(), ::isdigit)) {
+            result.push_back(std::stoull(name));
+        }
+    }
+
+    // legacy-interrupt, where 0 means no irq
+    if(result.size() == 0)
+    {
+        std::ifstream inFile(ownerPath + "/irq");
+        uint64_t irq = 0;
+        if(inFile >> irq
+                && irq != 0)
+        {
+            result.push_back(irq);
+        }
+    }
+
+    if(result.size() == 0)
+    {
+        error.addMeesage("No irqs found for device '" + devicePath + "'");
+        return false;
+    }
+
+    std::sort(result.begin(), result.end());
+    return true;
+}
+
+/**
+ * @brief get all irqs of the device of a network-interface
+ *
+ * @param result reference for the resulting irq-numbers
+ * @param interfaceName name of the network-interface, like "eth0"
+ * @param error reference for error-output
+ *
+ * @return false, if the interface has no device or no irqs were found, else true
+ */
+bool
+getInterruptsOfNetworkInterface(std::vector<uint64_t> &result,
+                                const std::string &interfaceName,
+                                ErrorContainer &error)
+{
+    const std::string devicePath = "/sys/class/net/" + interfaceName + "/device";
+    if(std::filesystem::exists(devicePath) == false)
+    {
+        error.addMeesage("Network-interface '" + interfaceName + "' has no device");
+        error.addSolution("virtual interfaces, like bridges or loopback, don't have irqs");
+        return false;
+    }
+
+    return getInterruptsOfDevice(result, devicePath, error);
+}
+
+/**
+ * @brief get cpu-threads, which are allowed to handle an irq
+ *
+ * @param result reference for result-output
+ * @param irq number of the irq
+ * @param error reference for error-output
+ *
+ * @return false, if the affinity can not be read, else true
+ */
+bool
+getInterruptAffinity(CpuSet &result,
+                     const uint64_t irq,
+                     ErrorContainer &error)
+{
+    const std::string filePath = "/proc/irq/" + std::to_string(irq) + "/smp_affinity_list";
+    std::ifstream inFile(filePath);
+    if(inFile.is_open() == false)
+    {
+        error.addMeesage("can not open file to read content: '" + filePath + "'");
+        return false;
+    }
+
+    std::string content = "";
+    std::getline(inFile, content);
+    if(result.parse(content) == false)
+    {
+        error.addMeesage("Failed to parse cpu-list '" + content + "' of file '" + filePath + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief set cpu-threads, which are allowed to handle an irq
+ *
+ * @param irq number of the irq
+ * @param threads new cpu-threads for the irq
+ * @param error reference for error-output
+ *
+ * @return false, if the affinity can not be changed, else true
+ */
+bool
+setInterruptAffinity(const uint64_t irq,
+                     const CpuSet &threads,
+                     ErrorContainer &error)
+{
+    const std::string filePath = "/proc/irq/" + std::to_string(irq) + "/smp_affinity_list";
+
+    // a plain file-stream would hide the error of the kernel, which is only returned by write
+    const int fd = open(filePath.c_str(), O_WRONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        error.addMeesage("can not open file to write content: '" + filePath + "'");
+        error.addSolution("check if you have write-permissions to the file '" + filePath + "'");
+        return false;
+    }
+
+    const std::string content = threads.toString() + "\n";
+    const ssize_t ret = write(fd, content.c_str(), content.size());
+    const int errorNumber = errno;
+    close(fd);
+
+    if(ret < 0)
+    {
+        error.addMeesage("Failed to set affinity of irq '"
+                         + std::to_string(irq)
+                         + "' to '"
+                         + threads.toString()
+                         + "': "
+                         + std::string(strerror(errorNumber)));
+        error.addSolution("irqs, which are managed by the kernel, like the queues of nvme-devices, "
+                          "and some legacy-irqs can not be moved");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief remove a set of cpu-threads from the affinity of all device-irqs, for example to keep
+ *        latency-critical cores free of interrupts. Irqs, which would have no cpu-thread left,
+ *        are allowed on all other online cpu-threads.
+ *
+ * @param failedIrqs reference for the irqs, which can not be moved
+ * @param protectedThreads cpu-threads, which should not handle any irqs
+ * @param error reference for error-output
+ *
+ * @return false, if no other cpu-thread is online or interrupts can not be read, else true.
+ *         Single irqs, which can not be moved, are listed in failedIrqs.
+ */
+bool
+moveInterruptsAway(std::vector<uint64_t> &failedIrqs,
+                   const CpuSet &protectedThreads,
+                   ErrorContainer &error)
+{
+    failedIrqs.clear();
+
+    CpuSet online;
+    if(getOnlineCpuThreads(online, error) == false) {
+        return false;
+    }
+    const CpuSet allowed = online - protectedThreads;
+    if(allowed.isEmpty())
+    {
+        error.addMeesage("Failed to move irqs, because no online cpu-thread is left for them");
+        return false;
+    }
+
+    std::vector<InterruptInfo> interrupts;
+    if(getInterrupts(interrupts, error) == false) {
+        return false;
+    }
+
+    for(const InterruptInfo &info : interrupts)
+    {
+        if(info.isDeviceIrq == false) {
+            continue;
+        }
+
+        ErrorContainer irqError;
+        CpuSet current;
+        if(getInterruptAffinity(current, info.irq, irqError) == false)
+        {
+            failedIrqs.push_back(info.irq);
+            continue;
+        }
+        if(current.intersects(protectedThreads) == false) {
+            continue;
+        }
+
+        CpuSet target = current - protectedThreads;
+        if(target.isEmpty()) {
+            target = allowed;
+        }
+        if(setInterruptAffinity(info.irq, target, irqError) == false)
+        {
+            LOG_WARNING(irqError.toString());
+            failedIrqs.push_back(info.irq);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief spread the irqs of a network-interface over the physical cores of its local
+ *        numa-node, so each queue has its own core
+ *
+ * @param interfaceName name of the network-interface, like "eth0"
+ * @param excludedThreads cpu-threads, which should not handle any irqs of the interface
+ * @param error reference for error-output
+ *
+ * @return false, if irqs or the local cores can not be found or an irq can not be moved,
+ *         else true
+ */
+bool
+spreadNetworkInterrupts(const std::string &interfaceName,
+                        const CpuSet &excludedThreads,
+                        ErrorContainer &error)
+{
+    const std::string devicePath = "/sys/class/net/" + interfaceName + "/device";
+    std::vector<uint64_t> irqs;
+    if(getInterruptsOfNetworkInterface(irqs, interfaceName, error) == false) {
+        return false;
+    }
+
+    CpuSet online;
+    if(getOnlineCpuThreads(online, error) == false) {
+        return false;
+    }
+
+    // numa-node of the device, where -1 means, that there is no local node
+    CpuSet threads = online;
+    int64_t nodeId = -1;
+    std::ifstream nodeFile(getIrqOwnerPath(devicePath) + "/numa_node");
+    if(nodeFile >> nodeId
+            && nodeId >= 0)
+    {
+        CpuSet nodeThreads;
+        if(getCpuThreadsOfNode(nodeThreads, nodeId, error) == false) {
+            return false;
+        }
+        threads &= nodeThreads;
+    }
+    threads -= excludedThreads;
+    if(threads.isEmpty())
+    {
+        error.addMeesage("Failed to spread irqs of network-interface '"
+                         + interfaceName
+                         + "', because no usable cpu-thread was found");
+        return false;
+    }
+
+    // use only one cpu-thread of each physical core, because hyperthreads share the core
+    std::vector<uint64_t> packageIds;
+    std::vector<uint64_t> coreIds;
+    if(getCpuPackageId(packageIds, threads, error) == false
+            || getCpuCoreId(coreIds, threads, error) == false)
+    {
+        return false;
+    }
+    std::vector<uint64_t> targets;
+    std::vector<std::pair<uint64_t, uint64_t>> usedCores;
+    const std::vector<uint64_t> threadIds = threads.getThreadIds();
+    for(uint64_t i = 0; i < threadIds.size(); i++)
+    {
+        const std::pair<uint64_t, uint64_t> core(packageIds[i], coreIds[i]);
+        if(std::find(usedCores.begin(), usedCores.end(), core) != usedCores.end()) {
+            continue;
+        }
+        usedCores.push_back(core);
+        targets.push_back(threadIds[i]);
+    }
+
+    bool success = true;
+    for(uint64_t i = 0; i < irqs.size(); i++)
+    {
+        CpuSet target;
+        target.add(targets[i % targets.size()]);
+        success &= setInterruptAffinity(irqs[i], target, error);
+    }
+
+    return success;
+}
+
+} // namespace Kitsunemimi
@@ -7,6 +7,10 @@
  */
 
 #include <libKitsunemimiCpu/memory.h>
+#include <libKitsunemimiCpu/cgroup.h>
+
+#include <algorithm>
+#include <fstream>
 
 namespace Kitsunemimi
 {
@@ -33,6 +37,33 @@ getFreeMemory()
     return pages * page_size;
 }
 
+/**
+ * @brief get amount of main-memory of the system in bytes, which can be used for new
+ *        allocations without swapping, so in contrast to the free memory the reclaimable
+ *        page-cache is included
+ *
+ * @return MemAvailable of the meminfo-file or the free memory, if not available
+ */
+uint64_t
+getAvailableMemory()
+{
+    std::ifstream inFile("/proc/meminfo");
+    std::string key;
+    uint64_t value = 0;
+    std::string unit;
+
+    // lines have the form "MemAvailable:   12345678 kB"
+    while(inFile >> key >> value)
+    {
+        if(key == "MemAvailable:") {
+            return value * 1024;
+        }
+        std::getline(inFile, unit);
+    }
+
+    return getFreeMemory();
+}
+
 /**
  * @brief get page-size of the main-memory of the system in bytes
  */
@@ -42,4 +73,57 @@ getPageSize()
     return sysconf(_SC_PAGE_SIZE);
 }
 
+/**
+ * @brief get total amount of main-memory in bytes, which can be used by the current process,
+ *        so inside of a container the memory-limit of the cgroup is used, if set
+ */
+uint64_t
+getContainerTotalMemory()
+{
+    const uint64_t total = getTotalMemory();
+
+    ErrorContainer error;
+    uint64_t limit = 0;
+    if(getCgroupMemoryLimit(limit, error) == false) {
+        return total;
+    }
+
+    return std::min(total, limit);
+}
+
+/**
+ * @brief get amount of free main-memory in bytes, which can still be used by the current process,
+ *        so inside of a container the memory-limit and -usage of the cgroup are used, if set
+ *
+ * @return minimum of the available memory of the host and the remaining memory of the cgroup,
+ *         where the reclaimable page-cache is counted as free in both cases
+ */
+uint64_t
+getContainerFreeMemory()
+{
+    const uint64_t available = getAvailableMemory();
+
+    ErrorContainer error;
+    uint64_t limit = 0;
+    uint64_t usage = 0;
+    if(getCgroupMemoryLimit(limit, error) == false
+            || limit == UINT64_MAX
+            || getCgroupMemoryUsage(usage, error) == false)
+    {
+        return available;
+    }
+
+    // the usage of the cgroup contains its page-cache, which is reclaimed before the limit is hit
+    uint64_t inactiveFile = 0;
+    if(getCgroupMemoryInactiveFile(inactiveFile, error)) {
+        usage -= std::min(usage, inactiveFile);
+    }
+
+    if(usage >= limit) {
+        return 0;
+    }
+
+    return std::min(available, limit - usage);
+}
+
 } // namespace Kitsunemimi
@@ -0,0 +1,507 @@
+/**
+ *  @file       memory_probe.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/memory_probe.h>
+#include <libKitsunemimiCpu/cpu.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <thread>
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief get ids of all online numa-nodes
+ *
+ * @param result reference for the resulting ids
+ * @param error reference for error-output
+ *
+ * @return false, if the node-information can not be read, else true
+ */
+bool
+getNumaNodes(std::vector<uint64_t> &result,
+             ErrorContainer &error)
+{
+    const std::string filePath = "/sys/devices/system/node/online";
+    std::ifstream inFile(filePath);
+    if(inFile.is_open() == false)
+    {
+        error.addMeesage("can not open file to read content: '" + filePath + "'");
+        error.addSolution("check if the kernel was build with numa-support");
+        return false;
+    }
+
+    // the node-list has the same format like a cpu-list
+    std::string content = "";
+    std::getline(inFile, content);
+    CpuSet nodes;
+    if(nodes.parse(content) == false)
+    {
+        error.addMeesage("Failed to parse numa-nodes from file '" + filePath + "'");
+        return false;
+    }
+
+    result = nodes.getThreadIds();
+    return true;
+}
+
+/**
+ * @brief get cpu-threads, which belong to a numa-node
+ *
+ * @param result reference for result-output
+ * @param nodeId id of the numa-node
+ * @param error reference for error-output
+ *
+ * @return false, if the node-information can not be read, else true
+ */
+bool
+getCpuThreadsOfNode(CpuSet &result,
+                    const uint64_t nodeId,
+                    ErrorContainer &error)
+{
+    const std::string filePath = "/sys/devices/system/node/node"
+                                 + std::to_string(nodeId)
+                                 + "/cpulist";
+    std::ifstream inFile(filePath);
+    if(inFile.is_open() == false)
+    {
+        error.addMeesage("can not open file to read content: '" + filePath + "'");
+        return false;
+    }
+
+    std::string content = "";
+    std::getline(inFile, content);
+    if(result.parse(content) == false)
+    {
+        error.addMeesage("Failed to parse cpu-threads from file '" + filePath + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief allocate memory, which is bound to a specific numa-node
+ *
+ * @param size size of the buffer in bytes
+ * @param memoryNode id of the numa-node
+ *
+ * @return nullptr, if allocation or binding failed, else pointer to the buffer
+ */
+uint8_t*
+allocateOnNode(const uint64_t size,
+               const uint64_t memoryNode)
+{
+    void* buffer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(buffer == MAP_FAILED) {
+        return nullptr;
+    }
+
+    // the policy has to be set before the first touch of the pages
+    std::vector<unsigned long> nodeMask(memoryNode / (8 * sizeof(unsigned long)) + 1, 0);
+    nodeMask[memoryNode / (8 * sizeof(unsigned long))] |=
+            1UL << (memoryNode % (8 * sizeof(unsigned long)));
+    const unsigned long maxNode = nodeMask.size() * 8 * sizeof(unsigned long) + 1;
+    if(syscall(SYS_mbind, buffer, size, MPOL_BIND, nodeMask.data(), maxNode, 0) != 0)
+    {
+        munmap(buffer, size);
+        return nullptr;
+    }
+
+    return static_cast<uint8_t*>(buffer);
+}
+
+/**
+ * @brief run a function in parallel on all cpu-threads of a set and measure the time, where all
+ *        threads are running
+ *
+ * @param threads cpu-threads to use
+ * @param function function, which gets the position of the thread and the number of threads
+ *
+ * @return time in seconds or a negative value, if any thread can not be bound
+ */
+double
+runOnThreads(const CpuSet &threads,
+             const std::function<void(const uint64_t, const uint64_t)> &function)
+{
+    const std::vector<uint64_t> threadIds = threads.getThreadIds();
+    const uint64_t numberOfThreads = threadIds.size();
+    std::atomic<uint64_t> ready(0);
+    std::atomic<bool> start(false);
+    std::atomic<bool> failed(false);
+
+    std::vector<std::thread> workers;
+    for(uint64_t i = 0; i < numberOfThreads; i++)
+    {
+        workers.emplace_back([&, i]()
+        {
+            ErrorContainer error;
+            CpuSet target;
+            target.add(threadIds[i]);
+            if(setThreadAffinity(target, error) == false) {
+                failed.store(true);
+            }
+
+            // wait until all threads are bound, so they start at the same time
+            ready.fetch_add(1);
+            while(start.load(std::memory_order_acquire) == false) {}
+
+            if(failed.load() == false) {
+                function(i, numberOfThreads);
+            }
+        });
+    }
+
+    while(ready.load() < numberOfThreads) {}
+    const auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    for(std::thread &worker : workers) {
+        worker.join();
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    if(failed.load()) {
+        return -1.0;
+    }
+
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+#if defined(__x86_64__)
+/**
+ * @brief avx2-variant of readKernel, which is compiled for avx2 independent of the build-flags
+ *        and only called, if the cpu supports avx2
+ */
+__attribute__((target("avx2")))
+uint64_t
+readKernelAvx2(const uint8_t* buffer,
+               const uint64_t size)
+{
+    __m256i sum = _mm256_setzero_si256();
+    const __m256i* pos = reinterpret_cast<const __m256i*>(buffer);
+    for(uint64_t i = 0; i < size / 32; i += 2)
+    {
+        sum = _mm256_add_epi64(sum, _mm256_load_si256(pos + i));
+        sum = _mm256_add_epi64(sum, _mm256_load_si256(pos + i + 1));
+    }
+    uint64_t values[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(values), sum);
+    return values[0] + values[1] + values[2] + values[3];
+}
+#endif
+
+/**
+ * @brief read a memory-block and sum up its content, so the compiler can not drop the loads
+ */
+uint64_t
+readKernel(const uint8_t* buffer,
+           const uint64_t size)
+{
+#if defined(__x86_64__)
+    // the library is build for the x86-64 baseline, so avx2 is selected at runtime
+    static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+    if(hasAvx2) {
+        return readKernelAvx2(buffer, size);
+    }
+#endif
+
+#if defined(__SSE2__)
+    __m128i sum = _mm_setzero_si128();
+    const __m128i* pos = reinterpret_cast<const __m128i*>(buffer);
+    for(uint64_t i = 0; i < size / 16; i += 4)
+    {
+        sum = _mm_add_epi64(sum, _mm_load_si128(pos + i));
+        sum = _mm_add_epi64(sum, _mm_load_si128(pos + i + 1));
+        sum = _mm_add_epi64(sum, _mm_load_si128(pos + i + 2));
+        sum = _mm_add_epi64(sum, _mm_load_si128(pos + i + 3));
+    }
+    uint64_t values[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(values), sum);
+    return values[0] + values[1];
+#else
+    uint64_t sum = 0;
+    const uint64_t* pos = reinterpret_cast<const uint64_t*>(buffer);
+    for(uint64_t i = 0; i < size / 8; i++) {
+        sum += pos[i];
+    }
+    return sum;
+#endif
+}
+
+/**
+ * @brief write a memory-block with non-temporal stores, like the STREAM-benchmark
+ */
+void
+writeKernel(uint8_t* buffer,
+            const uint64_t size)
+{
+#if defined(__SSE2__)
+    const __m128i value = _mm_set1_epi64x(0x0123456789abcdefLL);
+    __m128i* pos = reinterpret_cast<__m128i*>(buffer);
+    for(uint64_t i = 0; i < size / 16; i += 4)
+    {
+        _mm_stream_si128(pos + i, value);
+        _mm_stream_si128(pos + i + 1, value);
+        _mm_stream_si128(pos + i + 2, value);
+        _mm_stream_si128(pos + i + 3, value);
+    }
+    _mm_sfence();
+#else
+    uint64_t* pos = reinterpret_cast<uint64_t*>(buffer);
+    for(uint64_t i = 0; i < size / 8; i++) {
+        pos[i] = 0x0123456789abcdefULL;
+    }
+#endif
+}
+
+/**
+ * @brief copy a memory-block with non-temporal stores
+ */
+void
+copyKernel(uint8_t* target,
+           const uint8_t* source,
+           const uint64_t size)
+{
+#if defined(__SSE2__)
+    __m128i* out = reinterpret_cast<__m128i*>(target);
+    const __m128i* in = reinterpret_cast<const __m128i*>(source);
+    for(uint64_t i = 0; i < size / 16; i += 4)
+    {
+        _mm_stream_si128(out + i, _mm_load_si128(in + i));
+        _mm_stream_si128(out + i + 1, _mm_load_si128(in + i + 1));
+        _mm_stream_si128(out + i + 2, _mm_load_si128(in + i + 2));
+        _mm_stream_si128(out + i + 3, _mm_load_si128(in + i + 3));
+    }
+    _mm_sfence();
+#else
+    memcpy(target, source, size);
+#endif
+}
+
+/**
+ * @brief measure the latency of dependent loads with a pointer-chase in random order over the
+ *        cache-lines of a buffer, so the hardware-prefetcher can not predict the next access
+ *
+ * @param buffer buffer to use
+ * @param size size of the buffer in bytes
+ *
+ * @return average latency of a load in nanoseconds
+ */
+double
+measureLatency(uint8_t* buffer,
+               const uint64_t size)
+{
+    const uint64_t lineSize = 64;
+    const uint64_t numberOfLines = size / lineSize;
+
+    // create a random cycle over all cache-lines (Sattolo's algorithm)
+    std::vector<uint64_t> order(numberOfLines);
+    for(uint64_t i = 0; i < numberOfLines; i++) {
+        order[i] = i;
+    }
+    std::mt19937_64 random(42);
+    for(uint64_t i = numberOfLines - 1; i > 0; i--)
+    {
+        std::uniform_int_distribution<uint64_t> dist(0, i - 1);
+        std::swap(order[i], order[dist(random)]);
+    }
+    for(uint64_t i = 0; i < numberOfLines; i++)
+    {
+        void** line = reinterpret_cast<void**>(buffer + order[i] * lineSize);
+        *line = buffer + order[(i + 1) % numberOfLines] * lineSize;
+    }
+
+    // chase the pointers
+    const uint64_t steps = std::max(numberOfLines, static_cast<uint64_t>(1000000));
+    void** current = reinterpret_cast<void**>(buffer + order[0] * lineSize);
+    const auto begin = std::chrono::steady_clock::now();
+    for(uint64_t i = 0; i < steps; i++) {
+        current = reinterpret_cast<void**>(*current);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    // use the result, so the loop can not be removed
+    void* volatile sink = current;
+    (void)sink;
+
+    const double nanoSec = std::chrono::duration<double, std::nano>(end - begin).count();
+    return nanoSec / static_cast<double>(steps);
+}
+
+/**
+ * @brief measure bandwidth and latency from a set of cpu-threads to a numa-node
+ *
+ * @param result reference for result-output
+ * @param threads cpu-threads, which run the bandwidth-kernels in parallel. The latency is
+ *                measured with the first thread of the set.
+ * @param memoryNode numa-node, where the memory is allocated
+ * @param bufferSize size of the buffer in bytes, which should be much bigger than the last-level
+ *                   cache. Copy uses two buffers of this size.
+ * @param error reference for error-output
+ *
+ * @return false, if memory can not be allocated on the node or threads can not be bound,
+ *         else true
+ */
+bool
+probeMemory(MemoryProbeResult &result,
+            const CpuSet &threads,
+            const uint64_t memoryNode,
+            const uint64_t bufferSize,
+            ErrorContainer &error)
+{
+    if(threads.isEmpty())
+    {
+        error.addMeesage("Failed to probe memory, because no cpu-threads were given");
+        return false;
+    }
+
+    // each thread get a block, which is aligned to 4KiB
+    const uint64_t numberOfThreads = threads.count();
+    const uint64_t blockSize = (bufferSize / numberOfThreads) & ~static_cast<uint64_t>(4095);
+    const uint64_t size = blockSize * numberOfThreads;
+    if(blockSize == 0)
+    {
+        error.addMeesage("Failed to probe memory, because buffer-size is too small");
+        return false;
+    }
+
+    uint8_t* source = allocateOnNode(size, memoryNode);
+    uint8_t* target = allocateOnNode(size, memoryNode);
+    if(source == nullptr
+            || target == nullptr)
+    {
+        error.addMeesage("Failed to allocate memory on numa-node '"
+                         + std::to_string(memoryNode)
+                         + "'");
+        error.addSolution("Check if the numa-node exist and has enough free memory");
+        if(source != nullptr) {
+            munmap(source, size);
+        }
+        if(target != nullptr) {
+            munmap(target, size);
+        }
+        return false;
+    }
+
+    std::atomic<uint64_t> sum(0);
+    bool success = true;
+
+    // first touch, so page-faults are not part of the measurement
+    success &= runOnThreads(threads, [&](const uint64_t pos, const uint64_t) {
+        memset(source + pos * blockSize, 1, blockSize);
+        memset(target + pos * blockSize, 1, blockSize);
+    }) >= 0.0;
+
+    const double readTime = runOnThreads(threads, [&](const uint64_t pos, const uint64_t) {
+        sum.fetch_add(readKernel(source + pos * blockSize, blockSize));
+    });
+    const double writeTime = runOnThreads(threads, [&](const uint64_t pos, const uint64_t) {
+        writeKernel(target + pos * blockSize, blockSize);
+    });
+    const double copyTime = runOnThreads(threads, [&](const uint64_t pos, const uint64_t) {
+        copyKernel(target + pos * blockSize, source + pos * blockSize, blockSize);
+    });
+    success &= readTime > 0.0 && writeTime > 0.0 && copyTime > 0.0;
+
+    double latency = 0.0;
+    CpuSet firstThread;
+    firstThread.add(threads.getFirst());
+    success &= runOnThreads(firstThread, [&](const uint64_t, const uint64_t) {
+        latency = measureLatency(source, size);
+    }) >= 0.0;
+
+    munmap(source, size);
+    munmap(target, size);
+
+    if(success == false)
+    {
+        error.addMeesage("Failed to probe memory, because cpu-threads '"
+                         + threads.toString()
+                         + "' can not be used");
+        return false;
+    }
+
+    // copy reads and writes each byte
+    result.memoryNode = memoryNode;
+    result.readBandwidth = static_cast<double>(size) / readTime;
+    result.writeBandwidth = static_cast<double>(size) / writeTime;
+    result.copyBandwidth = static_cast<double>(2 * size) / copyTime;
+    result.latency = latency;
+
+    return true;
+}
+
+/**
+ * @brief measure bandwidth and latency for each pair of numa-nodes, where all cpu-threads of
+ *        the cpu-node are used to access the memory of the memory-node
+ *
+ * @param result reference for the resulting matrix
+ * @param bufferSize size of the buffer for each probe in bytes
+ * @param error reference for error-output
+ *
+ * @return false, if any probe failed, else true
+ */
+bool
+probeMemoryMatrix(MemoryProbeMatrix &result,
+                  const uint64_t bufferSize,
+                  ErrorContainer &error)
+{
+    if(getNumaNodes(result.nodeIds, error) == false)
+    {
+        error.addMeesage("Failed to probe memory-matrix");
+        return false;
+    }
+
+    result.results.clear();
+    for(const uint64_t cpuNode : result.nodeIds)
+    {
+        // nodes without cpu-threads, like memory-expanders, are only target of the probes
+        CpuSet threads;
+        if(getCpuThreadsOfNode(threads, cpuNode, error) == false) {
+            return false;
+        }
+        CpuSet online;
+        if(getOnlineCpuThreads(online, error) == false) {
+            return false;
+        }
+        threads &= online;
+
+        for(const uint64_t memoryNode : result.nodeIds)
+        {
+            MemoryProbeResult probe;
+            probe.cpuNode = cpuNode;
+            probe.memoryNode = memoryNode;
+            if(threads.isEmpty() == false
+                    && probeMemory(probe, threads, memoryNode, bufferSize, error) == false)
+            {
+                error.addMeesage("Failed to probe memory-matrix");
+                return false;
+            }
+            result.results.push_back(probe);
+        }
+    }
+
+    return true;
+}
+
+} // namespace Kitsunemimi
@@ -0,0 +1,767 @@
+/**
+ *  @file       metrics_exporter.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/metrics_exporter.h>
+#include <libKitsunemimiCpu/cpu.h>
+#include <libKitsunemimiCpu/tsc_clock.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace Kitsunemimi
+{
+
+// initial size of the buffer for the rendered metrics, which grows if necessary and is reused
+const uint64_t metricsBufferSize = 256 * 1024;
+
+// size of the buffer for reading /proc/stat and /proc/meminfo
+const uint64_t readBufferSize = 256 * 1024;
+
+// interval for reading the 32bit energy-counters of rapl independent of the scrapes. With the
+// smallest energy-unit of 15.3 uJ of AMD the counter wraps after 65 kJ, so at 10 s a wrap is
+// only missed above 6.5 kW per package.
+const uint64_t energySampleIntervalMs = 10000;
+
+/**
+ * @brief read the content of an already opened file from the beginning into a fixed buffer
+ *
+ * @param buffer target-buffer, which is null-terminated after reading
+ * @param bufferSize size of the buffer
+ * @param fd file-descriptor to read from
+ *
+ * @return number of read bytes, which is 0 if read failed
+ */
+uint64_t
+readOpenFileToBuffer(char* buffer,
+                     const uint64_t bufferSize,
+                     const int fd)
+{
+    uint64_t offset = 0;
+    while(offset < bufferSize - 1)
+    {
+        const ssize_t ret = pread(fd, buffer + offset, bufferSize - 1 - offset, offset);
+        if(ret <= 0) {
+            break;
+        }
+        offset += ret;
+    }
+
+    buffer[offset] = '\0';
+    return offset;
+}
+
+/**
+ * @brief read a single number from an already opened file, like a file of the sysfs
+ *
+ * @return false, if read failed, else true
+ */
+bool
+readOpenFileNumber(int64_t &result,
+                   const int fd)
+{
+    char buffer[64];
+    if(fd < 0
+            || readOpenFileToBuffer(buffer, sizeof(buffer), fd) == 0)
+    {
+        return false;
+    }
+
+    result = strtoll(buffer, nullptr, 10);
+    return true;
+}
+
+/**
+ * @brief constructor
+ */
+MetricsExporter::MetricsExporter()
+{
+    m_stopServer.store(false);
+    m_stopEnergy.store(false);
+}
+
+/**
+ * @brief destructor
+ */
+MetricsExporter::~MetricsExporter()
+{
+    stopServer();
+
+    m_stopEnergy.store(true);
+    if(m_energyThread.joinable()) {
+        m_energyThread.join();
+    }
+
+    for(const ThreadSource &thread : m_threads)
+    {
+        if(thread.speedFd >= 0) {
+            close(thread.speedFd);
+        }
+    }
+    for(const TemperatureSource &temperature : m_temperatures)
+    {
+        if(temperature.temperatureFd >= 0) {
+            close(temperature.temperatureFd);
+        }
+    }
+    for(const ZoneSource &zone : m_zones)
+    {
+        if(zone.temperatureFd >= 0) {
+            close(zone.temperatureFd);
+        }
+    }
+    if(m_statFd >= 0) {
+        close(m_statFd);
+    }
+    if(m_memInfoFd >= 0) {
+        close(m_memInfoFd);
+    }
+}
+
+/**
+ * @brief open all sources of the metrics once. Sources, which are not available, like rapl
+ *        without access to the msr, are skipped.
+ *
+ * @param cacheTimeMs time in milliseconds, how long rendered metrics are reused. Scrapes within
+ *                    this time only copy the buffer.
+ * @param error reference for error-output
+ *
+ * @return false, if the topology can not be read, else true
+ */
+bool
+MetricsExporter::initExporter(const uint64_t cacheTimeMs,
+                              ErrorContainer &error)
+{
+    // check if already initialized
+    if(m_isInit)
+    {
+        LOG_WARNING("this metrics-exporter was already successfully initialized");
+        return true;
+    }
+
+    CpuSet onlineThreads;
+    if(getOnlineCpuThreads(onlineThreads, error) == false)
+    {
+        error.addMeesage("Failed to initialize metrics-exporter");
+        return false;
+    }
+
+    // threads and packages
+    for(const uint64_t threadId : onlineThreads)
+    {
+        ThreadSource thread;
+        thread.threadId = threadId;
+        ErrorContainer threadError;
+        if(getCpuPackageId(thread.packageId, threadId, threadError) == false) {
+            continue;
+        }
+
+        const std::string speedPath = "/sys/devices/system/cpu/cpu"
+                                      + std::to_string(threadId)
+                                      + "/cpufreq/scaling_cur_freq";
+        thread.speedFd = open(speedPath.c_str(), O_RDONLY | O_CLOEXEC);
+        m_threads.push_back(thread);
+
+        // rapl is read by the first thread of each package
+        bool packageExist = false;
+        for(const PackageSource &package : m_packages) {
+            packageExist |= package.packageId == thread.packageId;
+        }
+        if(packageExist == false)
+        {
+            // rapl owns the open msr-file, so the package is created in place and never copied
+            m_packages.emplace_back(threadId);
+            m_packages.back().packageId = thread.packageId;
+            ErrorContainer raplError;
+            if(m_packages.back().rapl.initRapl(raplError) == false) {
+                m_packages.pop_back();
+            }
+        }
+    }
+
+    // temperature-sensors, which can be assigned to a package, like coretemp or k10temp
+    std::map<uint64_t, std::string> temperatureFiles;
+    ErrorContainer temperatureError;
+    getPkgTemperatureFiles(temperatureFiles, temperatureError);
+    for(const auto &[packageId, filePath] : temperatureFiles)
+    {
+        TemperatureSource temperature;
+        temperature.packageId = packageId;
+        temperature.temperatureFd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        if(temperature.temperatureFd >= 0) {
+            m_temperatures.push_back(temperature);
+        }
+    }
+
+    // all thermal-zones of the cpu-packages, which can not be assigned to a package, but are
+    // exported, even if there are multiple of them
+    std::vector<uint64_t> zoneIds;
+    ErrorContainer zoneError;
+    getPkgTemperatureIds(zoneIds, zoneError);
+    for(const uint64_t zoneId : zoneIds)
+    {
+        ZoneSource zone;
+        zone.zoneId = zoneId;
+        const std::string filePath = "/sys/class/thermal/thermal_zone"
+                                     + std::to_string(zoneId)
+                                     + "/temp";
+        zone.temperatureFd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        if(zone.temperatureFd >= 0) {
+            m_zones.push_back(zone);
+        }
+    }
+
+    m_statFd = open("/proc/stat", O_RDONLY | O_CLOEXEC);
+    m_memInfoFd = open("/proc/meminfo", O_RDONLY | O_CLOEXEC);
+
+    m_buffer.reserve(metricsBufferSize);
+    m_readBuffer.resize(readBufferSize);
+    m_cacheTime = cacheTimeMs * 1000000;
+    m_isInit = true;
+
+    // without the sampler the energy would only be read on scrapes, so a wrap of the counters
+    // between two rare scrapes would be lost
+    if(m_packages.size() > 0)
+    {
+        m_stopEnergy.store(false);
+        m_energyThread = std::thread(&MetricsExporter::sampleEnergy, this);
+    }
+
+    return true;
+}
+
+/**
+ * @brief get all metrics in the OpenMetrics-text-format. The metrics are only refreshed, if the
+ *        cache-time is over, else the last rendered metrics are returned.
+ *
+ * @param result reference for the metrics. If the same string is reused for each call, its
+ *               memory is also reused.
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized, else true
+ */
+bool
+MetricsExporter::getMetrics(std::string &result,
+                            ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to get metrics, because metrics-exporter is not initialized");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    const uint64_t now = TscClock::getInstance()->getTimestamp();
+    if(m_isRendered == false
+            || now - m_lastRender >= m_cacheTime)
+    {
+        renderMetrics();
+        m_lastRender = now;
+        m_isRendered = true;
+    }
+
+    result.assign(m_buffer);
+
+    return true;
+}
+
+/**
+ * @brief append the metadata of a metric-family
+ */
+void
+MetricsExporter::appendHeader(const char* name,
+                              const char* type,
+                              const char* unit,
+                              const char* help)
+{
+    char line[512];
+    const int size = snprintf(line,
+                              sizeof(line),
+                              "# TYPE %s %s\n# UNIT %s %s\n# HELP %s %s\n",
+                              name, type, name, unit, name, help);
+    m_buffer.append(line, static_cast<uint64_t>(size));
+}
+
+/**
+ * @brief append a single sample of a metric-family
+ *
+ * @param name name of the sample, which has the suffix "_total" for counters
+ * @param labels labels without braces, like "thread=\"0\"", or an empty string
+ * @param value value of the sample
+ */
+void
+MetricsExporter::appendValue(const char* name,
+                             const char* labels,
+                             const double value)
+{
+    char line[256];
+    int size = 0;
+    if(labels[0] == '\0') {
+        size = snprintf(line, sizeof(line), "%s %.15g\n", name, value);
+    } else {
+        size = snprintf(line, sizeof(line), "%s{%s} %.15g\n", name, labels, value);
+    }
+    m_buffer.append(line, static_cast<uint64_t>(size));
+}
+
+/**
+ * @brief refresh all values and render them into the buffer
+ */
+void
+MetricsExporter::renderMetrics()
+{
+    char labels[128];
+    m_buffer.clear();
+
+    // energy of the packages
+    if(m_packages.size() > 0)
+    {
+        appendHeader("kitsunemimi_cpu_package_energy_joules",
+                     "counter",
+                     "joules",
+                     "Consumed energy of the rapl-domains of a cpu-package.");
+        accumulateEnergy();
+        for(const PackageSource &package : m_packages)
+        {
+            const RaplInfo info = package.rapl.getInfo();
+            const char* format = "package=\"%lu\",domain=\"%s\"";
+            const unsigned long id = package.packageId;
+            snprintf(labels, sizeof(labels), format, id, "package");
+            appendValue("kitsunemimi_cpu_package_energy_joules_total",
+                        labels,
+                        package.total.pkgDiff);
+            if(info.supportPP0)
+            {
+                snprintf(labels, sizeof(labels), format, id, "cores");
+                appendValue("kitsunemimi_cpu_package_energy_joules_total",
+                            labels,
+                            package.total.pp0Diff);
+            }
+            if(info.supportPP1)
+            {
+                snprintf(labels, sizeof(labels), format, id, "graphics");
+                appendValue("kitsunemimi_cpu_package_energy_joules_total",
+                            labels,
+                            package.total.pp1Diff);
+            }
+            if(info.supportDram)
+            {
+                snprintf(labels, sizeof(labels), format, id, "dram");
+                appendValue("kitsunemimi_cpu_package_energy_joules_total",
+                            labels,
+                            package.total.dramDiff);
+            }
+        }
+    }
+
+    // frequency of the threads
+    appendHeader("kitsunemimi_cpu_frequency_hertz",
+                 "gauge",
+                 "hertz",
+                 "Current frequency of a cpu-thread.");
+    for(const ThreadSource &thread : m_threads)
+    {
+        int64_t speed = 0;
+        if(readOpenFileNumber(speed, thread.speedFd) == false) {
+            continue;
+        }
+
+        snprintf(labels,
+                 sizeof(labels),
+                 "package=\"%lu\",thread=\"%lu\"",
+                 static_cast<unsigned long>(thread.packageId),
+                 static_cast<unsigned long>(thread.threadId));
+        appendValue("kitsunemimi_cpu_frequency_hertz", labels, static_cast<double>(speed) * 1000.0);
+    }
+
+    // temperature of the packages
+    appendHeader("kitsunemimi_cpu_temperature_celsius",
+                 "gauge",
+                 "celsius",
+                 "Current temperature of a cpu-package.");
+    for(const TemperatureSource &source : m_temperatures)
+    {
+        int64_t temperature = 0;
+        if(readOpenFileNumber(temperature, source.temperatureFd) == false) {
+            continue;
+        }
+
+        snprintf(labels,
+                 sizeof(labels),
+                 "package=\"%lu\"",
+                 static_cast<unsigned long>(source.packageId));
+        appendValue("kitsunemimi_cpu_temperature_celsius",
+                    labels,
+                    static_cast<double>(temperature) / 1000.0);
+    }
+
+    // temperature of the thermal-zones
+    if(m_zones.size() > 0)
+    {
+        appendHeader("kitsunemimi_cpu_zone_temperature_celsius",
+                     "gauge",
+                     "celsius",
+                     "Current temperature of a thermal-zone of a cpu-package.");
+    }
+    for(const ZoneSource &zone : m_zones)
+    {
+        int64_t temperature = 0;
+        if(readOpenFileNumber(temperature, zone.temperatureFd) == false) {
+            continue;
+        }
+
+        snprintf(labels,
+                 sizeof(labels),
+                 "zone=\"%lu\"",
+                 static_cast<unsigned long>(zone.zoneId));
+        appendValue("kitsunemimi_cpu_zone_temperature_celsius",
+                    labels,
+                    static_cast<double>(temperature) / 1000.0);
+    }
+
+    renderCpuTimes();
+    renderMemory();
+
+    m_buffer.append("# EOF\n");
+}
+
+/**
+ * @brief add the energy since the last read of the counters to the totals of the packages.
+ *        Has to be called with locked mutex.
+ */
+void
+MetricsExporter::accumulateEnergy()
+{
+    for(PackageSource &package : m_packages)
+    {
+        const RaplDiff diff = package.rapl.calculateDiff();
+        package.total.pkgDiff += diff.pkgDiff;
+        package.total.pp0Diff += diff.pp0Diff;
+        package.total.pp1Diff += diff.pp1Diff;
+        package.total.dramDiff += diff.dramDiff;
+    }
+}
+
+/**
+ * @brief loop of the energy-sampler, which reads the energy-counters periodically
+ */
+void
+MetricsExporter::sampleEnergy()
+{
+    uint64_t waited = 0;
+    while(m_stopEnergy.load() == false)
+    {
+        // sleep in small steps, so the destructor doesn't have to wait for a whole interval
+        usleep(100 * 1000);
+        waited += 100;
+        if(waited < energySampleIntervalMs) {
+            continue;
+        }
+        waited = 0;
+
+        std::lock_guard<std::mutex> guard(m_lock);
+        accumulateEnergy();
+    }
+}
+
+/**
+ * @brief render the cumulative times of each cpu-thread from /proc/stat
+ */
+void
+MetricsExporter::renderCpuTimes()
+{
+    char* content = m_readBuffer.data();
+    if(m_statFd < 0
+            || readOpenFileToBuffer(content, m_readBuffer.size(), m_statFd) == 0)
+    {
+        return;
+    }
+
+    if(parseCpuThreadTimes(m_cpuTimes, content) == false) {
+        return;
+    }
+
+    const char* modes[numberOfCpuTimeModes] = {"user",
+                                               "nice",
+                                               "system",
+                                               "idle",
+                                               "iowait",
+                                               "irq",
+                                               "softirq",
+                                               "steal"};
+    const double ticksPerSec = static_cast<double>(sysconf(_SC_CLK_TCK));
+    char labels[128];
+
+    appendHeader("kitsunemimi_cpu_time_seconds",
+                 "counter",
+                 "seconds",
+                 "Time, which a cpu-thread spent in each mode.");
+
+    for(uint64_t threadId = 0; threadId < m_cpuTimes.size(); threadId++)
+    {
+        const CpuThreadTimes &times = m_cpuTimes[threadId];
+        if(times.isValid == false) {
+            continue;
+        }
+
+        for(uint64_t mode = 0; mode < numberOfCpuTimeModes; mode++)
+        {
+            snprintf(labels,
+                     sizeof(labels),
+                     "thread=\"%lu\",mode=\"%s\"",
+                     static_cast<unsigned long>(threadId),
+                     modes[mode]);
+            appendValue("kitsunemimi_cpu_time_seconds_total",
+                        labels,
+                        static_cast<double>(times.ticks[mode]) / ticksPerSec);
+        }
+    }
+}
+
+/**
+ * @brief render total and available main-memory from /proc/meminfo
+ */
+void
+MetricsExporter::renderMemory()
+{
+    char* content = m_readBuffer.data();
+    if(m_memInfoFd < 0
+            || readOpenFileToBuffer(content, m_readBuffer.size(), m_memInfoFd) == 0)
+    {
+        return;
+    }
+
+    // values in /proc/meminfo are in KiB
+    const char* total = strstr(content, "MemTotal:");
+    const char* available = strstr(content, "MemAvailable:");
+
+    appendHeader("kitsunemimi_memory_total_bytes",
+                 "gauge",
+                 "bytes",
+                 "Total amount of main-memory.");
+    if(total != nullptr)
+    {
+        appendValue("kitsunemimi_memory_total_bytes",
+                    "",
+                    static_cast<double>(strtoull(total + 9, nullptr, 10)) * 1024.0);
+    }
+
+    appendHeader("kitsunemimi_memory_available_bytes",
+                 "gauge",
+                 "bytes",
+                 "Amount of main-memory, which is available for new allocations.");
+    if(available != nullptr)
+    {
+        appendValue("kitsunemimi_memory_available_bytes",
+                    "",
+                    static_cast<double>(strtoull(available + 13, nullptr, 10)) * 1024.0);
+    }
+}
+
+/**
+ * @brief start a http-listener on localhost, which answers "GET /metrics" with the metrics.
+ *        Requests are handled one after another by a single background-thread.
+ *
+ * @param port port to listen on, where 0 selects a free port, which can be requested with
+ *             getServerPort
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized or the port can not be bound, else true
+ */
+bool
+MetricsExporter::startServer(const uint16_t port,
+                             ErrorContainer &error)
+{
+    if(m_isInit == false
+            || m_serverFd >= 0)
+    {
+        error.addMeesage("Failed to start metrics-server, because the exporter is not "
+                         "initialized or the server is already running");
+        return false;
+    }
+
+    m_serverFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(m_serverFd < 0)
+    {
+        error.addMeesage("Failed to create socket: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    const int enable = 1;
+    setsockopt(m_serverFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    // only bind to localhost, because the server has no authentication
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addressSize = sizeof(address);
+
+    if(bind(m_serverFd, reinterpret_cast<struct sockaddr*>(&address), addressSize) != 0
+            || listen(m_serverFd, 16) != 0
+            || getsockname(m_serverFd,
+                           reinterpret_cast<struct sockaddr*>(&address),
+                           &addressSize) != 0)
+    {
+        error.addMeesage("Failed to listen on port '"
+                         + std::to_string(port)
+                         + "': "
+                         + std::string(strerror(errno)));
+        error.addSolution("check if the port is already in use");
+        close(m_serverFd);
+        m_serverFd = -1;
+        return false;
+    }
+
+    m_serverPort = ntohs(address.sin_port);
+    m_stopServer.store(false);
+    m_serverThread = std::thread(&MetricsExporter::serveClients, this);
+
+    return true;
+}
+
+/**
+ * @brief stop the http-listener, if running
+ */
+void
+MetricsExporter::stopServer()
+{
+    if(m_serverFd < 0) {
+        return;
+    }
+
+    m_stopServer.store(true);
+    if(m_serverThread.joinable()) {
+        m_serverThread.join();
+    }
+
+    close(m_serverFd);
+    m_serverFd = -1;
+    m_serverPort = 0;
+}
+
+/**
+ * @brief get port of the running http-listener or 0, if not running
+ */
+uint16_t
+MetricsExporter::getServerPort() const
+{
+    return m_serverPort;
+}
+
+/**
+ * @brief send a complete buffer over a socket
+ */
+bool
+sendMetricsBuffer(const int fd,
+                  const char* data,
+                  const uint64_t size)
+{
+    uint64_t offset = 0;
+    while(offset < size)
+    {
+        const ssize_t ret = send(fd, data + offset, size - offset, MSG_NOSIGNAL);
+        if(ret <= 0) {
+            return false;
+        }
+        offset += ret;
+    }
+
+    return true;
+}
+
+/**
+ * @brief loop of the http-listener, which checks the stop-flag every 100ms
+ */
+void
+MetricsExporter::serveClients()
+{
+    std::string metrics;
+    metrics.reserve(metricsBufferSize);
+    char request[4096];
+
+    while(m_stopServer.load() == false)
+    {
+        struct pollfd pollFd;
+        pollFd.fd = m_serverFd;
+        pollFd.events = POLLIN;
+        if(poll(&pollFd, 1, 100) <= 0) {
+            continue;
+        }
+
+        const int clientFd = accept4(m_serverFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if(clientFd < 0) {
+            continue;
+        }
+
+        // slow clients must not block the listener for long
+        struct timeval timeout;
+        timeout.tv_sec = 1;
+        timeout.tv_usec = 0;
+        setsockopt(clientFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(clientFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        // read until the end of the request-header
+        uint64_t requestSize = 0;
+        while(requestSize < sizeof(request) - 1)
+        {
+            const ssize_t ret = recv(clientFd,
+                                     request + requestSize,
+                                     sizeof(request) - 1 - requestSize,
+                                     0);
+            if(ret <= 0) {
+                break;
+            }
+            requestSize += ret;
+            request[requestSize] = '\0';
+            if(strstr(request, "\r\n\r\n") != nullptr) {
+                break;
+            }
+        }
+        request[requestSize] = '\0';
+
+        ErrorContainer error;
+        char header[256];
+        if(strncmp(request, "GET /metrics ", 13) == 0
+                && getMetrics(metrics, error))
+        {
+            const int headerSize = snprintf(header,
+                                            sizeof(header),
+                                            "HTTP/1.1 200 OK\r\n"
+                                            "Content-Type: application/openmetrics-text; "
+                                            "version=1.0.0; charset=utf-8\r\n"
+                                            "Content-Length: %lu\r\n"
+                                            "Connection: close\r\n\r\n",
+                                            static_cast<unsigned long>(metrics.size()));
+            if(sendMetricsBuffer(clientFd, header, static_cast<uint64_t>(headerSize))) {
+                sendMetricsBuffer(clientFd, metrics.c_str(), metrics.size());
+            }
+        }
+        else
+        {
+            const char* notFound = "HTTP/1.1 404 Not Found\r\n"
+                                   "Content-Length: 0\r\n"
+                                   "Connection: close\r\n\r\n";
+            sendMetricsBuffer(clientFd, notFound, strlen(notFound));
+        }
+
+        close(clientFd);
+    }
+}
+
+} // namespace Kitsunemimi
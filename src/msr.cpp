@@ -0,0 +1,176 @@
+/**
+ *  @file       msr.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/msr.h>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief convert msr-offset into a hex-string for error-messages
+ */
+const std::string
+msrToHex(const uint32_t offset)
+{
+    std::stringstream stream;
+    stream << "0x" << std::hex << offset;
+    return stream.str();
+}
+
+/**
+ * @brief open msr-file of a cpu-thread
+ *
+ * @param threadId id of the cpu-thread
+ * @param writable true to open the file for reading and writing
+ * @param error reference for error-output
+ *
+ * @return file-descriptor or -1, if file doesn't exist or can not be opened
+ */
+int
+openMsr(const uint64_t threadId,
+        const bool writable,
+        ErrorContainer &error)
+{
+    const std::string path = "/dev/cpu/" + std::to_string(threadId) + "/msr";
+    const int fd = open(path.c_str(), (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    if(fd < 0)
+    {
+        error.addMeesage("Failed to open path: \"" + path + "\"");
+        error.addSolution("Maybe the msr-kernel-module still have to be loaded with "
+                          "\"modporobe msr\" or \"modprobe intel_rapl_msr\"");
+        if(writable)
+        {
+            error.addSolution("Check if you have write-permissions to the path: \""
+                              + path
+                              + "\", which requires CAP_SYS_RAWIO");
+        }
+        else
+        {
+            error.addSolution("Check if you have read-permissions to the path: \"" + path + "\"");
+        }
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * @brief read a single register from an opened msr-file
+ *
+ * @param result reference for the value of the register
+ * @param fd file-descriptor of the msr-file
+ * @param offset address of the register
+ * @param error reference for error-output
+ *
+ * @return false, if the register can not be read, else true
+ */
+bool
+readMsrFd(uint64_t &result,
+          const int fd,
+          const uint32_t offset,
+          ErrorContainer &error)
+{
+    if(pread(fd, &result, sizeof(result), offset) != sizeof(result))
+    {
+        error.addMeesage("Failed to read MSR " + msrToHex(offset) + ": " + strerror(errno));
+        error.addSolution("Check if the register is supported by the cpu");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief write a single register of an opened msr-file
+ *
+ * @param fd file-descriptor of the msr-file, which was opened writable
+ * @param offset address of the register
+ * @param value new value of the register
+ * @param error reference for error-output
+ *
+ * @return false, if the register can not be written, else true
+ */
+bool
+writeMsrFd(const int fd,
+           const uint32_t offset,
+           const uint64_t value,
+           ErrorContainer &error)
+{
+    if(pwrite(fd, &value, sizeof(value), offset) != sizeof(value))
+    {
+        error.addMeesage("Failed to write MSR " + msrToHex(offset) + ": " + strerror(errno));
+        error.addSolution("Check if the register is supported by the cpu and writes to msr are "
+                          "allowed by the kernel (msr.allow_writes)");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief read a single register of a cpu-thread
+ *
+ * @param result reference for the value of the register
+ * @param threadId id of the cpu-thread
+ * @param offset address of the register
+ * @param error reference for error-output
+ *
+ * @return false, if the register can not be read, else true
+ */
+bool
+readMsr(uint64_t &result,
+        const uint64_t threadId,
+        const uint32_t offset,
+        ErrorContainer &error)
+{
+    const int fd = openMsr(threadId, false, error);
+    if(fd < 0) {
+        return false;
+    }
+
+    const bool ret = readMsrFd(result, fd, offset, error);
+    close(fd);
+
+    return ret;
+}
+
+/**
+ * @brief write a single register of a cpu-thread
+ *
+ * @param threadId id of the cpu-thread
+ * @param offset address of the register
+ * @param value new value of the register
+ * @param error reference for error-output
+ *
+ * @return false, if the register can not be written, else true
+ */
+bool
+writeMsr(const uint64_t threadId,
+         const uint32_t offset,
+         const uint64_t value,
+         ErrorContainer &error)
+{
+    const int fd = openMsr(threadId, true, error);
+    if(fd < 0) {
+        return false;
+    }
+
+    const bool ret = writeMsrFd(fd, offset, value, error);
+    close(fd);
+
+    return ret;
+}
+
+} // namespace Kitsunemimi
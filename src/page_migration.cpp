@@ -0,0 +1,526 @@
+/**
+ *  @file       page_migration.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/page_migration.h>
+#include <libKitsunemimiCpu/cpu.h>
+#include <libKitsunemimiCpu/memory.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+namespace Kitsunemimi
+{
+
+// number of pages for each call of move_pages, to limit the size of the temporary arrays
+const uint64_t migrationBatchSize = 4096;
+
+/**
+ * @brief align a range to the page-size by extending it on both sides
+ *
+ * @param begin reference for the aligned begin-address
+ * @param numberOfPages reference for the number of pages of the aligned range
+ * @param address begin of the range
+ * @param size size of the range in bytes
+ */
+void
+alignRangeToPages(uint64_t &begin,
+                  uint64_t &numberOfPages,
+                  const void* address,
+                  const uint64_t size)
+{
+    const uint64_t pageSize = getPageSize();
+    const uint64_t start = reinterpret_cast<uint64_t>(address);
+    begin = start & ~(pageSize - 1);
+    const uint64_t end = (start + size + pageSize - 1) & ~(pageSize - 1);
+    numberOfPages = (end - begin) / pageSize;
+}
+
+/**
+ * @brief check in /proc/self/maps, if a range is completely covered by writable mappings
+ *
+ * @param address begin of the range
+ * @param size size of the range in bytes
+ *
+ * @return false, if any part of the range is not mapped or not writable, else true
+ */
+bool
+isRangeWritable(const void* address,
+                const uint64_t size)
+{
+    std::ifstream inFile("/proc/self/maps");
+    if(inFile.is_open() == false) {
+        return false;
+    }
+
+    // lines have the form "begin-end perms ..." and are sorted by their begin-address
+    uint64_t pos = reinterpret_cast<uint64_t>(address);
+    const uint64_t end = pos + size;
+    std::string line;
+    while(pos < end
+          && std::getline(inFile, line))
+    {
+        char* lineEnd = nullptr;
+        const uint64_t mapBegin = strtoull(line.c_str(), &lineEnd, 16);
+        if(*lineEnd != '-') {
+            return false;
+        }
+        const uint64_t mapEnd = strtoull(lineEnd + 1, &lineEnd, 16);
+        if(mapEnd <= pos) {
+            continue;
+        }
+
+        // gap or mapping without write-permission
+        if(mapBegin > pos
+                || lineEnd[0] != ' '
+                || lineEnd[1] == '\0'
+                || lineEnd[2] != 'w')
+        {
+            return false;
+        }
+        pos = mapEnd;
+    }
+
+    return pos >= end;
+}
+
+/**
+ * @brief call move_pages in batches over a range
+ *
+ * @param address begin of the range
+ * @param size size of the range in bytes
+ * @param nodeId target-node or -1 to only query the location of the pages
+ * @param handleStatus function, which is called for each page with address and status
+ *
+ * @return false, if the syscall failed, else true
+ */
+bool
+movePagesBatched(const void* address,
+                 const uint64_t size,
+                 const int nodeId,
+                 const std::function<void(const uint64_t, const int)> &handleStatus)
+{
+    const uint64_t pageSize = getPageSize();
+    uint64_t begin = 0;
+    uint64_t numberOfPages = 0;
+    alignRangeToPages(begin, numberOfPages, address, size);
+
+    std::vector<void*> pages(std::min(numberOfPages, migrationBatchSize));
+    std::vector<int> nodes(pages.size(), nodeId);
+    std::vector<int> status(pages.size(), 0);
+
+    for(uint64_t offset = 0; offset < numberOfPages; offset += migrationBatchSize)
+    {
+        const uint64_t count = std::min(migrationBatchSize, numberOfPages - offset);
+        for(uint64_t i = 0; i < count; i++) {
+            pages[i] = reinterpret_cast<void*>(begin + (offset + i) * pageSize);
+        }
+
+        // without node-list the kernel only writes the current node of each page into status
+        const long ret = syscall(SYS_move_pages,
+                                 0,
+                                 count,
+                                 pages.data(),
+                                 nodeId < 0 ? nullptr : nodes.data(),
+                                 status.data(),
+                                 MPOL_MF_MOVE);
+        if(ret < 0) {
+            return false;
+        }
+
+        for(uint64_t i = 0; i < count; i++) {
+            handleStatus(reinterpret_cast<uint64_t>(pages[i]), status[i]);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief get the numa-node of each page of a range of the current process
+ *
+ * @param result reference for the node of each page or a negative error-number, like -ENOENT
+ *               for pages, which were not touched until now
+ * @param address begin of the range
+ * @param size size of the range in bytes
+ * @param error reference for error-output
+ *
+ * @return false, if the location can not be requested, else true
+ */
+bool
+getPageNodes(std::vector<int> &result,
+             const void* address,
+             const uint64_t size,
+             ErrorContainer &error)
+{
+    result.clear();
+    const bool ret = movePagesBatched(address, size, -1, [&](const uint64_t, const int status) {
+        result.push_back(status);
+    });
+    if(ret == false)
+    {
+        error.addMeesage("Failed to get numa-nodes of pages: " + std::string(strerror(errno)));
+        error.addSolution("check if the kernel was build with numa-support");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief move the pages of a range of the current process to another numa-node. Pages which
+ *        are shared with other processes are not moved.
+ *
+ * @param result reference for the number of moved and failed pages
+ * @param address begin of the range
+ * @param size size of the range in bytes
+ * @param nodeId id of the target-node
+ * @param error reference for error-output
+ *
+ * @return false, if the migration was not possible at all, else true. Single pages, which can
+ *         not be moved, are listed in the result.
+ */
+bool
+migrateRange(PageMigrationResult &result,
+             const void* address,
+             const uint64_t size,
+             const uint64_t nodeId,
+             ErrorContainer &error)
+{
+    result = PageMigrationResult();
+
+    // request the current location first, because the kernel also reports pages, which were
+    // already on the target-node before, with the target-node as status
+    std::vector<int> previousNodes;
+    if(getPageNodes(previousNodes, address, size, error) == false) {
+        return false;
+    }
+
+    uint64_t pos = 0;
+    const bool ret = movePagesBatched(address,
+                                      size,
+                                      static_cast<int>(nodeId),
+                                      [&](const uint64_t page, const int status)
+    {
+        const int previousNode = previousNodes[pos];
+        pos++;
+        result.numberOfPages++;
+        if(status == static_cast<int>(nodeId))
+        {
+            if(previousNode == status) {
+                result.alreadyOnNodePages++;
+            } else {
+                result.movedPages++;
+            }
+        }
+        else if(status == -ENOENT)
+        {
+            result.notPresentPages++;
+        }
+        else
+        {
+            result.failedAddresses.push_back(page);
+            result.failedErrors.push_back(status < 0 ? -status : 0);
+        }
+    });
+
+    if(ret == false)
+    {
+        error.addMeesage("Failed to move pages to numa-node '"
+                         + std::to_string(nodeId)
+                         + "': "
+                         + std::string(strerror(errno)));
+        error.addSolution("check if the numa-node exist and is allowed by the cpuset of the "
+                          "process");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief bind a range of the current process to a numa-node, so already existing pages are moved
+ *        and new pages are allocated on this node
+ *
+ * @param address begin of the range
+ * @param size size of the range in bytes
+ * @param nodeId id of the target-node
+ * @param error reference for error-output
+ *
+ * @return false, if binding failed, else true
+ */
+bool
+bindRangeToNode(const void* address,
+                const uint64_t size,
+                const uint64_t nodeId,
+                ErrorContainer &error)
+{
+    uint64_t begin = 0;
+    uint64_t numberOfPages = 0;
+    alignRangeToPages(begin, numberOfPages, address, size);
+
+    const uint64_t bitsPerLong = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> nodeMask(nodeId / bitsPerLong + 1, 0);
+    nodeMask[nodeId / bitsPerLong] |= 1UL << (nodeId % bitsPerLong);
+    const unsigned long maxNode = nodeMask.size() * bitsPerLong + 1;
+
+    if(syscall(SYS_mbind,
+               begin,
+               numberOfPages * getPageSize(),
+               MPOL_BIND,
+               nodeMask.data(),
+               maxNode,
+               MPOL_MF_MOVE) != 0)
+    {
+        error.addMeesage("Failed to bind memory to numa-node '"
+                         + std::to_string(nodeId)
+                         + "': "
+                         + std::string(strerror(errno)));
+        error.addSolution("check if the numa-node exist and is allowed by the cpuset of the "
+                          "process");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief split a range into one chunk for each cpu-thread and process the chunks in parallel,
+ *        where each worker is bound to its cpu-thread
+ *
+ * @param address begin of the range
+ * @param size size of the range in bytes
+ * @param threads cpu-threads to use
+ * @param function function, which processes a chunk and returns false on error
+ * @param errorNumber reference for the errno of a failed chunk, because errno is
+ *                    thread-local and so not visible for the caller
+ * @param error reference for error-output, if a worker can not be bound to its cpu-thread
+ *
+ * @return false, if any chunk failed or any worker could not be bound, else true
+ */
+bool
+processChunksParallel(int &errorNumber,
+                      void* address,
+                      const uint64_t size,
+                      const CpuSet &threads,
+                      const std::function<bool(uint8_t*, const uint64_t)> &function,
+                      ErrorContainer &error)
+{
+    uint64_t begin = 0;
+    uint64_t numberOfPages = 0;
+    alignRangeToPages(begin, numberOfPages, address, size);
+
+    const std::vector<uint64_t> threadIds = threads.getThreadIds();
+    const uint64_t numberOfThreads = std::max(threadIds.size(), static_cast<size_t>(1));
+    const uint64_t pageSize = getPageSize();
+    const uint64_t pagesPerThread = (numberOfPages + numberOfThreads - 1) / numberOfThreads;
+    std::atomic<bool> success(true);
+    std::atomic<int> lastError(0);
+    std::atomic<bool> bindFailed(false);
+    std::atomic<uint64_t> unboundThreadId(0);
+
+    std::vector<std::thread> workers;
+    for(uint64_t i = 0; i < numberOfThreads; i++)
+    {
+        const uint64_t firstPage = i * pagesPerThread;
+        if(firstPage >= numberOfPages) {
+            break;
+        }
+        const uint64_t chunkPages = std::min(pagesPerThread, numberOfPages - firstPage);
+
+        workers.emplace_back([&, i, firstPage, chunkPages]()
+        {
+            // first-touch allocates the pages on the node of the touching thread
+            if(threadIds.size() > 0)
+            {
+                ErrorContainer bindError;
+                CpuSet target;
+                target.add(threadIds[i]);
+
+                // an unbound worker would allocate the pages on an arbitrary node
+                if(setThreadAffinity(target, bindError) == false)
+                {
+                    unboundThreadId.store(threadIds[i]);
+                    bindFailed.store(true);
+                    return;
+                }
+            }
+
+            uint8_t* chunk = reinterpret_cast<uint8_t*>(begin + firstPage * pageSize);
+            if(function(chunk, chunkPages * pageSize) == false)
+            {
+                lastError.store(errno);
+                success.store(false);
+            }
+        });
+    }
+
+    for(std::thread &worker : workers) {
+        worker.join();
+    }
+
+    errorNumber = lastError.load();
+    if(bindFailed.load())
+    {
+        error.addMeesage("Failed to bind worker to cpu-thread '"
+                         + std::to_string(unboundThreadId.load())
+                         + "'");
+        error.addSolution("check if the cpu-thread is online and allowed by the cpuset of the "
+                          "process");
+        return false;
+    }
+
+    return success.load();
+}
+
+/**
+ * @brief prefault the pages of a range in parallel, so later accesses on the request-path don't
+ *        cause page-faults. Uses MADV_POPULATE_WRITE (since kernel 5.14) and falls back to
+ *        touching each page, if the range is a writable mapping.
+ *
+ * @param address begin of the range
+ * @param size size of the range in bytes
+ * @param threads cpu-threads, which prefault the range. Without a memory-policy the pages are
+ *                allocated on the nodes of these threads.
+ * @param error reference for error-output
+ *
+ * @return false, if prefaulting failed, else true
+ */
+bool
+prefaultRange(void* address,
+              const uint64_t size,
+              const CpuSet &threads,
+              ErrorContainer &error)
+{
+    const uint64_t pageSize = getPageSize();
+    int errorNumber = 0;
+    const bool ret = processChunksParallel(errorNumber,
+                                           address,
+                                           size,
+                                           threads,
+                                           [&](uint8_t* chunk, const uint64_t chunkSize)
+    {
+        if(madvise(chunk, chunkSize, MADV_POPULATE_WRITE) == 0) {
+            return true;
+        }
+        // kernels before 5.14 don't support the advice and return EINVAL for every mapping,
+        // so the range has to be checked, before a page of a read-only mapping is touched
+        if(errno != EINVAL) {
+            return false;
+        }
+        if(isRangeWritable(chunk, chunkSize) == false)
+        {
+            errno = EFAULT;
+            return false;
+        }
+
+        // adding zero triggers a write-fault without changing the content
+        for(uint64_t pos = 0; pos < chunkSize; pos += pageSize) {
+            __atomic_fetch_add(chunk + pos, 0, __ATOMIC_RELAXED);
+        }
+        return true;
+    }, error);
+
+    if(ret == false)
+    {
+        // without errno the failure was the binding of a worker, which is already reported
+        std::string message = "Failed to prefault memory";
+        if(errorNumber != 0) {
+            message += ": " + std::string(strerror(errorNumber));
+        }
+        error.addMeesage(message);
+        error.addSolution("check if the range is a writable mapping and enough memory is free");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief lock the pages of a range in parallel into the main-memory, which also prefaults them
+ *
+ * @param address begin of the range
+ * @param size size of the range in bytes
+ * @param threads cpu-threads, which lock the range
+ * @param error reference for error-output
+ *
+ * @return false, if locking failed, else true
+ */
+bool
+lockRange(void* address,
+          const uint64_t size,
+          const CpuSet &threads,
+          ErrorContainer &error)
+{
+    int errorNumber = 0;
+    const bool ret = processChunksParallel(errorNumber,
+                                           address,
+                                           size,
+                                           threads,
+                                           [](uint8_t* chunk, const uint64_t chunkSize)
+    {
+        return mlock(chunk, chunkSize) == 0;
+    }, error);
+
+    if(ret == false)
+    {
+        // without errno the failure was the binding of a worker, which is already reported
+        std::string message = "Failed to lock memory";
+        if(errorNumber != 0) {
+            message += ": " + std::string(strerror(errorNumber));
+        }
+        error.addMeesage(message);
+        error.addSolution("check the limit for locked memory with 'ulimit -l' or "
+                          "run with CAP_IPC_LOCK");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief unlock the pages of a range, which were locked by lockRange
+ *
+ * @param address begin of the range
+ * @param size size of the range in bytes
+ * @param error reference for error-output
+ *
+ * @return false, if unlocking failed, else true
+ */
+bool
+unlockRange(void* address,
+            const uint64_t size,
+            ErrorContainer &error)
+{
+    uint64_t begin = 0;
+    uint64_t numberOfPages = 0;
+    alignRangeToPages(begin, numberOfPages, address, size);
+
+    if(munlock(reinterpret_cast<void*>(begin), numberOfPages * getPageSize()) != 0)
+    {
+        error.addMeesage("Failed to unlock memory: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Kitsunemimi
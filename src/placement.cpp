@@ -0,0 +1,463 @@
+/**
+ *  @file       placement.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/placement.h>
+#include <libKitsunemimiCpu/cpu.h>
+
+#include <libKitsunemimiCommon/methods/string_methods.h>
+
+#include <algorithm>
+#include <map>
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief constructor
+ */
+PlacementAdvisor::PlacementAdvisor() {}
+
+/**
+ * @brief collect the topology of the system and initialize the readers for the live-data
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if the topology can not be read, else true
+ */
+bool
+PlacementAdvisor::initAdvisor(ErrorContainer &error)
+{
+    // check if already initialized
+    if(m_isInit)
+    {
+        LOG_WARNING("this placement-advisor was already successfully initialized");
+        return true;
+    }
+
+    // offline threads have no topology-information and can not be used for a plan
+    CpuSet onlineThreads;
+    if(getOnlineCpuThreads(onlineThreads, error) == false)
+    {
+        error.addMeesage("Failed to initialize placement-advisor");
+        return false;
+    }
+
+    // collect topology of all threads
+    std::map<uint64_t, uint64_t> packagePositions;
+    for(const uint64_t threadId : onlineThreads.getThreadIds())
+    {
+        CpuThreadState thread;
+        thread.threadId = threadId;
+
+        ErrorContainer threadError;
+        if(getCpuPackageId(thread.packageId, threadId, threadError) == false
+                || getCpuCoreId(thread.coreId, threadId, threadError) == false)
+        {
+            continue;
+        }
+        getMaximumSpeed(thread.maximumSpeed, threadId, threadError);
+
+        // register package
+        if(packagePositions.find(thread.packageId) == packagePositions.end())
+        {
+            packagePositions.emplace(thread.packageId, m_packages.size());
+            CpuPackageState package;
+            package.packageId = thread.packageId;
+            m_packages.push_back(package);
+        }
+
+        m_packages[packagePositions[thread.packageId]].threadIds.push_back(m_threads.size());
+        m_threads.push_back(thread);
+    }
+
+    if(m_threads.size() == 0)
+    {
+        error.addMeesage("Failed to initialize placement-advisor, "
+                         "because no topology-information was found for any cpu-thread");
+        return false;
+    }
+
+    // temperature and energy are optional, because they are not available on all systems
+    // or require root-permissions
+    ErrorContainer optionalError;
+    getPkgTemperatureFiles(m_temperatureFiles, optionalError);
+    for(const CpuPackageState &package : m_packages)
+    {
+        // rapl owns the open msr-file, so it is created in place and never copied
+        m_rapls.emplace_back(m_threads[package.threadIds.at(0)].threadId);
+        m_rapls.back().initRapl(optionalError);
+    }
+
+    // create initial state for the diffs
+    if(getCpuThreadTimes(m_lastTimes, error) == false)
+    {
+        error.addMeesage("Failed to initialize placement-advisor");
+        return false;
+    }
+
+    m_isInit = true;
+
+    return true;
+}
+
+/**
+ * @brief update live-data of all threads and packages
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized or the load can not be read, else true
+ */
+bool
+PlacementAdvisor::updateState(ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to update placement-advisor, because it is not initialized");
+        return false;
+    }
+
+    // update load
+    std::vector<CpuThreadTimes> times;
+    if(getCpuThreadTimes(times, error) == false)
+    {
+        error.addMeesage("Failed to update load-information of the placement-advisor");
+        return false;
+    }
+
+    ErrorContainer optionalError;
+    for(CpuThreadState &thread : m_threads)
+    {
+        const uint64_t id = thread.threadId;
+        // counters of threads, which were offline in the meantime, can be reset
+        if(id < times.size()
+                && id < m_lastTimes.size()
+                && times[id].getTotal() > m_lastTimes[id].getTotal()
+                && times[id].getBusy() >= m_lastTimes[id].getBusy())
+        {
+            const uint64_t total = times[id].getTotal() - m_lastTimes[id].getTotal();
+            const uint64_t busy = times[id].getBusy() - m_lastTimes[id].getBusy();
+            thread.load = static_cast<double>(busy) / static_cast<double>(total);
+        }
+
+        getCurrentSpeed(thread.currentSpeed, id, optionalError);
+    }
+    m_lastTimes = times;
+
+    // update packages
+    for(uint64_t i = 0; i < m_packages.size(); i++)
+    {
+        CpuPackageState &package = m_packages[i];
+
+        // load
+        package.load = 0.0;
+        for(const uint64_t pos : package.threadIds) {
+            package.load += m_threads[pos].load;
+        }
+        package.load /= static_cast<double>(package.threadIds.size());
+
+        // temperature
+        const auto temperatureIt = m_temperatureFiles.find(package.packageId);
+        package.hasTemperature = temperatureIt != m_temperatureFiles.end()
+                                 && readPkgTemperature(package.temperature,
+                                                       temperatureIt->second,
+                                                       optionalError);
+
+        // power
+        if(m_rapls[i].isActive())
+        {
+            package.power = m_rapls[i].calculateDiff().pkgAvg;
+            package.hasPower = true;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief get physical cores of a package, sorted by their load and speed
+ *
+ * @param packagePos position of the package in the internal list
+ *
+ * @return list of cores, where each core is a list of thread-positions sorted by load
+ */
+const std::vector<std::vector<uint64_t>>
+PlacementAdvisor::getSortedCores(const uint64_t packagePos) const
+{
+    // group threads by core
+    std::map<uint64_t, std::vector<uint64_t>> coreMap;
+    for(const uint64_t pos : m_packages[packagePos].threadIds) {
+        coreMap[m_threads[pos].coreId].push_back(pos);
+    }
+
+    const auto threadLess = [this](const uint64_t a, const uint64_t b)
+    {
+        if(m_threads[a].load != m_threads[b].load) {
+            return m_threads[a].load < m_threads[b].load;
+        }
+        return m_threads[a].currentSpeed > m_threads[b].currentSpeed;
+    };
+
+    std::vector<std::vector<uint64_t>> cores;
+    for(auto &[coreId, threads] : coreMap)
+    {
+        std::sort(threads.begin(), threads.end(), threadLess);
+        cores.push_back(threads);
+    }
+
+    // idle cores first, fastest core wins on equal load
+    std::sort(cores.begin(), cores.end(),
+              [&threadLess](const std::vector<uint64_t> &a, const std::vector<uint64_t> &b) {
+                  return threadLess(a.at(0), b.at(0));
+              });
+
+    return cores;
+}
+
+/**
+ * @brief one thread per physical core over all packages, before siblings are used
+ */
+void
+PlacementAdvisor::createMaxThroughputPlan(PlacementPlan &result,
+                                          const uint64_t numberOfWorkers)
+{
+    // least loaded packages first
+    std::vector<uint64_t> packageOrder(m_packages.size());
+    for(uint64_t i = 0; i < packageOrder.size(); i++) {
+        packageOrder[i] = i;
+    }
+    std::sort(packageOrder.begin(), packageOrder.end(),
+              [this](const uint64_t a, const uint64_t b) {
+                  return m_packages[a].load < m_packages[b].load;
+              });
+
+    std::vector<std::vector<std::vector<uint64_t>>> coresPerPackage;
+    for(const uint64_t packagePos : packageOrder) {
+        coresPerPackage.push_back(getSortedCores(packagePos));
+    }
+
+    // round-robin over the packages, where the n-th round uses the n-th thread of each core
+    std::vector<uint64_t> order;
+    for(uint64_t level = 0; order.size() < m_threads.size(); level++)
+    {
+        uint64_t corePos = 0;
+        bool found = true;
+        while(found)
+        {
+            found = false;
+            for(const std::vector<std::vector<uint64_t>> &cores : coresPerPackage)
+            {
+                if(corePos >= cores.size()) {
+                    continue;
+                }
+                found = true;
+                if(level < cores[corePos].size()) {
+                    order.push_back(cores[corePos][level]);
+                }
+            }
+            corePos++;
+        }
+    }
+
+    for(uint64_t i = 0; i < numberOfWorkers; i++) {
+        result.threadIds.push_back(m_threads[order[i % order.size()]].threadId);
+    }
+}
+
+/**
+ * @brief fill all threads of one package, before the next package is used
+ */
+void
+PlacementAdvisor::createMinEnergyPlan(PlacementPlan &result,
+                                      const uint64_t numberOfWorkers)
+{
+    // prefer packages with the lowest power-consumption and fall back to the load, if rapl
+    // is not available
+    std::vector<uint64_t> packageOrder(m_packages.size());
+    for(uint64_t i = 0; i < packageOrder.size(); i++) {
+        packageOrder[i] = i;
+    }
+    std::sort(packageOrder.begin(), packageOrder.end(),
+              [this](const uint64_t a, const uint64_t b)
+              {
+                  const CpuPackageState &pa = m_packages[a];
+                  const CpuPackageState &pb = m_packages[b];
+                  if(pa.hasPower && pb.hasPower && pa.power != pb.power) {
+                      return pa.power < pb.power;
+                  }
+                  return pa.load < pb.load;
+              });
+
+    // siblings of the same core are used directly after each other
+    std::vector<uint64_t> order;
+    for(const uint64_t packagePos : packageOrder)
+    {
+        for(const std::vector<uint64_t> &core : getSortedCores(packagePos)) {
+            order.insert(order.end(), core.begin(), core.end());
+        }
+    }
+
+    for(uint64_t i = 0; i < numberOfWorkers; i++) {
+        result.threadIds.push_back(m_threads[order[i % order.size()]].threadId);
+    }
+}
+
+/**
+ * @brief assign each worker to the coolest package, weighted by the already assigned workers
+ */
+void
+PlacementAdvisor::createThermalBalancePlan(PlacementPlan &result,
+                                           const uint64_t numberOfWorkers)
+{
+    std::vector<std::vector<uint64_t>> orderPerPackage;
+    std::vector<uint64_t> assigned(m_packages.size(), 0);
+    for(uint64_t i = 0; i < m_packages.size(); i++)
+    {
+        // physical cores first, siblings afterwards
+        const std::vector<std::vector<uint64_t>> cores = getSortedCores(i);
+        std::vector<uint64_t> order;
+        for(uint64_t level = 0; order.size() < m_packages[i].threadIds.size(); level++)
+        {
+            for(const std::vector<uint64_t> &core : cores)
+            {
+                if(level < core.size()) {
+                    order.push_back(core[level]);
+                }
+            }
+        }
+        orderPerPackage.push_back(order);
+    }
+
+    // temperatures are only comparable, if they are known for all packages
+    bool useTemperature = true;
+    for(const CpuPackageState &package : m_packages) {
+        useTemperature &= package.hasTemperature;
+    }
+
+    for(uint64_t i = 0; i < numberOfWorkers; i++)
+    {
+        // every assigned worker heats up the package relative to its size
+        uint64_t bestPos = 0;
+        double bestScore = 0.0;
+        for(uint64_t p = 0; p < m_packages.size(); p++)
+        {
+            const double size = static_cast<double>(m_packages[p].threadIds.size());
+            const double usage = (static_cast<double>(assigned[p]) + m_packages[p].load * size) / size;
+            const double temperature = useTemperature ? m_packages[p].temperature : 0.0;
+            const double score = (temperature + 1.0) * (1.0 + usage);
+            if(p == 0 || score < bestScore)
+            {
+                bestScore = score;
+                bestPos = p;
+            }
+        }
+
+        const std::vector<uint64_t> &order = orderPerPackage[bestPos];
+        result.threadIds.push_back(m_threads[order[assigned[bestPos] % order.size()]].threadId);
+        assigned[bestPos]++;
+    }
+}
+
+/**
+ * @brief create a new affinity-plan based on the last updated state
+ *
+ * @param result reference for the resulting plan
+ * @param numberOfWorkers number of workers to place
+ * @param policy policy to use for the placement
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized, else true
+ */
+bool
+PlacementAdvisor::createPlan(PlacementPlan &result,
+                             const uint64_t numberOfWorkers,
+                             const PlacementPolicy policy,
+                             ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to create placement-plan, because advisor is not initialized");
+        error.addSolution("Call 'initAdvisor' before creating a plan");
+        return false;
+    }
+
+    result.policy = policy;
+    result.threadIds.clear();
+
+    switch(policy)
+    {
+        case MAX_THROUGHPUT_POLICY:
+            createMaxThroughputPlan(result, numberOfWorkers);
+            break;
+        case MIN_ENERGY_POLICY:
+            createMinEnergyPlan(result, numberOfWorkers);
+            break;
+        case THERMAL_BALANCE_POLICY:
+            createThermalBalancePlan(result, numberOfWorkers);
+            break;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get last updated state of all known cpu-threads
+ */
+const std::vector<CpuThreadState>
+PlacementAdvisor::getThreadStates() const
+{
+    return m_threads;
+}
+
+/**
+ * @brief get last updated state of all known cpu-packages
+ */
+const std::vector<CpuPackageState>
+PlacementAdvisor::getPackageStates() const
+{
+    return m_packages;
+}
+
+/**
+ * @brief bind the calling thread to the cpu-thread, which was planned for a specific worker
+ *
+ * @param plan plan with the placement of all workers
+ * @param workerId id of the worker, which calls this function
+ * @param error reference for error-output
+ *
+ * @return false, if worker-id is not in the plan or binding failed, else true
+ */
+bool
+applyPlacement(const PlacementPlan &plan,
+               const uint64_t workerId,
+               ErrorContainer &error)
+{
+    if(workerId >= plan.threadIds.size())
+    {
+        error.addMeesage("Failed to apply placement, because worker-id '"
+                         + std::to_string(workerId)
+                         + "' is not part of the plan");
+        return false;
+    }
+
+    const uint64_t threadId = plan.threadIds[workerId];
+    CpuSet threads;
+    threads.add(threadId);
+    if(setThreadAffinity(threads, error) == false)
+    {
+        error.addMeesage("Failed to bind worker '"
+                         + std::to_string(workerId)
+                         + "' to cpu-thread '"
+                         + std::to_string(threadId)
+                         + "'");
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Kitsunemimi
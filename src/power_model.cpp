@@ -0,0 +1,535 @@
+/**
+ *  @file       power_model.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/power_model.h>
+#include <libKitsunemimiCpu/cpu.h>
+#include <libKitsunemimiCpu/tsc_clock.h>
+
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <map>
+
+namespace Kitsunemimi
+{
+
+// minimum number of samples for each package, before a model can be fitted
+const uint64_t minimumCalibrationSamples = 10;
+
+const std::string powerModelFileHeader = "kitsunemimi-power-model 1";
+
+/**
+ * @brief fit the coefficients of one target with least-squares over all samples. A small
+ *        ridge-regularization keeps the system solvable, if features are constant, like the
+ *        frequency in a vm.
+ *
+ * @param result array for the resulting coefficients
+ * @param samples calibration-samples
+ * @param targetId position of the measured power within the samples
+ */
+template<typename T>
+void
+fitPowerCoefficients(double* result,
+                     const std::vector<T> &samples,
+                     const uint64_t targetId)
+{
+    const uint64_t size = numberOfPowerFeatures;
+    double matrix[numberOfPowerFeatures][numberOfPowerFeatures + 1];
+    for(uint64_t row = 0; row < size; row++)
+    {
+        for(uint64_t col = 0; col <= size; col++) {
+            matrix[row][col] = 0.0;
+        }
+    }
+
+    // normal-equations
+    for(const T &sample : samples)
+    {
+        for(uint64_t row = 0; row < size; row++)
+        {
+            for(uint64_t col = 0; col < size; col++) {
+                matrix[row][col] += sample.features[row] * sample.features[col];
+            }
+            matrix[row][size] += sample.features[row] * sample.power[targetId];
+        }
+    }
+
+    double trace = 0.0;
+    for(uint64_t row = 0; row < size; row++) {
+        trace += matrix[row][row];
+    }
+    const double lambda = 1e-6 * trace / static_cast<double>(size) + 1e-12;
+    for(uint64_t row = 0; row < size; row++) {
+        matrix[row][row] += lambda;
+    }
+
+    // gaussian elimination with partial pivoting
+    for(uint64_t col = 0; col < size; col++)
+    {
+        uint64_t pivot = col;
+        for(uint64_t row = col + 1; row < size; row++)
+        {
+            if(std::fabs(matrix[row][col]) > std::fabs(matrix[pivot][col])) {
+                pivot = row;
+            }
+        }
+        for(uint64_t i = 0; i <= size; i++) {
+            std::swap(matrix[col][i], matrix[pivot][i]);
+        }
+
+        for(uint64_t row = col + 1; row < size; row++)
+        {
+            const double factor = matrix[row][col] / matrix[col][col];
+            for(uint64_t i = col; i <= size; i++) {
+                matrix[row][i] -= factor * matrix[col][i];
+            }
+        }
+    }
+
+    for(uint64_t row = size; row-- > 0;)
+    {
+        double value = matrix[row][size];
+        for(uint64_t col = row + 1; col < size; col++) {
+            value -= matrix[row][col] * result[col];
+        }
+        result[row] = value / matrix[row][row];
+    }
+}
+
+/**
+ * @brief calculate power of a model for given features, which is never negative
+ */
+double
+evaluatePowerModel(const double* coefficients,
+                   const double* features)
+{
+    double power = 0.0;
+    for(uint64_t i = 0; i < numberOfPowerFeatures; i++) {
+        power += coefficients[i] * features[i];
+    }
+
+    return std::max(power, 0.0);
+}
+
+/**
+ * @brief constructor
+ */
+PowerModel::PowerModel() {}
+
+/**
+ * @brief initialize topology, rapl and the initial state of the cpu-times. Rapl is optional
+ *        and only necessary for the calibration.
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if topology or cpu-times can not be read, else true
+ */
+bool
+PowerModel::initModel(ErrorContainer &error)
+{
+    // check if already initialized
+    if(m_isInit)
+    {
+        LOG_WARNING("this power-model was already successfully initialized");
+        return true;
+    }
+
+    if(getOnlineCpuThreads(m_threads, error) == false
+            || m_threads.isEmpty())
+    {
+        error.addMeesage("Failed to initialize power-model");
+        return false;
+    }
+
+    // map cpu-threads to package-positions and create one rapl-instance for each package, where
+    // the ids of the cpu-threads are used as index, because they are not necessarily continuous
+    std::map<uint64_t, uint64_t> packagePositions;
+    m_packageOfThread.assign(m_threads.getLast() + 1, 0);
+    bool supportRapl = true;
+    for(const uint64_t threadId : m_threads)
+    {
+        uint64_t packageId = 0;
+        ErrorContainer threadError;
+        if(getCpuPackageId(packageId, threadId, threadError) == false) {
+            continue;
+        }
+
+        if(packagePositions.find(packageId) == packagePositions.end())
+        {
+            packagePositions.emplace(packageId, packagePositions.size());
+            m_packageIds.push_back(packageId);
+
+            // rapl owns the open msr-file, so it is created in place and never copied
+            m_rapls.emplace_back(threadId);
+            ErrorContainer raplError;
+            supportRapl &= m_rapls.back().initRapl(raplError);
+        }
+
+        m_packageOfThread[threadId] = packagePositions[packageId];
+    }
+
+    m_numberOfPackages = packagePositions.size();
+    // the destructor of rapl closes the msr-files of the already initialized packages
+    if(supportRapl == false) {
+        m_rapls.clear();
+    }
+
+    ErrorContainer temperatureError;
+    getPkgTemperatureFiles(m_temperatureFiles, temperatureError);
+
+    if(getCpuThreadTimes(m_lastTimes, error) == false)
+    {
+        error.addMeesage("Failed to initialize power-model");
+        return false;
+    }
+    m_lastTimeStamp = TscClock::getInstance()->getTimestamp();
+
+    m_samples.resize(m_numberOfPackages);
+    m_isInit = true;
+
+    return true;
+}
+
+/**
+ * @brief check if the model was fitted or loaded
+ */
+bool
+PowerModel::isCalibrated() const
+{
+    return m_isCalibrated;
+}
+
+/**
+ * @brief collect the features of each package for the interval since the last call
+ *
+ * @param result reference for one sample with the features for each package
+ * @param interval reference for the length of the interval in seconds
+ * @param error reference for error-output
+ *
+ * @return false, if cpu-times can not be read, else true
+ */
+bool
+PowerModel::collectFeatures(std::vector<CalibrationSample> &result,
+                            double &interval,
+                            ErrorContainer &error)
+{
+    std::vector<CpuThreadTimes> times;
+    if(getCpuThreadTimes(times, error) == false) {
+        return false;
+    }
+
+    const uint64_t now = TscClock::getInstance()->getTimestamp();
+    interval = static_cast<double>(now - m_lastTimeStamp) / 1000000000.0;
+    m_lastTimeStamp = now;
+
+    result.assign(m_numberOfPackages, CalibrationSample());
+    for(CalibrationSample &sample : result)
+    {
+        for(uint64_t i = 0; i < numberOfPowerFeatures; i++) {
+            sample.features[i] = 0.0;
+        }
+        sample.features[0] = 1.0;
+        sample.power[0] = 0.0;
+        sample.power[1] = 0.0;
+        sample.power[2] = 0.0;
+    }
+
+    // frequency is not available in most vms, so the reference of the calibration is used
+    std::vector<uint64_t> speeds;
+    ErrorContainer speedError;
+    const bool hasSpeed = getCurrentSpeed(speeds, m_threads, speedError)
+                          && speeds.size() == m_threads.getThreadIds().size();
+
+    uint64_t pos = 0;
+    for(const uint64_t threadId : m_threads)
+    {
+        // counters of threads, which were offline in the meantime, can be reset
+        double utilization = 0.0;
+        if(threadId < times.size()
+                && threadId < m_lastTimes.size()
+                && times[threadId].getTotal() > m_lastTimes[threadId].getTotal()
+                && times[threadId].getBusy() >= m_lastTimes[threadId].getBusy())
+        {
+            const uint64_t totalDiff = times[threadId].getTotal()
+                                       - m_lastTimes[threadId].getTotal();
+            const uint64_t busyDiff = times[threadId].getBusy()
+                                      - m_lastTimes[threadId].getBusy();
+            utilization = static_cast<double>(busyDiff) / static_cast<double>(totalDiff);
+        }
+
+        double frequency = m_referenceFrequency;
+        if(hasSpeed
+                && speeds[pos] > 0)
+        {
+            frequency = static_cast<double>(speeds[pos]) / 1000000.0;
+            m_frequencySum += frequency;
+            m_frequencyCount++;
+        }
+
+        double* features = result[m_packageOfThread[threadId]].features;
+        features[1] += utilization;
+        features[2] += utilization * frequency;
+        features[3] += utilization * frequency * frequency * frequency;
+        pos++;
+    }
+
+    for(uint64_t i = 0; i < m_numberOfPackages; i++)
+    {
+        double temperature = 0.0;
+        const auto temperatureIt = m_temperatureFiles.find(m_packageIds[i]);
+        ErrorContainer temperatureError;
+        if(temperatureIt != m_temperatureFiles.end()
+                && readPkgTemperature(temperature, temperatureIt->second, temperatureError))
+        {
+            m_temperatureSum += temperature;
+            m_temperatureCount++;
+        }
+        else
+        {
+            temperature = m_referenceTemperature;
+        }
+        result[i].features[4] = temperature;
+    }
+
+    m_lastTimes = times;
+
+    return true;
+}
+
+/**
+ * @brief add a sample of the features and the power, which was measured by rapl, of the
+ *        interval since the last call. Should be called in a fixed interval of about one second
+ *        while running workloads with different load and frequency.
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized or rapl is not available, else true
+ */
+bool
+PowerModel::addCalibrationSample(ErrorContainer &error)
+{
+    if(m_isInit == false
+            || m_rapls.size() != m_numberOfPackages)
+    {
+        error.addMeesage("Failed to add calibration-sample, because power-model is not "
+                         "initialized or rapl is not available on this host");
+        error.addSolution("calibrate on a host, where rapl is available, and load the model "
+                          "with loadModel on other hosts");
+        return false;
+    }
+
+    std::vector<CalibrationSample> samples;
+    double interval = 0.0;
+    if(collectFeatures(samples, interval, error) == false) {
+        return false;
+    }
+
+    for(uint64_t i = 0; i < m_numberOfPackages; i++)
+    {
+        const RaplDiff diff = m_rapls[i].calculateDiff();
+        samples[i].power[0] = diff.pkgAvg;
+        samples[i].power[1] = diff.pp0Avg;
+        samples[i].power[2] = diff.dramAvg;
+        m_samples[i].push_back(samples[i]);
+    }
+
+    return true;
+}
+
+/**
+ * @brief fit the model of each package to the collected calibration-samples
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if there are not enough samples, else true
+ */
+bool
+PowerModel::fitModel(ErrorContainer &error)
+{
+    if(m_isInit == false
+            || m_samples.size() == 0
+            || m_samples[0].size() < minimumCalibrationSamples)
+    {
+        error.addMeesage("Failed to fit power-model, because there are less than "
+                         + std::to_string(minimumCalibrationSamples)
+                         + " calibration-samples");
+        return false;
+    }
+
+    // the average values of the calibration are used, if they can not be read while estimating
+    if(m_frequencyCount > 0) {
+        m_referenceFrequency = m_frequencySum / static_cast<double>(m_frequencyCount);
+    }
+    if(m_temperatureCount > 0) {
+        m_referenceTemperature = m_temperatureSum / static_cast<double>(m_temperatureCount);
+    }
+
+    m_coefficients.assign(m_numberOfPackages, PowerModelCoefficients());
+    for(uint64_t i = 0; i < m_numberOfPackages; i++)
+    {
+        fitPowerCoefficients(m_coefficients[i].pkg, m_samples[i], 0);
+        fitPowerCoefficients(m_coefficients[i].pp0, m_samples[i], 1);
+        fitPowerCoefficients(m_coefficients[i].dram, m_samples[i], 2);
+    }
+
+    m_isCalibrated = true;
+
+    return true;
+}
+
+/**
+ * @brief write coefficients and reference-values of a calibrated model into a file
+ *
+ * @param filePath path to the file
+ * @param error reference for error-output
+ *
+ * @return false, if not calibrated or file can not be written, else true
+ */
+bool
+PowerModel::saveModel(const std::string &filePath,
+                      ErrorContainer &error) const
+{
+    if(m_isCalibrated == false)
+    {
+        error.addMeesage("Failed to save power-model, because it is not calibrated");
+        return false;
+    }
+
+    std::ofstream outFile(filePath, std::ios_base::trunc);
+    if(outFile.is_open() == false)
+    {
+        error.addMeesage("can not open file to write content: '" + filePath + "'");
+        return false;
+    }
+
+    // first line is the header, second line the reference-values and number of packages
+    // and then three lines for each package with the coefficients of pkg, pp0 and dram
+    outFile.precision(std::numeric_limits<double>::max_digits10);
+    outFile << powerModelFileHeader << "\n";
+    outFile << m_referenceFrequency << " "
+            << m_referenceTemperature << " "
+            << m_coefficients.size() << "\n";
+    for(const PowerModelCoefficients &coefficients : m_coefficients)
+    {
+        for(const double* values : {coefficients.pkg, coefficients.pp0, coefficients.dram})
+        {
+            for(uint64_t i = 0; i < numberOfPowerFeatures; i++) {
+                outFile << values[i] << (i + 1 == numberOfPowerFeatures ? "\n" : " ");
+            }
+        }
+    }
+
+    if(outFile.good() == false)
+    {
+        error.addMeesage("Failed to write power-model into file '" + filePath + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief load a model, which was calibrated and saved on another host
+ *
+ * @param filePath path to the file
+ * @param error reference for error-output
+ *
+ * @return false, if file doesn't exist or is invalid, else true
+ */
+bool
+PowerModel::loadModel(const std::string &filePath,
+                      ErrorContainer &error)
+{
+    std::ifstream inFile(filePath);
+    if(inFile.is_open() == false)
+    {
+        error.addMeesage("can not open file to read content: '" + filePath + "'");
+        return false;
+    }
+
+    std::string header = "";
+    std::getline(inFile, header);
+    uint64_t numberOfPackages = 0;
+    double referenceFrequency = 0.0;
+    double referenceTemperature = 0.0;
+    inFile >> referenceFrequency >> referenceTemperature >> numberOfPackages;
+
+    std::vector<PowerModelCoefficients> coefficients(numberOfPackages);
+    for(PowerModelCoefficients &package : coefficients)
+    {
+        for(double* values : {package.pkg, package.pp0, package.dram})
+        {
+            for(uint64_t i = 0; i < numberOfPowerFeatures; i++) {
+                inFile >> values[i];
+            }
+        }
+    }
+
+    if(header != powerModelFileHeader
+            || inFile.fail()
+            || numberOfPackages == 0)
+    {
+        error.addMeesage("File '" + filePath + "' is not a valid power-model");
+        return false;
+    }
+
+    m_referenceFrequency = referenceFrequency;
+    m_referenceTemperature = referenceTemperature;
+    m_coefficients = coefficients;
+    m_isCalibrated = true;
+
+    return true;
+}
+
+/**
+ * @brief estimate the energy of each package for the interval since the last call. The result
+ *        has the same form like the one of Rapl::calculateDiff, but without pp1 and core.
+ *
+ * @param result reference for one estimation for each package
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized or not calibrated, else true
+ */
+bool
+PowerModel::calculateDiff(std::vector<RaplDiff> &result,
+                          ErrorContainer &error)
+{
+    if(m_isInit == false
+            || m_isCalibrated == false)
+    {
+        error.addMeesage("Failed to estimate power, because power-model is not initialized or "
+                         "not calibrated");
+        error.addSolution("fit a model with fitModel or load a model with loadModel");
+        return false;
+    }
+
+    std::vector<CalibrationSample> samples;
+    double interval = 0.0;
+    if(collectFeatures(samples, interval, error) == false) {
+        return false;
+    }
+
+    // if the model comes from a host with another number of packages, the models are reused
+    result.assign(m_numberOfPackages, RaplDiff());
+    for(uint64_t i = 0; i < m_numberOfPackages; i++)
+    {
+        const PowerModelCoefficients &coefficients = m_coefficients[i % m_coefficients.size()];
+        RaplDiff &diff = result[i];
+        diff.pkgAvg = evaluatePowerModel(coefficients.pkg, samples[i].features);
+        diff.pp0Avg = evaluatePowerModel(coefficients.pp0, samples[i].features);
+        diff.dramAvg = evaluatePowerModel(coefficients.dram, samples[i].features);
+        diff.pkgDiff = diff.pkgAvg * interval;
+        diff.pp0Diff = diff.pp0Avg * interval;
+        diff.dramDiff = diff.dramAvg * interval;
+        diff.time = interval;
+    }
+
+    return true;
+}
+
+} // namespace Kitsunemimi
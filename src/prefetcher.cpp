@@ -0,0 +1,237 @@
+/**
+ *  @file       prefetcher.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/prefetcher.h>
+#include <libKitsunemimiCpu/msr.h>
+
+#include <unistd.h>
+
+namespace Kitsunemimi
+{
+
+#define MSR_MISC_FEATURE_CONTROL  0x1A4
+
+// lower 4 bits of the register, where a set bit disables the prefetcher
+const uint64_t prefetcherMask = 0xf;
+
+/**
+ * @brief convert value of the register into a state
+ */
+void
+decodePrefetcherBits(PrefetcherState &result,
+                     const uint64_t value)
+{
+    result.l2Streamer = ((value >> L2_STREAMER_PREFETCHER) & 0x1) == 0;
+    result.l2AdjacentLine = ((value >> L2_ADJACENT_LINE_PREFETCHER) & 0x1) == 0;
+    result.l1Dcu = ((value >> L1_DCU_PREFETCHER) & 0x1) == 0;
+    result.l1Ip = ((value >> L1_IP_PREFETCHER) & 0x1) == 0;
+}
+
+/**
+ * @brief convert state into the prefetcher-bits of the register
+ */
+uint64_t
+encodePrefetcherBits(const PrefetcherState &state)
+{
+    uint64_t value = 0;
+    value |= static_cast<uint64_t>(state.l2Streamer == false) << L2_STREAMER_PREFETCHER;
+    value |= static_cast<uint64_t>(state.l2AdjacentLine == false) << L2_ADJACENT_LINE_PREFETCHER;
+    value |= static_cast<uint64_t>(state.l1Dcu == false) << L1_DCU_PREFETCHER;
+    value |= static_cast<uint64_t>(state.l1Ip == false) << L1_IP_PREFETCHER;
+    return value;
+}
+
+/**
+ * @brief update the prefetcher-bits of a cpu-thread and keep all other bits of the register
+ *
+ * @param threadId id of the cpu-thread
+ * @param mask prefetcher-bits to change
+ * @param bits new values of the prefetcher-bits
+ * @param error reference for error-output
+ *
+ * @return false, if the register can not be read or written, else true
+ */
+bool
+updatePrefetcherBits(const uint64_t threadId,
+                     const uint64_t mask,
+                     const uint64_t bits,
+                     ErrorContainer &error)
+{
+    const int fd = openMsr(threadId, true, error);
+    if(fd < 0) {
+        return false;
+    }
+
+    uint64_t value = 0;
+    bool success = readMsrFd(value, fd, MSR_MISC_FEATURE_CONTROL, error);
+    if(success)
+    {
+        const uint64_t newValue = (value & ~mask) | (bits & mask);
+        if(newValue != value) {
+            success = writeMsrFd(fd, MSR_MISC_FEATURE_CONTROL, newValue, error);
+        }
+    }
+    close(fd);
+
+    if(success == false)
+    {
+        error.addMeesage("Failed to change prefetcher of cpu-thread '"
+                         + std::to_string(threadId)
+                         + "'");
+        error.addSolution("MSR_MISC_FEATURE_CONTROL is only available on Intel cpus");
+    }
+
+    return success;
+}
+
+/**
+ * @brief get state of the hardware-prefetchers of a cpu-thread
+ *
+ * @param result reference for result-output
+ * @param threadId id of the cpu-thread
+ * @param error reference for error-output
+ *
+ * @return false, if the register can not be read, else true
+ */
+bool
+getPrefetcherState(PrefetcherState &result,
+                   const uint64_t threadId,
+                   ErrorContainer &error)
+{
+    uint64_t value = 0;
+    if(readMsr(value, threadId, MSR_MISC_FEATURE_CONTROL, error) == false)
+    {
+        error.addMeesage("Failed to get prefetcher-state of cpu-thread '"
+                         + std::to_string(threadId)
+                         + "'");
+        error.addSolution("MSR_MISC_FEATURE_CONTROL is only available on Intel cpus");
+        return false;
+    }
+
+    result.threadId = threadId;
+    decodePrefetcherBits(result, value);
+
+    return true;
+}
+
+/**
+ * @brief set all hardware-prefetchers of a cpu-thread. The prefetchers belong to the physical
+ *        core, so hyperthreading-siblings are affected too.
+ *
+ * @param state new state, which also contains the id of the cpu-thread
+ * @param error reference for error-output
+ *
+ * @return false, if the register can not be written, else true
+ */
+bool
+setPrefetcherState(const PrefetcherState &state,
+                   ErrorContainer &error)
+{
+    return updatePrefetcherBits(state.threadId,
+                                prefetcherMask,
+                                encodePrefetcherBits(state),
+                                error);
+}
+
+/**
+ * @brief enable or disable a single hardware-prefetcher of a cpu-thread
+ *
+ * @param threadId id of the cpu-thread
+ * @param prefetcher prefetcher to change
+ * @param enable true to enable and false to disable the prefetcher
+ * @param error reference for error-output
+ *
+ * @return false, if the register can not be written, else true
+ */
+bool
+setPrefetcherEnabled(const uint64_t threadId,
+                     const Prefetcher prefetcher,
+                     const bool enable,
+                     ErrorContainer &error)
+{
+    const uint64_t mask = 1ULL << prefetcher;
+    return updatePrefetcherBits(threadId, mask, enable ? 0 : mask, error);
+}
+
+/**
+ * @brief get state of the hardware-prefetchers of multiple cpu-threads, for example to capture
+ *        them before a change
+ *
+ * @param result reference for the states in the same order as the threads in the set
+ * @param threads cpu-threads to check
+ * @param error reference for error-output
+ *
+ * @return false, if any register can not be read, else true
+ */
+bool
+getPrefetcherState(std::vector<PrefetcherState> &result,
+                   const CpuSet &threads,
+                   ErrorContainer &error)
+{
+    result.clear();
+    for(const uint64_t threadId : threads)
+    {
+        PrefetcherState state;
+        if(getPrefetcherState(state, threadId, error) == false) {
+            return false;
+        }
+        result.push_back(state);
+    }
+
+    return true;
+}
+
+/**
+ * @brief enable or disable a single hardware-prefetcher of multiple cpu-threads
+ *
+ * @param threads cpu-threads to change
+ * @param prefetcher prefetcher to change
+ * @param enable true to enable and false to disable the prefetcher
+ * @param error reference for error-output
+ *
+ * @return false, if any register can not be written, else true
+ */
+bool
+setPrefetcherEnabled(const CpuSet &threads,
+                     const Prefetcher prefetcher,
+                     const bool enable,
+                     ErrorContainer &error)
+{
+    for(const uint64_t threadId : threads)
+    {
+        if(setPrefetcherEnabled(threadId, prefetcher, enable, error) == false) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief restore the hardware-prefetchers, which were captured with getPrefetcherState
+ *
+ * @param state captured states
+ * @param error reference for error-output
+ *
+ * @return false, if any register can not be written, else true
+ */
+bool
+restorePrefetcherState(const std::vector<PrefetcherState> &state,
+                       ErrorContainer &error)
+{
+    bool result = true;
+
+    // try to restore as much as possible, even if a single thread fails
+    for(const PrefetcherState &threadState : state) {
+        result &= setPrefetcherState(threadState, error);
+    }
+
+    return result;
+}
+
+} // namespace Kitsunemimi
@@ -0,0 +1,534 @@
+/**
+ *  @file       pressure.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/pressure.h>
+#include <libKitsunemimiCpu/cgroup.h>
+#include <libKitsunemimiCpu/tsc_clock.h>
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief get name of the pressure-file of a resource
+ */
+const std::string
+getPressureName(const PressureResource resource)
+{
+    switch(resource)
+    {
+        case CPU_PRESSURE:
+            return "cpu";
+        case MEMORY_PRESSURE:
+            return "memory";
+        case IO_PRESSURE:
+            return "io";
+    }
+
+    return "";
+}
+
+/**
+ * @brief parse a line of the pressure-stall-information, like
+ *        "some avg10=0.00 avg60=0.00 avg300=0.00 total=0"
+ *
+ * @param result reference for result-output, where only the values of the type of the line
+ *               are updated
+ * @param line line to parse
+ *
+ * @return false, if the type or a value of the line is invalid, else true
+ */
+bool
+parsePressureLine(PressureInfo &result,
+                  const std::string &line)
+{
+    std::istringstream lineStream(line);
+    std::string type;
+    lineStream >> type;
+
+    PressureValues* values = nullptr;
+    if(type == "some") {
+        values = &result.some;
+    } else if(type == "full") {
+        values = &result.full;
+    } else {
+        return false;
+    }
+
+    std::string field;
+    while(lineStream >> field)
+    {
+        const size_t pos = field.find('=');
+        if(pos == std::string::npos) {
+            return false;
+        }
+
+        const std::string key = field.substr(0, pos);
+        const std::string value = field.substr(pos + 1);
+        char* end = nullptr;
+        if(key == "avg10") {
+            values->avg10 = strtod(value.c_str(), &end);
+        } else if(key == "avg60") {
+            values->avg60 = strtod(value.c_str(), &end);
+        } else if(key == "avg300") {
+            values->avg300 = strtod(value.c_str(), &end);
+        } else if(key == "total") {
+            values->total = strtoull(value.c_str(), &end, 10);
+        } else {
+            // unknown keys of newer kernels are skipped
+            continue;
+        }
+
+        if(end == value.c_str()
+                || *end != '\0')
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief read a file in the format of the pressure-stall-information, which has the lines
+ *        "some avg10=0.00 avg60=0.00 avg300=0.00 total=0" and "full ..."
+ *
+ * @param result reference for result-output
+ * @param filePath path to the file
+ * @param error reference for error-output
+ *
+ * @return false, if the file can not be read or has an invalid line, else true
+ */
+bool
+readPressureFile(PressureInfo &result,
+                 const std::string &filePath,
+                 ErrorContainer &error)
+{
+    std::ifstream inFile(filePath);
+    if(inFile.is_open() == false)
+    {
+        error.addMeesage("can not open file to read content: '" + filePath + "'");
+        error.addSolution("check if the kernel is at least version 4.20 and was build with "
+                          "CONFIG_PSI and without the boot-parameter 'psi=0'");
+        return false;
+    }
+
+    // the full-line doesn't exist for the cpu in kernel older than 5.13, so it stays zero
+    std::string line;
+    while(std::getline(inFile, line))
+    {
+        if(line == "") {
+            continue;
+        }
+
+        if(parsePressureLine(result, line) == false)
+        {
+            error.addMeesage("Failed to parse line '" + line + "' of pressure-file '"
+                             + filePath + "'");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief get path of the pressure-file of the cgroup of the current process
+ *
+ * @param result reference for the resulting path
+ * @param resource requested resource
+ * @param error reference for error-output
+ *
+ * @return false, if no cgroup v2 was found, else true
+ */
+bool
+getCgroupPressurePath(std::string &result,
+                      const PressureResource resource,
+                      ErrorContainer &error)
+{
+    // pressure-files only exist in the unified hierarchy
+    if(getCgroupVersion() != CGROUP_V2)
+    {
+        error.addMeesage("Failed to get pressure of the cgroup, because no cgroup v2 was found");
+        error.addSolution("use the system-wide pressure instead");
+        return false;
+    }
+
+    std::string path = "";
+    if(getCgroupPath(path, getPressureName(resource), error) == false) {
+        return false;
+    }
+
+    result = path + "/" + getPressureName(resource) + ".pressure";
+    return true;
+}
+
+/**
+ * @brief get system-wide pressure-stall-information of a resource
+ *
+ * @param result reference for result-output
+ * @param resource requested resource
+ * @param error reference for error-output
+ *
+ * @return false, if pressure-stall-information are not available, else true
+ */
+bool
+getPressure(PressureInfo &result,
+            const PressureResource resource,
+            ErrorContainer &error)
+{
+    const std::string filePath = "/proc/pressure/" + getPressureName(resource);
+    return readPressureFile(result, filePath, error);
+}
+
+/**
+ * @brief get pressure-stall-information of a resource for the cgroup of the current process
+ *
+ * @param result reference for result-output
+ * @param resource requested resource
+ * @param error reference for error-output
+ *
+ * @return false, if no cgroup v2 was found or pressure-stall-information are not available,
+ *         else true
+ */
+bool
+getCgroupPressure(PressureInfo &result,
+                  const PressureResource resource,
+                  ErrorContainer &error)
+{
+    std::string filePath = "";
+    if(getCgroupPressurePath(filePath, resource, error) == false) {
+        return false;
+    }
+
+    return readPressureFile(result, filePath, error);
+}
+
+/**
+ * @brief get counters of the memory-management, which indicate pressure on the memory
+ *
+ * @param result reference for result-output
+ * @param error reference for error-output
+ *
+ * @return false, if the vmstat-file can not be read, else true
+ */
+bool
+getVmStat(VmStatInfo &result,
+          ErrorContainer &error)
+{
+    const std::string filePath = "/proc/vmstat";
+    std::ifstream inFile(filePath);
+    if(inFile.is_open() == false)
+    {
+        error.addMeesage("can not open file to read content: '" + filePath + "'");
+        return false;
+    }
+
+    result = VmStatInfo();
+
+    std::string key;
+    uint64_t value = 0;
+    while(inFile >> key >> value)
+    {
+        // scan and steal are split into the sources of the reclaim. The additional
+        // pgscan_anon and pgscan_file of newer kernels are only another split of the same
+        // pages, so they are not added.
+        if(key == "pgmajfault") {
+            result.pgMajFault = value;
+        } else if(key == "pgscan_kswapd"
+                  || key == "pgscan_direct"
+                  || key == "pgscan_khugepaged")
+        {
+            result.pgScan += value;
+        } else if(key == "pgsteal_kswapd"
+                  || key == "pgsteal_direct"
+                  || key == "pgsteal_khugepaged")
+        {
+            result.pgSteal += value;
+        } else if(key == "compact_stall") {
+            result.compactStall = value;
+        } else if(key == "compact_fail") {
+            result.compactFail = value;
+        } else if(key == "compact_success") {
+            result.compactSuccess = value;
+        } else if(key == "oom_kill") {
+            result.oomKill = value;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief constructor
+ */
+VmStatSampler::VmStatSampler() {}
+
+/**
+ * @brief read initial state of the counters
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if the counters can not be read, else true
+ */
+bool
+VmStatSampler::initSampler(ErrorContainer &error)
+{
+    // check if already initialized
+    if(m_isInit)
+    {
+        LOG_WARNING("this vmstat-sampler was already successfully initialized");
+        return true;
+    }
+
+    if(getVmStat(m_lastState, error) == false)
+    {
+        error.addMeesage("Failed to initialize vmstat-sampler");
+        return false;
+    }
+    m_lastTimeStamp = TscClock::getInstance()->getTimestamp();
+    m_isInit = true;
+
+    return true;
+}
+
+/**
+ * @brief get the increase of the counters since the last call
+ *
+ * @param result reference for the difference of the counters
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized or counters can not be read, else true
+ */
+bool
+VmStatSampler::calculateDiff(VmStatInfo &result,
+                             ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to calculate vmstat-diff, because sampler is not initialized");
+        return false;
+    }
+
+    VmStatInfo current;
+    if(getVmStat(current, error) == false) {
+        return false;
+    }
+    const uint64_t now = TscClock::getInstance()->getTimestamp();
+
+    result.pgMajFault = current.pgMajFault - m_lastState.pgMajFault;
+    result.pgScan = current.pgScan - m_lastState.pgScan;
+    result.pgSteal = current.pgSteal - m_lastState.pgSteal;
+    result.compactStall = current.compactStall - m_lastState.compactStall;
+    result.compactFail = current.compactFail - m_lastState.compactFail;
+    result.compactSuccess = current.compactSuccess - m_lastState.compactSuccess;
+    result.oomKill = current.oomKill - m_lastState.oomKill;
+    result.time = static_cast<double>(now - m_lastTimeStamp) / 1000000000.0;
+
+    m_lastState = current;
+    m_lastTimeStamp = now;
+
+    return true;
+}
+
+/**
+ * @brief constructor
+ */
+PressureTrigger::PressureTrigger() {}
+
+/**
+ * @brief destructor
+ */
+PressureTrigger::~PressureTrigger()
+{
+    if(m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+/**
+ * @brief register a trigger in a pressure-file. The trigger stays registered, as long as the
+ *        file-descriptor is open.
+ *
+ * @param filePath path to the pressure-file
+ * @param type type of the stall
+ * @param stallUs stall-time in microseconds within the window, which fires the trigger
+ * @param windowUs size of the time-window in microseconds
+ * @param error reference for error-output
+ *
+ * @return false, if registration failed, else true
+ */
+bool
+PressureTrigger::registerTrigger(const std::string &filePath,
+                                 const PressureType type,
+                                 const uint64_t stallUs,
+                                 const uint64_t windowUs,
+                                 ErrorContainer &error)
+{
+    // check if already initialized
+    if(m_isInit)
+    {
+        LOG_WARNING("this pressure-trigger was already successfully initialized");
+        return true;
+    }
+
+    // limits of the kernel for the window
+    if(windowUs < 500000
+            || windowUs > 10000000
+            || stallUs == 0
+            || stallUs > windowUs)
+    {
+        error.addMeesage("Failed to register pressure-trigger, because of invalid values: stall '"
+                         + std::to_string(stallUs)
+                         + "' us within window '"
+                         + std::to_string(windowUs)
+                         + "' us");
+        error.addSolution("use a window between 500ms and 10s and a stall-time, which is not "
+                          "bigger than the window");
+        return false;
+    }
+
+    m_fd = open(filePath.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if(m_fd < 0)
+    {
+        error.addMeesage("Failed to open pressure-file '" + filePath + "'");
+        error.addSolution("check if the kernel is at least version 5.2 and was build with "
+                          "CONFIG_PSI");
+        return false;
+    }
+
+    // the kernel expects the terminating null-character as part of the write
+    const std::string trigger = std::string(type == SOME_PRESSURE ? "some " : "full ")
+                                + std::to_string(stallUs)
+                                + " "
+                                + std::to_string(windowUs);
+    if(write(m_fd, trigger.c_str(), trigger.size() + 1) < 0)
+    {
+        error.addMeesage("Failed to register pressure-trigger '"
+                         + trigger
+                         + "' in file '"
+                         + filePath
+                         + "': "
+                         + std::string(strerror(errno)));
+        error.addSolution("unprivileged processes can only use windows, which are a multiple "
+                          "of 2 seconds");
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    m_isInit = true;
+
+    return true;
+}
+
+/**
+ * @brief register a trigger for the system-wide pressure of a resource
+ *
+ * @param resource resource to observe
+ * @param type type of the stall
+ * @param stallUs stall-time in microseconds within the window, which fires the trigger
+ * @param windowUs size of the time-window in microseconds
+ * @param error reference for error-output
+ *
+ * @return false, if registration failed, else true
+ */
+bool
+PressureTrigger::initTrigger(const PressureResource resource,
+                             const PressureType type,
+                             const uint64_t stallUs,
+                             const uint64_t windowUs,
+                             ErrorContainer &error)
+{
+    const std::string filePath = "/proc/pressure/" + getPressureName(resource);
+    return registerTrigger(filePath, type, stallUs, windowUs, error);
+}
+
+/**
+ * @brief register a trigger for the pressure of a resource within the cgroup of the
+ *        current process
+ *
+ * @param resource resource to observe
+ * @param type type of the stall
+ * @param stallUs stall-time in microseconds within the window, which fires the trigger
+ * @param windowUs size of the time-window in microseconds
+ * @param error reference for error-output
+ *
+ * @return false, if no cgroup v2 was found or registration failed, else true
+ */
+bool
+PressureTrigger::initCgroupTrigger(const PressureResource resource,
+                                   const PressureType type,
+                                   const uint64_t stallUs,
+                                   const uint64_t windowUs,
+                                   ErrorContainer &error)
+{
+    std::string filePath = "";
+    if(getCgroupPressurePath(filePath, resource, error) == false) {
+        return false;
+    }
+
+    return registerTrigger(filePath, type, stallUs, windowUs, error);
+}
+
+/**
+ * @brief block until the trigger fires or the timeout was reached
+ *
+ * @param timeoutMs timeout in milliseconds
+ * @param error reference for error-output
+ *
+ * @return true, if the trigger fired, else false
+ */
+bool
+PressureTrigger::waitForEvent(const uint32_t timeoutMs,
+                              ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to wait for pressure-event, because trigger is not initialized");
+        return false;
+    }
+
+    struct pollfd pfd = {};
+    pfd.fd = m_fd;
+    pfd.events = POLLPRI;
+    if(poll(&pfd, 1, timeoutMs) <= 0) {
+        return false;
+    }
+
+    // the cgroup of the trigger was removed
+    if(pfd.revents & POLLERR)
+    {
+        error.addMeesage("Failed to wait for pressure-event, because the source of the trigger "
+                         "is gone");
+        return false;
+    }
+
+    return (pfd.revents & POLLPRI) != 0;
+}
+
+/**
+ * @brief get file-descriptor of the trigger to integrate it into an own poll-loop. The trigger
+ *        fired, when the descriptor signals POLLPRI.
+ *
+ * @return -1, if not initialized, else the file-descriptor
+ */
+int
+PressureTrigger::getFileDescriptor() const
+{
+    return m_fd;
+}
+
+} // namespace Kitsunemimi
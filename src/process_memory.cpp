@@ -0,0 +1,416 @@
+/**
+ *  @file       process_memory.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/process_memory.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace Kitsunemimi
+{
+
+// size of the read-buffer for the files of the proc-filesystem
+const uint64_t procReadBufferSize = 64 * 1024;
+
+/**
+ * @brief line-reader for big files of the proc-filesystem. The smaps-file of a process with
+ *        hundreds of gigabytes has millions of lines, so the file is read in big chunks and the
+ *        lines are returned as pointer into the buffer without any allocation per line. The
+ *        buffer is given by the caller, so multiple files, which are read one after another,
+ *        can share the same buffer.
+ */
+class ProcLineReader
+{
+public:
+    ProcLineReader(const std::string &filePath,
+                   std::vector<char> &buffer)
+        : m_buffer(buffer)
+    {
+        m_fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+
+    ~ProcLineReader()
+    {
+        if(m_fd >= 0) {
+            close(m_fd);
+        }
+    }
+
+    ProcLineReader(const ProcLineReader &) = delete;
+    ProcLineReader &operator=(const ProcLineReader &) = delete;
+
+    bool isOpen() const
+    {
+        return m_fd >= 0;
+    }
+
+    /**
+     * @brief get next line as null-terminated string without the line-break
+     *
+     * @return nullptr, if end of file is reached, else pointer to the line
+     */
+    char* nextLine()
+    {
+        while(true)
+        {
+            char* buffer = m_buffer.data();
+            char* lineEnd = static_cast<char*>(memchr(buffer + m_pos, '\n', m_end - m_pos));
+            if(lineEnd != nullptr)
+            {
+                *lineEnd = '\0';
+                char* line = buffer + m_pos;
+                m_pos = (lineEnd - buffer) + 1;
+                return line;
+            }
+
+            // move the incomplete line to the beginning of the buffer and read the next chunk
+            const uint64_t rest = m_end - m_pos;
+            memmove(buffer, buffer + m_pos, rest);
+            m_pos = 0;
+            m_end = rest;
+
+            const ssize_t readBytes = read(m_fd, buffer + m_end, m_buffer.size() - m_end - 1);
+            if(readBytes <= 0)
+            {
+                // return last line without line-break
+                if(m_end == 0) {
+                    return nullptr;
+                }
+                buffer[m_end] = '\0';
+                m_pos = m_end;
+                return buffer;
+            }
+            m_end += readBytes;
+        }
+    }
+
+private:
+    int m_fd = -1;
+    std::vector<char> &m_buffer;
+    uint64_t m_pos = 0;
+    uint64_t m_end = 0;
+};
+
+/**
+ * @brief check if a line starts with a key and get the value behind the key in kB as bytes
+ *
+ * @param value reference for the value in bytes
+ * @param line line of a status- or smaps-file, like "Rss:    1420 kB"
+ * @param key key with colon, like "Rss:"
+ *
+ * @return false, if the key doesn't match, else true
+ */
+bool
+parseKibValue(uint64_t &value,
+              const char* line,
+              const char* key)
+{
+    const size_t keyLength = strlen(key);
+    if(strncmp(line, key, keyLength) != 0) {
+        return false;
+    }
+
+    value = strtoull(line + keyLength, nullptr, 10) * 1024;
+    return true;
+}
+
+/**
+ * @brief add the values of a line of a smaps- or smaps_rollup-file to the result
+ *
+ * @return false, if the line has no known key, else true
+ */
+bool
+addSmapsLine(ProcessMemoryInfo &result,
+             const char* line)
+{
+    uint64_t value = 0;
+    if(parseKibValue(value, line, "Rss:")) {
+        result.rss += value;
+    } else if(parseKibValue(value, line, "Pss:")) {
+        result.pss += value;
+    } else if(parseKibValue(value, line, "Anonymous:")) {
+        result.rssAnon += value;
+    } else if(parseKibValue(value, line, "Swap:")) {
+        result.swap += value;
+    } else if(parseKibValue(value, line, "SwapPss:")) {
+        result.swapPss += value;
+    } else if(parseKibValue(value, line, "AnonHugePages:")) {
+        result.anonHugePages += value;
+    } else if(parseKibValue(value, line, "Shared_Hugetlb:")
+              || parseKibValue(value, line, "Private_Hugetlb:"))
+    {
+        result.hugetlbPages += value;
+    } else if(parseKibValue(value, line, "Locked:")) {
+        result.locked += value;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief add the values of all lines of a smaps- or smaps_rollup-file to the result
+ *
+ * @param result reference for the result
+ * @param filePath path to the file
+ * @param buffer read-buffer for the file
+ *
+ * @return false, if the file can not be opened, else true
+ */
+bool
+readSmapsFile(ProcessMemoryInfo &result,
+              const std::string &filePath,
+              std::vector<char> &buffer)
+{
+    ProcLineReader reader(filePath, buffer);
+    if(reader.isOpen() == false) {
+        return false;
+    }
+
+    char* line = nullptr;
+    while((line = reader.nextLine()) != nullptr) {
+        addSmapsLine(result, line);
+    }
+
+    return true;
+}
+
+/**
+ * @brief parse a line of a numa-maps-file, like
+ *        "7f0000000000 default anon=512 dirty=512 N0=256 N1=256 kernelpagesize_kB=4",
+ *        and add the pages of each node to the distribution
+ *
+ * @param result reference for the distribution
+ * @param line line of the numa_maps-file
+ */
+void
+addNumaMapsLine(NodeMemoryDistribution &result,
+                char* line)
+{
+    // the page-size is at the end of the line, so the node-values are buffered
+    uint64_t nodeIds[64];
+    uint64_t pages[64];
+    uint64_t numberOfNodes = 0;
+    uint64_t pageSize = 4096;
+    bool isHuge = false;
+
+    char* savePtr = nullptr;
+    char* token = strtok_r(line, " ", &savePtr);
+    while(token != nullptr)
+    {
+        if(token[0] == 'N'
+                && token[1] >= '0'
+                && token[1] <= '9'
+                && numberOfNodes < 64)
+        {
+            char* end = nullptr;
+            nodeIds[numberOfNodes] = strtoull(token + 1, &end, 10);
+            if(*end == '=')
+            {
+                pages[numberOfNodes] = strtoull(end + 1, nullptr, 10);
+                numberOfNodes++;
+            }
+        }
+        else if(strncmp(token, "kernelpagesize_kB=", 18) == 0)
+        {
+            pageSize = strtoull(token + 18, nullptr, 10) * 1024;
+        }
+        else if(strcmp(token, "huge") == 0)
+        {
+            isHuge = true;
+        }
+
+        token = strtok_r(nullptr, " ", &savePtr);
+    }
+
+    for(uint64_t i = 0; i < numberOfNodes; i++) {
+        result.add(nodeIds[i], pages[i] * pageSize, isHuge);
+    }
+}
+
+/**
+ * @brief get memory-footprint of a process
+ *
+ * @param result reference for result-output
+ * @param pid id of the process. Use getpid() for the current process.
+ * @param error reference for error-output
+ *
+ * @return false, if the files of the process can not be read, else true
+ */
+bool
+getProcessMemory(ProcessMemoryInfo &result,
+                 const pid_t pid,
+                 ErrorContainer &error)
+{
+    const std::string basePath = "/proc/" + std::to_string(pid);
+    result = ProcessMemoryInfo();
+
+    std::vector<char> buffer(procReadBufferSize);
+
+    // pss and huge-pages are only available in the smaps-files. The rollup-file exist since
+    // kernel 4.14, else all entries of the much bigger smaps-file have to be summed up.
+    if(readSmapsFile(result, basePath + "/smaps_rollup", buffer) == false
+            && readSmapsFile(result, basePath + "/smaps", buffer) == false)
+    {
+        error.addMeesage("can not open file to read content: '" + basePath + "/smaps'");
+        error.addSolution("check if the process exist and if you have the permissions to read "
+                          "its memory-information");
+        return false;
+    }
+
+    // the status-file has the peak and the split into anonymous and file-backed memory
+    ProcLineReader status(basePath + "/status", buffer);
+    if(status.isOpen() == false)
+    {
+        error.addMeesage("can not open file to read content: '" + basePath + "/status'");
+        return false;
+    }
+    char* line = nullptr;
+    while((line = status.nextLine()) != nullptr)
+    {
+        uint64_t value = 0;
+        if(parseKibValue(value, line, "VmRSS:")) {
+            result.rss = value;
+        } else if(parseKibValue(value, line, "VmHWM:")) {
+            result.rssPeak = value;
+        } else if(parseKibValue(value, line, "RssAnon:")) {
+            result.rssAnon = value;
+        } else if(parseKibValue(value, line, "RssFile:")) {
+            result.rssFile = value;
+        } else if(parseKibValue(value, line, "HugetlbPages:")) {
+            result.hugetlbPages = value;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief get distribution of the resident memory of a process over the numa-nodes
+ *
+ * @param result reference for result-output
+ * @param pid id of the process. Use getpid() for the current process.
+ * @param error reference for error-output
+ *
+ * @return false, if the numa_maps-file can not be read, else true
+ */
+bool
+getProcessNodeDistribution(NodeMemoryDistribution &result,
+                           const pid_t pid,
+                           ErrorContainer &error)
+{
+    const std::string filePath = "/proc/" + std::to_string(pid) + "/numa_maps";
+    std::vector<char> buffer(procReadBufferSize);
+    ProcLineReader reader(filePath, buffer);
+    if(reader.isOpen() == false)
+    {
+        error.addMeesage("can not open file to read content: '" + filePath + "'");
+        error.addSolution("check if the kernel was build with numa-support");
+        return false;
+    }
+
+    result = NodeMemoryDistribution();
+    char* line = nullptr;
+    while((line = reader.nextLine()) != nullptr) {
+        addNumaMapsLine(result, line);
+    }
+
+    return true;
+}
+
+/**
+ * @brief get memory-footprint and node-distribution of an address-range of the current process.
+ *        The kernel only provides these values for whole mappings, so each mapping, which
+ *        overlaps the range, is counted completely. For a single big allocation with mmap this
+ *        is exactly the allocation.
+ *
+ * @param result reference for the memory-footprint. rssPeak is not available for a range.
+ * @param distribution reference for the node-distribution
+ * @param address begin of the range
+ * @param size size of the range in bytes
+ * @param error reference for error-output
+ *
+ * @return false, if the files of the process can not be read, else true
+ */
+bool
+getRangeMemory(ProcessMemoryInfo &result,
+               NodeMemoryDistribution &distribution,
+               const void* address,
+               const uint64_t size,
+               ErrorContainer &error)
+{
+    const uint64_t rangeBegin = reinterpret_cast<uint64_t>(address);
+    const uint64_t rangeEnd = rangeBegin + size;
+    result = ProcessMemoryInfo();
+    distribution = NodeMemoryDistribution();
+
+    const std::string smapsPath = "/proc/self/smaps";
+    std::vector<char> buffer(procReadBufferSize);
+    ProcLineReader smaps(smapsPath, buffer);
+    if(smaps.isOpen() == false)
+    {
+        error.addMeesage("can not open file to read content: '" + smapsPath + "'");
+        return false;
+    }
+
+    // header-lines of the mappings start with the address-range in lower-case hex, like
+    // "7f0000000000-7f0040000000 rw-p ...", and the value-lines with an upper-case key
+    std::vector<uint64_t> mappingStarts;
+    bool inRange = false;
+    char* line = nullptr;
+    while((line = smaps.nextLine()) != nullptr)
+    {
+        if(line[0] >= 'A' && line[0] <= 'Z')
+        {
+            if(inRange) {
+                addSmapsLine(result, line);
+            }
+            continue;
+        }
+
+        char* end = nullptr;
+        const uint64_t mappingBegin = strtoull(line, &end, 16);
+        if(*end != '-') {
+            continue;
+        }
+        const uint64_t mappingEnd = strtoull(end + 1, nullptr, 16);
+
+        inRange = mappingBegin < rangeEnd && mappingEnd > rangeBegin;
+        if(inRange) {
+            mappingStarts.push_back(mappingBegin);
+        }
+    }
+    result.rssFile = result.rss - std::min(result.rss, result.rssAnon);
+
+    // lines of the numa_maps-file start with the begin-address of the mapping
+    const std::string numaMapsPath = "/proc/self/numa_maps";
+    ProcLineReader numaMaps(numaMapsPath, buffer);
+    if(numaMaps.isOpen() == false)
+    {
+        error.addMeesage("can not open file to read content: '" + numaMapsPath + "'");
+        error.addSolution("check if the kernel was build with numa-support");
+        return false;
+    }
+    while((line = numaMaps.nextLine()) != nullptr)
+    {
+        const uint64_t mappingBegin = strtoull(line, nullptr, 16);
+        if(std::binary_search(mappingStarts.begin(), mappingStarts.end(), mappingBegin)) {
+            addNumaMapsLine(distribution, line);
+        }
+    }
+
+    return true;
+}
+
+} // namespace Kitsunemimi
@@ -7,6 +7,11 @@
  */
 
 #include <libKitsunemimiCpu/rapl.h>
+#include <libKitsunemimiCpu/msr.h>
+#include <libKitsunemimiCpu/tsc_clock.h>
+
+#include <cstring>
+#include <utility>
 
 typedef std::chrono::milliseconds chronoMilliSec;
 typedef std::chrono::microseconds chronoMicroSec;
@@ -58,6 +63,14 @@ namespace Kitsunemimi
 #define TIME_UNIT_OFFSET               0x10
 #define TIME_UNIT_MASK                 0xF000
 
+/* AMD RAPL Domains (Zen and newer) */
+#define MSR_AMD_RAPL_POWER_UNIT        0xC0010299
+#define MSR_AMD_CORE_ENERGY_STATUS     0xC001029A
+#define MSR_AMD_PKG_ENERGY_STATUS      0xC001029B
+
+/* all energy-counter are 32bit wide and overflow */
+#define ENERGY_COUNTER_MASK            0xFFFFFFFF
+
 #define SIGNATURE_MASK                 0xFFFF0
 #define IVYBRIDGE_E                    0x306F0
 #define SANDYBRIDGE_E                  0x206D0
@@ -70,6 +83,50 @@ Rapl::Rapl(const uint64_t threadId)
     m_threadId = threadId;
 }
 
+/**
+ * @brief destructor
+ */
+Rapl::~Rapl()
+{
+    if(m_fd >= 0) {
+        close(m_fd);
+    }
+}
+
+/**
+ * @brief move-constructor, which takes over the msr-file of the other instance
+ */
+Rapl::Rapl(Rapl &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+/**
+ * @brief move-assignment, which takes over the msr-file of the other instance
+ */
+Rapl&
+Rapl::operator=(Rapl &&other) noexcept
+{
+    if(this == &other) {
+        return *this;
+    }
+
+    if(m_fd >= 0) {
+        close(m_fd);
+    }
+
+    m_threadId = other.m_threadId;
+    m_fd = other.m_fd;
+    m_isInit = other.m_isInit;
+    m_lastState = other.m_lastState;
+    m_info = other.m_info;
+
+    other.m_fd = -1;
+    other.m_isInit = false;
+
+    return *this;
+}
+
 /**
  * @brief initalize rapl-class by open and reading msr-file
  *
@@ -92,6 +149,50 @@ Rapl::initRapl(ErrorContainer &error)
         return false;
     }
 
+    // the msr-addresses are different for each vendor
+    m_info.vendor = checkVendor();
+    switch(m_info.vendor)
+    {
+        case INTEL_CPU_VENDOR:
+            initIntel();
+            break;
+        case AMD_CPU_VENDOR:
+            if(initAmd(error) == false)
+            {
+                close(m_fd);
+                m_fd = -1;
+                return false;
+            }
+            break;
+        case UNKNOWN_CPU_VENDOR:
+            error.addMeesage("Failed to initialize rapl, because the vendor of the cpu is "
+                             "not supported");
+            error.addSolution("Use an Intel or AMD cpu");
+            close(m_fd);
+            m_fd = -1;
+            return false;
+    }
+
+    // create inital state
+    RaplState initialState;
+    initialState.timeStamp = TscClock::getInstance()->getTimestamp();
+    m_lastState = initialState;
+    calculateDiff();
+
+    m_isInit = true;
+
+    return true;
+}
+
+/**
+ * @brief read units and power-info of the msr-registers of Intel cpus
+ */
+void
+Rapl::initIntel()
+{
+    m_info.supportPP0 = true;
+    m_info.supportDram = true;
+
     // check if cpu supports pp1-value
     m_info.supportPP1 = checkPP1();
 
@@ -107,14 +208,51 @@ Rapl::initRapl(ErrorContainer &error)
     m_info.minimum_power = m_info.power_units * ((double)((raw_value >> 16) & 0x7fff));
     m_info.maximum_power = m_info.power_units * ((double)((raw_value >> 32) & 0x7fff));
     m_info.time_window = m_info.time_units * ((double)((raw_value >> 48) & 0x7fff));
+}
 
-    // create inital state
-    RaplState initialState;
-    initialState.timeStamp = std::chrono::system_clock::now();
-    m_lastState = initialState;
-    calculateDiff();
+/**
+ * @brief read units of the msr-registers of AMD cpus. AMD provides no pp0-, pp1-, dram- and
+ *        power-info-registers, but an energy-counter for each physical core.
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if the cpu doesn't support rapl, like AMD cpus before Zen, else true
+ */
+bool
+Rapl::initAmd(ErrorContainer &error)
+{
+    // rapl-support is reported by bit 14 of edx of the extended cpuid-leaf 0x80000007
+    uint32_t eax = 0;
+    uint32_t ebx = 0;
+    uint32_t ecx = 0;
+    uint32_t edx = 0;
+    __asm__("cpuid;" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "0"(0x80000000));
+    if(eax >= 0x80000007) {
+        __asm__("cpuid;" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "0"(0x80000007));
+    } else {
+        edx = 0;
+    }
 
-    m_isInit = true;
+    if((edx & (1 << 14)) == 0)
+    {
+        error.addMeesage("Failed to initialize rapl, because the AMD cpu doesn't support rapl");
+        error.addSolution("Rapl is only available on AMD cpus based on Zen or newer");
+        return false;
+    }
+
+    // the unit-register has the same layout like the one of Intel
+    uint64_t raw_value = 0;
+    if(readMsrFd(raw_value, m_fd, MSR_AMD_RAPL_POWER_UNIT, error) == false)
+    {
+        error.addMeesage("Failed to initialize rapl, because the power-unit-register of the "
+                         "AMD cpu can not be read");
+        return false;
+    }
+
+    m_info.supportCore = true;
+    m_info.power_units = pow(0.5, (double) (raw_value & 0xf));
+    m_info.energy_units = pow(0.5, (double) ((raw_value >> 8) & 0x1f));
+    m_info.time_units = pow(0.5, (double) ((raw_value >> 16) & 0xf));
 
     return true;
 }
@@ -130,6 +268,42 @@ Rapl::isActive() const
     return m_isInit;
 }
 
+/**
+ * @brief check vendor of the cpu based on the vendor-string of cpuid
+ *
+ * @return vendor of the cpu
+ */
+CpuVendor
+Rapl::checkVendor()
+{
+    uint32_t eax = 0;
+    uint32_t ebx = 0;
+    uint32_t ecx = 0;
+    uint32_t edx = 0;
+    __asm__("cpuid;" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "0"(0));
+
+    // vendor-string is stored in the order ebx, edx, ecx
+    char vendor[13];
+    memcpy(&vendor[0], &ebx, 4);
+    memcpy(&vendor[4], &edx, 4);
+    memcpy(&vendor[8], &ecx, 4);
+    vendor[12] = '\0';
+
+    const std::string vendorString(vendor);
+    if(vendorString == "GenuineIntel") {
+        return INTEL_CPU_VENDOR;
+    }
+
+    // Hygon cpus are based on AMD Zen and use the same registers
+    if(vendorString == "AuthenticAMD"
+            || vendorString == "HygonGenuine")
+    {
+        return AMD_CPU_VENDOR;
+    }
+
+    return UNKNOWN_CPU_VENDOR;
+}
+
 /**
  * @brief check if the pp1-energy-value is supported by the cpu
  *
@@ -162,18 +336,8 @@ Rapl::checkPP1()
 bool
 Rapl::openMSR(ErrorContainer &error)
 {
-    const std::string path = "/dev/cpu/" + std::to_string(m_threadId) + "/msr";
-    m_fd = open(path.c_str(), O_RDONLY);
-    if(m_fd <= 0)
-    {
-        error.addMeesage("Failed to open path: \"" + path + "\"");
-        error.addSolution("Maybe the msr-kernel-module still have to be loaded with "
-                          "\"modporobe msr\" or \"modprobe intel_rapl_msr\"");
-        error.addSolution("Check if you have read-permissions to the path: \"" + path + "\"");
-        return false;
-    }
-
-    return true;
+    m_fd = openMsr(m_threadId, false, error);
+    return m_fd >= 0;
 }
 
 /**
@@ -184,12 +348,12 @@ Rapl::openMSR(ErrorContainer &error)
  * @return requeste value, if successful, else 0
  */
 uint64_t
-Rapl::readMSR(const int32_t offset)
+Rapl::readMSR(const uint32_t offset)
 {
-    uint64_t data;
-    if(pread(m_fd, &data, sizeof(data), offset) != sizeof(data))
+    uint64_t data = 0;
+    ErrorContainer error;
+    if(readMsrFd(data, m_fd, offset, error) == false)
     {
-        ErrorContainer error;
         error.addMeesage("can not read MSR of cpu even the msr-file is open");
         LOG_ERROR(error);
         return 0;
@@ -209,24 +373,32 @@ Rapl::calculateDiff()
     RaplState state;
 
     // read data from msr
-    state.pkg = readMSR(MSR_PKG_ENERGY_STATUS);
-    state.pp0 = readMSR(MSR_PP0_ENERGY_STATUS);
-    state.dram = readMSR(MSR_DRAM_ENERGY_STATUS);
-    if(m_info.supportPP1) {
-        state.pp1 = readMSR(MSR_PP1_ENERGY_STATUS);
+    if(m_info.vendor == AMD_CPU_VENDOR)
+    {
+        state.pkg = readMSR(MSR_AMD_PKG_ENERGY_STATUS);
+        state.core = readMSR(MSR_AMD_CORE_ENERGY_STATUS);
+    }
+    else
+    {
+        state.pkg = readMSR(MSR_PKG_ENERGY_STATUS);
+        state.pp0 = readMSR(MSR_PP0_ENERGY_STATUS);
+        state.dram = readMSR(MSR_DRAM_ENERGY_STATUS);
+        if(m_info.supportPP1) {
+            state.pp1 = readMSR(MSR_PP1_ENERGY_STATUS);
+        }
     }
-    state.timeStamp = std::chrono::system_clock::now();
+    state.timeStamp = TscClock::getInstance()->getTimestamp();
 
     // create diff to last run
     RaplDiff diff;
-    diff.pkgDiff = m_info.energy_units * static_cast<double>(state.pkg - m_lastState.pkg);
-    diff.pp0Diff = m_info.energy_units * static_cast<double>(state.pp0 - m_lastState.pp0);
-    diff.pp1Diff = m_info.energy_units * static_cast<double>(state.pp1 - m_lastState.pp1);
-    diff.dramDiff = m_info.energy_units * static_cast<double>(state.dram - m_lastState.dram);
+    diff.pkgDiff = calcEnergy(state.pkg, m_lastState.pkg);
+    diff.pp0Diff = calcEnergy(state.pp0, m_lastState.pp0);
+    diff.pp1Diff = calcEnergy(state.pp1, m_lastState.pp1);
+    diff.dramDiff = calcEnergy(state.dram, m_lastState.dram);
+    diff.coreDiff = calcEnergy(state.core, m_lastState.core);
 
     // calculate time-difference to last run and convert it into seconds
-    uint64_t nanoSec = std::chrono::duration_cast<chronoNanoSec>(state.timeStamp -
-                                                                 m_lastState.timeStamp).count();
+    const uint64_t nanoSec = state.timeStamp - m_lastState.timeStamp;
     const double nanoSecPerSec = 1000000000.0;
     diff.time = static_cast<double>(nanoSec) / nanoSecPerSec;
 
@@ -235,6 +407,7 @@ Rapl::calculateDiff()
     diff.pp0Avg = static_cast<double>(diff.pp0Diff) / diff.time;
     diff.pp1Avg = static_cast<double>(diff.pp1Diff) / diff.time;
     diff.dramAvg = static_cast<double>(diff.dramDiff) / diff.time;
+    diff.coreAvg = static_cast<double>(diff.coreDiff) / diff.time;
 
     // update internal state
     m_lastState = state;
@@ -242,6 +415,24 @@ Rapl::calculateDiff()
     return diff;
 }
 
+/**
+ * @brief convert the difference of two counter-values into energy
+ *
+ * @param current current counter-value
+ * @param last last counter-value
+ *
+ * @return energy in Ws
+ */
+double
+Rapl::calcEnergy(const uint64_t current,
+                 const uint64_t last) const
+{
+    // the counters are only 32bit wide, so an overflow between two reads has to be handled
+    const uint64_t diff = ((current & ENERGY_COUNTER_MASK) - (last & ENERGY_COUNTER_MASK))
+                          & ENERGY_COUNTER_MASK;
+    return m_info.energy_units * static_cast<double>(diff);
+}
+
 /**
  * @brief get global info-data
  *
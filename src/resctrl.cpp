@@ -0,0 +1,752 @@
+/**
+ *  @file       resctrl.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/resctrl.h>
+
+#include <libKitsunemimiCommon/methods/string_methods.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <sys/mount.h>
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief read first line of a file of the resctrl-filesystem
+ *
+ * @return false, if file doesn't exist or is empty, else true
+ */
+bool
+readResctrlLine(std::string &result,
+                const std::string &filePath)
+{
+    std::ifstream inFile(filePath);
+    if(inFile.is_open() == false) {
+        return false;
+    }
+
+    std::getline(inFile, result);
+    Kitsunemimi::trim(result);
+
+    return result != "";
+}
+
+/**
+ * @brief parse a number, which was read from the resctrl-filesystem
+ *
+ * @param result reference for the number
+ * @param text text to parse, which must contain only the number
+ * @param base 10 for decimal and 16 for hex-values, like bitmasks
+ *
+ * @return false, if the text is not a number, else true
+ */
+bool
+parseResctrlNumber(uint64_t &result,
+                   const std::string &text,
+                   const int base)
+{
+    char* end = nullptr;
+    result = strtoull(text.c_str(), &end, base);
+    return end != text.c_str()
+           && *end == '\0';
+}
+
+/**
+ * @brief read a number of a file of the resctrl-filesystem
+ *
+ * @param result reference for the number
+ * @param filePath path to the file
+ * @param base 10 for decimal and 16 for hex-values, like bitmasks
+ *
+ * @return false, if file doesn't exist or doesn't contain a number, else true
+ */
+bool
+readResctrlNumber(uint64_t &result,
+                  const std::string &filePath,
+                  const int base)
+{
+    std::string content = "";
+    if(readResctrlLine(content, filePath) == false) {
+        return false;
+    }
+
+    return parseResctrlNumber(result, content, base);
+}
+
+/**
+ * @brief write content into a file of the resctrl-filesystem
+ */
+bool
+writeResctrlFile(const std::string &filePath,
+                 const std::string &content,
+                 ErrorContainer &error)
+{
+    std::ofstream outFile(filePath);
+    if(outFile.is_open() == false)
+    {
+        error.addMeesage("can not open file to write content: '" + filePath + "'");
+        error.addSolution("check if you have write-permissions to the file '" + filePath + "'");
+        return false;
+    }
+
+    // invalid values are rejected by the kernel while flushing
+    outFile << content;
+    outFile.flush();
+    if(outFile.fail())
+    {
+        error.addMeesage("Failed to write '" + content + "' into file '" + filePath + "'");
+        error.addSolution("check the file 'info/last_cmd_status' of the resctrl-filesystem");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief constructor
+ *
+ * @param rootPath path, where the resctrl-filesystem is mounted, normally "/sys/fs/resctrl"
+ */
+Resctrl::Resctrl(const std::string &rootPath)
+{
+    m_rootPath = rootPath;
+}
+
+/**
+ * @brief mount the resctrl-filesystem
+ *
+ * @param rootPath target-directory, normally "/sys/fs/resctrl"
+ * @param error reference for error-output
+ *
+ * @return false, if mount failed, else true. It is also true, if already mounted.
+ */
+bool
+Resctrl::mountResctrl(const std::string &rootPath,
+                      ErrorContainer &error)
+{
+    if(mount("resctrl", rootPath.c_str(), "resctrl", 0, nullptr) == 0
+            || errno == EBUSY)
+    {
+        return true;
+    }
+
+    error.addMeesage("Failed to mount resctrl-filesystem at '"
+                     + rootPath
+                     + "': "
+                     + std::string(strerror(errno)));
+    error.addSolution("check if the cpu supports RDT and the kernel was build with "
+                      "CONFIG_X86_CPU_RESCTRL");
+    error.addSolution("mounting requires CAP_SYS_ADMIN");
+    return false;
+}
+
+/**
+ * @brief read the supported features from the info-directory
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if the resctrl-filesystem is not mounted, else true
+ */
+bool
+Resctrl::initResctrl(ErrorContainer &error)
+{
+    // check if already initialized
+    if(m_isInit)
+    {
+        LOG_WARNING("this resctrl-class was already successfully initialized");
+        return true;
+    }
+
+    const std::string infoPath = m_rootPath + "/info";
+    if(std::filesystem::is_directory(infoPath) == false)
+    {
+        error.addMeesage("No resctrl-filesystem found at '" + m_rootPath + "'");
+        error.addSolution("mount the filesystem with mountResctrl or "
+                          "\"mount -t resctrl resctrl /sys/fs/resctrl\"");
+        return false;
+    }
+
+    m_info.supportL3 = readResctrlNumber(m_info.cbmMask, infoPath + "/L3/cbm_mask", 16);
+    if(m_info.supportL3)
+    {
+        readResctrlNumber(m_info.minCbmBits, infoPath + "/L3/min_cbm_bits", 10);
+        readResctrlNumber(m_info.numberOfL3Closids, infoPath + "/L3/num_closids", 10);
+    }
+
+    m_info.supportMba = readResctrlNumber(m_info.minBandwidth,
+                                          infoPath + "/MB/min_bandwidth",
+                                          10);
+    if(m_info.supportMba)
+    {
+        readResctrlNumber(m_info.bandwidthGranularity, infoPath + "/MB/bandwidth_gran", 10);
+        readResctrlNumber(m_info.numberOfMbaClosids, infoPath + "/MB/num_closids", 10);
+    }
+
+    m_info.supportMonitoring = readResctrlNumber(m_info.numberOfRmids,
+                                                 infoPath + "/L3_MON/num_rmids",
+                                                 10);
+    if(m_info.supportMonitoring)
+    {
+        std::ifstream inFile(infoPath + "/L3_MON/mon_features");
+        std::string feature;
+        while(inFile >> feature) {
+            m_info.monitoringFeatures.push_back(feature);
+        }
+    }
+
+    m_isInit = true;
+
+    return true;
+}
+
+/**
+ * @brief get supported features of the resctrl-filesystem
+ */
+ResctrlInfo
+Resctrl::getInfo() const
+{
+    return m_info;
+}
+
+/**
+ * @brief get path of a resource-group, where an empty name is the default-group
+ */
+const std::string
+Resctrl::getGroupPath(const std::string &groupName) const
+{
+    if(groupName == "") {
+        return m_rootPath;
+    }
+
+    return m_rootPath + "/" + groupName;
+}
+
+/**
+ * @brief get names of all resource-groups without the default-group
+ *
+ * @param result reference for result-output
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized, else true
+ */
+bool
+Resctrl::getGroups(std::vector<std::string> &result,
+                   ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to get resctrl-groups, because resctrl is not initialized");
+        return false;
+    }
+
+    result.clear();
+    std::error_code ec;
+    for(const auto &entry : std::filesystem::directory_iterator(m_rootPath, ec))
+    {
+        const std::string name = entry.path().filename().string();
+        if(entry.is_directory() == false
+                || name == "info"
+                || name == "mon_groups"
+                || name == "mon_data")
+        {
+            continue;
+        }
+        result.push_back(name);
+    }
+    std::sort(result.begin(), result.end());
+
+    return true;
+}
+
+/**
+ * @brief create a new resource-group, which gets its own closid
+ *
+ * @param groupName name of the new group
+ * @param error reference for error-output
+ *
+ * @return false, if group can not be created, for example because all closids are in use,
+ *         else true
+ */
+bool
+Resctrl::createGroup(const std::string &groupName,
+                     ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to create resctrl-group, because resctrl is not initialized");
+        return false;
+    }
+
+    std::error_code ec;
+    if(groupName == ""
+            || std::filesystem::create_directory(getGroupPath(groupName), ec) == false)
+    {
+        error.addMeesage("Failed to create resctrl-group '" + groupName + "'");
+        error.addSolution("check if the group already exist or all closids are already in use");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief remove a resource-group. Its tasks and cpu-threads fall back to the default-group.
+ *
+ * @param groupName name of the group
+ * @param error reference for error-output
+ *
+ * @return false, if group can not be removed, else true
+ */
+bool
+Resctrl::removeGroup(const std::string &groupName,
+                     ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to remove resctrl-group, because resctrl is not initialized");
+        return false;
+    }
+
+    // the kernel only allows rmdir on the group-directory and not deleting its files
+    std::error_code ec;
+    if(groupName == ""
+            || std::filesystem::remove(getGroupPath(groupName), ec) == false)
+    {
+        error.addMeesage("Failed to remove resctrl-group '" + groupName + "'");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief read the schemata-file of a group, which has lines like "L3:0=7ff;1=7ff"
+ *
+ * @param result reference for the values for each resource and domain
+ * @param groupName name of the group
+ * @param error reference for error-output
+ *
+ * @return false, if the file can not be read, else true
+ */
+bool
+Resctrl::readSchemataLines(std::map<std::string, std::map<uint64_t, std::string>> &result,
+                           const std::string &groupName,
+                           ErrorContainer &error)
+{
+    const std::string filePath = getGroupPath(groupName) + "/schemata";
+    std::ifstream inFile(filePath);
+    if(inFile.is_open() == false)
+    {
+        error.addMeesage("can not open file to read content: '" + filePath + "'");
+        return false;
+    }
+
+    result.clear();
+    std::string line;
+    while(std::getline(inFile, line))
+    {
+        const size_t colon = line.find(':');
+        if(colon == std::string::npos) {
+            continue;
+        }
+        std::string resource = line.substr(0, colon);
+        Kitsunemimi::trim(resource);
+
+        std::vector<std::string> domains;
+        Kitsunemimi::splitStringByDelimiter(domains, line.substr(colon + 1), ';');
+        for(const std::string &domain : domains)
+        {
+            const size_t equal = domain.find('=');
+            if(equal == std::string::npos) {
+                continue;
+            }
+            std::string value = domain.substr(equal + 1);
+            std::string id = domain.substr(0, equal);
+            Kitsunemimi::trim(value);
+            Kitsunemimi::trim(id);
+
+            uint64_t domainId = 0;
+            if(parseResctrlNumber(domainId, id, 10) == false)
+            {
+                error.addMeesage("File '" + filePath + "' contains broken line '" + line + "'");
+                return false;
+            }
+            result[resource][domainId] = value;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief update the value of a single resource and domain in the schemata-file of a group.
+ *        All other lines are written back unchanged.
+ */
+bool
+Resctrl::updateSchemata(const std::string &groupName,
+                        const std::string &resource,
+                        const uint64_t domainId,
+                        const std::string &value,
+                        ErrorContainer &error)
+{
+    std::map<std::string, std::map<uint64_t, std::string>> schemata;
+    if(readSchemataLines(schemata, groupName, error) == false) {
+        return false;
+    }
+    schemata[resource][domainId] = value;
+
+    std::string content = "";
+    for(const auto &[name, domains] : schemata)
+    {
+        content += name + ":";
+        bool first = true;
+        for(const auto &[id, domainValue] : domains)
+        {
+            content += (first ? "" : ";") + std::to_string(id) + "=" + domainValue;
+            first = false;
+        }
+        content += "\n";
+    }
+
+    return writeResctrlFile(getGroupPath(groupName) + "/schemata", content, error);
+}
+
+/**
+ * @brief get the L3-masks and memory-bandwidths of a group
+ *
+ * @param result reference for result-output
+ * @param groupName name of the group
+ * @param error reference for error-output
+ *
+ * @return false, if the schemata can not be read, else true
+ */
+bool
+Resctrl::getSchemata(ResctrlSchemata &result,
+                     const std::string &groupName,
+                     ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to get resctrl-schemata, because resctrl is not initialized");
+        return false;
+    }
+
+    std::map<std::string, std::map<uint64_t, std::string>> schemata;
+    if(readSchemataLines(schemata, groupName, error) == false) {
+        return false;
+    }
+
+    result = ResctrlSchemata();
+    bool success = true;
+    for(const auto &[id, value] : schemata["L3"]) {
+        success &= parseResctrlNumber(result.l3Masks[id], value, 16);
+    }
+    for(const auto &[id, value] : schemata["MB"]) {
+        success &= parseResctrlNumber(result.mbaPercent[id], value, 10);
+    }
+
+    if(success == false)
+    {
+        error.addMeesage("Schemata of resctrl-group '" + groupName + "' contains broken values");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief set the capacity-bitmask of the L3-cache of a group for a cache-domain
+ *
+ * @param groupName name of the group
+ * @param domainId id of the cache-domain
+ * @param mask new bitmask, which has to consist of contiguous bits
+ * @param error reference for error-output
+ *
+ * @return false, if L3-allocation is not supported or the mask is invalid, else true
+ */
+bool
+Resctrl::setL3Mask(const std::string &groupName,
+                   const uint64_t domainId,
+                   const uint64_t mask,
+                   ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to set L3-mask, because resctrl is not initialized");
+        return false;
+    }
+
+    if(m_info.supportL3 == false)
+    {
+        error.addMeesage("Failed to set L3-mask, because L3-allocation is not supported");
+        return false;
+    }
+
+    // the hardware only accepts contiguous bits within the mask of the cache
+    const uint64_t shifted = mask >> (mask == 0 ? 0 : __builtin_ctzll(mask));
+    if(mask == 0
+            || (mask & ~m_info.cbmMask) != 0
+            || (shifted & (shifted + 1)) != 0
+            || static_cast<uint64_t>(__builtin_popcountll(mask)) < m_info.minCbmBits)
+    {
+        std::stringstream stream;
+        stream << std::hex << mask;
+        error.addMeesage("Failed to set L3-mask, because mask '" + stream.str() + "' is invalid");
+        error.addSolution("use at least " + std::to_string(m_info.minCbmBits)
+                          + " contiguous bits within the mask of the cache");
+        return false;
+    }
+
+    std::stringstream stream;
+    stream << std::hex << mask;
+    return updateSchemata(groupName, "L3", domainId, stream.str(), error);
+}
+
+/**
+ * @brief set the memory-bandwidth of a group for a cache-domain
+ *
+ * @param groupName name of the group
+ * @param domainId id of the cache-domain
+ * @param percent new bandwidth in percent, which is rounded by the kernel to the granularity
+ * @param error reference for error-output
+ *
+ * @return false, if memory-bandwidth-allocation is not supported or the value is invalid,
+ *         else true
+ */
+bool
+Resctrl::setMemoryBandwidth(const std::string &groupName,
+                            const uint64_t domainId,
+                            const uint64_t percent,
+                            ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to set memory-bandwidth, because resctrl is not initialized");
+        return false;
+    }
+
+    if(m_info.supportMba == false)
+    {
+        error.addMeesage("Failed to set memory-bandwidth, because memory-bandwidth-allocation "
+                         "is not supported");
+        return false;
+    }
+
+    if(percent < m_info.minBandwidth
+            || percent > 100)
+    {
+        error.addMeesage("Failed to set memory-bandwidth, because '"
+                         + std::to_string(percent)
+                         + "' percent is out of range");
+        error.addSolution("use a value between " + std::to_string(m_info.minBandwidth)
+                          + " and 100");
+        return false;
+    }
+
+    return updateSchemata(groupName, "MB", domainId, std::to_string(percent), error);
+}
+
+/**
+ * @brief move a task into a group
+ *
+ * @param groupName name of the group
+ * @param pid id of the task, which can also be the id of a single thread
+ * @param error reference for error-output
+ *
+ * @return false, if the task can not be moved, else true
+ */
+bool
+Resctrl::assignTask(const std::string &groupName,
+                    const pid_t pid,
+                    ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to assign task, because resctrl is not initialized");
+        return false;
+    }
+
+    return writeResctrlFile(getGroupPath(groupName) + "/tasks", std::to_string(pid), error);
+}
+
+/**
+ * @brief assign cpu-threads to a group, so all tasks of the default-group, which run on these
+ *        threads, use the allocation of the group
+ *
+ * @param groupName name of the group
+ * @param threads cpu-threads to assign
+ * @param error reference for error-output
+ *
+ * @return false, if the threads can not be assigned, else true
+ */
+bool
+Resctrl::assignCpuThreads(const std::string &groupName,
+                          const CpuSet &threads,
+                          ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to assign cpu-threads, because resctrl is not initialized");
+        return false;
+    }
+
+    return writeResctrlFile(getGroupPath(groupName) + "/cpus_list", threads.toString(), error);
+}
+
+/**
+ * @brief read the monitoring-counters of a group for each cache-domain
+ *
+ * @param result reference for result-output
+ * @param groupName name of the group
+ * @param error reference for error-output
+ *
+ * @return false, if monitoring is not supported, else true
+ */
+bool
+Resctrl::getMonitorValues(std::vector<ResctrlMonitorValues> &result,
+                          const std::string &groupName,
+                          ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to read resctrl-monitoring, because resctrl is not initialized");
+        return false;
+    }
+
+    if(m_info.supportMonitoring == false)
+    {
+        error.addMeesage("Failed to read resctrl-monitoring, because it is not supported");
+        return false;
+    }
+
+    // directories have the form "mon_L3_<domain>"
+    result.clear();
+    const std::string monPath = getGroupPath(groupName) + "/mon_data";
+    std::error_code ec;
+    for(const auto &entry : std::filesystem::directory_iterator(monPath, ec))
+    {
+        const std::string name = entry.path().filename().string();
+        if(name.compare(0, 7, "mon_L3_") != 0) {
+            continue;
+        }
+
+        // counters contain "Unavailable", while the rmid is not yet valid, so they stay zero
+        ResctrlMonitorValues values;
+        const std::string path = entry.path().string();
+        if(parseResctrlNumber(values.domainId, name.substr(7), 10) == false) {
+            continue;
+        }
+        readResctrlNumber(values.llcOccupancy, path + "/llc_occupancy", 10);
+        readResctrlNumber(values.mbmTotalBytes, path + "/mbm_total_bytes", 10);
+        readResctrlNumber(values.mbmLocalBytes, path + "/mbm_local_bytes", 10);
+        result.push_back(values);
+    }
+
+    if(ec)
+    {
+        error.addMeesage("Failed to read monitoring-data of resctrl-group '" + groupName + "'");
+        return false;
+    }
+
+    std::sort(result.begin(),
+              result.end(),
+              [](const ResctrlMonitorValues &a, const ResctrlMonitorValues &b) {
+        return a.domainId < b.domainId;
+    });
+
+    return true;
+}
+
+/**
+ * @brief constructor
+ */
+ResctrlSampler::ResctrlSampler() {}
+
+/**
+ * @brief read initial state of the monitoring-counters of a group
+ *
+ * @param resctrl pointer to an initialized resctrl-object
+ * @param groupName name of the group
+ * @param error reference for error-output
+ *
+ * @return false, if the counters can not be read, else true
+ */
+bool
+ResctrlSampler::initSampler(Resctrl* resctrl,
+                            const std::string &groupName,
+                            ErrorContainer &error)
+{
+    // check if already initialized
+    if(m_isInit)
+    {
+        LOG_WARNING("this resctrl-sampler was already successfully initialized");
+        return true;
+    }
+
+    if(resctrl->getMonitorValues(m_lastState, groupName, error) == false)
+    {
+        error.addMeesage("Failed to initialize resctrl-sampler");
+        return false;
+    }
+
+    m_resctrl = resctrl;
+    m_groupName = groupName;
+    m_isInit = true;
+
+    return true;
+}
+
+/**
+ * @brief get the memory-traffic since the last call and the current cache-occupancy
+ *
+ * @param result reference for result-output
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized or counters can not be read, else true
+ */
+bool
+ResctrlSampler::calculateDiff(std::vector<ResctrlMonitorValues> &result,
+                              ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to calculate resctrl-diff, because sampler is not initialized");
+        return false;
+    }
+
+    std::vector<ResctrlMonitorValues> current;
+    if(m_resctrl->getMonitorValues(current, m_groupName, error) == false) {
+        return false;
+    }
+
+    // occupancy is a current value and only the traffic-counters are cumulative
+    result = current;
+    for(ResctrlMonitorValues &values : result)
+    {
+        for(const ResctrlMonitorValues &last : m_lastState)
+        {
+            if(last.domainId != values.domainId) {
+                continue;
+            }
+            values.mbmTotalBytes -= std::min(values.mbmTotalBytes, last.mbmTotalBytes);
+            values.mbmLocalBytes -= std::min(values.mbmLocalBytes, last.mbmLocalBytes);
+        }
+    }
+
+    m_lastState = current;
+
+    return true;
+}
+
+} // namespace Kitsunemimi
@@ -0,0 +1,1107 @@
+/**
+ *  @file       sample_recorder.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/sample_recorder.h>
+#include <libKitsunemimiCpu/cpu.h>
+#include <libKitsunemimiCpu/tsc_clock.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace Kitsunemimi
+{
+
+const char sampleFileMagic[8] = {'K', 'S', 'A', 'M', 'P', 'L', 'E', '\0'};
+const uint32_t sampleFileVersion = 1;
+
+// maximum number of samples of a block, where each block can be decoded independently
+const uint64_t sampleBlockSize = 1024;
+
+// the file is extended in steps of this size, to avoid a resize of the mapping for each block
+const uint64_t sampleFileGrowSize = 64 * 1024 * 1024;
+
+// worst case of a compressed value: 2 control-bits, 5 bits leading zeros, 6 bits length and
+// 64 bits of the value
+const uint64_t maxBitsPerSample = 77;
+
+/**
+ * @brief write the lower bits of a value into a stream, beginning with the most significant bit
+ *
+ * @param stream preallocated and zeroed stream
+ * @param bitPos reference for the current position in the stream, which is moved forward
+ * @param value value to write
+ * @param numberOfBits number of bits of the value to write (1 - 64)
+ */
+inline void
+writeSampleBits(uint64_t* stream,
+                uint64_t &bitPos,
+                const uint64_t value,
+                const uint32_t numberOfBits)
+{
+    const uint64_t bits = numberOfBits == 64 ? value : value & ((1ULL << numberOfBits) - 1);
+    const uint64_t word = bitPos >> 6;
+    const uint32_t freeBits = 64 - (bitPos & 63);
+
+    if(numberOfBits <= freeBits)
+    {
+        stream[word] |= bits << (freeBits - numberOfBits);
+    }
+    else
+    {
+        stream[word] |= bits >> (numberOfBits - freeBits);
+        stream[word + 1] |= bits << (64 - (numberOfBits - freeBits));
+    }
+
+    bitPos += numberOfBits;
+}
+
+/**
+ * @brief read bits from a stream, which was written by writeSampleBits. Bits behind the end of
+ *        the stream are read as zero, so a broken block, which claims more samples than its
+ *        stream contains, can not be read behind the mapping.
+ *
+ * @param stream stream to read
+ * @param numberOfWords number of words of the stream
+ * @param bitPos reference for the current position in the stream, which is moved forward
+ * @param numberOfBits number of bits to read (1 - 64)
+ *
+ * @return read bits
+ */
+inline uint64_t
+readSampleBits(const uint64_t* stream,
+               const uint64_t numberOfWords,
+               uint64_t &bitPos,
+               const uint32_t numberOfBits)
+{
+    const uint64_t word = bitPos >> 6;
+    const uint32_t offset = bitPos & 63;
+    const uint32_t freeBits = 64 - offset;
+    bitPos += numberOfBits;
+
+    if(word >= numberOfWords) {
+        return 0;
+    }
+
+    uint64_t bits = (stream[word] << offset) >> (64 - numberOfBits);
+    if(numberOfBits > freeBits
+            && word + 1 < numberOfWords)
+    {
+        bits |= stream[word + 1] >> (64 - (numberOfBits - freeBits));
+    }
+
+    return bits;
+}
+
+/**
+ * @brief check if a signed value fits into a number of bits
+ */
+inline bool
+fitsIntoSampleBits(const int64_t value,
+                   const uint32_t numberOfBits)
+{
+    const int64_t limit = 1LL << (numberOfBits - 1);
+    return value >= -limit && value < limit;
+}
+
+/**
+ * @brief extend the sign of a value, which was read with a number of bits
+ */
+inline int64_t
+extendSampleSign(const uint64_t bits,
+                 const uint32_t numberOfBits)
+{
+    const uint32_t shift = 64 - numberOfBits;
+    return static_cast<int64_t>(bits << shift) >> shift;
+}
+
+/**
+ * @brief decoder for the delta-of-delta-compressed timestamps of a block
+ */
+struct SampleTimeDecoder
+{
+    const uint64_t* stream = nullptr;
+    uint64_t numberOfWords = 0;
+    uint64_t bitPos = 0;
+    uint64_t last = 0;
+    int64_t lastDelta = 0;
+    bool isFirst = true;
+
+    uint64_t next()
+    {
+        if(isFirst)
+        {
+            isFirst = false;
+            last = readSampleBits(stream, numberOfWords, bitPos, 64);
+            return last;
+        }
+
+        int64_t deltaOfDelta = 0;
+        if(readSampleBits(stream, numberOfWords, bitPos, 1) == 0) {
+            deltaOfDelta = 0;
+        } else if(readSampleBits(stream, numberOfWords, bitPos, 1) == 0) {
+            deltaOfDelta = extendSampleSign(readSampleBits(stream, numberOfWords, bitPos, 16), 16);
+        } else if(readSampleBits(stream, numberOfWords, bitPos, 1) == 0) {
+            deltaOfDelta = extendSampleSign(readSampleBits(stream, numberOfWords, bitPos, 24), 24);
+        } else if(readSampleBits(stream, numberOfWords, bitPos, 1) == 0) {
+            deltaOfDelta = extendSampleSign(readSampleBits(stream, numberOfWords, bitPos, 32), 32);
+        } else {
+            deltaOfDelta = static_cast<int64_t>(readSampleBits(stream, numberOfWords, bitPos, 64));
+        }
+
+        lastDelta += deltaOfDelta;
+        last += static_cast<uint64_t>(lastDelta);
+        return last;
+    }
+};
+
+/**
+ * @brief decoder for the xor-compressed values of a column of a block
+ */
+struct SampleValueDecoder
+{
+    const uint64_t* stream = nullptr;
+    uint64_t numberOfWords = 0;
+    uint64_t bitPos = 0;
+    uint64_t lastBits = 0;
+    uint32_t leading = 0;
+    uint32_t trailing = 0;
+    bool isFirst = true;
+
+    double next()
+    {
+        if(isFirst)
+        {
+            isFirst = false;
+            lastBits = readSampleBits(stream, numberOfWords, bitPos, 64);
+        }
+        else if(readSampleBits(stream, numberOfWords, bitPos, 1) == 1)
+        {
+            // a new window of meaningful bits is only stored, if the old one doesn't fit
+            if(readSampleBits(stream, numberOfWords, bitPos, 1) == 1)
+            {
+                leading = static_cast<uint32_t>(readSampleBits(stream, numberOfWords, bitPos, 5));
+                uint32_t length = static_cast<uint32_t>(readSampleBits(stream,
+                                                                       numberOfWords,
+                                                                       bitPos,
+                                                                       6)) + 1;
+                // only possible in a broken stream
+                if(leading + length > 64) {
+                    length = 64 - leading;
+                }
+                trailing = 64 - leading - length;
+            }
+            const uint32_t length = 64 - leading - trailing;
+            lastBits ^= readSampleBits(stream, numberOfWords, bitPos, length) << trailing;
+        }
+
+        double value = 0.0;
+        memcpy(&value, &lastBits, sizeof(double));
+        return value;
+    }
+};
+
+//==================================================================================================
+// SampleRecorder
+//==================================================================================================
+
+/**
+ * @brief constructor
+ */
+SampleRecorder::SampleRecorder() {}
+
+/**
+ * @brief destructor, which writes the last block and closes the file
+ */
+SampleRecorder::~SampleRecorder()
+{
+    ErrorContainer error;
+    if(closeRecorder(error) == false) {
+        LOG_ERROR(error);
+    }
+}
+
+/**
+ * @brief add a new column to the recorder, which is only possible before the recorder is
+ *        initialized
+ *
+ * @param name name of the column, like "pkgAvg" (max 47 characters)
+ * @param unit unit of the values, like "W" (max 15 characters)
+ * @param source type of the source of the values
+ * @param sourceId id of the package, core or thread of the values
+ * @param error reference for error-output
+ *
+ * @return false, if already initialized or name or unit are too long, else true
+ */
+bool
+SampleRecorder::addColumn(const std::string &name,
+                          const std::string &unit,
+                          const SampleSource source,
+                          const uint64_t sourceId,
+                          ErrorContainer &error)
+{
+    SampleColumn column;
+    if(m_isInit
+            || name.size() >= sizeof(column.name)
+            || unit.size() >= sizeof(column.unit))
+    {
+        error.addMeesage("Failed to add column '" + name + "' to sample-recorder");
+        error.addSolution("add all columns before initializing the recorder");
+        error.addSolution("use names with less than 48 and units with less than 16 characters");
+        return false;
+    }
+
+    memset(column.name, 0, sizeof(column.name));
+    memset(column.unit, 0, sizeof(column.unit));
+    memcpy(column.name, name.c_str(), name.size());
+    memcpy(column.unit, unit.c_str(), unit.size());
+    column.source = source;
+    column.sourceId = sourceId;
+    m_columns.push_back(column);
+
+    return true;
+}
+
+/**
+ * @brief get header at the begin of the mapped file
+ */
+SampleFileHeader*
+SampleRecorder::getHeader() const
+{
+    return reinterpret_cast<SampleFileHeader*>(m_data);
+}
+
+/**
+ * @brief extend file and mapping, if it is smaller than a minimum size
+ *
+ * @param minimumSize requested minimum size in bytes
+ * @param error reference for error-output
+ *
+ * @return false, if resizing failed, else true
+ */
+bool
+SampleRecorder::resizeFile(const uint64_t minimumSize,
+                           ErrorContainer &error)
+{
+    if(minimumSize <= m_mappedSize) {
+        return true;
+    }
+
+    uint64_t newSize = m_mappedSize + sampleFileGrowSize;
+    while(newSize < minimumSize) {
+        newSize += sampleFileGrowSize;
+    }
+
+    if(ftruncate(m_fd, static_cast<off_t>(newSize)) != 0)
+    {
+        error.addMeesage("Failed to resize sample-file: " + std::string(strerror(errno)));
+        error.addSolution("check if there is enough free space on the disc");
+        return false;
+    }
+
+    void* newData = nullptr;
+    if(m_data == nullptr) {
+        newData = mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    } else {
+        newData = mremap(m_data, m_mappedSize, newSize, MREMAP_MAYMOVE);
+    }
+
+    if(newData == MAP_FAILED)
+    {
+        error.addMeesage("Failed to map sample-file: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    m_data = static_cast<uint8_t*>(newData);
+    m_mappedSize = newSize;
+
+    return true;
+}
+
+/**
+ * @brief create the file, write the header with the columns and the topology and preallocate
+ *        the buffers for the compression
+ *
+ * @param filePath path to the new file, which is overwritten, if already exist
+ * @param error reference for error-output
+ *
+ * @return false, if there are no columns or the file can not be created, else true
+ */
+bool
+SampleRecorder::initRecorder(const std::string &filePath,
+                             ErrorContainer &error)
+{
+    // check if already initialized
+    if(m_isInit)
+    {
+        LOG_WARNING("this sample-recorder was already successfully initialized");
+        return true;
+    }
+
+    if(m_columns.size() == 0)
+    {
+        error.addMeesage("Failed to initialize sample-recorder, because it has no columns");
+        error.addSolution("add columns with addColumn before initializing the recorder");
+        return false;
+    }
+
+    m_fd = open(filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(m_fd < 0)
+    {
+        error.addMeesage("Failed to create sample-file '"
+                         + filePath
+                         + "': "
+                         + std::string(strerror(errno)));
+        error.addSolution("check if you have write-permissions to the directory of the file");
+        return false;
+    }
+
+    const uint64_t headerSize = sizeof(SampleFileHeader)
+                                + m_columns.size() * sizeof(SampleColumn);
+    if(resizeFile(headerSize, error) == false)
+    {
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    // write header
+    SampleFileHeader header;
+    memcpy(header.magic, sampleFileMagic, sizeof(header.magic));
+    header.version = sampleFileVersion;
+    header.headerSize = static_cast<uint32_t>(headerSize);
+    header.numberOfColumns = m_columns.size();
+    header.dataEnd = headerSize;
+
+    ErrorContainer topologyError;
+    getNumberOfCpuPackages(header.numberOfPackages, topologyError);
+    getNumberOfCpuThreads(header.numberOfThreads, topologyError);
+
+    struct timespec realTime;
+    clock_gettime(CLOCK_REALTIME, &realTime);
+    header.startRealTime = static_cast<uint64_t>(realTime.tv_sec) * 1000000000ULL
+                           + static_cast<uint64_t>(realTime.tv_nsec);
+    header.startTimeStamp = TscClock::getInstance()->getTimestamp();
+
+    memcpy(m_data, &header, sizeof(SampleFileHeader));
+    memcpy(m_data + sizeof(SampleFileHeader),
+           m_columns.data(),
+           m_columns.size() * sizeof(SampleColumn));
+
+    // preallocate streams for the timestamps and all columns, so appending never allocates
+    const uint64_t maxWords = (sampleBlockSize * maxBitsPerSample) / 64 + 2;
+    m_streams.assign(m_columns.size() + 1, std::vector<uint64_t>(maxWords, 0));
+    m_streamBits.assign(m_columns.size() + 1, 0);
+    m_lastBits.assign(m_columns.size(), 0);
+    m_lastLeading.assign(m_columns.size(), 0);
+    m_lastTrailing.assign(m_columns.size(), 0);
+    m_blockSamples = 0;
+    m_lastTimeStamp = 0;
+
+    m_isInit = true;
+
+    return true;
+}
+
+/**
+ * @brief append a sample to the current block. The timestamps are stored as delta-of-delta and
+ *        the values xor-compressed to the previous value of the same column, like in the
+ *        Gorilla-format, so constant or slowly changing values only need a few bits.
+ *
+ * @param timeStamp monotonic timestamp in nanoseconds, like from TscClock::getTimestamp, which
+ *                  must not be smaller than the one of the previous sample
+ * @param values one value for each column in the order of the columns
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized, input is invalid or the full block can not be written,
+ *         else true
+ */
+bool
+SampleRecorder::appendSample(const uint64_t timeStamp,
+                             const std::vector<double> &values,
+                             ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to append sample, because sample-recorder is not initialized");
+        return false;
+    }
+
+    if(values.size() != m_columns.size()
+            || timeStamp < m_lastTimeStamp)
+    {
+        error.addMeesage("Failed to append sample, because it has "
+                         + std::to_string(values.size())
+                         + " instead of "
+                         + std::to_string(m_columns.size())
+                         + " values or its timestamp is older than the last one");
+        return false;
+    }
+
+    // timestamps
+    uint64_t* timeStream = m_streams[0].data();
+    uint64_t &timeBits = m_streamBits[0];
+    if(m_blockSamples == 0)
+    {
+        writeSampleBits(timeStream, timeBits, timeStamp, 64);
+        m_firstTimeStamp = timeStamp;
+        m_lastDelta = 0;
+    }
+    else
+    {
+        const int64_t delta = static_cast<int64_t>(timeStamp - m_lastTimeStamp);
+        const int64_t deltaOfDelta = delta - m_lastDelta;
+        const uint64_t bits = static_cast<uint64_t>(deltaOfDelta);
+        if(deltaOfDelta == 0) {
+            writeSampleBits(timeStream, timeBits, 0b0, 1);
+        } else if(fitsIntoSampleBits(deltaOfDelta, 16)) {
+            writeSampleBits(timeStream, timeBits, 0b10, 2);
+            writeSampleBits(timeStream, timeBits, bits, 16);
+        } else if(fitsIntoSampleBits(deltaOfDelta, 24)) {
+            writeSampleBits(timeStream, timeBits, 0b110, 3);
+            writeSampleBits(timeStream, timeBits, bits, 24);
+        } else if(fitsIntoSampleBits(deltaOfDelta, 32)) {
+            writeSampleBits(timeStream, timeBits, 0b1110, 4);
+            writeSampleBits(timeStream, timeBits, bits, 32);
+        } else {
+            writeSampleBits(timeStream, timeBits, 0b1111, 4);
+            writeSampleBits(timeStream, timeBits, bits, 64);
+        }
+        m_lastDelta = delta;
+    }
+    m_lastTimeStamp = timeStamp;
+
+    // values
+    for(uint64_t i = 0; i < values.size(); i++)
+    {
+        uint64_t* stream = m_streams[i + 1].data();
+        uint64_t &streamBits = m_streamBits[i + 1];
+        uint64_t bits = 0;
+        memcpy(&bits, &values[i], sizeof(double));
+
+        if(m_blockSamples == 0)
+        {
+            writeSampleBits(stream, streamBits, bits, 64);
+            m_lastBits[i] = bits;
+            m_lastLeading[i] = 0;
+            m_lastTrailing[i] = 0;
+            continue;
+        }
+
+        const uint64_t xorValue = bits ^ m_lastBits[i];
+        m_lastBits[i] = bits;
+        if(xorValue == 0)
+        {
+            writeSampleBits(stream, streamBits, 0b0, 1);
+            continue;
+        }
+
+        // leading zeros are limited to 5 bits in the stream
+        const uint32_t leading = std::min(__builtin_clzll(xorValue), 31);
+        const uint32_t trailing = __builtin_ctzll(xorValue);
+        const uint32_t lastLength = 64 - m_lastLeading[i] - m_lastTrailing[i];
+        if(lastLength < 64
+                && leading >= m_lastLeading[i]
+                && trailing >= m_lastTrailing[i])
+        {
+            // reuse the window of meaningful bits of the previous value
+            writeSampleBits(stream, streamBits, 0b10, 2);
+            writeSampleBits(stream, streamBits, xorValue >> m_lastTrailing[i], lastLength);
+        }
+        else
+        {
+            const uint32_t length = 64 - leading - trailing;
+            writeSampleBits(stream, streamBits, 0b11, 2);
+            writeSampleBits(stream, streamBits, leading, 5);
+            writeSampleBits(stream, streamBits, length - 1, 6);
+            writeSampleBits(stream, streamBits, xorValue >> trailing, length);
+            m_lastLeading[i] = static_cast<uint8_t>(leading);
+            m_lastTrailing[i] = static_cast<uint8_t>(trailing);
+        }
+    }
+
+    m_blockSamples++;
+    if(m_blockSamples == sampleBlockSize) {
+        return writeBlock(error);
+    }
+
+    return true;
+}
+
+/**
+ * @brief copy the compressed streams of the current block into the file and reset the streams
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if the file can not be extended, else true
+ */
+bool
+SampleRecorder::writeBlock(ErrorContainer &error)
+{
+    if(m_blockSamples == 0) {
+        return true;
+    }
+
+    // layout: block-header, number of words of each stream, streams
+    uint64_t blockSize = sizeof(SampleBlockHeader) + m_streams.size() * sizeof(uint64_t);
+    for(const uint64_t bits : m_streamBits) {
+        blockSize += ((bits + 63) / 64) * sizeof(uint64_t);
+    }
+
+    const uint64_t dataEnd = getHeader()->dataEnd;
+    if(resizeFile(dataEnd + blockSize, error) == false)
+    {
+        error.addMeesage("Failed to write block of samples");
+        return false;
+    }
+
+    uint8_t* target = m_data + dataEnd;
+    SampleBlockHeader blockHeader;
+    blockHeader.blockSize = blockSize;
+    blockHeader.numberOfSamples = m_blockSamples;
+    blockHeader.firstTimeStamp = m_firstTimeStamp;
+    blockHeader.lastTimeStamp = m_lastTimeStamp;
+    memcpy(target, &blockHeader, sizeof(SampleBlockHeader));
+    target += sizeof(SampleBlockHeader);
+
+    uint64_t* wordCounts = reinterpret_cast<uint64_t*>(target);
+    target += m_streams.size() * sizeof(uint64_t);
+    for(uint64_t i = 0; i < m_streams.size(); i++)
+    {
+        const uint64_t words = (m_streamBits[i] + 63) / 64;
+        wordCounts[i] = words;
+        memcpy(target, m_streams[i].data(), words * sizeof(uint64_t));
+        target += words * sizeof(uint64_t);
+
+        // only the used part of the stream has to be cleared for the next block
+        std::fill(m_streams[i].begin(), m_streams[i].begin() + words, 0);
+        m_streamBits[i] = 0;
+    }
+
+    // publish the block by updating the header after the block is complete
+    SampleFileHeader* header = getHeader();
+    __atomic_store_n(&header->numberOfBlocks, header->numberOfBlocks + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&header->numberOfSamples,
+                     header->numberOfSamples + m_blockSamples,
+                     __ATOMIC_RELEASE);
+    __atomic_store_n(&header->dataEnd, dataEnd + blockSize, __ATOMIC_RELEASE);
+
+    m_blockSamples = 0;
+
+    return true;
+}
+
+/**
+ * @brief write the current block, even if not full, and start writing the file to disc
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized or the block can not be written, else true
+ */
+bool
+SampleRecorder::flush(ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to flush, because sample-recorder is not initialized");
+        return false;
+    }
+
+    if(writeBlock(error) == false) {
+        return false;
+    }
+
+    if(msync(m_data, getHeader()->dataEnd, MS_ASYNC) != 0)
+    {
+        error.addMeesage("Failed to sync sample-file: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief write the current block, cut the file to its used size and close it
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if the last block can not be written, else true
+ */
+bool
+SampleRecorder::closeRecorder(ErrorContainer &error)
+{
+    if(m_isInit == false) {
+        return true;
+    }
+
+    bool result = writeBlock(error);
+    const uint64_t dataEnd = getHeader()->dataEnd;
+
+    munmap(m_data, m_mappedSize);
+    if(ftruncate(m_fd, static_cast<off_t>(dataEnd)) != 0)
+    {
+        error.addMeesage("Failed to cut sample-file to its used size: "
+                         + std::string(strerror(errno)));
+        result = false;
+    }
+    close(m_fd);
+
+    m_data = nullptr;
+    m_mappedSize = 0;
+    m_fd = -1;
+    m_isInit = false;
+
+    return result;
+}
+
+/**
+ * @brief get number of columns
+ */
+uint64_t
+SampleRecorder::getNumberOfColumns() const
+{
+    return m_columns.size();
+}
+
+/**
+ * @brief get used size of the file in bytes, without the block, which is not written until now
+ */
+uint64_t
+SampleRecorder::getFileSize() const
+{
+    if(m_isInit == false) {
+        return 0;
+    }
+
+    return getHeader()->dataEnd;
+}
+
+//==================================================================================================
+// SampleReader
+//==================================================================================================
+
+/**
+ * @brief constructor
+ */
+SampleReader::SampleReader() {}
+
+/**
+ * @brief destructor
+ */
+SampleReader::~SampleReader()
+{
+    if(m_data != nullptr) {
+        munmap(const_cast<uint8_t*>(m_data), m_mappedSize);
+    }
+}
+
+/**
+ * @brief check if a block and the word-counts of its streams fit into the available space, so
+ *        the decoders never read behind the mapping
+ *
+ * @param block block to check
+ * @param numberOfStreams number of streams of each block
+ * @param availableSize number of bytes between the begin of the block and the end of the data
+ *
+ * @return false, if the block is broken, else true
+ */
+bool
+isValidSampleBlock(const SampleBlockHeader* block,
+                   const uint64_t numberOfStreams,
+                   const uint64_t availableSize)
+{
+    const uint64_t countsEnd = sizeof(SampleBlockHeader) + numberOfStreams * sizeof(uint64_t);
+    if(availableSize < sizeof(SampleBlockHeader)
+            || block->blockSize < countsEnd
+            || block->blockSize > availableSize
+            || block->numberOfSamples == 0
+            || block->numberOfSamples > sampleBlockSize)
+    {
+        return false;
+    }
+
+    // the counts are compared one by one against the remaining space, so their sum can not
+    // overflow
+    const uint64_t* wordCounts = reinterpret_cast<const uint64_t*>(block + 1);
+    uint64_t remainingWords = (block->blockSize - countsEnd) / sizeof(uint64_t);
+    for(uint64_t i = 0; i < numberOfStreams; i++)
+    {
+        if(wordCounts[i] > remainingWords) {
+            return false;
+        }
+        remainingWords -= wordCounts[i];
+    }
+
+    return true;
+}
+
+/**
+ * @brief map a sample-file read-only and build the index of its blocks. Files, which are still
+ *        written, can also be read, but only contain the blocks, which were complete at this
+ *        point.
+ *
+ * @param filePath path to the file
+ * @param error reference for error-output
+ *
+ * @return false, if the file can not be mapped or is not a valid sample-file, else true
+ */
+bool
+SampleReader::initReader(const std::string &filePath,
+                         ErrorContainer &error)
+{
+    // check if already initialized
+    if(m_isInit)
+    {
+        LOG_WARNING("this sample-reader was already successfully initialized");
+        return true;
+    }
+
+    const int fd = open(filePath.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        error.addMeesage("Failed to open sample-file '"
+                         + filePath
+                         + "': "
+                         + std::string(strerror(errno)));
+        return false;
+    }
+
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) != 0
+            || static_cast<uint64_t>(fileStat.st_size) < sizeof(SampleFileHeader))
+    {
+        error.addMeesage("Sample-file '" + filePath + "' is too small");
+        close(fd);
+        return false;
+    }
+
+    // the mapping stays valid after closing the file-descriptor
+    const uint64_t fileSize = static_cast<uint64_t>(fileStat.st_size);
+    void* data = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED)
+    {
+        error.addMeesage("Failed to map sample-file '"
+                         + filePath
+                         + "': "
+                         + std::string(strerror(errno)));
+        return false;
+    }
+    m_data = static_cast<const uint8_t*>(data);
+    m_mappedSize = fileSize;
+
+    // check header
+    const SampleFileHeader* header = getHeader();
+    const uint64_t dataEnd = __atomic_load_n(&header->dataEnd, __ATOMIC_ACQUIRE);
+    if(memcmp(header->magic, sampleFileMagic, sizeof(sampleFileMagic)) != 0
+            || header->version != sampleFileVersion
+            || header->headerSize != sizeof(SampleFileHeader)
+                                     + header->numberOfColumns * sizeof(SampleColumn)
+            || header->headerSize > dataEnd
+            || dataEnd > fileSize)
+    {
+        error.addMeesage("File '" + filePath + "' is not a valid sample-file");
+        munmap(data, fileSize);
+        m_data = nullptr;
+        m_mappedSize = 0;
+        return false;
+    }
+
+    // build block-index
+    const uint64_t numberOfStreams = header->numberOfColumns + 1;
+    uint64_t offset = header->headerSize;
+    m_blockOffsets.clear();
+    while(offset + sizeof(SampleBlockHeader) <= dataEnd)
+    {
+        const SampleBlockHeader* block =
+                reinterpret_cast<const SampleBlockHeader*>(m_data + offset);
+        if(isValidSampleBlock(block, numberOfStreams, dataEnd - offset) == false)
+        {
+            error.addMeesage("Sample-file '" + filePath + "' contains a broken block");
+            munmap(data, fileSize);
+            m_data = nullptr;
+            m_mappedSize = 0;
+            return false;
+        }
+
+        m_blockOffsets.push_back(offset);
+        offset += block->blockSize;
+    }
+
+    m_isInit = true;
+
+    return true;
+}
+
+/**
+ * @brief get header of the file
+ */
+const SampleFileHeader*
+SampleReader::getHeader() const
+{
+    return reinterpret_cast<const SampleFileHeader*>(m_data);
+}
+
+/**
+ * @brief get descriptions of all columns
+ */
+const std::vector<SampleColumn>
+SampleReader::getColumns() const
+{
+    if(m_isInit == false) {
+        return std::vector<SampleColumn>();
+    }
+
+    const SampleColumn* columns = reinterpret_cast<const SampleColumn*>(m_data
+                                                                        + sizeof(SampleFileHeader));
+    return std::vector<SampleColumn>(columns, columns + getHeader()->numberOfColumns);
+}
+
+/**
+ * @brief get number of samples of all blocks, which were complete while initializing the reader
+ */
+uint64_t
+SampleReader::getNumberOfSamples() const
+{
+    uint64_t result = 0;
+    for(uint64_t i = 0; i < m_blockOffsets.size(); i++) {
+        result += getBlock(i)->numberOfSamples;
+    }
+    return result;
+}
+
+/**
+ * @brief get timestamp of the first sample or 0, if file is empty
+ */
+uint64_t
+SampleReader::getFirstTimeStamp() const
+{
+    if(m_blockOffsets.size() == 0) {
+        return 0;
+    }
+
+    return getBlock(0)->firstTimeStamp;
+}
+
+/**
+ * @brief get timestamp of the last sample or 0, if file is empty
+ */
+uint64_t
+SampleReader::getLastTimeStamp() const
+{
+    if(m_blockOffsets.size() == 0) {
+        return 0;
+    }
+
+    return getBlock(m_blockOffsets.size() - 1)->lastTimeStamp;
+}
+
+/**
+ * @brief get header of a block
+ */
+const SampleBlockHeader*
+SampleReader::getBlock(const uint64_t blockId) const
+{
+    return reinterpret_cast<const SampleBlockHeader*>(m_data + m_blockOffsets[blockId]);
+}
+
+/**
+ * @brief get the first block, which contains samples at or after a timestamp
+ */
+uint64_t
+SampleReader::findFirstBlock(const uint64_t beginTimeStamp) const
+{
+    uint64_t lower = 0;
+    uint64_t upper = m_blockOffsets.size();
+    while(lower < upper)
+    {
+        const uint64_t middle = (lower + upper) / 2;
+        if(getBlock(middle)->lastTimeStamp < beginTimeStamp) {
+            lower = middle + 1;
+        } else {
+            upper = middle;
+        }
+    }
+
+    return lower;
+}
+
+/**
+ * @brief get pointer to a compressed stream of a block, which is directly read from the mapping
+ *
+ * @param numberOfWords reference for the number of words of the stream
+ * @param block block, which was checked by isValidSampleBlock
+ * @param numberOfStreams number of streams of each block
+ * @param streamId position of the requested stream
+ *
+ * @return pointer to the first word of the stream
+ */
+const uint64_t*
+getSampleStream(uint64_t &numberOfWords,
+                const SampleBlockHeader* block,
+                const uint64_t numberOfStreams,
+                const uint64_t streamId)
+{
+    const uint64_t* wordCounts = reinterpret_cast<const uint64_t*>(block + 1);
+    const uint64_t* stream = wordCounts + numberOfStreams;
+    for(uint64_t i = 0; i < streamId; i++) {
+        stream += wordCounts[i];
+    }
+    numberOfWords = wordCounts[streamId];
+    return stream;
+}
+
+/**
+ * @brief call a function for each sample within a time-range. The samples are decoded directly
+ *        from the mapped file and blocks outside of the range are skipped.
+ *
+ * @param beginTimeStamp first timestamp of the range
+ * @param endTimeStamp last timestamp of the range (inclusive)
+ * @param function function, which is called with the timestamp and all values of a sample
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized, else true
+ */
+bool
+SampleReader::forEachSample(const uint64_t beginTimeStamp,
+                            const uint64_t endTimeStamp,
+                            const std::function<void(const uint64_t,
+                                                     const std::vector<double>&)> &function,
+                            ErrorContainer &error) const
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to read samples, because sample-reader is not initialized");
+        return false;
+    }
+
+    const uint64_t numberOfColumns = getHeader()->numberOfColumns;
+    std::vector<SampleValueDecoder> decoders(numberOfColumns);
+    std::vector<double> values(numberOfColumns, 0.0);
+
+    for(uint64_t blockId = findFirstBlock(beginTimeStamp);
+        blockId < m_blockOffsets.size();
+        blockId++)
+    {
+        const SampleBlockHeader* block = getBlock(blockId);
+        if(block->firstTimeStamp > endTimeStamp) {
+            break;
+        }
+
+        SampleTimeDecoder timeDecoder;
+        timeDecoder.stream = getSampleStream(timeDecoder.numberOfWords,
+                                             block,
+                                             numberOfColumns + 1,
+                                             0);
+        for(uint64_t i = 0; i < numberOfColumns; i++)
+        {
+            decoders[i] = SampleValueDecoder();
+            decoders[i].stream = getSampleStream(decoders[i].numberOfWords,
+                                                 block,
+                                                 numberOfColumns + 1,
+                                                 i + 1);
+        }
+
+        for(uint64_t sample = 0; sample < block->numberOfSamples; sample++)
+        {
+            const uint64_t timeStamp = timeDecoder.next();
+            for(uint64_t i = 0; i < numberOfColumns; i++) {
+                values[i] = decoders[i].next();
+            }
+
+            if(timeStamp > endTimeStamp) {
+                return true;
+            }
+            if(timeStamp >= beginTimeStamp) {
+                function(timeStamp, values);
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief read the values of a single column within a time-range, where only the timestamps and
+ *        the stream of the requested column are decoded
+ *
+ * @param timeStamps reference for the timestamps of the samples
+ * @param values reference for the values of the column
+ * @param columnId position of the column
+ * @param beginTimeStamp first timestamp of the range
+ * @param endTimeStamp last timestamp of the range (inclusive)
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized or column doesn't exist, else true
+ */
+bool
+SampleReader::readColumn(std::vector<uint64_t> &timeStamps,
+                         std::vector<double> &values,
+                         const uint64_t columnId,
+                         const uint64_t beginTimeStamp,
+                         const uint64_t endTimeStamp,
+                         ErrorContainer &error) const
+{
+    if(m_isInit == false
+            || columnId >= getHeader()->numberOfColumns)
+    {
+        error.addMeesage("Failed to read column '"
+                         + std::to_string(columnId)
+                         + "' from sample-file");
+        return false;
+    }
+
+    timeStamps.clear();
+    values.clear();
+    const uint64_t numberOfStreams = getHeader()->numberOfColumns + 1;
+
+    for(uint64_t blockId = findFirstBlock(beginTimeStamp);
+        blockId < m_blockOffsets.size();
+        blockId++)
+    {
+        const SampleBlockHeader* block = getBlock(blockId);
+        if(block->firstTimeStamp > endTimeStamp) {
+            break;
+        }
+
+        SampleTimeDecoder timeDecoder;
+        timeDecoder.stream = getSampleStream(timeDecoder.numberOfWords,
+                                             block,
+                                             numberOfStreams,
+                                             0);
+        SampleValueDecoder valueDecoder;
+        valueDecoder.stream = getSampleStream(valueDecoder.numberOfWords,
+                                              block,
+                                              numberOfStreams,
+                                              columnId + 1);
+
+        for(uint64_t sample = 0; sample < block->numberOfSamples; sample++)
+        {
+            const uint64_t timeStamp = timeDecoder.next();
+            const double value = valueDecoder.next();
+            if(timeStamp > endTimeStamp) {
+                return true;
+            }
+            if(timeStamp >= beginTimeStamp)
+            {
+                timeStamps.push_back(timeStamp);
+                values.push_back(value);
+            }
+        }
+    }
+
+    return true;
+}
+
+} // namespace Kitsunemimi
@@ -0,0 +1,760 @@
+/**
+ *  @file       shared_metrics.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/shared_metrics.h>
+#include <libKitsunemimiCpu/cpu.h>
+#include <libKitsunemimiCpu/memory.h>
+#include <libKitsunemimiCpu/tsc_clock.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace Kitsunemimi
+{
+
+const char sharedMetricsMagic[8] = {'K', 'C', 'P', 'U', 'S', 'H', 'M', '\0'};
+const uint32_t sharedMetricsVersion = 2;
+
+// number of attempts to read a consistent snapshot, before the publisher is assumed to be dead
+// while writing
+const uint64_t maxSnapshotRetries = 100000;
+
+// header at the begin of the shared segment, which is followed by the system-metrics, the
+// package-metrics and the thread-metrics
+struct SharedMetricsHeader
+{
+    char magic[8];
+    uint32_t version = 0;
+    uint32_t publisherPid = 0;
+    uint64_t numberOfPackages = 0;
+    uint64_t numberOfThreads = 0;
+
+    // sequence-counter of the seqlock, which is odd while the publisher writes. It has its own
+    // cache-line, so readers of the topology don't collide with the writes.
+    alignas(64) uint64_t sequence = 0;
+    uint64_t padding[7];
+};
+
+/**
+ * @brief copy words into the shared segment with atomic stores, because readers access them at
+ *        the same time
+ */
+void
+storeSharedWords(uint8_t* target,
+                 const void* source,
+                 const uint64_t size)
+{
+    uint64_t* targetWords = reinterpret_cast<uint64_t*>(target);
+    const uint64_t* sourceWords = static_cast<const uint64_t*>(source);
+    for(uint64_t i = 0; i < size / sizeof(uint64_t); i++) {
+        __atomic_store_n(&targetWords[i], sourceWords[i], __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief copy words from the shared segment with atomic loads, because the publisher can write
+ *        them at the same time
+ */
+void
+loadSharedWords(void* target,
+                const uint8_t* source,
+                const uint64_t size)
+{
+    uint64_t* targetWords = static_cast<uint64_t*>(target);
+    const uint64_t* sourceWords = reinterpret_cast<const uint64_t*>(source);
+    for(uint64_t i = 0; i < size / sizeof(uint64_t); i++) {
+        targetWords[i] = __atomic_load_n(&sourceWords[i], __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief get name of a posix shared-memory-segment, which has to begin with a slash
+ */
+const std::string
+getSharedMetricsName(const std::string &name)
+{
+    if(name.size() > 0
+            && name[0] == '/')
+    {
+        return name;
+    }
+
+    return "/" + name;
+}
+
+/**
+ * @brief get name of the lock-file of a shared segment
+ */
+const std::string
+getSharedMetricsLockName(const std::string &name)
+{
+    return name + ".lock";
+}
+
+/**
+ * @brief lock the name of a shared segment for a publisher. The lock is held on a separate
+ *        lock-file, because the segment itself is replaced by each new publisher. The lock-file
+ *        is never removed, so all publishers of the same name always lock the same file. The
+ *        kernel releases the lock, when the publisher exits or dies, so no pid has to be checked.
+ *        An open-file-description-lock is used instead of flock, because readers can test it
+ *        without acquiring it, so a reader never blocks the start of a publisher.
+ *
+ * @param lockFd reference for the file-descriptor of the locked lock-file
+ * @param name name of the shared segment with leading slash
+ * @param error reference for error-output
+ *
+ * @return false, if the lock-file can not be opened or another publisher holds the lock,
+ *         else true
+ */
+bool
+lockSharedMetricsName(int &lockFd,
+                      const std::string &name,
+                      ErrorContainer &error)
+{
+    const std::string lockName = getSharedMetricsLockName(name);
+    lockFd = shm_open(lockName.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+    if(lockFd < 0)
+    {
+        error.addMeesage("Failed to open lock-file '"
+                         + lockName
+                         + "' of shared segment: "
+                         + std::string(strerror(errno)));
+        error.addSolution("check if /dev/shm is mounted and writable");
+        return false;
+    }
+
+    struct flock lock = {};
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    if(fcntl(lockFd, F_OFD_SETLK, &lock) != 0)
+    {
+        const int lockErrno = errno;
+        close(lockFd);
+        lockFd = -1;
+
+        if(lockErrno == EAGAIN
+                || lockErrno == EACCES)
+        {
+            error.addMeesage("Failed to create shared segment '"
+                             + name
+                             + "', because it is still used by another running publisher");
+            error.addSolution("stop the other publisher or use another name for the segment");
+            return false;
+        }
+
+        error.addMeesage("Failed to lock lock-file '"
+                         + lockName
+                         + "' of shared segment: "
+                         + std::string(strerror(lockErrno)));
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief check without acquiring the lock, if a publisher holds the lock-file of a segment
+ *
+ * @param isRunning reference for the result
+ * @param lockFd file-descriptor of the lock-file
+ *
+ * @return false, if the lock can not be tested, else true
+ */
+bool
+isSharedMetricsPublisherRunning(bool &isRunning,
+                                const int lockFd)
+{
+    struct flock lock = {};
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    if(fcntl(lockFd, F_OFD_GETLK, &lock) != 0) {
+        return false;
+    }
+
+    isRunning = lock.l_type != F_UNLCK;
+    return true;
+}
+
+//==================================================================================================
+// SharedMetricsPublisher
+//==================================================================================================
+
+/**
+ * @brief constructor
+ */
+SharedMetricsPublisher::SharedMetricsPublisher()
+{
+    m_stopPublishing.store(false);
+}
+
+/**
+ * @brief destructor, which removes the shared segment. Readers, which already mapped it, can
+ *        still read the last snapshot.
+ */
+SharedMetricsPublisher::~SharedMetricsPublisher()
+{
+    stopPublishing();
+
+    if(m_isInit)
+    {
+        munmap(m_segment, m_segmentSize);
+        shm_unlink(m_name.c_str());
+        // released at last, so the next publisher can not create its segment before this one
+        // is removed
+        close(m_lockFd);
+    }
+}
+
+/**
+ * @brief create the shared segment and initialize all sources
+ *
+ * @param name name of the shared segment, like "kitsunemimi_cpu", which is the same for the
+ *             readers. A segment of a dead publisher with the same name is replaced, but
+ *             readers, which still have the old segment mapped, keep their consistent mapping.
+ * @param error reference for error-output
+ *
+ * @return false, if topology can not be read, the publisher of an existing segment with the
+ *         same name is still running or segment can not be created, else true
+ */
+bool
+SharedMetricsPublisher::initPublisher(const std::string &name,
+                                      ErrorContainer &error)
+{
+    // check if already initialized
+    if(m_isInit)
+    {
+        LOG_WARNING("this shared-metrics-publisher was already successfully initialized");
+        return true;
+    }
+
+    // all sources are collected locally and only taken over, after the segment was created,
+    // so a failed initialization leaves the publisher untouched and it can be initialized again
+    CpuSet threads;
+    if(getOnlineCpuThreads(threads, error) == false)
+    {
+        error.addMeesage("Failed to initialize shared-metrics-publisher");
+        return false;
+    }
+
+    // topology and one rapl-instance for the first thread of each package
+    SharedMetricsSnapshot snapshot;
+    std::vector<Rapl> rapls;
+    for(const uint64_t threadId : threads)
+    {
+        SharedThreadMetrics thread;
+        thread.threadId = threadId;
+        if(getCpuPackageId(thread.packageId, threadId, error) == false)
+        {
+            error.addMeesage("Failed to initialize shared-metrics-publisher");
+            return false;
+        }
+        snapshot.threads.push_back(thread);
+
+        bool packageExist = false;
+        for(const SharedPackageMetrics &package : snapshot.packages) {
+            packageExist |= package.packageId == thread.packageId;
+        }
+        if(packageExist == false)
+        {
+            // without access to the msr only rapl is missing and all other values are published
+            SharedPackageMetrics package;
+            package.packageId = thread.packageId;
+            // rapl owns the open msr-file, so it is created in place and never copied
+            rapls.emplace_back(threadId);
+            ErrorContainer raplError;
+            package.supportRapl = rapls.back().initRapl(raplError);
+            snapshot.packages.push_back(package);
+        }
+    }
+
+    std::map<uint64_t, std::string> temperatureFiles;
+    ErrorContainer temperatureError;
+    getPkgTemperatureFiles(temperatureFiles, temperatureError);
+
+    // create segment
+    const std::string segmentName = getSharedMetricsName(name);
+    const uint64_t segmentSize = sizeof(SharedMetricsHeader)
+                                 + sizeof(SharedSystemMetrics)
+                                 + snapshot.packages.size() * sizeof(SharedPackageMetrics)
+                                 + snapshot.threads.size() * sizeof(SharedThreadMetrics);
+
+    // the seqlock allows only one writer, so a running publisher is never replaced. The lock is
+    // held for the whole lifetime of the publisher.
+    int lockFd = -1;
+    if(lockSharedMetricsName(lockFd, segmentName, error) == false) {
+        return false;
+    }
+
+    // a new segment is created instead of resizing the old one, because shrinking a segment,
+    // which is still mapped by readers, would cause SIGBUS on their side
+    shm_unlink(segmentName.c_str());
+    const int fd = shm_open(segmentName.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+    if(fd < 0)
+    {
+        error.addMeesage("Failed to create shared segment '"
+                         + segmentName
+                         + "': "
+                         + std::string(strerror(errno)));
+        error.addSolution("check if /dev/shm is mounted and writable");
+        close(lockFd);
+        return false;
+    }
+
+    if(ftruncate(fd, static_cast<off_t>(segmentSize)) != 0)
+    {
+        error.addMeesage("Failed to resize shared segment '"
+                         + segmentName
+                         + "': "
+                         + std::string(strerror(errno)));
+        close(fd);
+        shm_unlink(segmentName.c_str());
+        close(lockFd);
+        return false;
+    }
+
+    void* segment = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(segment == MAP_FAILED)
+    {
+        error.addMeesage("Failed to map shared segment '"
+                         + segmentName
+                         + "': "
+                         + std::string(strerror(errno)));
+        shm_unlink(segmentName.c_str());
+        close(lockFd);
+        return false;
+    }
+
+    m_name = segmentName;
+    m_segment = static_cast<uint8_t*>(segment);
+    m_segmentSize = segmentSize;
+    m_lockFd = lockFd;
+    m_threads = threads;
+    m_snapshot = std::move(snapshot);
+    m_rapls = std::move(rapls);
+    m_temperatureFiles = std::move(temperatureFiles);
+
+    // write topology and at last the magic, so readers only accept a complete header
+    SharedMetricsHeader* header = reinterpret_cast<SharedMetricsHeader*>(m_segment);
+    header->version = sharedMetricsVersion;
+    header->publisherPid = static_cast<uint32_t>(getpid());
+    header->numberOfPackages = m_snapshot.packages.size();
+    header->numberOfThreads = m_snapshot.threads.size();
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(header->magic, sharedMetricsMagic, sizeof(sharedMetricsMagic));
+
+    m_lastTimeStamp = TscClock::getInstance()->getTimestamp();
+    m_isInit = true;
+
+    return true;
+}
+
+/**
+ * @brief sample all metrics once and write them as new snapshot into the shared segment. Calls
+ *        are serialized with the background-thread, because the segment allows only one writer.
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized, else true
+ */
+bool
+SharedMetricsPublisher::publish(ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to publish, because shared-metrics-publisher is not "
+                         "initialized");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(m_publishLock);
+
+    // sample
+    const uint64_t now = TscClock::getInstance()->getTimestamp();
+    SharedSystemMetrics &system = m_snapshot.system;
+    system.timeStamp = now;
+    system.numberOfUpdates++;
+    system.interval = static_cast<double>(now - m_lastTimeStamp) / 1000000000.0;
+    system.totalMemory = getTotalMemory();
+    system.availableMemory = getAvailableMemory();
+    m_lastTimeStamp = now;
+
+    for(uint64_t i = 0; i < m_snapshot.packages.size(); i++)
+    {
+        SharedPackageMetrics &package = m_snapshot.packages[i];
+        if(package.supportRapl)
+        {
+            const RaplDiff diff = m_rapls[i].calculateDiff();
+            package.pkgEnergy += diff.pkgDiff;
+            package.pp0Energy += diff.pp0Diff;
+            package.pp1Energy += diff.pp1Diff;
+            package.dramEnergy += diff.dramDiff;
+            package.pkgPower = diff.pkgAvg;
+            package.pp0Power = diff.pp0Avg;
+            package.pp1Power = diff.pp1Avg;
+            package.dramPower = diff.dramAvg;
+        }
+
+        // without sensor the temperature is marked as unsupported instead of publishing 0.0
+        const auto temperatureIt = m_temperatureFiles.find(package.packageId);
+        ErrorContainer temperatureError;
+        package.supportTemperature = temperatureIt != m_temperatureFiles.end()
+                                     && readPkgTemperature(package.temperature,
+                                                           temperatureIt->second,
+                                                           temperatureError);
+    }
+
+    std::vector<uint64_t> speeds;
+    ErrorContainer speedError;
+    if(getCurrentSpeed(speeds, m_threads, speedError)
+            && speeds.size() == m_snapshot.threads.size())
+    {
+        for(uint64_t i = 0; i < speeds.size(); i++) {
+            m_snapshot.threads[i].speed = speeds[i];
+        }
+    }
+
+    // write snapshot, while the sequence-counter is odd
+    SharedMetricsHeader* header = reinterpret_cast<SharedMetricsHeader*>(m_segment);
+    const uint64_t sequence = header->sequence;
+    __atomic_store_n(&header->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    uint8_t* target = m_segment + sizeof(SharedMetricsHeader);
+    storeSharedWords(target, &system, sizeof(SharedSystemMetrics));
+    target += sizeof(SharedSystemMetrics);
+    storeSharedWords(target,
+                     m_snapshot.packages.data(),
+                     m_snapshot.packages.size() * sizeof(SharedPackageMetrics));
+    target += m_snapshot.packages.size() * sizeof(SharedPackageMetrics);
+    storeSharedWords(target,
+                     m_snapshot.threads.data(),
+                     m_snapshot.threads.size() * sizeof(SharedThreadMetrics));
+
+    __atomic_store_n(&header->sequence, sequence + 2, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+/**
+ * @brief start a background-thread, which publishes the metrics in a fixed interval
+ *
+ * @param intervalMs interval in milliseconds
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized or already publishing, else true
+ */
+bool
+SharedMetricsPublisher::startPublishing(const uint64_t intervalMs,
+                                        ErrorContainer &error)
+{
+    if(m_isInit == false
+            || m_publishThread.joinable())
+    {
+        error.addMeesage("Failed to start publishing, because shared-metrics-publisher is not "
+                         "initialized or is already publishing");
+        return false;
+    }
+
+    m_stopPublishing.store(false);
+    m_publishThread = std::thread([this, intervalMs]()
+    {
+        auto nextTime = std::chrono::steady_clock::now();
+        while(m_stopPublishing.load() == false)
+        {
+            ErrorContainer publishError;
+            if(publish(publishError) == false) {
+                LOG_ERROR(publishError);
+            }
+
+            // fixed rate, so the interval doesn't drift with the time for sampling
+            nextTime += std::chrono::milliseconds(intervalMs);
+            std::this_thread::sleep_until(nextTime);
+        }
+    });
+
+    return true;
+}
+
+/**
+ * @brief stop the background-thread, if running
+ */
+void
+SharedMetricsPublisher::stopPublishing()
+{
+    m_stopPublishing.store(true);
+    if(m_publishThread.joinable()) {
+        m_publishThread.join();
+    }
+}
+
+//==================================================================================================
+// SharedMetricsReader
+//==================================================================================================
+
+/**
+ * @brief constructor
+ */
+SharedMetricsReader::SharedMetricsReader() {}
+
+/**
+ * @brief destructor
+ */
+SharedMetricsReader::~SharedMetricsReader()
+{
+    if(m_segment != nullptr) {
+        munmap(const_cast<uint8_t*>(m_segment), m_segmentSize);
+    }
+    if(m_lockFd >= 0) {
+        close(m_lockFd);
+    }
+}
+
+/**
+ * @brief map the shared segment of a publisher read-only
+ *
+ * @param name name of the shared segment, which was used by the publisher
+ * @param error reference for error-output
+ *
+ * @return false, if the segment doesn't exist, is invalid or its publisher is not running,
+ *         else true
+ */
+bool
+SharedMetricsReader::initReader(const std::string &name,
+                                ErrorContainer &error)
+{
+    // check if already initialized
+    if(m_isInit)
+    {
+        LOG_WARNING("this shared-metrics-reader was already successfully initialized");
+        return true;
+    }
+
+    // the lock-file is opened before the segment, so the lock always belongs to a publisher,
+    // which is at least as new as the mapped segment
+    const std::string segmentName = getSharedMetricsName(name);
+    const std::string lockName = getSharedMetricsLockName(segmentName);
+    const int lockFd = shm_open(lockName.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if(lockFd < 0)
+    {
+        error.addMeesage("Failed to open lock-file '"
+                         + lockName
+                         + "' of shared segment: "
+                         + std::string(strerror(errno)));
+        error.addSolution("check if the publisher is running");
+        return false;
+    }
+
+    m_name = segmentName;
+    m_lockFd = lockFd;
+    if(mapSegment(error) == false)
+    {
+        close(m_lockFd);
+        m_lockFd = -1;
+        return false;
+    }
+
+    m_isInit = true;
+
+    return true;
+}
+
+/**
+ * @brief map the current segment of the name of the reader and replace the already mapped one
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if the segment doesn't exist or is invalid, else true
+ */
+bool
+SharedMetricsReader::mapSegment(ErrorContainer &error)
+{
+    const int fd = shm_open(m_name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if(fd < 0)
+    {
+        error.addMeesage("Failed to open shared segment '"
+                         + m_name
+                         + "': "
+                         + std::string(strerror(errno)));
+        error.addSolution("check if the publisher is running");
+        return false;
+    }
+
+    struct stat segmentStat;
+    if(fstat(fd, &segmentStat) != 0
+            || static_cast<uint64_t>(segmentStat.st_size) < sizeof(SharedMetricsHeader))
+    {
+        error.addMeesage("Shared segment '" + m_name + "' is too small");
+        close(fd);
+        return false;
+    }
+
+    const uint64_t segmentSize = static_cast<uint64_t>(segmentStat.st_size);
+    void* segment = mmap(nullptr, segmentSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(segment == MAP_FAILED)
+    {
+        error.addMeesage("Failed to map shared segment '"
+                         + m_name
+                         + "': "
+                         + std::string(strerror(errno)));
+        return false;
+    }
+
+    // check header
+    const SharedMetricsHeader* header = static_cast<const SharedMetricsHeader*>(segment);
+    const uint64_t expectedSize = sizeof(SharedMetricsHeader)
+                                  + sizeof(SharedSystemMetrics)
+                                  + header->numberOfPackages * sizeof(SharedPackageMetrics)
+                                  + header->numberOfThreads * sizeof(SharedThreadMetrics);
+    if(memcmp(header->magic, sharedMetricsMagic, sizeof(sharedMetricsMagic)) != 0
+            || header->version != sharedMetricsVersion
+            || expectedSize != segmentSize)
+    {
+        error.addMeesage("Shared segment '" + m_name + "' is not a valid metrics-segment");
+        munmap(segment, segmentSize);
+        return false;
+    }
+
+    if(m_segment != nullptr) {
+        munmap(const_cast<uint8_t*>(m_segment), m_segmentSize);
+    }
+    m_segment = static_cast<const uint8_t*>(segment);
+    m_segmentSize = segmentSize;
+    m_segmentInode = static_cast<uint64_t>(segmentStat.st_ino);
+
+    return true;
+}
+
+/**
+ * @brief check if the publisher of the mapped segment is still running. If the publisher was
+ *        restarted in the meantime, the new segment is mapped.
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if no publisher is running anymore or the new segment can not be mapped,
+ *         else true
+ */
+bool
+SharedMetricsReader::checkPublisher(ErrorContainer &error)
+{
+    bool isRunning = false;
+    if(isSharedMetricsPublisherRunning(isRunning, m_lockFd) == false)
+    {
+        error.addMeesage("Failed to check lock-file of shared segment '" + m_name + "'");
+        return false;
+    }
+    if(isRunning == false)
+    {
+        error.addMeesage("Publisher of shared segment '" + m_name + "' is not running anymore");
+        error.addSolution("restart the publisher");
+        return false;
+    }
+
+    // a restarted publisher always creates a new segment, so a changed inode shows, that the
+    // mapped segment is orphaned
+    struct stat segmentStat;
+    const int fd = shm_open(m_name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if(fd < 0) {
+        return mapSegment(error);
+    }
+    const int ret = fstat(fd, &segmentStat);
+    close(fd);
+    if(ret == 0
+            && static_cast<uint64_t>(segmentStat.st_ino) == m_segmentInode)
+    {
+        return true;
+    }
+
+    if(mapSegment(error) == false)
+    {
+        error.addMeesage("Failed to map new shared segment '"
+                         + m_name
+                         + "' of the restarted publisher");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief read a consistent snapshot of all metrics. Only the liveness of the publisher is
+ *        checked with a few syscalls, the snapshot itself is read without any syscall. If the
+ *        publisher writes at the same time, the read is repeated.
+ *
+ * @param result reference for the snapshot. If the same object is reused for each call, the
+ *               memory of its vectors is also reused.
+ * @param error reference for error-output
+ *
+ * @return false, if not initialized, the publisher is not running anymore, nothing was
+ *         published until now or the publisher seems to be died while writing, else true
+ */
+bool
+SharedMetricsReader::readSnapshot(SharedMetricsSnapshot &result,
+                                  ErrorContainer &error)
+{
+    if(m_isInit == false)
+    {
+        error.addMeesage("Failed to read snapshot, because shared-metrics-reader is not "
+                         "initialized");
+        return false;
+    }
+
+    if(checkPublisher(error) == false)
+    {
+        error.addMeesage("Failed to read snapshot");
+        return false;
+    }
+
+    const SharedMetricsHeader* header = reinterpret_cast<const SharedMetricsHeader*>(m_segment);
+    result.packages.resize(header->numberOfPackages);
+    result.threads.resize(header->numberOfThreads);
+
+    for(uint64_t retry = 0; retry < maxSnapshotRetries; retry++)
+    {
+        const uint64_t before = __atomic_load_n(&header->sequence, __ATOMIC_ACQUIRE);
+        if(before == 0)
+        {
+            error.addMeesage("Failed to read snapshot, because nothing was published until now");
+            return false;
+        }
+        if(before & 1) {
+            continue;
+        }
+
+        const uint8_t* source = m_segment + sizeof(SharedMetricsHeader);
+        loadSharedWords(&result.system, source, sizeof(SharedSystemMetrics));
+        source += sizeof(SharedSystemMetrics);
+        loadSharedWords(result.packages.data(),
+                        source,
+                        result.packages.size() * sizeof(SharedPackageMetrics));
+        source += result.packages.size() * sizeof(SharedPackageMetrics);
+        loadSharedWords(result.threads.data(),
+                        source,
+                        result.threads.size() * sizeof(SharedThreadMetrics));
+
+        // the snapshot is only consistent, if the publisher didn't write in the meantime
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if(__atomic_load_n(&header->sequence, __ATOMIC_RELAXED) == before) {
+            return true;
+        }
+    }
+
+    error.addMeesage("Failed to read consistent snapshot from shared segment");
+    error.addSolution("check if the publisher is still running");
+    return false;
+}
+
+} // namespace Kitsunemimi
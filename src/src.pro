@@ -10,16 +10,63 @@ LIBS += -L../../libKitsunemimiCommon/src/debug -lKitsunemimiCommon
 LIBS += -L../../libKitsunemimiCommon/src/release -lKitsunemimiCommon
 INCLUDEPATH += ../../libKitsunemimiCommon/include
 
+# shm_open for older glibc-versions
+LIBS += -lrt
+
 INCLUDEPATH += $$PWD \
                $$PWD/../include
 
 HEADERS += \
+    ../include/libKitsunemimiCpu/batched_reader.h \
+    ../include/libKitsunemimiCpu/cgroup.h \
+    ../include/libKitsunemimiCpu/core_latency.h \
     ../include/libKitsunemimiCpu/cpu.h \
+    ../include/libKitsunemimiCpu/cpu_hotplug.h \
+    ../include/libKitsunemimiCpu/cpu_set.h \
+    ../include/libKitsunemimiCpu/energy_attribution.h \
+    ../include/libKitsunemimiCpu/frequency_profile.h \
+    ../include/libKitsunemimiCpu/interrupts.h \
     ../include/libKitsunemimiCpu/memory.h \
-    ../include/libKitsunemimiCpu/rapl.h
+    ../include/libKitsunemimiCpu/memory_probe.h \
+    ../include/libKitsunemimiCpu/metrics_exporter.h \
+    ../include/libKitsunemimiCpu/msr.h \
+    ../include/libKitsunemimiCpu/page_migration.h \
+    ../include/libKitsunemimiCpu/placement.h \
+    ../include/libKitsunemimiCpu/power_model.h \
+    ../include/libKitsunemimiCpu/prefetcher.h \
+    ../include/libKitsunemimiCpu/pressure.h \
+    ../include/libKitsunemimiCpu/process_memory.h \
+    ../include/libKitsunemimiCpu/rapl.h \
+    ../include/libKitsunemimiCpu/resctrl.h \
+    ../include/libKitsunemimiCpu/sample_recorder.h \
+    ../include/libKitsunemimiCpu/shared_metrics.h \
+    ../include/libKitsunemimiCpu/tsc_clock.h \
+    ../include/libKitsunemimiCpu/uncore.h
 
 SOURCES += \
+    batched_reader.cpp \
+    cgroup.cpp \
+    core_latency.cpp \
     cpu.cpp \
+    cpu_hotplug.cpp \
+    cpu_set.cpp \
+    energy_attribution.cpp \
+    frequency_profile.cpp \
+    interrupts.cpp \
     memory.cpp \
-    rapl.cpp
+    memory_probe.cpp \
+    metrics_exporter.cpp \
+    msr.cpp \
+    page_migration.cpp \
+    placement.cpp \
+    power_model.cpp \
+    prefetcher.cpp \
+    pressure.cpp \
+    process_memory.cpp \
+    rapl.cpp \
+    resctrl.cpp \
+    sample_recorder.cpp \
+    shared_metrics.cpp \
+    tsc_clock.cpp \
+    uncore.cpp
 
@@ -0,0 +1,164 @@
+/**
+ *  @file       tsc_clock.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/tsc_clock.h>
+
+#include <fstream>
+#include <string>
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief read a pair of tsc-value and CLOCK_MONOTONIC_RAW, which belong together as close as
+ *        possible. The pair with the shortest time between the two tsc-reads is used.
+ *
+ * @param ticks reference for the tsc-value
+ * @param nanoSec reference for the clock-value in nanoseconds
+ */
+void
+readTscClockPair(uint64_t &ticks,
+                 uint64_t &nanoSec)
+{
+    uint64_t bestWindow = UINT64_MAX;
+    for(uint32_t i = 0; i < 16; i++)
+    {
+        struct timespec time;
+        const uint64_t before = TscClock::readTicks();
+        clock_gettime(CLOCK_MONOTONIC_RAW, &time);
+        const uint64_t after = TscClock::readTicks();
+
+        if(after - before < bestWindow)
+        {
+            bestWindow = after - before;
+            ticks = before + (after - before) / 2;
+            nanoSec = static_cast<uint64_t>(time.tv_sec) * 1000000000ULL
+                      + static_cast<uint64_t>(time.tv_nsec);
+        }
+    }
+}
+
+/**
+ * @brief get the global clock, which is calibrated at the first call
+ */
+TscClock*
+TscClock::getInstance()
+{
+    static TscClock instance;
+    return &instance;
+}
+
+/**
+ * @brief constructor
+ */
+TscClock::TscClock()
+{
+    checkFeatures();
+    calibrate();
+}
+
+/**
+ * @brief check with cpuid if the tsc is invariant, so it runs with constant rate in all
+ *        p-, c- and t-states and is synchronized between all cores
+ */
+void
+TscClock::checkFeatures()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t eax = 0;
+    uint32_t ebx = 0;
+    uint32_t ecx = 0;
+    uint32_t edx = 0;
+
+    // get highest extended leaf
+    __asm__("cpuid;" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "0"(0x80000000));
+    if(eax >= 0x80000007)
+    {
+        __asm__("cpuid;" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "0"(0x80000007));
+        m_isInvariant = (edx >> 8) & 0x1;
+    }
+#endif
+
+    // constant rate without invariance in deep c-states is only provided as flag by the kernel
+    m_isConstant = m_isInvariant;
+    std::ifstream inFile("/proc/cpuinfo");
+    std::string line;
+    while(m_isConstant == false
+          && std::getline(inFile, line))
+    {
+        if(line.compare(0, 5, "flags") != 0) {
+            continue;
+        }
+        m_isConstant = line.find(" constant_tsc") != std::string::npos;
+        break;
+    }
+}
+
+/**
+ * @brief measure the rate of the tsc against CLOCK_MONOTONIC_RAW, which is not affected by
+ *        ntp-adjustments
+ */
+void
+TscClock::calibrate()
+{
+    uint64_t startTicks = 0;
+    uint64_t startNs = 0;
+    uint64_t endTicks = 0;
+    uint64_t endNs = 0;
+
+    readTscClockPair(startTicks, startNs);
+
+    // busy-wait instead of sleep, so the cpu-thread is not changed in the meantime
+    const uint64_t calibrationTimeNs = 20000000;
+    readTscClockPair(endTicks, endNs);
+    while(endNs - startNs < calibrationTimeNs) {
+        readTscClockPair(endTicks, endNs);
+    }
+
+    m_ticksPerNs = static_cast<double>(endTicks - startTicks)
+                   / static_cast<double>(endNs - startNs);
+    if(m_ticksPerNs <= 0.0)
+    {
+        // no usable tsc, so timestamps fall back to the clock
+        m_isInvariant = false;
+        m_ticksPerNs = 1.0;
+    }
+    m_nsPerTick = static_cast<uint64_t>((1.0 / m_ticksPerNs) * 4294967296.0);
+
+    m_baseTicks = endTicks;
+    m_baseNs = endNs;
+}
+
+/**
+ * @brief check if the tsc is invariant and so timestamps are read from the tsc
+ */
+bool
+TscClock::isInvariant() const
+{
+    return m_isInvariant;
+}
+
+/**
+ * @brief check if the tsc runs with constant rate independent of the cpu-frequency
+ */
+bool
+TscClock::isConstant() const
+{
+    return m_isConstant;
+}
+
+/**
+ * @brief get calibrated rate of the tsc
+ */
+double
+TscClock::getTicksPerNanoSec() const
+{
+    return m_ticksPerNs;
+}
+
+} // namespace Kitsunemimi
@@ -0,0 +1,470 @@
+/**
+ *  @file       uncore.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/uncore.h>
+#include <libKitsunemimiCpu/cpu.h>
+#include <libKitsunemimiCpu/msr.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+#include <unistd.h>
+
+namespace Kitsunemimi
+{
+
+#define MSR_UNCORE_RATIO_LIMIT  0x620
+#define MSR_UNCORE_PERF_STATUS  0x621
+
+const std::string uncoreBasePath = "/sys/devices/system/cpu/intel_uncore_frequency";
+
+// the ratios of the msr are multiples of 100 MHz
+const uint64_t uncoreRatioToKHz = 100000;
+
+/**
+ * @brief read a single value of a sysfs-file of the uncore-driver
+ *
+ * @return false, if the file doesn't exist, else true
+ */
+bool
+readUncoreValue(uint64_t &result,
+                const std::string &filePath)
+{
+    std::ifstream inFile(filePath);
+    if(inFile.is_open() == false) {
+        return false;
+    }
+
+    inFile >> result;
+    return inFile.fail() == false;
+}
+
+/**
+ * @brief write a single value into a sysfs-file of the uncore-driver
+ */
+bool
+writeUncoreValue(const std::string &filePath,
+                 const uint64_t value,
+                 ErrorContainer &error)
+{
+    std::ofstream outFile(filePath);
+    if(outFile.is_open() == false)
+    {
+        error.addMeesage("can not open file to write content: '" + filePath + "'");
+        error.addSolution("check if you have write-permissions to the file '" + filePath + "'");
+        return false;
+    }
+
+    // the kernel rejects invalid values only while flushing
+    outFile << value;
+    outFile.flush();
+    if(outFile.fail())
+    {
+        error.addMeesage("Failed to write value '"
+                         + std::to_string(value)
+                         + "' into file '"
+                         + filePath
+                         + "'");
+        error.addSolution("check if the value is within the initial limits of the uncore");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief read the uncore-frequencies from the intel_uncore_frequency-driver. Old kernels have
+ *        directories like "package_00_die_00" and newer kernels with tpmi-support directories
+ *        like "uncore00" with additional files for the ids.
+ *
+ * @param result reference for result-output
+ *
+ * @return false, if the driver is not available, else true
+ */
+bool
+getUncoreFromSysfs(std::vector<UncoreFrequency> &result)
+{
+    std::error_code ec;
+    if(std::filesystem::is_directory(uncoreBasePath, ec) == false) {
+        return false;
+    }
+
+    for(const auto &entry : std::filesystem::directory_iterator(uncoreBasePath, ec))
+    {
+        const std::string name = entry.path().filename().string();
+        const std::string path = entry.path().string();
+
+        UncoreFrequency frequency;
+        frequency.sysfsPath = path;
+        if(name.compare(0, 8, "package_") == 0)
+        {
+            // format: package_<package>_die_<die>
+            const size_t diePos = name.find("_die_");
+            if(diePos == std::string::npos) {
+                continue;
+            }
+            frequency.packageId = std::stoull(name.substr(8, diePos - 8));
+            frequency.dieId = std::stoull(name.substr(diePos + 5));
+        }
+        else if(name.compare(0, 6, "uncore") == 0)
+        {
+            if(readUncoreValue(frequency.packageId, path + "/package_id") == false
+                    || readUncoreValue(frequency.dieId, path + "/domain_id") == false)
+            {
+                continue;
+            }
+        }
+        else
+        {
+            continue;
+        }
+
+        if(readUncoreValue(frequency.minimum, path + "/min_freq_khz") == false
+                || readUncoreValue(frequency.maximum, path + "/max_freq_khz") == false)
+        {
+            continue;
+        }
+        readUncoreValue(frequency.initialMinimum, path + "/initial_min_freq_khz");
+        readUncoreValue(frequency.initialMaximum, path + "/initial_max_freq_khz");
+        readUncoreValue(frequency.current, path + "/current_freq_khz");
+
+        result.push_back(frequency);
+    }
+
+    return result.size() > 0;
+}
+
+/**
+ * @brief get id of the first cpu-thread of a package to access the msr of the package
+ */
+bool
+getUncoreMsrThread(uint64_t &result,
+                   const uint64_t packageId,
+                   ErrorContainer &error)
+{
+    CpuSet threads;
+    if(getCpuThreadsOfPackage(threads, packageId, error) == false) {
+        return false;
+    }
+    if(threads.isEmpty())
+    {
+        error.addMeesage("No online cpu-thread found for package '"
+                         + std::to_string(packageId)
+                         + "'");
+        return false;
+    }
+
+    result = threads.getFirst();
+    return true;
+}
+
+/**
+ * @brief read the uncore-frequencies of each package from MSR_UNCORE_RATIO_LIMIT and
+ *        MSR_UNCORE_PERF_STATUS. The initial limits are not available in this case.
+ *
+ * @param result reference for result-output
+ * @param error reference for error-output
+ *
+ * @return false, if the msr can not be read, else true
+ */
+bool
+getUncoreFromMsr(std::vector<UncoreFrequency> &result,
+                 ErrorContainer &error)
+{
+    // the numa-nodes are not usable here, because of sub-numa-clustering and empty nodes, so
+    // the packages are taken from the online cpu-threads with the first thread of each package
+    CpuSet online;
+    std::vector<uint64_t> packageIds;
+    if(getOnlineCpuThreads(online, error) == false
+            || getCpuPackageId(packageIds, online, error) == false)
+    {
+        return false;
+    }
+    std::map<uint64_t, uint64_t> packageThreads;
+    uint64_t pos = 0;
+    for(const uint64_t threadId : online)
+    {
+        packageThreads.emplace(packageIds[pos], threadId);
+        pos++;
+    }
+
+    for(const auto &[packageId, threadId] : packageThreads)
+    {
+        uint64_t limit = 0;
+        uint64_t status = 0;
+        if(readMsr(limit, threadId, MSR_UNCORE_RATIO_LIMIT, error) == false) {
+            return false;
+        }
+
+        // bits 6:0 are the maximum- and bits 14:8 the minimum-ratio
+        UncoreFrequency frequency;
+        frequency.packageId = packageId;
+        frequency.maximum = (limit & 0x7f) * uncoreRatioToKHz;
+        frequency.minimum = ((limit >> 8) & 0x7f) * uncoreRatioToKHz;
+
+        // the status-register is not supported by all cpus, so it's optional
+        ErrorContainer statusError;
+        if(readMsr(status, threadId, MSR_UNCORE_PERF_STATUS, statusError)) {
+            frequency.current = (status & 0x7f) * uncoreRatioToKHz;
+        }
+
+        result.push_back(frequency);
+    }
+
+    return true;
+}
+
+/**
+ * @brief get uncore-frequencies of all packages and dies from the intel_uncore_frequency-driver
+ *        or, if the driver is not loaded, from the msr of each package
+ *
+ * @param result reference for result-output
+ * @param error reference for error-output
+ *
+ * @return false, if neither driver nor msr are available, else true
+ */
+bool
+getUncoreFrequencies(std::vector<UncoreFrequency> &result,
+                     ErrorContainer &error)
+{
+    result.clear();
+    if(getUncoreFromSysfs(result)) {
+        return true;
+    }
+
+    if(getUncoreFromMsr(result, error) == false)
+    {
+        error.addMeesage("Failed to get uncore-frequencies");
+        error.addSolution("load the kernel-module with \"modprobe intel-uncore-frequency\"");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief set limits of a single uncore-entry
+ *
+ * @param frequency entry to update
+ * @param minimum new minimum in kHz
+ * @param maximum new maximum in kHz
+ * @param error reference for error-output
+ *
+ * @return false, if the limits can not be set, else true
+ */
+bool
+applyUncoreLimits(const UncoreFrequency &frequency,
+                  const uint64_t minimum,
+                  const uint64_t maximum,
+                  ErrorContainer &error)
+{
+    if(minimum > maximum)
+    {
+        error.addMeesage("Failed to set uncore-frequency, because minimum '"
+                         + std::to_string(minimum)
+                         + "' is bigger than maximum '"
+                         + std::to_string(maximum)
+                         + "'");
+        return false;
+    }
+
+    if(frequency.sysfsPath != "")
+    {
+        // the kernel rejects a minimum above the current maximum and the other way round,
+        // so the order depends on the direction of the change
+        const std::string minPath = frequency.sysfsPath + "/min_freq_khz";
+        const std::string maxPath = frequency.sysfsPath + "/max_freq_khz";
+        if(minimum > frequency.maximum)
+        {
+            return writeUncoreValue(maxPath, maximum, error)
+                   && writeUncoreValue(minPath, minimum, error);
+        }
+        return writeUncoreValue(minPath, minimum, error)
+               && writeUncoreValue(maxPath, maximum, error);
+    }
+
+    uint64_t threadId = 0;
+    if(getUncoreMsrThread(threadId, frequency.packageId, error) == false) {
+        return false;
+    }
+
+    const int fd = openMsr(threadId, true, error);
+    if(fd < 0) {
+        return false;
+    }
+
+    // keep the reserved bits of the register
+    uint64_t limit = 0;
+    bool success = readMsrFd(limit, fd, MSR_UNCORE_RATIO_LIMIT, error);
+    if(success)
+    {
+        limit &= ~static_cast<uint64_t>(0x7f7f);
+        limit |= (maximum / uncoreRatioToKHz) & 0x7f;
+        limit |= ((minimum / uncoreRatioToKHz) & 0x7f) << 8;
+        success = writeMsrFd(fd, MSR_UNCORE_RATIO_LIMIT, limit, error);
+    }
+    close(fd);
+
+    return success;
+}
+
+/**
+ * @brief set limits of the uncore-frequency of all dies of a package
+ *
+ * @param packageId id of the package
+ * @param minimum new minimum in kHz
+ * @param maximum new maximum in kHz
+ * @param error reference for error-output
+ *
+ * @return false, if package was not found or the limits can not be set, else true
+ */
+bool
+setUncoreFrequency(const uint64_t packageId,
+                   const uint64_t minimum,
+                   const uint64_t maximum,
+                   ErrorContainer &error)
+{
+    const std::vector<uint64_t> packageIds = {packageId};
+    return setUncoreFrequency(packageIds, minimum, maximum, error);
+}
+
+/**
+ * @brief set limits of the uncore-frequency of multiple packages with only one scan of the
+ *        available uncore-entries
+ *
+ * @param packageIds ids of the packages
+ * @param minimum new minimum in kHz
+ * @param maximum new maximum in kHz
+ * @param error reference for error-output
+ *
+ * @return false, if any package was not found or the limits can not be set, else true
+ */
+bool
+setUncoreFrequency(const std::vector<uint64_t> &packageIds,
+                   const uint64_t minimum,
+                   const uint64_t maximum,
+                   ErrorContainer &error)
+{
+    std::vector<UncoreFrequency> frequencies;
+    if(getUncoreFrequencies(frequencies, error) == false) {
+        return false;
+    }
+
+    for(const uint64_t packageId : packageIds)
+    {
+        bool found = false;
+        for(const UncoreFrequency &frequency : frequencies)
+        {
+            if(frequency.packageId != packageId) {
+                continue;
+            }
+
+            found = true;
+            if(applyUncoreLimits(frequency, minimum, maximum, error) == false)
+            {
+                error.addMeesage("Failed to set uncore-frequency of package '"
+                                 + std::to_string(packageId)
+                                 + "'");
+                return false;
+            }
+        }
+
+        if(found == false)
+        {
+            error.addMeesage("No uncore found for package '" + std::to_string(packageId) + "'");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief restore limits of the uncore-frequencies, which were captured before with
+ *        getUncoreFrequencies
+ *
+ * @param state captured uncore-frequencies
+ * @param error reference for error-output
+ *
+ * @return false, if any limit can not be restored, else true
+ */
+bool
+restoreUncoreFrequencies(const std::vector<UncoreFrequency> &state,
+                         ErrorContainer &error)
+{
+    // the current limits are necessary to get the correct order of the writes
+    std::vector<UncoreFrequency> current;
+    if(getUncoreFrequencies(current, error) == false) {
+        return false;
+    }
+
+    for(const UncoreFrequency &saved : state)
+    {
+        const auto it = std::find_if(current.begin(),
+                                     current.end(),
+                                     [&](const UncoreFrequency &frequency) {
+            return frequency.packageId == saved.packageId
+                   && frequency.dieId == saved.dieId;
+        });
+        if(it == current.end()) {
+            continue;
+        }
+
+        if(applyUncoreLimits(*it, saved.minimum, saved.maximum, error) == false)
+        {
+            error.addMeesage("Failed to restore uncore-frequency of package '"
+                             + std::to_string(saved.packageId)
+                             + "'");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief reset limits of all uncore-frequencies to the initial limits of the driver
+ *
+ * @param error reference for error-output
+ *
+ * @return false, if initial limits are not available or can not be set, else true
+ */
+bool
+resetUncoreFrequencies(ErrorContainer &error)
+{
+    std::vector<UncoreFrequency> frequencies;
+    if(getUncoreFrequencies(frequencies, error) == false) {
+        return false;
+    }
+
+    for(const UncoreFrequency &frequency : frequencies)
+    {
+        if(frequency.initialMaximum == 0)
+        {
+            error.addMeesage("Failed to reset uncore-frequency, because initial limits are "
+                             "only available with the intel_uncore_frequency-driver");
+            error.addSolution("capture the limits with getUncoreFrequencies before changing "
+                              "them and use restoreUncoreFrequencies");
+            return false;
+        }
+
+        if(applyUncoreLimits(frequency,
+                             frequency.initialMinimum,
+                             frequency.initialMaximum,
+                             error) == false)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace Kitsunemimi
@@ -4,6 +4,7 @@
 #include <libKitsunemimiCpu/cpu.h>
 #include <libKitsunemimiCpu/rapl.h>
 #include <libKitsunemimiCpu/memory.h>
+#include <libKitsunemimiCpu/placement.h>
 #include <libKitsunemimiCommon/logger.h>
 #include <libKitsunemimiCommon/threading/thread.h>
 
@@ -27,6 +28,8 @@ int main()
     std::cout<<"total: "<<getTotalMemory()<<std::endl;
     std::cout<<"free: "<<getFreeMemory()<<std::endl;
     std::cout<<"page-size: "<<getPageSize()<<std::endl;
+    std::cout<<"container total: "<<getContainerTotalMemory()<<std::endl;
+    std::cout<<"container free: "<<getContainerFreeMemory()<<std::endl;
 
     //==============================================================================================
 
@@ -41,6 +44,9 @@ int main()
     getCpuPackageId(socketOfThread, 1, error);
     getCpuSiblingId(siblingId, 1, error);
     std::cout<<"threads: "<<numberOfThreads<<std::endl;
+    uint64_t usableThreads = 0;
+    getNumberOfUsableCpuThreads(usableThreads, error);
+    std::cout<<"usable threads: "<<usableThreads<<std::endl;
     std::cout<<"sockets: "<<numberOfSockets<<std::endl;
     std::cout<<"socket of thead 1: "<<socketOfThread<<std::endl;
     std::cout<<"sibling of thread 1: "<<siblingId<<std::endl;
@@ -147,5 +153,28 @@ int main()
 
     //==============================================================================================
 
+    std::cout<<"=============================PLACEMENT============================="<<std::endl;
+
+    PlacementAdvisor advisor;
+    if(advisor.initAdvisor(error))
+    {
+        sleep(1);
+        advisor.updateState(error);
+
+        PlacementPlan plan;
+        advisor.createPlan(plan, 4, MAX_THROUGHPUT_POLICY, error);
+        std::cout<<"max-throughput:\n"<<plan.toString()<<std::endl;
+        advisor.createPlan(plan, 4, MIN_ENERGY_POLICY, error);
+        std::cout<<"min-energy:\n"<<plan.toString()<<std::endl;
+        advisor.createPlan(plan, 4, THERMAL_BALANCE_POLICY, error);
+        std::cout<<"thermal-balance:\n"<<plan.toString()<<std::endl;
+    }
+    else
+    {
+        LOG_ERROR(error);
+    }
+
+    //==============================================================================================
+
     return 0;
 }
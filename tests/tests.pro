@@ -4,6 +4,7 @@ QT -= qt core gui
 CONFIG += c++17
 
 SUBDIRS = \
-    cli_tests
+    cli_tests \
+    unit_tests
 
 tests.depends = src
@@ -0,0 +1,157 @@
+/**
+ *  @file       batched_reader_test.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include "batched_reader_test.h"
+
+#include <libKitsunemimiCpu/batched_reader.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include <stdlib.h>
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief write a test-file with the given content
+ */
+void
+writeBatchedReaderTestFile(const std::string &filePath,
+                           const std::string &content)
+{
+    std::ofstream outFile(filePath, std::ios::trunc);
+    outFile << content;
+}
+
+/**
+ * @brief get content of a read as string, which is empty for failed reads
+ */
+const std::string
+getBatchedReaderContent(const BatchedReader &reader,
+                        const uint64_t readId)
+{
+    const char* content = reader.getContent(readId);
+    if(content == nullptr) {
+        return "";
+    }
+
+    return std::string(content);
+}
+
+/**
+ * @brief register the same reads of all test-files at a reader and initialize it
+ */
+bool
+initBatchedTestReader(BatchedReader &reader,
+                      std::vector<uint64_t> &readIds,
+                      const std::string &rootPath,
+                      const bool useIoUring)
+{
+    ErrorContainer error;
+    readIds.assign(4, 0);
+    return reader.addFile(readIds[0], rootPath + "/number", 64, error)
+           && reader.addFile(readIds[1], rootPath + "/text", 4096, error)
+           && reader.addFile(readIds[2], rootPath + "/text", 10, error)
+           && reader.addFile(readIds[3], rootPath + "/empty", 64, error)
+           && reader.initReader(useIoUring, error);
+}
+
+/**
+ * @brief constructor
+ */
+BatchedReader_Test::BatchedReader_Test()
+    : Kitsunemimi::CompareTestHelper("BatchedReader_Test")
+{
+    char pathTemplate[] = "/tmp/KitsunemimiCpu_batched_reader_test_XXXXXX";
+    if(mkdtemp(pathTemplate) == nullptr) {
+        return;
+    }
+    m_rootPath = pathTemplate;
+
+    writeBatchedReaderTestFile(m_rootPath + "/number", "2400000\n");
+    writeBatchedReaderTestFile(m_rootPath + "/text", std::string(300, 'a') + " 42 end\n");
+    writeBatchedReaderTestFile(m_rootPath + "/empty", "");
+
+    compareBackends_test();
+    rereadFiles_test();
+
+    std::filesystem::remove_all(m_rootPath);
+}
+
+/**
+ * @brief compareBackends_test
+ */
+void
+BatchedReader_Test::compareBackends_test()
+{
+    // if io_uring is not available, the first reader falls back to preadv, so both have to
+    // return the same results in any case
+    BatchedReader ringReader;
+    BatchedReader preadvReader;
+    std::vector<uint64_t> ringIds;
+    std::vector<uint64_t> preadvIds;
+    TEST_EQUAL(initBatchedTestReader(ringReader, ringIds, m_rootPath, true), true);
+    TEST_EQUAL(initBatchedTestReader(preadvReader, preadvIds, m_rootPath, false), true);
+    TEST_EQUAL(preadvReader.isUsingIoUring(), false);
+
+    ErrorContainer error;
+    TEST_EQUAL(ringReader.readAll(error), true);
+    TEST_EQUAL(preadvReader.readAll(error), true);
+
+    for(uint64_t i = 0; i < ringIds.size(); i++)
+    {
+        TEST_EQUAL(ringReader.getResult(ringIds[i]), preadvReader.getResult(preadvIds[i]));
+        TEST_EQUAL(getBatchedReaderContent(ringReader, ringIds[i]),
+                   getBatchedReaderContent(preadvReader, preadvIds[i]));
+    }
+
+    // expected content independent of the backend
+    int64_t number = 0;
+    TEST_EQUAL(ringReader.getNumber(number, ringIds[0]), true);
+    TEST_EQUAL(number, 2400000);
+    TEST_EQUAL(getBatchedReaderContent(ringReader, ringIds[1]),
+               std::string(300, 'a') + " 42 end\n");
+    TEST_EQUAL(getBatchedReaderContent(ringReader, ringIds[2]), std::string(10, 'a'));
+    TEST_EQUAL(ringReader.getResult(ringIds[3]), 0);
+    TEST_EQUAL(ringReader.getContent(ringIds[3]) == nullptr, true);
+}
+
+/**
+ * @brief rereadFiles_test
+ */
+void
+BatchedReader_Test::rereadFiles_test()
+{
+    BatchedReader ringReader;
+    BatchedReader preadvReader;
+    std::vector<uint64_t> ringIds;
+    std::vector<uint64_t> preadvIds;
+    TEST_EQUAL(initBatchedTestReader(ringReader, ringIds, m_rootPath, true), true);
+    TEST_EQUAL(initBatchedTestReader(preadvReader, preadvIds, m_rootPath, false), true);
+
+    ErrorContainer error;
+    TEST_EQUAL(ringReader.readAll(error), true);
+    TEST_EQUAL(preadvReader.readAll(error), true);
+
+    // each tick reads the already opened files again from the beginning
+    writeBatchedReaderTestFile(m_rootPath + "/number", "800\n");
+    TEST_EQUAL(ringReader.readAll(error), true);
+    TEST_EQUAL(preadvReader.readAll(error), true);
+
+    int64_t ringNumber = 0;
+    int64_t preadvNumber = 0;
+    TEST_EQUAL(ringReader.getNumber(ringNumber, ringIds[0]), true);
+    TEST_EQUAL(preadvReader.getNumber(preadvNumber, preadvIds[0]), true);
+    TEST_EQUAL(ringNumber, 800);
+    TEST_EQUAL(preadvNumber, 800);
+    TEST_EQUAL(getBatchedReaderContent(ringReader, ringIds[0]), "800\n");
+    TEST_EQUAL(getBatchedReaderContent(preadvReader, preadvIds[0]), "800\n");
+}
+
+} // namespace Kitsunemimi
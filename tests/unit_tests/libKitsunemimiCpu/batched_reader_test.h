@@ -0,0 +1,33 @@
+/**
+ *  @file       batched_reader_test.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_BATCHED_READER_TEST_H
+#define KITSUNEMIMI_CPU_BATCHED_READER_TEST_H
+
+#include <string>
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+
+class BatchedReader_Test : public Kitsunemimi::CompareTestHelper
+{
+public:
+    BatchedReader_Test();
+
+private:
+    std::string m_rootPath = "";
+
+    void compareBackends_test();
+    void rereadFiles_test();
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_BATCHED_READER_TEST_H
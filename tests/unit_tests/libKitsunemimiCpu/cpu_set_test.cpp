@@ -0,0 +1,108 @@
+/**
+ *  @file       cpu_set_test.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include "cpu_set_test.h"
+
+#include <libKitsunemimiCpu/cpu_set.h>
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief constructor
+ */
+CpuSet_Test::CpuSet_Test()
+    : Kitsunemimi::CompareTestHelper("CpuSet_Test")
+{
+    parse_test();
+    brokenList_test();
+    toString_test();
+}
+
+/**
+ * @brief parse_test
+ */
+void
+CpuSet_Test::parse_test()
+{
+    CpuSet cpuSet;
+
+    TEST_EQUAL(cpuSet.parse("0-3,8-11,16\n"), true);
+    TEST_EQUAL(cpuSet.count(), 9);
+    TEST_EQUAL(cpuSet.contains(3), true);
+    TEST_EQUAL(cpuSet.contains(4), false);
+    TEST_EQUAL(cpuSet.contains(16), true);
+    TEST_EQUAL(cpuSet.getFirst(), 0);
+    TEST_EQUAL(cpuSet.getLast(), 16);
+
+    // ids above a single word of the bitmask
+    TEST_EQUAL(cpuSet.parse("63-64,200"), true);
+    TEST_EQUAL(cpuSet.count(), 3);
+    TEST_EQUAL(cpuSet.contains(64), true);
+    TEST_EQUAL(cpuSet.contains(200), true);
+
+    // empty content of the offline-file
+    TEST_EQUAL(cpuSet.parse("\n"), true);
+    TEST_EQUAL(cpuSet.isEmpty(), true);
+
+    // highest accepted id
+    TEST_EQUAL(cpuSet.parse("65535"), true);
+    TEST_EQUAL(cpuSet.getLast(), 65535);
+}
+
+/**
+ * @brief brokenList_test
+ */
+void
+CpuSet_Test::brokenList_test()
+{
+    CpuSet cpuSet;
+
+    TEST_EQUAL(cpuSet.parse("1-"), false);
+    TEST_EQUAL(cpuSet.parse("-1"), false);
+    TEST_EQUAL(cpuSet.parse("0,"), false);
+    TEST_EQUAL(cpuSet.parse(",0"), false);
+    TEST_EQUAL(cpuSet.parse("0,,1"), false);
+    TEST_EQUAL(cpuSet.parse("3-1"), false);
+    TEST_EQUAL(cpuSet.parse("1-2-3"), false);
+    TEST_EQUAL(cpuSet.parse("+1"), false);
+    TEST_EQUAL(cpuSet.parse("0, 1"), false);
+    TEST_EQUAL(cpuSet.parse("a"), false);
+    TEST_EQUAL(cpuSet.parse("65536"), false);
+    TEST_EQUAL(cpuSet.parse("0-4294967295"), false);
+
+    // a failed parse never leaves a partial set
+    cpuSet.add(5);
+    TEST_EQUAL(cpuSet.parse("0-3,x"), false);
+    TEST_EQUAL(cpuSet.isEmpty(), true);
+}
+
+/**
+ * @brief toString_test
+ */
+void
+CpuSet_Test::toString_test()
+{
+    CpuSet cpuSet;
+    TEST_EQUAL(cpuSet.toString(), "");
+
+    cpuSet.add(0);
+    cpuSet.add(1);
+    cpuSet.add(2);
+    cpuSet.add(4);
+    cpuSet.add(63);
+    cpuSet.add(64);
+    TEST_EQUAL(cpuSet.toString(), "0-2,4,63-64");
+
+    // output has to be parsable again into the same set
+    CpuSet parsed;
+    TEST_EQUAL(parsed.parse(cpuSet.toString()), true);
+    TEST_EQUAL(parsed == cpuSet, true);
+}
+
+} // namespace Kitsunemimi
@@ -0,0 +1,30 @@
+/**
+ *  @file       cpu_set_test.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_CPU_SET_TEST_H
+#define KITSUNEMIMI_CPU_CPU_SET_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+
+class CpuSet_Test : public Kitsunemimi::CompareTestHelper
+{
+public:
+    CpuSet_Test();
+
+private:
+    void parse_test();
+    void brokenList_test();
+    void toString_test();
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_CPU_SET_TEST_H
@@ -0,0 +1,101 @@
+/**
+ *  @file       cpu_test.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include "cpu_test.h"
+
+#include <libKitsunemimiCpu/cpu.h>
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief constructor
+ */
+Cpu_Test::Cpu_Test()
+    : Kitsunemimi::CompareTestHelper("Cpu_Test")
+{
+    parseKernelCpuList_test();
+    parseCpuThreadTimes_test();
+}
+
+/**
+ * @brief parseKernelCpuList_test
+ */
+void
+Cpu_Test::parseKernelCpuList_test()
+{
+    CpuSet result;
+
+    // format of the sysfs
+    TEST_EQUAL(parseKernelCpuList(result, {"2-5", "8"}, 15), true);
+    TEST_EQUAL(result.toString(), "2-5,8");
+
+    // "N" for the last possible cpu-thread
+    result.clear();
+    TEST_EQUAL(parseKernelCpuList(result, {"12-N"}, 15), true);
+    TEST_EQUAL(result.toString(), "12-15");
+
+    // first 2 of each group of 4 cpu-threads
+    result.clear();
+    TEST_EQUAL(parseKernelCpuList(result, {"0-15:2/4"}, 15), true);
+    TEST_EQUAL(result.toString(), "0-1,4-5,8-9,12-13");
+
+    // cpu-threads beyond the possible ones are ignored like by the kernel
+    result.clear();
+    TEST_EQUAL(parseKernelCpuList(result, {"6-100"}, 7), true);
+    TEST_EQUAL(result.toString(), "6-7");
+
+    // broken lists
+    result.clear();
+    TEST_EQUAL(parseKernelCpuList(result, {"5-2"}, 15), false);
+    TEST_EQUAL(parseKernelCpuList(result, {"1-"}, 15), false);
+    TEST_EQUAL(parseKernelCpuList(result, {""}, 15), false);
+    TEST_EQUAL(parseKernelCpuList(result, {"0-7:3"}, 15), false);
+    TEST_EQUAL(parseKernelCpuList(result, {"0-7:0/4"}, 15), false);
+    TEST_EQUAL(parseKernelCpuList(result, {"0-7:5/4"}, 15), false);
+    TEST_EQUAL(parseKernelCpuList(result, {"x"}, 15), false);
+}
+
+/**
+ * @brief parseCpuThreadTimes_test
+ */
+void
+Cpu_Test::parseCpuThreadTimes_test()
+{
+    // cpu-thread 1 is offline and the summary-line of all threads has to be ignored
+    const char* content = "cpu  1000 1000 1000 1000 1000 1000 1000 1000 0 0\n"
+                          "cpu0 10 20 30 400 50 6 7 80 0 0\n"
+                          "cpu2 1 2 3 4 5 6 7 8 0 0\n"
+                          "intr 12345 0 0\n"
+                          "ctxt 67890\n";
+    std::vector<CpuThreadTimes> times;
+    TEST_EQUAL(parseCpuThreadTimes(times, content), true);
+    TEST_EQUAL(times.size(), 3);
+    TEST_EQUAL(times[0].isValid, true);
+    TEST_EQUAL(times[1].isValid, false);
+    TEST_EQUAL(times[2].isValid, true);
+    TEST_EQUAL(times[0].ticks[0], 10);
+    TEST_EQUAL(times[0].ticks[7], 80);
+
+    // the steal-time is neither busy nor idle
+    TEST_EQUAL(times[0].getBusy(), 10 + 20 + 30 + 6 + 7);
+    TEST_EQUAL(times[0].getTotal(), 10 + 20 + 30 + 6 + 7 + 400 + 50);
+
+    // reused vector, where a now offline cpu-thread is reset
+    TEST_EQUAL(parseCpuThreadTimes(times, "cpu0 1 1 1 1 1 1 1 1 0 0\n"), true);
+    TEST_EQUAL(times.size(), 3);
+    TEST_EQUAL(times[0].ticks[0], 1);
+    TEST_EQUAL(times[2].isValid, false);
+    TEST_EQUAL(times[2].getTotal(), 0);
+
+    // content without any cpu-thread
+    TEST_EQUAL(parseCpuThreadTimes(times, "cpu  1 1 1 1 1 1 1 1 0 0\nintr 1\n"), false);
+    TEST_EQUAL(parseCpuThreadTimes(times, ""), false);
+}
+
+} // namespace Kitsunemimi
@@ -0,0 +1,29 @@
+/**
+ *  @file       cpu_test.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_CPU_TEST_H
+#define KITSUNEMIMI_CPU_CPU_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+
+class Cpu_Test : public Kitsunemimi::CompareTestHelper
+{
+public:
+    Cpu_Test();
+
+private:
+    void parseKernelCpuList_test();
+    void parseCpuThreadTimes_test();
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_CPU_TEST_H
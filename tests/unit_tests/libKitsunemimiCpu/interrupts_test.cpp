@@ -0,0 +1,93 @@
+/**
+ *  @file       interrupts_test.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include "interrupts_test.h"
+
+#include <libKitsunemimiCpu/interrupts.h>
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief constructor
+ */
+Interrupts_Test::Interrupts_Test()
+    : Kitsunemimi::CompareTestHelper("Interrupts_Test")
+{
+    deviceIrq_test();
+    architectureIrq_test();
+    brokenLine_test();
+}
+
+/**
+ * @brief deviceIrq_test
+ */
+void
+Interrupts_Test::deviceIrq_test()
+{
+    // cpu-thread 1 is offline, so the columns belong to the threads 0 and 2
+    const std::vector<uint64_t> columnIds = {0, 2};
+    InterruptInfo info;
+
+    TEST_EQUAL(parseInterruptLine(info,
+                                  " 43:  1673  5  PCI-MSIX-0000:00:05.0   1-edge      virtio4-rx",
+                                  columnIds), true);
+    TEST_EQUAL(info.name, "43");
+    TEST_EQUAL(info.isDeviceIrq, true);
+    TEST_EQUAL(info.irq, 43);
+    TEST_EQUAL(info.chip, "PCI-MSIX-0000:00:05.0");
+    TEST_EQUAL(info.actions, "virtio4-rx");
+    TEST_EQUAL(info.counts.size(), 3);
+    TEST_EQUAL(info.counts[0], 1673);
+    TEST_EQUAL(info.counts[1], 0);
+    TEST_EQUAL(info.counts[2], 5);
+    TEST_EQUAL(info.getTotal(), 1678);
+}
+
+/**
+ * @brief architectureIrq_test
+ */
+void
+Interrupts_Test::architectureIrq_test()
+{
+    const std::vector<uint64_t> columnIds = {0, 1};
+
+    InterruptInfo localTimer;
+    TEST_EQUAL(parseInterruptLine(localTimer,
+                                  "LOC:     100     200   Local timer interrupts",
+                                  columnIds), true);
+    TEST_EQUAL(localTimer.name, "LOC");
+    TEST_EQUAL(localTimer.isDeviceIrq, false);
+    TEST_EQUAL(localTimer.chip, "");
+    TEST_EQUAL(localTimer.actions, "Local timer interrupts");
+    TEST_EQUAL(localTimer.getTotal(), 300);
+
+    // lines with only a single value instead of one for each cpu-thread
+    InterruptInfo errors;
+    TEST_EQUAL(parseInterruptLine(errors, "ERR:          7", columnIds), true);
+    TEST_EQUAL(errors.name, "ERR");
+    TEST_EQUAL(errors.counts.size(), 2);
+    TEST_EQUAL(errors.counts[0], 7);
+    TEST_EQUAL(errors.getTotal(), 7);
+}
+
+/**
+ * @brief brokenLine_test
+ */
+void
+Interrupts_Test::brokenLine_test()
+{
+    const std::vector<uint64_t> columnIds = {0};
+    InterruptInfo info;
+
+    TEST_EQUAL(parseInterruptLine(info, "", columnIds), false);
+    TEST_EQUAL(parseInterruptLine(info, ":  1", columnIds), false);
+    TEST_EQUAL(parseInterruptLine(info, "CPU0", columnIds), false);
+}
+
+} // namespace Kitsunemimi
@@ -0,0 +1,30 @@
+/**
+ *  @file       interrupts_test.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_INTERRUPTS_TEST_H
+#define KITSUNEMIMI_CPU_INTERRUPTS_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+
+class Interrupts_Test : public Kitsunemimi::CompareTestHelper
+{
+public:
+    Interrupts_Test();
+
+private:
+    void deviceIrq_test();
+    void architectureIrq_test();
+    void brokenLine_test();
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_INTERRUPTS_TEST_H
@@ -0,0 +1,68 @@
+/**
+ *  @file       pressure_test.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include "pressure_test.h"
+
+#include <libKitsunemimiCpu/pressure.h>
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief constructor
+ */
+Pressure_Test::Pressure_Test()
+    : Kitsunemimi::CompareTestHelper("Pressure_Test")
+{
+    parsePressureLine_test();
+    brokenLine_test();
+}
+
+/**
+ * @brief parsePressureLine_test
+ */
+void
+Pressure_Test::parsePressureLine_test()
+{
+    PressureInfo info;
+
+    TEST_EQUAL(parsePressureLine(info, "some avg10=1.25 avg60=0.50 avg300=0.00 total=123456"),
+               true);
+    TEST_EQUAL(info.some.avg10, 1.25);
+    TEST_EQUAL(info.some.avg60, 0.5);
+    TEST_EQUAL(info.some.avg300, 0.0);
+    TEST_EQUAL(info.some.total, 123456);
+
+    // the full-line only updates the full-values
+    TEST_EQUAL(parsePressureLine(info, "full avg10=0.75 avg60=0.25 avg300=0.10 total=42"), true);
+    TEST_EQUAL(info.full.avg10, 0.75);
+    TEST_EQUAL(info.full.total, 42);
+    TEST_EQUAL(info.some.total, 123456);
+
+    // unknown keys of newer kernels are skipped
+    TEST_EQUAL(parsePressureLine(info, "some avg10=2.00 new=7 total=1"), true);
+    TEST_EQUAL(info.some.avg10, 2.0);
+    TEST_EQUAL(info.some.total, 1);
+}
+
+/**
+ * @brief brokenLine_test
+ */
+void
+Pressure_Test::brokenLine_test()
+{
+    PressureInfo info;
+
+    TEST_EQUAL(parsePressureLine(info, "other avg10=0.00"), false);
+    TEST_EQUAL(parsePressureLine(info, "some avg10=abc"), false);
+    TEST_EQUAL(parsePressureLine(info, "some avg10="), false);
+    TEST_EQUAL(parsePressureLine(info, "some total=12x"), false);
+    TEST_EQUAL(parsePressureLine(info, "some avg10"), false);
+}
+
+} // namespace Kitsunemimi
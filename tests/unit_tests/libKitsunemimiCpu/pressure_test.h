@@ -0,0 +1,29 @@
+/**
+ *  @file       pressure_test.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_PRESSURE_TEST_H
+#define KITSUNEMIMI_CPU_PRESSURE_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+
+class Pressure_Test : public Kitsunemimi::CompareTestHelper
+{
+public:
+    Pressure_Test();
+
+private:
+    void parsePressureLine_test();
+    void brokenLine_test();
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_PRESSURE_TEST_H
@@ -0,0 +1,239 @@
+/**
+ *  @file       resctrl_test.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include "resctrl_test.h"
+
+#include <libKitsunemimiCpu/resctrl.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief write a file of the synthesized resctrl-filesystem and create its directory
+ */
+void
+writeResctrlTestFile(const std::string &filePath,
+                     const std::string &content)
+{
+    std::filesystem::create_directories(std::filesystem::path(filePath).parent_path());
+    std::ofstream outFile(filePath);
+    outFile << content;
+}
+
+/**
+ * @brief read the first line of a file of the synthesized resctrl-filesystem
+ */
+const std::string
+readResctrlTestFile(const std::string &filePath)
+{
+    std::ifstream inFile(filePath);
+    std::string content = "";
+    std::getline(inFile, content);
+    return content;
+}
+
+/**
+ * @brief constructor
+ */
+Resctrl_Test::Resctrl_Test()
+    : Kitsunemimi::CompareTestHelper("Resctrl_Test")
+{
+    // synthesized resctrl-filesystem with 2 cache-domains in a temporary directory
+    char pathTemplate[] = "/tmp/KitsunemimiCpu_resctrl_test_XXXXXX";
+    if(mkdtemp(pathTemplate) == nullptr) {
+        return;
+    }
+    m_rootPath = pathTemplate;
+
+    writeResctrlTestFile(m_rootPath + "/info/L3/cbm_mask", "7ff\n");
+    writeResctrlTestFile(m_rootPath + "/info/L3/min_cbm_bits", "1\n");
+    writeResctrlTestFile(m_rootPath + "/info/L3/num_closids", "16\n");
+    writeResctrlTestFile(m_rootPath + "/info/MB/min_bandwidth", "10\n");
+    writeResctrlTestFile(m_rootPath + "/info/MB/bandwidth_gran", "10\n");
+    writeResctrlTestFile(m_rootPath + "/info/MB/num_closids", "8\n");
+    writeResctrlTestFile(m_rootPath + "/info/L3_MON/num_rmids", "128\n");
+    writeResctrlTestFile(m_rootPath + "/info/L3_MON/mon_features",
+                         "llc_occupancy\nmbm_total_bytes\nmbm_local_bytes\n");
+    writeResctrlTestFile(m_rootPath + "/schemata", "    L3:0=7ff;1=7ff\n    MB:0=100;1=100\n");
+
+    initResctrl_test();
+    groups_test();
+    schemata_test();
+    assignTask_test();
+    monitoring_test();
+
+    std::filesystem::remove_all(m_rootPath);
+}
+
+/**
+ * @brief initResctrl_test
+ */
+void
+Resctrl_Test::initResctrl_test()
+{
+    ErrorContainer error;
+
+    Resctrl missing(m_rootPath + "/not_existing");
+    TEST_EQUAL(missing.initResctrl(error), false);
+
+    Resctrl resctrl(m_rootPath);
+    TEST_EQUAL(resctrl.initResctrl(error), true);
+
+    const ResctrlInfo info = resctrl.getInfo();
+    TEST_EQUAL(info.supportL3, true);
+    TEST_EQUAL(info.cbmMask, 0x7ff);
+    TEST_EQUAL(info.numberOfL3Closids, 16);
+    TEST_EQUAL(info.supportMba, true);
+    TEST_EQUAL(info.minBandwidth, 10);
+    TEST_EQUAL(info.supportMonitoring, true);
+    TEST_EQUAL(info.numberOfRmids, 128);
+    TEST_EQUAL(info.monitoringFeatures.size(), 3);
+}
+
+/**
+ * @brief groups_test
+ */
+void
+Resctrl_Test::groups_test()
+{
+    ErrorContainer error;
+    Resctrl resctrl(m_rootPath);
+
+    // not initialized
+    TEST_EQUAL(resctrl.createGroup("group1", error), false);
+    TEST_EQUAL(std::filesystem::exists(m_rootPath + "/group1"), false);
+
+    resctrl.initResctrl(error);
+    TEST_EQUAL(resctrl.createGroup("group1", error), true);
+    TEST_EQUAL(resctrl.createGroup("group1", error), false);
+    TEST_EQUAL(resctrl.createGroup("", error), false);
+
+    // the kernel creates the files of a new group, so this is done here by the test
+    writeResctrlTestFile(m_rootPath + "/group1/schemata",
+                         "    L3:0=7ff;1=7ff\n    MB:0=100;1=100\n");
+    writeResctrlTestFile(m_rootPath + "/group1/tasks", "");
+
+    std::vector<std::string> groups;
+    TEST_EQUAL(resctrl.getGroups(groups, error), true);
+    TEST_EQUAL(groups.size(), 1);
+    TEST_EQUAL(groups.at(0), "group1");
+}
+
+/**
+ * @brief schemata_test
+ */
+void
+Resctrl_Test::schemata_test()
+{
+    ErrorContainer error;
+    Resctrl resctrl(m_rootPath);
+    resctrl.initResctrl(error);
+
+    TEST_EQUAL(resctrl.setL3Mask("group1", 1, 0x0f0, error), true);
+    TEST_EQUAL(resctrl.setMemoryBandwidth("group1", 0, 50, error), true);
+
+    // not contiguous, outside of the cbm-mask and out of range
+    TEST_EQUAL(resctrl.setL3Mask("group1", 0, 0x505, error), false);
+    TEST_EQUAL(resctrl.setL3Mask("group1", 0, 0x1000, error), false);
+    TEST_EQUAL(resctrl.setMemoryBandwidth("group1", 0, 5, error), false);
+
+    // only the changed domains are different
+    ResctrlSchemata schemata;
+    TEST_EQUAL(resctrl.getSchemata(schemata, "group1", error), true);
+    TEST_EQUAL(schemata.l3Masks.size(), 2);
+    TEST_EQUAL(schemata.l3Masks[0], 0x7ff);
+    TEST_EQUAL(schemata.l3Masks[1], 0x0f0);
+    TEST_EQUAL(schemata.mbaPercent.size(), 2);
+    TEST_EQUAL(schemata.mbaPercent[0], 50);
+    TEST_EQUAL(schemata.mbaPercent[1], 100);
+
+    // default-group is not changed
+    TEST_EQUAL(resctrl.getSchemata(schemata, "", error), true);
+    TEST_EQUAL(schemata.l3Masks[1], 0x7ff);
+
+    // broken values of the kernel are reported as error
+    const std::string schemataPath = m_rootPath + "/schemata";
+    writeResctrlTestFile(schemataPath, "    L3:x=7ff;1=7ff\n    MB:0=100;1=100\n");
+    TEST_EQUAL(resctrl.getSchemata(schemata, "", error), false);
+    writeResctrlTestFile(schemataPath, "    L3:0=7ff;1=zzz\n    MB:0=100;1=100\n");
+    TEST_EQUAL(resctrl.getSchemata(schemata, "", error), false);
+    writeResctrlTestFile(schemataPath, "    L3:0=7ff;1=7ff\n    MB:0=100;1=100\n");
+}
+
+/**
+ * @brief assignTask_test
+ */
+void
+Resctrl_Test::assignTask_test()
+{
+    ErrorContainer error;
+    Resctrl resctrl(m_rootPath);
+    resctrl.initResctrl(error);
+
+    TEST_EQUAL(resctrl.assignTask("group1", getpid(), error), true);
+    TEST_EQUAL(readResctrlTestFile(m_rootPath + "/group1/tasks"), std::to_string(getpid()));
+
+    CpuSet threads;
+    threads.add(0);
+    threads.add(1);
+    threads.add(4);
+    TEST_EQUAL(resctrl.assignCpuThreads("group1", threads, error), true);
+    TEST_EQUAL(readResctrlTestFile(m_rootPath + "/group1/cpus_list"), "0-1,4");
+}
+
+/**
+ * @brief monitoring_test
+ */
+void
+Resctrl_Test::monitoring_test()
+{
+    ErrorContainer error;
+    Resctrl resctrl(m_rootPath);
+    resctrl.initResctrl(error);
+
+    const std::string monPath = m_rootPath + "/group1/mon_data";
+    writeResctrlTestFile(monPath + "/mon_L3_01/llc_occupancy", "2048\n");
+    writeResctrlTestFile(monPath + "/mon_L3_01/mbm_total_bytes", "5000\n");
+    writeResctrlTestFile(monPath + "/mon_L3_01/mbm_local_bytes", "3000\n");
+    writeResctrlTestFile(monPath + "/mon_L3_00/llc_occupancy", "1024\n");
+    writeResctrlTestFile(monPath + "/mon_L3_00/mbm_total_bytes", "Unavailable\n");
+    writeResctrlTestFile(monPath + "/mon_L3_00/mbm_local_bytes", "1000\n");
+
+    // sorted by domain and unavailable counters stay zero
+    std::vector<ResctrlMonitorValues> values;
+    TEST_EQUAL(resctrl.getMonitorValues(values, "group1", error), true);
+    TEST_EQUAL(values.size(), 2);
+    TEST_EQUAL(values.at(0).domainId, 0);
+    TEST_EQUAL(values.at(0).llcOccupancy, 1024);
+    TEST_EQUAL(values.at(0).mbmTotalBytes, 0);
+    TEST_EQUAL(values.at(0).mbmLocalBytes, 1000);
+    TEST_EQUAL(values.at(1).domainId, 1);
+    TEST_EQUAL(values.at(1).mbmTotalBytes, 5000);
+
+    // sampler only returns the difference of the traffic-counters
+    ResctrlSampler sampler;
+    TEST_EQUAL(sampler.initSampler(&resctrl, "group1", error), true);
+    writeResctrlTestFile(monPath + "/mon_L3_01/llc_occupancy", "4096\n");
+    writeResctrlTestFile(monPath + "/mon_L3_01/mbm_total_bytes", "7500\n");
+    writeResctrlTestFile(monPath + "/mon_L3_01/mbm_local_bytes", "3100\n");
+
+    TEST_EQUAL(sampler.calculateDiff(values, error), true);
+    TEST_EQUAL(values.size(), 2);
+    TEST_EQUAL(values.at(1).llcOccupancy, 4096);
+    TEST_EQUAL(values.at(1).mbmTotalBytes, 2500);
+    TEST_EQUAL(values.at(1).mbmLocalBytes, 100);
+    TEST_EQUAL(values.at(0).mbmLocalBytes, 0);
+}
+
+} // namespace Kitsunemimi
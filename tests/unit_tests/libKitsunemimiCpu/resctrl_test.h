@@ -0,0 +1,36 @@
+/**
+ *  @file       resctrl_test.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_RESCTRL_TEST_H
+#define KITSUNEMIMI_CPU_RESCTRL_TEST_H
+
+#include <string>
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+
+class Resctrl_Test : public Kitsunemimi::CompareTestHelper
+{
+public:
+    Resctrl_Test();
+
+private:
+    std::string m_rootPath = "";
+
+    void initResctrl_test();
+    void groups_test();
+    void schemata_test();
+    void assignTask_test();
+    void monitoring_test();
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_RESCTRL_TEST_H
@@ -0,0 +1,219 @@
+/**
+ *  @file       sample_recorder_test.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include "sample_recorder_test.h"
+
+#include <libKitsunemimiCpu/sample_recorder.h>
+
+#include <filesystem>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace Kitsunemimi
+{
+
+/**
+ * @brief create a series, which covers all branches of the codec: constant and changing
+ *        time-deltas, a large jump of the timestamps, a wrapping 32bit-counter, identical
+ *        values and values with changing sign
+ */
+void
+createTestSeries(std::vector<uint64_t> &timeStamps,
+                 std::vector<std::vector<double>> &values)
+{
+    uint64_t timeStamp = 1000;
+    uint32_t counter = 4000000000;
+    for(uint64_t i = 0; i < 2500; i++)
+    {
+        if(i == 1500) {
+            timeStamp += 5000000000000;
+        } else if(i == 2000) {
+            timeStamp += 1 << 20;
+        } else {
+            timeStamp += 1000000 + (i % 7 == 0 ? 3 : 0);
+        }
+        counter += 123456789;
+
+        const double mixed = static_cast<double>(i % 100) * (i % 2 == 0 ? 0.25 : -1.5);
+        timeStamps.push_back(timeStamp);
+        values.push_back({static_cast<double>(counter), 42.5, mixed});
+    }
+}
+
+/**
+ * @brief write the test-series into a new sample-file
+ */
+bool
+writeTestFile(const std::string &filePath,
+              const std::vector<uint64_t> &timeStamps,
+              const std::vector<std::vector<double>> &values)
+{
+    ErrorContainer error;
+    SampleRecorder recorder;
+    if(recorder.addColumn("counter", "", SYSTEM_SAMPLE_SOURCE, 0, error) == false
+            || recorder.addColumn("constant", "W", PACKAGE_SAMPLE_SOURCE, 0, error) == false
+            || recorder.addColumn("mixed", "", THREAD_SAMPLE_SOURCE, 1, error) == false
+            || recorder.initRecorder(filePath, error) == false)
+    {
+        return false;
+    }
+
+    for(uint64_t i = 0; i < timeStamps.size(); i++)
+    {
+        if(recorder.appendSample(timeStamps[i], values[i], error) == false) {
+            return false;
+        }
+    }
+
+    return recorder.closeRecorder(error);
+}
+
+/**
+ * @brief constructor
+ */
+SampleRecorder_Test::SampleRecorder_Test()
+    : Kitsunemimi::CompareTestHelper("SampleRecorder_Test")
+{
+    // unique directory, so parallel test-runs don't share the sample-file
+    char pathTemplate[] = "/tmp/KitsunemimiCpu_sample_recorder_test_XXXXXX";
+    if(mkdtemp(pathTemplate) == nullptr) {
+        return;
+    }
+    m_testFilePath = std::string(pathTemplate) + "/samples.data";
+
+    roundTrip_test();
+    rangeQuery_test();
+    brokenFile_test();
+
+    std::filesystem::remove_all(pathTemplate);
+}
+
+/**
+ * @brief roundTrip_test
+ */
+void
+SampleRecorder_Test::roundTrip_test()
+{
+    std::vector<uint64_t> timeStamps;
+    std::vector<std::vector<double>> values;
+    createTestSeries(timeStamps, values);
+    TEST_EQUAL(writeTestFile(m_testFilePath, timeStamps, values), true);
+
+    ErrorContainer error;
+    SampleReader reader;
+    TEST_EQUAL(reader.initReader(m_testFilePath, error), true);
+    TEST_EQUAL(reader.getNumberOfSamples(), timeStamps.size());
+    TEST_EQUAL(reader.getColumns().size(), 3);
+    TEST_EQUAL(reader.getFirstTimeStamp(), timeStamps.front());
+    TEST_EQUAL(reader.getLastTimeStamp(), timeStamps.back());
+
+    std::vector<uint64_t> readTimeStamps;
+    std::vector<std::vector<double>> readValues;
+    const bool ret = reader.forEachSample(0,
+                                          UINT64_MAX,
+                                          [&](const uint64_t timeStamp,
+                                              const std::vector<double> &sample)
+    {
+        readTimeStamps.push_back(timeStamp);
+        readValues.push_back(sample);
+    }, error);
+    TEST_EQUAL(ret, true);
+
+    // the codec is lossless, so all values have to be exactly the same
+    const bool equalTimeStamps = readTimeStamps == timeStamps;
+    const bool equalValues = readValues == values;
+    TEST_EQUAL(equalTimeStamps, true);
+    TEST_EQUAL(equalValues, true);
+
+    unlink(m_testFilePath.c_str());
+}
+
+/**
+ * @brief rangeQuery_test
+ */
+void
+SampleRecorder_Test::rangeQuery_test()
+{
+    std::vector<uint64_t> timeStamps;
+    std::vector<std::vector<double>> values;
+    createTestSeries(timeStamps, values);
+    TEST_EQUAL(writeTestFile(m_testFilePath, timeStamps, values), true);
+
+    ErrorContainer error;
+    SampleReader reader;
+    TEST_EQUAL(reader.initReader(m_testFilePath, error), true);
+
+    // range over the border of blocks and over the jump of the timestamps
+    std::vector<uint64_t> readTimeStamps;
+    std::vector<double> readValues;
+    TEST_EQUAL(reader.readColumn(readTimeStamps,
+                                 readValues,
+                                 0,
+                                 timeStamps[1000],
+                                 timeStamps[2100],
+                                 error), true);
+    TEST_EQUAL(readTimeStamps.size(), 1101);
+
+    bool equal = readTimeStamps.size() == 1101;
+    for(uint64_t i = 0; i < readTimeStamps.size() && equal; i++)
+    {
+        equal = readTimeStamps[i] == timeStamps[1000 + i]
+                && readValues[i] == values[1000 + i][0];
+    }
+    TEST_EQUAL(equal, true);
+
+    // range without samples
+    TEST_EQUAL(reader.readColumn(readTimeStamps, readValues, 2, 0, 500, error), true);
+    TEST_EQUAL(readTimeStamps.size(), 0);
+
+    unlink(m_testFilePath.c_str());
+}
+
+/**
+ * @brief brokenFile_test
+ */
+void
+SampleRecorder_Test::brokenFile_test()
+{
+    std::vector<uint64_t> timeStamps;
+    std::vector<std::vector<double>> values;
+    createTestSeries(timeStamps, values);
+    TEST_EQUAL(writeTestFile(m_testFilePath, timeStamps, values), true);
+
+    const int fd = open(m_testFilePath.c_str(), O_RDWR);
+    TEST_NOT_EQUAL(fd, -1);
+    SampleFileHeader header;
+    TEST_EQUAL(pread(fd, &header, sizeof(header), 0), sizeof(header));
+
+    // word-count of the first stream, which is bigger than the whole block
+    const uint64_t brokenWordCount = UINT64_MAX / 8;
+    const off_t countPos = header.headerSize + sizeof(SampleBlockHeader);
+    uint64_t oldWordCount = 0;
+    TEST_EQUAL(pread(fd, &oldWordCount, sizeof(uint64_t), countPos), sizeof(uint64_t));
+    TEST_EQUAL(pwrite(fd, &brokenWordCount, sizeof(uint64_t), countPos), sizeof(uint64_t));
+
+    ErrorContainer error;
+    SampleReader brokenBlockReader;
+    TEST_EQUAL(brokenBlockReader.initReader(m_testFilePath, error), false);
+
+    // end of the data before the end of the header
+    TEST_EQUAL(pwrite(fd, &oldWordCount, sizeof(uint64_t), countPos), sizeof(uint64_t));
+    SampleFileHeader brokenHeader = header;
+    brokenHeader.dataEnd = header.headerSize - 1;
+    TEST_EQUAL(pwrite(fd, &brokenHeader, sizeof(header), 0), sizeof(header));
+
+    SampleReader brokenHeaderReader;
+    TEST_EQUAL(brokenHeaderReader.initReader(m_testFilePath, error), false);
+
+    close(fd);
+    unlink(m_testFilePath.c_str());
+}
+
+} // namespace Kitsunemimi
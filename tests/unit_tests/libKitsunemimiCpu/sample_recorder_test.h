@@ -0,0 +1,34 @@
+/**
+ *  @file       sample_recorder_test.h
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#ifndef KITSUNEMIMI_CPU_SAMPLE_RECORDER_TEST_H
+#define KITSUNEMIMI_CPU_SAMPLE_RECORDER_TEST_H
+
+#include <string>
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+
+namespace Kitsunemimi
+{
+
+class SampleRecorder_Test : public Kitsunemimi::CompareTestHelper
+{
+public:
+    SampleRecorder_Test();
+
+private:
+    std::string m_testFilePath = "";
+
+    void roundTrip_test();
+    void rangeQuery_test();
+    void brokenFile_test();
+};
+
+} // namespace Kitsunemimi
+
+#endif // KITSUNEMIMI_CPU_SAMPLE_RECORDER_TEST_H
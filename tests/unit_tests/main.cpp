@@ -0,0 +1,28 @@
+/**
+ *  @file       main.cpp
+ *
+ *  @author     Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright  MIT License
+ */
+
+#include <libKitsunemimiCpu/batched_reader_test.h>
+#include <libKitsunemimiCpu/cpu_test.h>
+#include <libKitsunemimiCpu/cpu_set_test.h>
+#include <libKitsunemimiCpu/interrupts_test.h>
+#include <libKitsunemimiCpu/pressure_test.h>
+#include <libKitsunemimiCpu/resctrl_test.h>
+#include <libKitsunemimiCpu/sample_recorder_test.h>
+
+int main()
+{
+    Kitsunemimi::BatchedReader_Test();
+    Kitsunemimi::Cpu_Test();
+    Kitsunemimi::CpuSet_Test();
+    Kitsunemimi::Interrupts_Test();
+    Kitsunemimi::Pressure_Test();
+    Kitsunemimi::Resctrl_Test();
+    Kitsunemimi::SampleRecorder_Test();
+
+    return 0;
+}
@@ -0,0 +1,34 @@
+include(../../defaults.pri)
+
+QT -= qt core gui
+
+CONFIG   -= app_bundle
+CONFIG += c++17 console
+
+LIBS += -L../../src -lKitsunemimiCpu
+
+LIBS += -L../../../libKitsunemimiCommon/src -lKitsunemimiCommon
+LIBS += -L../../../libKitsunemimiCommon/src/debug -lKitsunemimiCommon
+LIBS += -L../../../libKitsunemimiCommon/src/release -lKitsunemimiCommon
+INCLUDEPATH += ../../../libKitsunemimiCommon/include
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    libKitsunemimiCpu/batched_reader_test.h \
+    libKitsunemimiCpu/cpu_test.h \
+    libKitsunemimiCpu/cpu_set_test.h \
+    libKitsunemimiCpu/interrupts_test.h \
+    libKitsunemimiCpu/pressure_test.h \
+    libKitsunemimiCpu/resctrl_test.h \
+    libKitsunemimiCpu/sample_recorder_test.h
+
+SOURCES += \
+    main.cpp \
+    libKitsunemimiCpu/batched_reader_test.cpp \
+    libKitsunemimiCpu/cpu_test.cpp \
+    libKitsunemimiCpu/cpu_set_test.cpp \
+    libKitsunemimiCpu/interrupts_test.cpp \
+    libKitsunemimiCpu/pressure_test.cpp \
+    libKitsunemimiCpu/resctrl_test.cpp \
+    libKitsunemimiCpu/sample_recorder_test.cpp